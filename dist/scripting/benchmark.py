@@ -0,0 +1,71 @@
+"""
+Measures the throughput of the Citra RPC server. Run it while a game is running:
+
+    python3 benchmark.py --address 0x08000000 --ranges 256
+"""
+import argparse
+import time
+
+from citra import Citra
+
+def measure(name, unit, function, amount, duration):
+    count = 0
+    start = time.perf_counter()
+    while time.perf_counter() - start < duration:
+        function()
+        count += 1
+    elapsed = time.perf_counter() - start
+    print("{:<36} {:>10.1f} requests/s {:>12.1f} {}/s".format(
+        name, count / elapsed, count * amount / elapsed, unit))
+
+def main():
+    parser = argparse.ArgumentParser(description="Benchmark the Citra RPC server")
+    parser.add_argument("--host", default="127.0.0.1")
+    parser.add_argument("--address", type=lambda x: int(x, 0), default=0x08000000,
+                        help="address of the memory to read (default: start of the heap)")
+    parser.add_argument("--ranges", type=int, default=256,
+                        help="number of 4 byte values polled per iteration")
+    parser.add_argument("--block-size", type=lambda x: int(x, 0), default=0x100000,
+                        help="size of block reads over the stream transport")
+    parser.add_argument("--duration", type=float, default=3.0,
+                        help="duration of every measurement in seconds")
+    args = parser.parse_args()
+
+    ranges = [(args.address + 16 * i, 4) for i in range(args.ranges)]
+
+    datagram = Citra(args.host)
+    stream = Citra(args.host, stream=True)
+
+    measure("Single reads (datagram)", "values", lambda: datagram.read_memory(args.address, 4),
+            1, args.duration)
+    measure("Polling, one read per value", "polls",
+            lambda: [datagram.read_memory(address, size) for address, size in ranges],
+            1, args.duration)
+    measure("Polling, batched (datagram)", "polls",
+            lambda: datagram.read_memory_batch(ranges), 1, args.duration)
+    measure("Polling, batched (stream)", "polls",
+            lambda: stream.read_memory_batch(ranges), 1, args.duration)
+    measure("Block reads (datagram)", "MiB",
+            lambda: datagram.read_memory(args.address, args.block_size),
+            args.block_size / (1024 * 1024), args.duration)
+    measure("Block reads (stream)", "MiB",
+            lambda: stream.read_memory(args.address, args.block_size),
+            args.block_size / (1024 * 1024), args.duration)
+
+    subscription_id = stream.subscribe(ranges)
+    if subscription_id is None:
+        print("Subscription does not fit into a single packet")
+        return
+    _, first_frame, _ = stream.wait_for_update()
+    start = time.perf_counter()
+    updates = 0
+    while time.perf_counter() - start < args.duration:
+        _, last_frame, _ = stream.wait_for_update()
+        updates += 1
+    elapsed = time.perf_counter() - start
+    stream.unsubscribe(subscription_id)
+    print("{:<36} {:>10.1f} updates/s  {:>12} frames missed".format(
+        "Subscription (stream)", updates / elapsed, last_frame - first_frame - updates))
+
+if "__main__" == __name__:
+    main()
@@ -2,21 +2,42 @@ import struct
 import random
 import enum
 import socket
+import collections
 
-CURRENT_REQUEST_VERSION = 1
-MAX_REQUEST_DATA_SIZE = 32
-MAX_PACKET_SIZE = 48
+CURRENT_REQUEST_VERSION = 2
+MAX_REQUEST_DATA_SIZE = 1024
+MAX_PACKET_SIZE = 16 + MAX_REQUEST_DATA_SIZE
+MAX_STREAM_REQUEST_DATA_SIZE = 16 * 1024 * 1024
 
 class RequestType(enum.IntEnum):
     ReadMemory = 1,
-    WriteMemory = 2
+    WriteMemory = 2,
+    ReadMemoryBatch = 3,
+    Subscribe = 4,
+    Unsubscribe = 5,
+    SubscriptionUpdate = 6
 
 CITRA_PORT = 45987
 
 class Citra:
-    def __init__(self, address="127.0.0.1", port=CITRA_PORT):
-        self.socket = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    def __init__(self, address="127.0.0.1", port=CITRA_PORT, stream=False):
+        """
+        Connects to the RPC server. Datagrams have the lowest latency, the stream transport
+        allows reads and writes of up to 16 MiB per request.
+        """
         self.address = address
+        self.port = port
+        self.stream = stream
+        if stream:
+            self.socket = socket.create_connection((address, port))
+            self.socket.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+            self.max_data_size = MAX_STREAM_REQUEST_DATA_SIZE
+        else:
+            self.socket = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+            self.max_data_size = MAX_REQUEST_DATA_SIZE
+        # Range sizes of active subscriptions and updates received while waiting for replies
+        self.subscriptions = {}
+        self.pending_updates = collections.deque()
 
     def is_connected(self):
         return self.socket is not None
@@ -25,6 +46,22 @@ class Citra:
         request_id = random.getrandbits(32)
         return (struct.pack("IIII", CURRENT_REQUEST_VERSION, request_id, request_type, data_size), request_id)
 
+    def _receive_exactly(self, size):
+        data = bytearray()
+        while len(data) < size:
+            chunk = self.socket.recv(size - len(data))
+            if not chunk:
+                raise ConnectionError("Connection closed by Citra")
+            data += chunk
+        return bytes(data)
+
+    def _receive_packet(self):
+        if self.stream:
+            header = self._receive_exactly(4*4)
+            data_size = struct.unpack("IIII", header)[3]
+            return header + self._receive_exactly(data_size)
+        return self.socket.recv(MAX_PACKET_SIZE)
+
     def _read_and_validate_header(self, raw_reply, expected_id, expected_type):
         reply_version, reply_id, reply_type, reply_data_size = struct.unpack("IIII", raw_reply[:4*4])
         if (CURRENT_REQUEST_VERSION == reply_version and
@@ -34,6 +71,22 @@ class Citra:
             return raw_reply[4*4:]
         return None
 
+    def _request(self, request_type, request_data):
+        request, request_id = self._generate_header(request_type, len(request_data))
+        request += request_data
+        if self.stream:
+            self.socket.sendall(request)
+        else:
+            self.socket.sendto(request, (self.address, self.port))
+
+        while True:
+            raw_reply = self._receive_packet()
+            reply_type = struct.unpack("IIII", raw_reply[:4*4])[2]
+            if reply_type == RequestType.SubscriptionUpdate:
+                self.pending_updates.append(raw_reply)
+                continue
+            return self._read_and_validate_header(raw_reply, request_id, request_type)
+
     def read_memory(self, read_address, read_size):
         """
         >>> c.read_memory(0x100000, 4)
@@ -41,14 +94,9 @@ class Citra:
         """
         result = bytes()
         while read_size > 0:
-            temp_read_size = min(read_size, MAX_REQUEST_DATA_SIZE)
+            temp_read_size = min(read_size, self.max_data_size)
             request_data = struct.pack("II", read_address, temp_read_size)
-            request, request_id = self._generate_header(RequestType.ReadMemory, len(request_data))
-            request += request_data
-            self.socket.sendto(request, (self.address, CITRA_PORT))
-
-            raw_reply = self.socket.recv(MAX_PACKET_SIZE)
-            reply_data = self._read_and_validate_header(raw_reply, request_id, RequestType.ReadMemory)
+            reply_data = self._request(RequestType.ReadMemory, request_data)
 
             if reply_data:
                 result += reply_data
@@ -59,6 +107,41 @@ class Citra:
 
         return result
 
+    def read_memory_batch(self, ranges):
+        """
+        Reads a list of (address, size) ranges with as few requests as possible.
+        >>> c.read_memory_batch([(0x100000, 4), (0x100000, 2)])
+        [b'\\x07\\x00\\x00\\xeb', b'\\x07\\x00']
+        """
+        results = []
+        batch = []
+        batch_size = 0
+        for address, size in ranges:
+            if size > self.max_data_size:
+                return None
+            if (batch_size + size > self.max_data_size or
+                (len(batch) + 1) * 8 > self.max_data_size):
+                if not self._read_batch(batch, results):
+                    return None
+                batch = []
+                batch_size = 0
+            batch.append((address, size))
+            batch_size += size
+        if batch and not self._read_batch(batch, results):
+            return None
+        return results
+
+    def _read_batch(self, batch, results):
+        request_data = b"".join(struct.pack("II", address, size) for address, size in batch)
+        reply_data = self._request(RequestType.ReadMemoryBatch, request_data)
+        if not reply_data:
+            return False
+        offset = 0
+        for _, size in batch:
+            results.append(reply_data[offset:offset + size])
+            offset += size
+        return True
+
     def write_memory(self, write_address, write_contents):
         """
         >>> c.write_memory(0x100000, b"\\xff\\xff\\xff\\xff")
@@ -72,15 +155,10 @@ class Citra:
         """
         write_size = len(write_contents)
         while write_size > 0:
-            temp_write_size = min(write_size, MAX_REQUEST_DATA_SIZE - 8)
+            temp_write_size = min(write_size, self.max_data_size - 8)
             request_data = struct.pack("II", write_address, temp_write_size)
             request_data += write_contents[:temp_write_size]
-            request, request_id = self._generate_header(RequestType.WriteMemory, len(request_data))
-            request += request_data
-            self.socket.sendto(request, (self.address, CITRA_PORT))
-
-            raw_reply = self.socket.recv(MAX_PACKET_SIZE)
-            reply_data = self._read_and_validate_header(raw_reply, request_id, RequestType.WriteMemory)
+            reply_data = self._request(RequestType.WriteMemory, request_data)
 
             if None != reply_data:
                 write_address += temp_write_size
@@ -90,6 +168,53 @@ class Citra:
                 return False
         return True
 
+    def subscribe(self, ranges):
+        """
+        Registers a list of (address, size) ranges, whose contents Citra sends once per frame.
+        Returns the subscription id, or None if the ranges do not fit into a single packet.
+        """
+        request_data = b"".join(struct.pack("II", address, size) for address, size in ranges)
+        reply_data = self._request(RequestType.Subscribe, request_data)
+        if not reply_data:
+            return None
+        subscription_id = struct.unpack("I", reply_data)[0]
+        self.subscriptions[subscription_id] = [size for _, size in ranges]
+        return subscription_id
+
+    def unsubscribe(self, subscription_id):
+        """
+        Removes a subscription. Returns True if it was removed, False if Citra did not know it.
+        """
+        reply_data = self._request(RequestType.Unsubscribe, struct.pack("I", subscription_id))
+        self.subscriptions.pop(subscription_id, None)
+        if reply_data is None or len(reply_data) != 4:
+            return False
+        return struct.unpack("I", reply_data)[0] == 1
+
+    def wait_for_update(self):
+        """
+        Waits for the next subscription update.
+        Returns (subscription id, frame number, [contents of each range]).
+        """
+        while True:
+            if self.pending_updates:
+                raw_update = self.pending_updates.popleft()
+            else:
+                raw_update = self._receive_packet()
+            _, subscription_id, update_type, data_size = struct.unpack("IIII", raw_update[:4*4])
+            if (update_type != RequestType.SubscriptionUpdate or
+                subscription_id not in self.subscriptions):
+                continue
+
+            data = raw_update[4*4:]
+            frame = struct.unpack("I", data[:4])[0]
+            contents = []
+            offset = 4
+            for size in self.subscriptions[subscription_id]:
+                contents.append(data[offset:offset + size])
+                offset += size
+            return (subscription_id, frame, contents)
+
 if "__main__" == __name__:
     import doctest
     doctest.testmod(extraglobs={'c': Citra()})
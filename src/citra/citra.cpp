@@ -27,6 +27,7 @@
 #include "common/logging/backend.h"
 #include "common/logging/filter.h"
 #include "common/logging/log.h"
+#include "common/microprofile_trace.h"
 #include "common/scm_rev.h"
 #include "common/scope_exit.h"
 #include "common/string_util.h"
@@ -68,6 +69,10 @@ static void PrintHelp(const char* argv0) {
                  "-r, --movie-record=[file]  Record a movie (game inputs) to the given file\n"
                  "-p, --movie-play=[file]    Playback the movie (game inputs) from the given file\n"
                  "-d, --dump-video=[file]    Dumps audio and video to the given video file\n"
+                 "-t, --profile-trace=[file] Write the MicroProfile scopes as a Chrome trace to"
+                 " the given file\n"
+                 "-F, --profile-frames=FIRST[:COUNT]  Frames to include in the profile trace,"
+                 " all by default\n"
                  "-f, --fullscreen     Start in fullscreen mode\n"
                  "-h, --help           Display this help and exit\n"
                  "-v, --version        Output version information and exit\n";
@@ -194,6 +199,9 @@ int main(int argc, char** argv) {
     std::string movie_record;
     std::string movie_play;
     std::string dump_video;
+    std::string profile_trace;
+    u64 profile_first_frame = 0;
+    u64 profile_num_frames = 0;
 
     InitializeLogging();
 
@@ -220,12 +228,13 @@ int main(int argc, char** argv) {
         {"gdbport", required_argument, 0, 'g'},     {"install", required_argument, 0, 'i'},
         {"multiplayer", required_argument, 0, 'm'}, {"movie-record", required_argument, 0, 'r'},
         {"movie-play", required_argument, 0, 'p'},  {"dump-video", required_argument, 0, 'd'},
+        {"profile-trace", required_argument, 0, 't'}, {"profile-frames", required_argument, 0, 'F'},
         {"fullscreen", no_argument, 0, 'f'},        {"help", no_argument, 0, 'h'},
         {"version", no_argument, 0, 'v'},           {0, 0, 0, 0},
     };
 
     while (optind < argc) {
-        int arg = getopt_long(argc, argv, "g:i:m:r:p:fhv", long_options, &option_index);
+        int arg = getopt_long(argc, argv, "g:i:m:r:p:t:F:fhv", long_options, &option_index);
         if (arg != -1) {
             switch (static_cast<char>(arg)) {
             case 'g':
@@ -291,6 +300,17 @@ int main(int argc, char** argv) {
             case 'd':
                 dump_video = optarg;
                 break;
+            case 't':
+                profile_trace = optarg;
+                break;
+            case 'F':
+                if (!Common::MicroProfileTrace::ParseFrameRange(optarg, profile_first_frame,
+                                                                profile_num_frames)) {
+                    std::cout << "Wrong format for option --profile-frames\n";
+                    PrintHelp(argv[0]);
+                    return 0;
+                }
+                break;
             case 'f':
                 fullscreen = true;
                 LOG_INFO(Frontend, "Starting in fullscreen mode...");
@@ -317,7 +337,10 @@ int main(int argc, char** argv) {
 #endif
 
     MicroProfileOnThreadCreate("EmuThread");
-    SCOPE_EXIT({ MicroProfileShutdown(); });
+    SCOPE_EXIT({
+        Common::MicroProfileTrace::Stop();
+        MicroProfileShutdown();
+    });
 
     if (filepath.empty()) {
         LOG_CRITICAL(Frontend, "Failed to load ROM: No ROM specified");
@@ -384,6 +407,10 @@ int main(int argc, char** argv) {
 
     system.TelemetrySession().AddField(Telemetry::FieldType::App, "Frontend", "SDL");
 
+    if (!profile_trace.empty()) {
+        Common::MicroProfileTrace::Start(profile_trace, profile_first_frame, profile_num_frames);
+    }
+
     if (use_multiplayer) {
         if (auto member = Network::GetRoomMember().lock()) {
             member->BindOnChatMessageRecieved(OnMessageReceived);
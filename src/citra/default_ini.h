@@ -112,6 +112,16 @@ shaders_accurate_mul =
 # 0: Interpreter (slow), 1 (default): JIT (fast)
 use_shader_jit =
 
+# Whether to emulate the GPU on a separate thread. Only used with the software renderer, the
+# hardware renderer always emulates the GPU on the emulation thread.
+# 0 (default): Off, 1: On
+use_async_gpu =
+
+# Whether to keep the vertex and index arrays of hardware rendered draws on the host GPU across
+# draws, instead of uploading them for every draw
+# 0: Off, 1 (default): On
+use_vertex_buffer_cache =
+
 # Forces VSync on the display thread. Usually doesn't impact performance, but on some drivers it can
 # so only turn this off if you notice a speed difference.
 # 0: Off, 1 (default): On
@@ -191,6 +201,15 @@ custom_textures =
 # 0 (default): Off, 1: On
 preload_textures =
 
+# Number of frames that can wait for the encoder while dumping video. More frames smooth over
+# encoder spikes at the cost of memory.
+# Must be at least 1. Default: 4
+video_dumping_queue_size =
+
+# What to do when the video dumping queue is full.
+# 0 (default): Wait for the encoder, slowing down emulation, 1: Drop the frame
+video_dumping_drop_frames =
+
 [Audio]
 # Whether or not to enable DSP LLE
 # 0 (default): No, 1: Yes
@@ -272,6 +291,9 @@ log_filter = *:Info
 [Debugging]
 # Record frame time data, can be found in the log directory. Boolean value
 record_frame_times =
+# Record call counts and host time of HLE service commands and SVCs, can be found in the log
+# directory. Boolean value
+record_call_stats =
 # Port for listening to GDB connections.
 use_gdbstub=false
 gdbstub_port=24689
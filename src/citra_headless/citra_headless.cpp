@@ -0,0 +1,474 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <fmt/format.h>
+
+// This needs to be included before getopt.h because the latter #defines symbols used by it
+#include "common/microprofile.h"
+
+#ifdef _WIN32
+// windows.h needs to be included before shellapi.h
+#include <windows.h>
+
+#include <shellapi.h>
+#endif
+
+#include "citra/config.h"
+#include "citra_headless/emu_window_headless.h"
+#include "common/common_paths.h"
+#include "common/detached_tasks.h"
+#include "common/file_util.h"
+#include "common/logging/backend.h"
+#include "common/logging/filter.h"
+#include "common/logging/log.h"
+#include "common/microprofile_trace.h"
+#include "common/scm_rev.h"
+#include "common/scope_exit.h"
+#include "common/string_util.h"
+#include "core/core.h"
+#include "core/frontend/applets/default_applets.h"
+#include "core/movie.h"
+#include "core/movie_file.h"
+#include "core/settings.h"
+#include "video_core/renderer_null/renderer_null.h"
+#include "video_core/video_core.h"
+
+#undef _UNICODE
+#include <getopt.h>
+#ifndef _MSC_VER
+#include <unistd.h>
+#endif
+
+static void PrintHelp(const char* argv0) {
+    std::cout << "Usage: " << argv0
+              << " [options] <filename>\n"
+                 "Runs a title without a display as fast as possible, for batch and CI runs.\n"
+                 "-n, --frames=NUMBER        Stop after NUMBER frames\n"
+                 "-p, --movie-play=[file]    Playback the movie (game inputs) from the given file,"
+                 " stopping when it ends\n"
+                 "-m, --convert-movie=[file] Convert the given movie to the chunked format,"
+                 " writing it to <filename>, and exit\n"
+                 "-o, --output=[file]        Write frame hashes and perf stats as JSON to the"
+                 " given file, or - for stdout\n"
+                 "-b, --benchmark            Use a fixed clock and print frametime percentiles,"
+                 " hitches and the frame breakdown to stderr when done\n"
+                 "-c, --checkpoints=NUMBER   Print wall time, fps and frame hashes to stderr every"
+                 " NUMBER frames and at the end\n"
+                 "-t, --profile-trace=[file] Write the MicroProfile scopes as a Chrome trace to"
+                 " the given file\n"
+                 "-F, --profile-frames=FIRST[:COUNT]  Frames to include in the profile trace,"
+                 " all by default\n"
+                 "-h, --help                 Display this help and exit\n"
+                 "-v, --version              Output version information and exit\n";
+}
+
+static void PrintVersion() {
+    std::cout << "Citra " << Common::g_scm_branch << " " << Common::g_scm_desc << std::endl;
+}
+
+static void InitializeLogging() {
+    Log::Filter log_filter(Log::Level::Debug);
+    log_filter.ParseFilterString(Settings::values.log_filter);
+    Log::SetGlobalFilter(log_filter);
+
+    Log::AddBackend(std::make_unique<Log::ColorConsoleBackend>());
+
+    const std::string& log_dir = FileUtil::GetUserPath(FileUtil::UserPath::LogDir);
+    FileUtil::CreateFullPath(log_dir);
+    Log::AddBackend(std::make_unique<Log::FileBackend>(log_dir + LOG_FILE));
+#ifdef _WIN32
+    Log::AddBackend(std::make_unique<Log::DebuggerBackend>());
+#endif
+}
+
+static std::string EscapeJsonString(const std::string& str) {
+    std::string escaped;
+    escaped.reserve(str.size());
+    for (const char c : str) {
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+            escaped += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            escaped += fmt::format("\\u{:04x}", static_cast<int>(c));
+        } else {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+static constexpr std::array<const char*, Core::NumFrameSections> FrameSectionNames{
+    "cpu", "gpu", "hle", "frame_limiter"};
+
+static std::string FormatSummary(const Core::PerfStats::FrameTimeSummary& summary) {
+    std::string text = fmt::format(
+        "Frames: {}\n"
+        "Frametime (ms): mean {:.3f}, p50 {:.3f}, p95 {:.3f}, p99 {:.3f}, max {:.3f}\n"
+        "Hitches over {:.2f} ms: {}\n"
+        "Mean frame breakdown (ms):",
+        summary.frames, summary.mean_ms, summary.p50_ms, summary.p95_ms, summary.p99_ms,
+        summary.max_ms, Core::PerfStats::DefaultHitchThresholdMs, summary.hitches);
+    for (std::size_t i = 0; i < Core::NumFrameSections; ++i) {
+        text += fmt::format(" {} {:.3f}", FrameSectionNames[i], summary.section_mean_ms[i]);
+    }
+    return text + "\n";
+}
+
+/// Progress of the run at a given frame, used to compare builds running the same workload
+struct Checkpoint {
+    u64 frame;
+    double wall_time;
+    VideoCore::RendererNull::ScreenHashes hashes;
+};
+
+static std::string FormatCheckpoint(const Checkpoint& checkpoint) {
+    return fmt::format("Checkpoint frame {}: {:.3f} s, {:.2f} fps, hashes {:016x} {:016x}\n",
+                       checkpoint.frame, checkpoint.wall_time,
+                       checkpoint.wall_time > 0.0 ? checkpoint.frame / checkpoint.wall_time : 0.0,
+                       checkpoint.hashes[0], checkpoint.hashes[1]);
+}
+
+static std::string FormatResults(const std::string& filepath, double wall_time,
+                                 const Core::PerfStats::Results& stats,
+                                 const Core::PerfStats::FrameTimeSummary& summary,
+                                 const std::vector<Checkpoint>& checkpoints,
+                                 const std::vector<VideoCore::RendererNull::ScreenHashes>& hashes) {
+    std::string json = "{\n";
+    json += fmt::format("  \"file\": \"{}\",\n", EscapeJsonString(filepath));
+    json += fmt::format("  \"version\": \"{} {}\",\n", Common::g_scm_branch, Common::g_scm_desc);
+    json += fmt::format("  \"frames\": {},\n", hashes.size());
+    json += fmt::format("  \"wall_time\": {:.6f},\n", wall_time);
+    json += fmt::format("  \"average_fps\": {:.3f},\n",
+                        wall_time > 0.0 ? hashes.size() / wall_time : 0.0);
+    json += "  \"perf_stats\": {\n";
+    json += fmt::format("    \"system_fps\": {:.3f},\n", stats.system_fps);
+    json += fmt::format("    \"game_fps\": {:.3f},\n", stats.game_fps);
+    json += fmt::format("    \"frametime\": {:.6f},\n", stats.frametime);
+    json += fmt::format("    \"emulation_speed\": {:.6f},\n", stats.emulation_speed);
+    json += fmt::format("    \"host_memory_resident\": {},\n", stats.host_memory_resident);
+    json += fmt::format("    \"emulated_memory_used\": {}\n", stats.emulated_memory_used);
+    json += "  },\n";
+    json += "  \"frametimes\": {\n";
+    json += fmt::format("    \"mean_ms\": {:.3f},\n", summary.mean_ms);
+    json += fmt::format("    \"p50_ms\": {:.3f},\n", summary.p50_ms);
+    json += fmt::format("    \"p95_ms\": {:.3f},\n", summary.p95_ms);
+    json += fmt::format("    \"p99_ms\": {:.3f},\n", summary.p99_ms);
+    json += fmt::format("    \"max_ms\": {:.3f},\n", summary.max_ms);
+    json += fmt::format("    \"hitch_threshold_ms\": {:.2f},\n",
+                        Core::PerfStats::DefaultHitchThresholdMs);
+    json += fmt::format("    \"hitches\": {},\n", summary.hitches);
+    json += "    \"section_mean_ms\": {";
+    for (std::size_t i = 0; i < Core::NumFrameSections; ++i) {
+        json += fmt::format("{}\"{}\": {:.3f}", i == 0 ? "" : ", ", FrameSectionNames[i],
+                            summary.section_mean_ms[i]);
+    }
+    json += "}\n";
+    json += "  },\n";
+    json += "  \"checkpoints\": [";
+    for (std::size_t i = 0; i < checkpoints.size(); ++i) {
+        const Checkpoint& checkpoint = checkpoints[i];
+        json += fmt::format("{}\n    {{\"frame\": {}, \"wall_time\": {:.6f}, "
+                            "\"hashes\": [\"{:016x}\", \"{:016x}\"]}}",
+                            i == 0 ? "" : ",", checkpoint.frame, checkpoint.wall_time,
+                            checkpoint.hashes[0], checkpoint.hashes[1]);
+    }
+    json += checkpoints.empty() ? "],\n" : "\n  ],\n";
+    json += "  \"frame_hashes\": [";
+    for (std::size_t i = 0; i < hashes.size(); ++i) {
+        json += fmt::format("{}\n    [\"{:016x}\", \"{:016x}\"]", i == 0 ? "" : ",", hashes[i][0],
+                            hashes[i][1]);
+    }
+    json += hashes.empty() ? "]\n" : "\n  ]\n";
+    json += "}\n";
+    return json;
+}
+
+/// Application entry point
+int main(int argc, char** argv) {
+    Common::DetachedTasks detached_tasks;
+    Config config;
+    int option_index = 0;
+    u64 max_frames = 0;
+    std::string movie_play;
+    std::string convert_movie;
+    std::string output;
+    bool benchmark = false;
+    u64 checkpoint_interval = 0;
+    std::string profile_trace;
+    u64 profile_first_frame = 0;
+    u64 profile_num_frames = 0;
+
+    InitializeLogging();
+
+    char* endarg;
+#ifdef _WIN32
+    int argc_w;
+    auto argv_w = CommandLineToArgvW(GetCommandLineW(), &argc_w);
+
+    if (argv_w == nullptr) {
+        LOG_CRITICAL(Frontend, "Failed to get command line arguments");
+        return -1;
+    }
+#endif
+    std::string filepath;
+
+    static struct option long_options[] = {
+        {"frames", required_argument, 0, 'n'},
+        {"movie-play", required_argument, 0, 'p'},
+        {"convert-movie", required_argument, 0, 'm'},
+        {"output", required_argument, 0, 'o'},
+        {"benchmark", no_argument, 0, 'b'},
+        {"checkpoints", required_argument, 0, 'c'},
+        {"profile-trace", required_argument, 0, 't'},
+        {"profile-frames", required_argument, 0, 'F'},
+        {"help", no_argument, 0, 'h'},
+        {"version", no_argument, 0, 'v'},
+        {0, 0, 0, 0},
+    };
+
+    while (optind < argc) {
+        int arg = getopt_long(argc, argv, "n:p:m:o:bc:t:F:hv", long_options, &option_index);
+        if (arg != -1) {
+            switch (static_cast<char>(arg)) {
+            case 'n':
+                errno = 0;
+                max_frames = strtoull(optarg, &endarg, 0);
+                if (endarg == optarg)
+                    errno = EINVAL;
+                if (errno != 0) {
+                    perror("--frames");
+                    exit(1);
+                }
+                break;
+            case 'p':
+                movie_play = optarg;
+                break;
+            case 'm':
+                convert_movie = optarg;
+                break;
+            case 'o':
+                output = optarg;
+                break;
+            case 'b':
+                benchmark = true;
+                break;
+            case 'c':
+                errno = 0;
+                checkpoint_interval = strtoull(optarg, &endarg, 0);
+                if (endarg == optarg)
+                    errno = EINVAL;
+                if (errno != 0) {
+                    perror("--checkpoints");
+                    exit(1);
+                }
+                break;
+            case 't':
+                profile_trace = optarg;
+                break;
+            case 'F':
+                if (!Common::MicroProfileTrace::ParseFrameRange(optarg, profile_first_frame,
+                                                                profile_num_frames)) {
+                    std::cout << "Wrong format for option --profile-frames\n";
+                    PrintHelp(argv[0]);
+                    return 1;
+                }
+                break;
+            case 'h':
+                PrintHelp(argv[0]);
+                return 0;
+            case 'v':
+                PrintVersion();
+                return 0;
+            }
+        } else {
+#ifdef _WIN32
+            filepath = Common::UTF16ToUTF8(argv_w[optind]);
+#else
+            filepath = argv[optind];
+#endif
+            optind++;
+        }
+    }
+
+#ifdef _WIN32
+    LocalFree(argv_w);
+#endif
+
+    if (!convert_movie.empty()) {
+        if (filepath.empty()) {
+            LOG_CRITICAL(Frontend, "No output file for the converted movie specified");
+            return -1;
+        }
+        return Core::ConvertMovie(convert_movie, filepath) ? 0 : -1;
+    }
+
+    MicroProfileOnThreadCreate("EmuThread");
+    SCOPE_EXIT({
+        Common::MicroProfileTrace::Stop();
+        MicroProfileShutdown();
+    });
+
+    if (filepath.empty()) {
+        LOG_CRITICAL(Frontend, "Failed to load ROM: No ROM specified");
+        return -1;
+    }
+
+    if (max_frames == 0 && movie_play.empty()) {
+        LOG_CRITICAL(Frontend, "Either a frame count or a movie to play back is required");
+        return -1;
+    }
+
+    if (!movie_play.empty()) {
+        Core::Movie::GetInstance().PrepareForPlayback(movie_play);
+    }
+
+    // Run as fast as possible, without a display or audio output
+    Settings::values.use_null_renderer = true;
+    Settings::values.use_frame_limit = false;
+    Settings::values.sink_id = "null";
+    Settings::values.enable_audio_stretching = false;
+    // The LLE DSP thread would make the audio timing depend on the host scheduler
+    Settings::values.enable_dsp_lle_multithread = false;
+    if (benchmark) {
+        // Movies override the clock with the time they were recorded at, plain runs need a fixed
+        // one so that they execute the same code on every run
+        Settings::values.init_clock = Settings::InitClock::FixedTime;
+    }
+    Settings::Apply();
+
+    // Register frontend applets
+    Frontend::RegisterDefaultApplets();
+
+    EmuWindow_Headless emu_window;
+    Core::System& system{Core::System::GetInstance()};
+
+    const Core::System::ResultStatus load_result{system.Load(emu_window, filepath)};
+
+    switch (load_result) {
+    case Core::System::ResultStatus::ErrorGetLoader:
+        LOG_CRITICAL(Frontend, "Failed to obtain loader for {}!", filepath);
+        return -1;
+    case Core::System::ResultStatus::ErrorLoader:
+        LOG_CRITICAL(Frontend, "Failed to load ROM!");
+        return -1;
+    case Core::System::ResultStatus::ErrorLoader_ErrorEncrypted:
+        LOG_CRITICAL(Frontend, "The game that you are trying to load must be decrypted before "
+                               "being used with Citra.");
+        return -1;
+    case Core::System::ResultStatus::ErrorLoader_ErrorInvalidFormat:
+        LOG_CRITICAL(Frontend, "Error while loading ROM: The ROM format is not supported.");
+        return -1;
+    case Core::System::ResultStatus::ErrorNotInitialized:
+        LOG_CRITICAL(Frontend, "CPUCore not initialized");
+        return -1;
+    case Core::System::ResultStatus::ErrorSystemMode:
+        LOG_CRITICAL(Frontend, "Failed to determine system mode!");
+        return -1;
+    case Core::System::ResultStatus::ErrorVideoCore:
+        LOG_CRITICAL(Frontend, "VideoCore not initialized");
+        return -1;
+    case Core::System::ResultStatus::Success:
+        break; // Expected case
+    default:
+        LOG_CRITICAL(Frontend, "Failed to load ROM: {}", static_cast<u32>(load_result));
+        return -1;
+    }
+
+    system.TelemetrySession().AddField(Telemetry::FieldType::App, "Frontend", "Headless");
+
+    if (!profile_trace.empty()) {
+        Common::MicroProfileTrace::Start(profile_trace, profile_first_frame, profile_num_frames);
+    }
+
+    std::atomic<bool> finished{false};
+    std::vector<VideoCore::RendererNull::ScreenHashes> frame_hashes;
+    std::vector<Checkpoint> checkpoints;
+    std::chrono::steady_clock::time_point start_time;
+    const auto add_checkpoint = [&] {
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_time;
+        checkpoints.push_back({frame_hashes.size(), elapsed.count(), frame_hashes.back()});
+        std::cerr << FormatCheckpoint(checkpoints.back()) << std::flush;
+    };
+    auto& renderer = static_cast<VideoCore::RendererNull&>(*VideoCore::g_renderer);
+    renderer.SetFrameCallback(
+        [&](int frame, const VideoCore::RendererNull::ScreenHashes& hashes) {
+            frame_hashes.push_back(hashes);
+            if (checkpoint_interval != 0 && frame_hashes.size() % checkpoint_interval == 0) {
+                add_checkpoint();
+            }
+            if (max_frames != 0 && frame_hashes.size() >= max_frames) {
+                finished = true;
+            }
+        });
+
+    if (!movie_play.empty()) {
+        Core::Movie::GetInstance().StartPlayback(movie_play, [&finished] { finished = true; });
+    }
+
+    if (benchmark || !output.empty()) {
+        // The summary and the results include the time spent in each frame section
+        system.perf_stats->SetSectionTimingEnabled(true);
+    }
+
+    // Discard whatever was accumulated while loading
+    system.GetAndResetPerfStats();
+    start_time = std::chrono::steady_clock::now();
+
+    int exit_code = 0;
+    while (!finished) {
+        const Core::System::ResultStatus result = system.RunLoop();
+        if (result == Core::System::ResultStatus::ShutdownRequested) {
+            LOG_INFO(Frontend, "Emulated program requested a shutdown");
+            break;
+        }
+        if (result != Core::System::ResultStatus::Success) {
+            LOG_CRITICAL(Frontend, "Emulation stopped with error {}", static_cast<u32>(result));
+            exit_code = -1;
+            break;
+        }
+    }
+
+    if (checkpoint_interval != 0 && !frame_hashes.empty() &&
+        (checkpoints.empty() || checkpoints.back().frame != frame_hashes.size())) {
+        add_checkpoint();
+    }
+
+    const std::chrono::duration<double> wall_time = std::chrono::steady_clock::now() - start_time;
+    const Core::PerfStats::Results stats = system.GetAndResetPerfStats();
+    const Core::PerfStats::FrameTimeSummary summary = system.perf_stats->GetFrameTimeSummary();
+    renderer.SetFrameCallback(nullptr);
+
+    LOG_INFO(Frontend, "Ran {} frames in {:.3f} s ({:.2f} fps)", frame_hashes.size(),
+             wall_time.count(),
+             wall_time.count() > 0.0 ? frame_hashes.size() / wall_time.count() : 0.0);
+
+    if (benchmark) {
+        // stdout may be taken by the JSON output
+        std::cerr << FormatSummary(summary);
+    }
+
+    if (!output.empty()) {
+        const std::string json =
+            FormatResults(filepath, wall_time.count(), stats, summary, checkpoints, frame_hashes);
+        if (output == "-") {
+            std::cout << json;
+        } else if (FileUtil::WriteStringToFile(true, output, json) != json.size()) {
+            LOG_ERROR(Frontend, "Failed to write results to {}", output);
+            exit_code = -1;
+        }
+    }
+
+    Core::Movie::GetInstance().Shutdown();
+    system.Shutdown();
+
+    detached_tasks.WaitForAllTasks();
+    return exit_code;
+}
@@ -0,0 +1,221 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <fmt/format.h>
+
+// This needs to be included before getopt.h because the latter #defines symbols used by it
+#include "common/microprofile.h"
+
+#include "citra_headless/emu_window_headless.h"
+#include "common/file_util.h"
+#include "common/logging/backend.h"
+#include "common/logging/filter.h"
+#include "common/logging/log.h"
+#include "common/scm_rev.h"
+#include "common/scope_exit.h"
+#include "core/hw/gpu.h"
+#include "core/memory.h"
+#include "core/settings.h"
+#include "core/tracer/player.h"
+#include "video_core/renderer_base.h"
+#include "video_core/renderer_null/renderer_null.h"
+#include "video_core/video_core.h"
+
+#undef _UNICODE
+#include <getopt.h>
+#ifndef _MSC_VER
+#include <unistd.h>
+#endif
+
+static void PrintHelp(const char* argv0) {
+    std::cout << "Usage: " << argv0
+              << " [options] <trace.ctf>\n"
+                 "Replays a CiTrace through the software rasterizer and reports frame timings.\n"
+                 "-n, --iterations=NUMBER    Replay the trace NUMBER times (default 1)\n"
+                 "-j, --shader-jit           Use the shader JIT instead of the interpreter\n"
+                 "-o, --output=[file]        Write frame timings and hashes as JSON to the given"
+                 " file, or - for stdout\n"
+                 "-h, --help                 Display this help and exit\n"
+                 "-v, --version              Output version information and exit\n";
+}
+
+static void PrintVersion() {
+    std::cout << "Citra " << Common::g_scm_branch << " " << Common::g_scm_desc << std::endl;
+}
+
+namespace {
+struct FrameResult {
+    VideoCore::RendererNull::ScreenHashes hashes{};
+    /// Wall time spent on this frame in every iteration, in milliseconds
+    std::vector<double> times;
+};
+} // Anonymous namespace
+
+static std::string FormatResults(const std::vector<FrameResult>& frames,
+                                 const std::vector<double>& iteration_times,
+                                 std::size_t hash_mismatches) {
+    std::string json = "{\n";
+    json += fmt::format("  \"version\": \"{} {}\",\n", Common::g_scm_branch, Common::g_scm_desc);
+    json += fmt::format("  \"hash_mismatches\": {},\n", hash_mismatches);
+    json += "  \"iteration_times\": [";
+    for (std::size_t i = 0; i < iteration_times.size(); ++i) {
+        json += fmt::format("{}{:.3f}", i == 0 ? "" : ", ", iteration_times[i]);
+    }
+    json += "],\n";
+    json += "  \"frames\": [";
+    for (std::size_t i = 0; i < frames.size(); ++i) {
+        const auto& frame = frames[i];
+        json += fmt::format("{}\n    {{\"hashes\": [\"{:016x}\", \"{:016x}\"], \"times\": [",
+                            i == 0 ? "" : ",", frame.hashes[0], frame.hashes[1]);
+        for (std::size_t j = 0; j < frame.times.size(); ++j) {
+            json += fmt::format("{}{:.3f}", j == 0 ? "" : ", ", frame.times[j]);
+        }
+        json += "]}";
+    }
+    json += frames.empty() ? "]\n" : "\n  ]\n";
+    json += "}\n";
+    return json;
+}
+
+/// Application entry point
+int main(int argc, char** argv) {
+    int option_index = 0;
+    u64 iterations = 1;
+    bool use_shader_jit = false;
+    std::string output;
+    std::string filepath;
+
+    Log::Filter log_filter(Log::Level::Info);
+    Log::SetGlobalFilter(log_filter);
+    Log::AddBackend(std::make_unique<Log::ColorConsoleBackend>());
+
+    char* endarg;
+    static struct option long_options[] = {
+        {"iterations", required_argument, 0, 'n'}, {"shader-jit", no_argument, 0, 'j'},
+        {"output", required_argument, 0, 'o'},     {"help", no_argument, 0, 'h'},
+        {"version", no_argument, 0, 'v'},          {0, 0, 0, 0},
+    };
+
+    while (optind < argc) {
+        int arg = getopt_long(argc, argv, "n:jo:hv", long_options, &option_index);
+        if (arg != -1) {
+            switch (static_cast<char>(arg)) {
+            case 'n':
+                errno = 0;
+                iterations = strtoull(optarg, &endarg, 0);
+                if (endarg == optarg || iterations == 0)
+                    errno = EINVAL;
+                if (errno != 0) {
+                    perror("--iterations");
+                    exit(1);
+                }
+                break;
+            case 'j':
+                use_shader_jit = true;
+                break;
+            case 'o':
+                output = optarg;
+                break;
+            case 'h':
+                PrintHelp(argv[0]);
+                return 0;
+            case 'v':
+                PrintVersion();
+                return 0;
+            }
+        } else {
+            filepath = argv[optind];
+            optind++;
+        }
+    }
+
+    MicroProfileOnThreadCreate("EmuThread");
+    SCOPE_EXIT({ MicroProfileShutdown(); });
+
+    if (filepath.empty()) {
+        LOG_CRITICAL(Frontend, "No CiTrace file specified");
+        return -1;
+    }
+
+    Settings::values.use_null_renderer = true;
+    Settings::values.use_hw_renderer = false;
+    Settings::values.use_shader_jit = use_shader_jit;
+    Settings::Apply();
+
+    // Only the GPU and the video core are brought up, there is no emulated system
+    Memory::MemorySystem memory;
+    GPU::g_memory = &memory;
+    EmuWindow_Headless emu_window;
+    if (VideoCore::Init(emu_window, memory) != Core::System::ResultStatus::Success) {
+        LOG_CRITICAL(Frontend, "VideoCore not initialized");
+        return -1;
+    }
+    SCOPE_EXIT({ VideoCore::Shutdown(); });
+
+    CiTrace::Player player(memory);
+    if (!player.Load(filepath)) {
+        LOG_CRITICAL(Frontend, "Failed to load CiTrace {}", filepath);
+        return -1;
+    }
+
+    using Clock = std::chrono::steady_clock;
+    using Milliseconds = std::chrono::duration<double, std::milli>;
+
+    std::vector<FrameResult> frames(player.GetFrameCount());
+    std::vector<double> iteration_times;
+    std::size_t hash_mismatches = 0;
+
+    for (u64 iteration = 0; iteration < iterations; ++iteration) {
+        Milliseconds iteration_time{};
+        auto frame_start = Clock::now();
+        player.Replay([&](std::size_t frame) {
+            VideoCore::g_renderer->Rasterizer()->FlushAll();
+            const auto frame_end = Clock::now();
+            const Milliseconds frame_time = frame_end - frame_start;
+            iteration_time += frame_time;
+
+            // Hashing is not part of the measured frame time
+            auto& result = frames[frame];
+            const auto hashes = VideoCore::RendererNull::HashScreens();
+            if (iteration == 0) {
+                result.hashes = hashes;
+            } else if (hashes != result.hashes) {
+                LOG_WARNING(Frontend, "Frame {} differs from the first iteration in iteration {}",
+                            frame, iteration);
+                ++hash_mismatches;
+            }
+            result.times.push_back(frame_time.count());
+
+            frame_start = Clock::now();
+        });
+        iteration_times.push_back(iteration_time.count());
+
+        LOG_INFO(Frontend, "Iteration {}: {} frames in {:.3f} ms", iteration, frames.size(),
+                 iteration_time.count());
+    }
+
+    if (!iteration_times.empty() && !frames.empty()) {
+        const auto [min, max] = std::minmax_element(iteration_times.begin(), iteration_times.end());
+        LOG_INFO(Frontend, "Fastest iteration {:.3f} ms ({:.3f} ms/frame), slowest {:.3f} ms", *min,
+                 *min / frames.size(), *max);
+    }
+
+    if (!output.empty()) {
+        const std::string json = FormatResults(frames, iteration_times, hash_mismatches);
+        if (output == "-") {
+            std::cout << json;
+        } else if (FileUtil::WriteStringToFile(true, output, json) != json.size()) {
+            LOG_ERROR(Frontend, "Failed to write results to {}", output);
+            return -1;
+        }
+    }
+
+    return hash_mismatches == 0 ? 0 : 1;
+}
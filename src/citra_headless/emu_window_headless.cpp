@@ -0,0 +1,13 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include "citra_headless/emu_window_headless.h"
+#include "core/frontend/framebuffer_layout.h"
+
+EmuWindow_Headless::EmuWindow_Headless() {
+    // The layout is never drawn, but the core still queries it for touch input and scaling
+    NotifyFramebufferLayoutChanged(Layout::FrameLayoutFromResolutionScale(1));
+}
+
+EmuWindow_Headless::~EmuWindow_Headless() = default;
@@ -0,0 +1,23 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include "core/frontend/emu_window.h"
+
+/// Window without a display or graphics context, to be used together with the null renderer
+class EmuWindow_Headless : public Frontend::EmuWindow {
+public:
+    EmuWindow_Headless();
+    ~EmuWindow_Headless() override;
+
+    /// There are no window events to poll
+    void PollEvents() override {}
+
+    /// There is no graphics context to make current
+    void MakeCurrent() override {}
+
+    /// There is no graphics context to release
+    void DoneCurrent() override {}
+};
@@ -239,6 +239,10 @@ void Config::ReadUtilityValues() {
     Settings::values.dump_textures = ReadSetting("dump_textures", false).toBool();
     Settings::values.custom_textures = ReadSetting("custom_textures", false).toBool();
     Settings::values.preload_textures = ReadSetting("preload_textures", false).toBool();
+    Settings::values.video_dumping_queue_size =
+        ReadSetting("video_dumping_queue_size", 4).toUInt();
+    Settings::values.video_dumping_drop_frames =
+        ReadSetting("video_dumping_drop_frames", false).toBool();
 
     qt_config->endGroup();
 }
@@ -265,6 +269,8 @@ void Config::ReadDebuggingValues() {
     // Intentionally not using the QT default setting as this is intended to be changed in the ini
     Settings::values.record_frame_times =
         qt_config->value(QStringLiteral("record_frame_times"), false).toBool();
+    Settings::values.record_call_stats =
+        qt_config->value(QStringLiteral("record_call_stats"), false).toBool();
     Settings::values.use_gdbstub = ReadSetting(QStringLiteral("use_gdbstub"), false).toBool();
     Settings::values.gdbstub_port = ReadSetting(QStringLiteral("gdbstub_port"), 24689).toInt();
 
@@ -430,6 +436,9 @@ void Config::ReadRendererValues() {
     Settings::values.shaders_accurate_mul =
         ReadSetting(QStringLiteral("shaders_accurate_mul"), false).toBool();
     Settings::values.use_shader_jit = ReadSetting(QStringLiteral("use_shader_jit"), true).toBool();
+    Settings::values.use_async_gpu = ReadSetting(QStringLiteral("use_async_gpu"), false).toBool();
+    Settings::values.use_vertex_buffer_cache =
+        ReadSetting(QStringLiteral("use_vertex_buffer_cache"), true).toBool();
     Settings::values.use_vsync_new = ReadSetting(QStringLiteral("use_vsync_new"), true).toBool();
     Settings::values.resolution_factor =
         static_cast<u16>(ReadSetting(QStringLiteral("resolution_factor"), 1).toInt());
@@ -713,6 +722,8 @@ void Config::SaveUtilityValues() {
     WriteSetting("dump_textures", Settings::values.dump_textures, false);
     WriteSetting("custom_textures", Settings::values.custom_textures, false);
     WriteSetting("preload_textures", Settings::values.preload_textures, false);
+    WriteSetting("video_dumping_queue_size", Settings::values.video_dumping_queue_size, 4);
+    WriteSetting("video_dumping_drop_frames", Settings::values.video_dumping_drop_frames, false);
 
     qt_config->endGroup();
 }
@@ -738,6 +749,7 @@ void Config::SaveDebuggingValues() {
 
     // Intentionally not using the QT default setting as this is intended to be changed in the ini
     qt_config->setValue(QStringLiteral("record_frame_times"), Settings::values.record_frame_times);
+    qt_config->setValue(QStringLiteral("record_call_stats"), Settings::values.record_call_stats);
     WriteSetting(QStringLiteral("use_gdbstub"), Settings::values.use_gdbstub, false);
     WriteSetting(QStringLiteral("gdbstub_port"), Settings::values.gdbstub_port, 24689);
 
@@ -859,6 +871,9 @@ void Config::SaveRendererValues() {
     WriteSetting(QStringLiteral("shaders_accurate_mul"), Settings::values.shaders_accurate_mul,
                  false);
     WriteSetting(QStringLiteral("use_shader_jit"), Settings::values.use_shader_jit, true);
+    WriteSetting(QStringLiteral("use_async_gpu"), Settings::values.use_async_gpu, false);
+    WriteSetting(QStringLiteral("use_vertex_buffer_cache"),
+                 Settings::values.use_vertex_buffer_cache, true);
     WriteSetting(QStringLiteral("use_vsync_new"), Settings::values.use_vsync_new, true);
     WriteSetting(QStringLiteral("resolution_factor"), Settings::values.resolution_factor, 1);
     WriteSetting(QStringLiteral("use_frame_limit"), Settings::values.use_frame_limit, true);
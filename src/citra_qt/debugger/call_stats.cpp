@@ -0,0 +1,170 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <QCheckBox>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QPushButton>
+#include <QTabWidget>
+#include <QTimer>
+#include <QTreeWidget>
+#include <QVBoxLayout>
+#include "citra_qt/debugger/call_stats.h"
+#include "core/core.h"
+#include "core/hle/kernel/call_stats.h"
+#include "core/hle/kernel/kernel.h"
+
+static QTreeWidget* CreateStatsView(const QStringList& name_columns) {
+    QTreeWidget* view = new QTreeWidget;
+    view->setRootIsDecorated(false);
+    view->setSortingEnabled(true);
+    view->setHeaderLabels(name_columns +
+                          QStringList{QObject::tr("Calls"), QObject::tr("Total (ms)"),
+                                      QObject::tr("Mean (us)"), QObject::tr("Min (us)"),
+                                      QObject::tr("Max (us)")});
+    view->sortByColumn(name_columns.size() + 1, Qt::DescendingOrder);
+    return view;
+}
+
+/// Item that sorts numeric columns by value instead of by text
+class CallStatsItem : public QTreeWidgetItem {
+public:
+    CallStatsItem(const QStringList& names, const Kernel::CallStats::Entry& stats)
+        : QTreeWidgetItem(names), first_stat_column(names.size()) {
+        const double mean_us = static_cast<double>(stats.total_ns) / stats.count / 1000.0;
+        SetValue(0, static_cast<double>(stats.count), QString::number(stats.count));
+        SetValue(1, stats.total_ns / 1000000.0,
+                 QString::number(stats.total_ns / 1000000.0, 'f', 3));
+        SetValue(2, mean_us, QString::number(mean_us, 'f', 2));
+        SetValue(3, stats.min_ns / 1000.0, QString::number(stats.min_ns / 1000.0, 'f', 2));
+        SetValue(4, stats.max_ns / 1000.0, QString::number(stats.max_ns / 1000.0, 'f', 2));
+    }
+
+    bool operator<(const QTreeWidgetItem& other) const override {
+        const int column = treeWidget()->sortColumn();
+        if (column < first_stat_column) {
+            return QTreeWidgetItem::operator<(other);
+        }
+        return data(column, Qt::UserRole).toDouble() < other.data(column, Qt::UserRole).toDouble();
+    }
+
+private:
+    void SetValue(int stat, double value, const QString& text) {
+        setText(first_stat_column + stat, text);
+        setData(first_stat_column + stat, Qt::UserRole, value);
+        setTextAlignment(first_stat_column + stat, Qt::AlignRight);
+    }
+
+    int first_stat_column;
+};
+
+CallStatsWidget::CallStatsWidget(QWidget* parent)
+    : QDockWidget(tr("HLE Call Statistics"), parent) {
+    setObjectName(QStringLiteral("CallStatsWidget"));
+
+    enabled = new QCheckBox(tr("Enabled"));
+    QPushButton* reset_button = new QPushButton(tr("Reset"));
+    QHBoxLayout* controls_layout = new QHBoxLayout;
+    controls_layout->addWidget(enabled);
+    controls_layout->addStretch();
+    controls_layout->addWidget(reset_button);
+
+    services = CreateStatsView({tr("Service"), tr("Function"), tr("Header")});
+    svcs = CreateStatsView({tr("SVC"), tr("ID")});
+    QTabWidget* tabs = new QTabWidget;
+    tabs->addTab(services, tr("Services"));
+    tabs->addTab(svcs, tr("SVCs"));
+
+    QVBoxLayout* main_layout = new QVBoxLayout;
+    main_layout->addLayout(controls_layout);
+    main_layout->addWidget(tabs);
+    QWidget* main_widget = new QWidget;
+    main_widget->setLayout(main_layout);
+    setWidget(main_widget);
+
+    refresh_timer = new QTimer(this);
+    refresh_timer->setInterval(1000);
+
+    connect(enabled, &QCheckBox::toggled, this, &CallStatsWidget::SetEnabled);
+    connect(reset_button, &QPushButton::clicked, this, &CallStatsWidget::Reset);
+    connect(refresh_timer, &QTimer::timeout, this, &CallStatsWidget::Refresh);
+    connect(this, &QDockWidget::visibilityChanged, [this](bool visible) {
+        if (visible && emulation_running) {
+            Refresh();
+            refresh_timer->start();
+        } else {
+            refresh_timer->stop();
+        }
+    });
+}
+
+CallStatsWidget::~CallStatsWidget() = default;
+
+void CallStatsWidget::OnEmulationStarting() {
+    emulation_running = true;
+    services->clear();
+    svcs->clear();
+
+    // Recording may also have been enabled from the configuration file
+    auto& call_stats = Core::System::GetInstance().Kernel().GetCallStats();
+    if (enabled->isChecked()) {
+        call_stats.SetEnabled(true);
+    } else {
+        enabled->setChecked(call_stats.IsEnabled());
+    }
+
+    if (isVisible()) {
+        refresh_timer->start();
+    }
+}
+
+void CallStatsWidget::OnEmulationStopping() {
+    // Keep the last stats visible after the emulation stops
+    Refresh();
+    emulation_running = false;
+    refresh_timer->stop();
+}
+
+void CallStatsWidget::SetEnabled(bool enabled) {
+    if (emulation_running) {
+        Core::System::GetInstance().Kernel().GetCallStats().SetEnabled(enabled);
+    }
+}
+
+void CallStatsWidget::Reset() {
+    if (emulation_running) {
+        Core::System::GetInstance().Kernel().GetCallStats().Reset();
+    }
+    services->clear();
+    svcs->clear();
+}
+
+void CallStatsWidget::Refresh() {
+    if (!emulation_running) {
+        return;
+    }
+
+    const auto& call_stats = Core::System::GetInstance().Kernel().GetCallStats();
+
+    services->setSortingEnabled(false);
+    services->clear();
+    for (const auto& entry : call_stats.GetServiceCallStats()) {
+        services->addTopLevelItem(new CallStatsItem(
+            {QString::fromStdString(entry.service_name),
+             QString::fromStdString(entry.function_name),
+             QStringLiteral("0x%1").arg(entry.header, 8, 16, QLatin1Char('0'))},
+            entry.stats));
+    }
+    services->setSortingEnabled(true);
+
+    svcs->setSortingEnabled(false);
+    svcs->clear();
+    for (const auto& entry : call_stats.GetSVCStats()) {
+        svcs->addTopLevelItem(new CallStatsItem(
+            {QString::fromStdString(entry.name),
+             QStringLiteral("0x%1").arg(entry.id, 2, 16, QLatin1Char('0'))},
+            entry.stats));
+    }
+    svcs->setSortingEnabled(true);
+}
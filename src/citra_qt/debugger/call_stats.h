@@ -0,0 +1,34 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <QDockWidget>
+
+class QCheckBox;
+class QTimer;
+class QTreeWidget;
+
+/// Shows the call counts and host time of HLE service commands and SVCs
+class CallStatsWidget : public QDockWidget {
+    Q_OBJECT
+
+public:
+    explicit CallStatsWidget(QWidget* parent = nullptr);
+    ~CallStatsWidget();
+
+    void OnEmulationStarting();
+    void OnEmulationStopping();
+
+private:
+    void SetEnabled(bool enabled);
+    void Reset();
+    void Refresh();
+
+    QCheckBox* enabled;
+    QTreeWidget* services;
+    QTreeWidget* svcs;
+    QTimer* refresh_timer;
+    bool emulation_running = false;
+};
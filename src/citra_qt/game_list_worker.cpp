@@ -2,12 +2,19 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <condition_variable>
 #include <memory>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
+#include <QDataStream>
+#include <QDateTime>
 #include <QDir>
+#include <QFile>
 #include <QFileInfo>
+#include <QSaveFile>
 #include "citra_qt/compatibility_list.h"
 #include "citra_qt/game_list.h"
 #include "citra_qt/game_list_p.h"
@@ -20,10 +27,34 @@
 #include "core/loader/loader.h"
 
 namespace {
+/// Version of the on-disk game list cache, bump when the entry layout changes.
+constexpr quint32 CACHE_VERSION = 1;
+
 bool HasSupportedFileExtension(const std::string& file_name) {
     const QFileInfo file = QFileInfo(QString::fromStdString(file_name));
     return GameList::supported_file_extensions.contains(file.suffix(), Qt::CaseInsensitive);
 }
+
+bool IsUpdatableTitle(u64 program_id) {
+    return program_id >= 0x0004000000000000 && program_id <= 0x00040000FFFFFFFF;
+}
+
+std::string GetUpdatePath(u64 program_id) {
+    return Service::AM::GetTitleContentPath(Service::FS::MediaType::SDMC,
+                                            program_id + 0x0000000E00000000);
+}
+
+/// Returns the modification time of the file in milliseconds, or 0 if it doesn't exist.
+qint64 GetModificationTime(const std::string& path) {
+    const QFileInfo file_info(QString::fromStdString(path));
+    if (!file_info.exists())
+        return 0;
+    return file_info.lastModified().toMSecsSinceEpoch();
+}
+
+std::string GetCachePath() {
+    return FileUtil::GetUserPath(FileUtil::UserPath::CacheDir) + "game_list" DIR_SEP "cache.bin";
+}
 } // Anonymous namespace
 
 GameListWorker::GameListWorker(QVector<UISettings::GameDir>& game_dirs,
@@ -45,81 +76,204 @@ void GameListWorker::AddFstEntriesToGameList(const std::string& dir_path, unsign
         const std::string physical_name = directory + DIR_SEP + virtual_name;
         const bool is_dir = FileUtil::IsDirectory(physical_name);
         if (!is_dir && HasSupportedFileExtension(physical_name)) {
-            std::unique_ptr<Loader::AppLoader> loader = Loader::GetLoader(physical_name);
-            if (!loader)
-                return true;
+            scan_jobs.push_back({physical_name, parent_dir});
+        } else if (is_dir && recursion > 0) {
+            watch_list.append(QString::fromStdString(physical_name));
+            AddFstEntriesToGameList(physical_name, recursion - 1, parent_dir);
+        }
 
-            bool executable = false;
-            loader->IsExecutable(executable);
-            if (!executable)
-                return true;
+        return true;
+    };
 
-            u64 program_id = 0;
-            loader->ReadProgramId(program_id);
+    FileUtil::ForeachDirectoryEntry(nullptr, dir_path, callback);
+}
 
-            u64 extdata_id = 0;
-            loader->ReadExtdataId(extdata_id);
+GameListCacheEntry GameListWorker::ScanFile(const std::string& physical_name) {
+    const QFileInfo file_info(QString::fromStdString(physical_name));
 
-            std::vector<u8> smdh = [program_id, &loader]() -> std::vector<u8> {
-                std::vector<u8> original_smdh;
-                loader->ReadIcon(original_smdh);
+    GameListCacheEntry entry;
+    entry.size = static_cast<u64>(file_info.size());
+    entry.modified = file_info.lastModified().toMSecsSinceEpoch();
 
-                if (program_id < 0x0004000000000000 || program_id > 0x00040000FFFFFFFF)
-                    return original_smdh;
+    const auto cached = cache.find(physical_name);
+    if (cached != cache.end() && cached->second.size == entry.size &&
+        cached->second.modified == entry.modified) {
+        // The update title is checked separately, it can be installed or removed without the
+        // game itself changing.
+        const u64 program_id = cached->second.program_id;
+        if (!cached->second.executable || !IsUpdatableTitle(program_id) ||
+            GetModificationTime(GetUpdatePath(program_id)) == cached->second.update_modified) {
+            return cached->second;
+        }
+    }
+
+    std::unique_ptr<Loader::AppLoader> loader = Loader::GetLoader(physical_name);
+    if (!loader)
+        return entry;
 
-                std::string update_path = Service::AM::GetTitleContentPath(
-                    Service::FS::MediaType::SDMC, program_id + 0x0000000E00000000);
+    loader->IsExecutable(entry.executable);
+    if (!entry.executable)
+        return entry;
 
-                if (!FileUtil::Exists(update_path))
-                    return original_smdh;
+    loader->ReadProgramId(entry.program_id);
+    loader->ReadExtdataId(entry.extdata_id);
+    entry.file_type = static_cast<u32>(loader->GetFileType());
 
-                std::unique_ptr<Loader::AppLoader> update_loader = Loader::GetLoader(update_path);
+    std::vector<u8> smdh;
+    loader->ReadIcon(smdh);
 
-                if (!update_loader)
-                    return original_smdh;
+    if (IsUpdatableTitle(entry.program_id)) {
+        const std::string update_path = GetUpdatePath(entry.program_id);
+        entry.update_modified = GetModificationTime(update_path);
 
+        if (entry.update_modified != 0) {
+            std::unique_ptr<Loader::AppLoader> update_loader = Loader::GetLoader(update_path);
+            if (update_loader) {
                 std::vector<u8> update_smdh;
                 update_loader->ReadIcon(update_smdh);
-                return update_smdh;
-            }();
+                smdh = std::move(update_smdh);
+            }
+        }
+    }
+
+    entry.smdh =
+        QByteArray(reinterpret_cast<const char*>(smdh.data()), static_cast<int>(smdh.size()));
+    return entry;
+}
+
+void GameListWorker::EmitEntry(const ScanJob& job, const GameListCacheEntry& entry) {
+    if (!entry.executable)
+        return;
+
+    const std::vector<u8> smdh(entry.smdh.begin(), entry.smdh.end());
+    if (!Loader::IsValidSMDH(smdh) && UISettings::values.game_list_hide_no_icon) {
+        // Skip this invalid entry
+        return;
+    }
+
+    auto it = FindMatchingCompatibilityEntry(compatibility_list, entry.program_id);
 
-            if (!Loader::IsValidSMDH(smdh) && UISettings::values.game_list_hide_no_icon) {
-                // Skip this invalid entry
-                return true;
+    // The game list uses this as compatibility number for untested games
+    QString compatibility(QStringLiteral("99"));
+    if (it != compatibility_list.end())
+        compatibility = it->second.first;
+
+    const auto file_type = static_cast<Loader::FileType>(entry.file_type);
+    emit EntryReady(
+        {
+            new GameListItemPath(QString::fromStdString(job.physical_name), smdh, entry.program_id,
+                                 entry.extdata_id),
+            new GameListItemCompat(compatibility),
+            new GameListItemRegion(smdh),
+            new GameListItem(QString::fromStdString(Loader::GetFileTypeString(file_type))),
+            new GameListItemSize(entry.size),
+        },
+        job.parent_dir);
+}
+
+void GameListWorker::ProcessScanJobs() {
+    // Opening the files is mostly waiting on I/O, especially for libraries on network shares, so
+    // use more threads than there are cores.
+    const std::size_t num_threads = std::min<std::size_t>(
+        scan_jobs.size(), std::max(4u, std::thread::hardware_concurrency() * 2));
+
+    std::vector<GameListCacheEntry> results(scan_jobs.size());
+    std::vector<bool> done(scan_jobs.size());
+    std::mutex done_mutex;
+    std::condition_variable done_cv;
+    std::atomic<std::size_t> next_job{0};
+
+    const auto scan_thread = [&] {
+        for (std::size_t i = next_job++; i < scan_jobs.size(); i = next_job++) {
+            if (!stop_processing) {
+                results[i] = ScanFile(scan_jobs[i].physical_name);
+                std::lock_guard lock{new_cache_mutex};
+                new_cache.emplace(scan_jobs[i].physical_name, results[i]);
             }
 
-            auto it = FindMatchingCompatibilityEntry(compatibility_list, program_id);
-
-            // The game list uses this as compatibility number for untested games
-            QString compatibility(QStringLiteral("99"));
-            if (it != compatibility_list.end())
-                compatibility = it->second.first;
-
-            emit EntryReady(
-                {
-                    new GameListItemPath(QString::fromStdString(physical_name), smdh, program_id,
-                                         extdata_id),
-                    new GameListItemCompat(compatibility),
-                    new GameListItemRegion(smdh),
-                    new GameListItem(
-                        QString::fromStdString(Loader::GetFileTypeString(loader->GetFileType()))),
-                    new GameListItemSize(FileUtil::GetSize(physical_name)),
-                },
-                parent_dir);
+            std::lock_guard lock{done_mutex};
+            done[i] = true;
+            done_cv.notify_one();
+        }
+    };
 
-        } else if (is_dir && recursion > 0) {
-            watch_list.append(QString::fromStdString(physical_name));
-            AddFstEntriesToGameList(physical_name, recursion - 1, parent_dir);
+    std::vector<std::thread> threads;
+    threads.reserve(num_threads);
+    for (std::size_t i = 0; i < num_threads; ++i) {
+        threads.emplace_back(scan_thread);
+    }
+
+    // The item models are created on this thread only, in the order the files were found.
+    for (std::size_t i = 0; i < scan_jobs.size(); ++i) {
+        {
+            std::unique_lock lock{done_mutex};
+            done_cv.wait(lock, [&] { return done[i]; });
+        }
+        if (!stop_processing) {
+            EmitEntry(scan_jobs[i], results[i]);
         }
+    }
 
-        return true;
-    };
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
 
-    FileUtil::ForeachDirectoryEntry(nullptr, dir_path, callback);
+void GameListWorker::LoadCache() {
+    QFile file(QString::fromStdString(GetCachePath()));
+    if (!file.open(QIODevice::ReadOnly))
+        return;
+
+    QDataStream stream(&file);
+    quint32 version;
+    stream >> version;
+    if (version != CACHE_VERSION)
+        return;
+
+    quint32 count;
+    stream >> count;
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        QString path;
+        GameListCacheEntry entry;
+        quint64 size, program_id, extdata_id;
+        stream >> path >> size >> entry.modified >> entry.update_modified >> entry.executable >>
+            program_id >> extdata_id >> entry.file_type >> entry.smdh;
+        entry.size = size;
+        entry.program_id = program_id;
+        entry.extdata_id = extdata_id;
+        cache.emplace(path.toStdString(), std::move(entry));
+    }
+
+    if (stream.status() != QDataStream::Ok) {
+        LOG_WARNING(Frontend, "Game list cache is corrupted, rescanning all files");
+        cache.clear();
+    }
+}
+
+void GameListWorker::SaveCache() const {
+    const std::string path = GetCachePath();
+    FileUtil::CreateFullPath(path);
+
+    QSaveFile file(QString::fromStdString(path));
+    if (!file.open(QIODevice::WriteOnly)) {
+        LOG_WARNING(Frontend, "Failed to write game list cache to {}", path);
+        return;
+    }
+
+    QDataStream stream(&file);
+    stream << CACHE_VERSION << static_cast<quint32>(new_cache.size());
+    for (const auto& [physical_name, entry] : new_cache) {
+        stream << QString::fromStdString(physical_name) << static_cast<quint64>(entry.size)
+               << entry.modified << entry.update_modified << entry.executable
+               << static_cast<quint64>(entry.program_id) << static_cast<quint64>(entry.extdata_id)
+               << entry.file_type << entry.smdh;
+    }
+    file.commit();
 }
 
 void GameListWorker::run() {
     stop_processing = false;
+    LoadCache();
     for (UISettings::GameDir& game_dir : game_dirs) {
         if (game_dir.path == QStringLiteral("INSTALLED")) {
             QString games_path =
@@ -154,6 +308,12 @@ void GameListWorker::run() {
                                     game_list_dir);
         }
     };
+
+    ProcessScanJobs();
+    if (!stop_processing) {
+        SaveCache();
+    }
+
     emit Finished(watch_list);
 }
 
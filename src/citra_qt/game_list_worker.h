@@ -7,8 +7,11 @@
 #include <atomic>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
+#include <vector>
+#include <QByteArray>
 #include <QList>
 #include <QObject>
 #include <QRunnable>
@@ -19,6 +22,22 @@
 
 class QStandardItem;
 
+/**
+ * Metadata of a scanned file, cached on disk so that unchanged files don't have to be opened
+ * again on the next scan. An entry is only reused if the size and modification time of the file,
+ * and of its update title if any, still match.
+ */
+struct GameListCacheEntry {
+    u64 size = 0;
+    qint64 modified = 0;
+    qint64 update_modified = 0; ///< Modification time of the update title, or 0 if absent
+    bool executable = false;
+    u64 program_id = 0;
+    u64 extdata_id = 0;
+    u32 file_type = 0;
+    QByteArray smdh;
+};
+
 /**
  * Asynchronous worker object for populating the game list.
  * Communicates with other threads through Qt's signal/slot system.
@@ -53,12 +72,36 @@ signals:
     void Finished(QStringList watch_list);
 
 private:
+    struct ScanJob {
+        std::string physical_name;
+        GameListDir* parent_dir;
+    };
+
     void AddFstEntriesToGameList(const std::string& dir_path, unsigned int recursion,
                                  GameListDir* parent_dir);
 
+    /// Reads the metadata of the file, from the cache if it is still up to date.
+    GameListCacheEntry ScanFile(const std::string& physical_name);
+
+    /// Scans all the queued files on a pool of threads and emits their entries in order.
+    void ProcessScanJobs();
+
+    void EmitEntry(const ScanJob& job, const GameListCacheEntry& entry);
+
+    void LoadCache();
+    void SaveCache() const;
+
     QVector<UISettings::GameDir>& game_dirs;
     const CompatibilityList& compatibility_list;
 
     QStringList watch_list;
     std::atomic_bool stop_processing;
+
+    std::vector<ScanJob> scan_jobs;
+
+    /// Entries loaded from the on-disk cache, only read while scanning.
+    std::unordered_map<std::string, GameListCacheEntry> cache;
+    /// Entries for the files found by this scan, written back to disk once it is done.
+    std::unordered_map<std::string, GameListCacheEntry> new_cache;
+    std::mutex new_cache_mutex;
 };
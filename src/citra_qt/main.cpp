@@ -32,6 +32,7 @@
 #include "citra_qt/compatibility_list.h"
 #include "citra_qt/configuration/config.h"
 #include "citra_qt/configuration/configure_dialog.h"
+#include "citra_qt/debugger/call_stats.h"
 #include "citra_qt/debugger/console.h"
 #include "citra_qt/debugger/graphics/graphics.h"
 #include "citra_qt/debugger/graphics/graphics_breakpoints.h"
@@ -348,6 +349,15 @@ void GMainWindow::InitializeDebugWidgets() {
     debug_menu->addAction(ipcRecorderWidget->toggleViewAction());
     connect(this, &GMainWindow::EmulationStarting, ipcRecorderWidget,
             &IPCRecorderWidget::OnEmulationStarting);
+
+    callStatsWidget = new CallStatsWidget(this);
+    addDockWidget(Qt::RightDockWidgetArea, callStatsWidget);
+    callStatsWidget->hide();
+    debug_menu->addAction(callStatsWidget->toggleViewAction());
+    connect(this, &GMainWindow::EmulationStarting, callStatsWidget,
+            &CallStatsWidget::OnEmulationStarting);
+    connect(this, &GMainWindow::EmulationStopping, callStatsWidget,
+            &CallStatsWidget::OnEmulationStopping);
 }
 
 void GMainWindow::InitializeRecentFileMenuActions() {
@@ -0,0 +1,150 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstdint>
+#include <cstring>
+#include "common/assert.h"
+#include "common/common_funcs.h"
+#include "common/logging/log.h"
+#include "common/memory_util.h"
+
+#ifdef _WIN32
+#include <windows.h>
+// windows.h needs to be included before psapi.h
+#include <psapi.h>
+#else
+#include <cstdio>
+#include <sys/mman.h>
+#include <unistd.h>
+#ifdef __APPLE__
+#include <mach/mach.h>
+#endif
+#endif
+
+namespace Common {
+
+namespace {
+std::size_t GetPageSize() {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwPageSize;
+#else
+    return static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+#endif
+}
+} // Anonymous namespace
+
+u8* AllocateMemoryPages(std::size_t size) {
+#ifdef _WIN32
+    void* ptr = VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    if (ptr == nullptr) {
+        LOG_CRITICAL(Common_Memory, "VirtualAlloc failed: {}", GetLastErrorMsg());
+    }
+#else
+    void* ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_ANON | MAP_PRIVATE, -1, 0);
+    if (ptr == MAP_FAILED) {
+        LOG_CRITICAL(Common_Memory, "mmap failed: {}", GetLastErrorMsg());
+        ptr = nullptr;
+    }
+#endif
+    ASSERT_MSG(ptr != nullptr, "Failed to allocate {} bytes", size);
+    return static_cast<u8*>(ptr);
+}
+
+void FreeMemoryPages(void* ptr, std::size_t size) {
+    if (ptr == nullptr)
+        return;
+
+#ifdef _WIN32
+    if (!VirtualFree(ptr, 0, MEM_RELEASE)) {
+        LOG_ERROR(Common_Memory, "VirtualFree failed: {}", GetLastErrorMsg());
+    }
+#else
+    if (munmap(ptr, size) != 0) {
+        LOG_ERROR(Common_Memory, "munmap failed: {}", GetLastErrorMsg());
+    }
+#endif
+}
+
+void DiscardMemoryPages(void* ptr, std::size_t size) {
+    static const std::size_t page_size = GetPageSize();
+
+    u8* const begin = static_cast<u8*>(ptr);
+    u8* const end = begin + size;
+    u8* const aligned_begin = reinterpret_cast<u8*>(
+        (reinterpret_cast<std::uintptr_t>(begin) + page_size - 1) & ~(page_size - 1));
+    u8* const aligned_end =
+        reinterpret_cast<u8*>(reinterpret_cast<std::uintptr_t>(end) & ~(page_size - 1));
+
+    if (aligned_begin >= aligned_end) {
+        // The range doesn't cover a single whole host page
+        std::memset(begin, 0, size);
+        return;
+    }
+
+    // Partial pages at either end might be shared with live data and have to be zeroed by hand
+    std::memset(begin, 0, aligned_begin - begin);
+    std::memset(aligned_end, 0, end - aligned_end);
+
+    const std::size_t aligned_size = aligned_end - aligned_begin;
+#ifdef _WIN32
+    // Decommitting and recommitting guarantees the pages read back as zero. In between, the range
+    // is inaccessible, so no other thread may touch it during this call.
+    if (!VirtualFree(aligned_begin, aligned_size, MEM_DECOMMIT)) {
+        // The pages are still committed and hold their old contents
+        LOG_ERROR(Common_Memory, "Failed to decommit memory: {}", GetLastErrorMsg());
+        std::memset(aligned_begin, 0, aligned_size);
+        return;
+    }
+    if (!VirtualAlloc(aligned_begin, aligned_size, MEM_COMMIT, PAGE_READWRITE)) {
+        // The range is gone now, and any later access to it would fault
+        UNREACHABLE_MSG("Failed to recommit {} bytes of discarded memory at {}: {}", aligned_size,
+                        static_cast<void*>(aligned_begin), GetLastErrorMsg());
+    }
+#elif defined(__linux__)
+    // On private anonymous mappings, the pages read back as zero after MADV_DONTNEED
+    if (madvise(aligned_begin, aligned_size, MADV_DONTNEED) != 0) {
+        LOG_ERROR(Common_Memory, "madvise failed: {}", GetLastErrorMsg());
+        std::memset(aligned_begin, 0, aligned_size);
+    }
+#else
+    // Other systems don't guarantee zeroed pages after madvise, map fresh ones over the range
+    if (mmap(aligned_begin, aligned_size, PROT_READ | PROT_WRITE,
+             MAP_ANON | MAP_PRIVATE | MAP_FIXED, -1, 0) == MAP_FAILED) {
+        LOG_ERROR(Common_Memory, "mmap failed: {}", GetLastErrorMsg());
+        std::memset(aligned_begin, 0, aligned_size);
+    }
+#endif
+}
+
+u64 GetResidentMemoryUsage() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return 0;
+    return counters.WorkingSetSize;
+#elif defined(__APPLE__)
+    mach_task_basic_info info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, reinterpret_cast<task_info_t>(&info),
+                  &count) != KERN_SUCCESS)
+        return 0;
+    return info.resident_size;
+#else
+    std::FILE* statm = std::fopen("/proc/self/statm", "r");
+    if (statm == nullptr)
+        return 0;
+
+    unsigned long long total_pages = 0;
+    unsigned long long resident_pages = 0;
+    const int matched = std::fscanf(statm, "%llu %llu", &total_pages, &resident_pages);
+    std::fclose(statm);
+    if (matched != 2)
+        return 0;
+    return resident_pages * GetPageSize();
+#endif
+}
+
+} // namespace Common
@@ -0,0 +1,34 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include "common/common_types.h"
+
+namespace Common {
+
+/**
+ * Allocates zero-initialized memory directly from the OS. The pages are only backed by physical
+ * memory once they are touched, so large buffers that are mostly unused stay cheap.
+ * @param size Size of the allocation, in bytes.
+ * @return Pointer to the allocation, aligned to the host page size.
+ */
+u8* AllocateMemoryPages(std::size_t size);
+
+/// Frees memory returned by AllocateMemoryPages.
+void FreeMemoryPages(void* ptr, std::size_t size);
+
+/**
+ * Zeroes a range of memory returned by AllocateMemoryPages, and gives the whole pages in it back
+ * to the OS. The range stays accessible, the pages are backed again when they are next touched.
+ * On Windows the pages are decommitted for the duration of the call, so the caller must make sure
+ * no other thread can access the range until it returns.
+ */
+void DiscardMemoryPages(void* ptr, std::size_t size);
+
+/// Returns the amount of physical memory currently used by this process, in bytes.
+u64 GetResidentMemoryUsage();
+
+} // namespace Common
@@ -0,0 +1,318 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include <fmt/format.h>
+#include "common/file_util.h"
+#include "common/logging/log.h"
+#include "common/microprofile.h"
+#include "common/microprofile_trace.h"
+
+namespace Common::MicroProfileTrace {
+
+bool ParseFrameRange(const std::string& range, u64& first_frame, u64& num_frames) {
+    const std::size_t separator = range.find(':');
+    try {
+        std::size_t parsed;
+        first_frame = std::stoull(range.substr(0, separator), &parsed);
+        if (parsed != std::min(separator, range.size())) {
+            return false;
+        }
+        num_frames = 0;
+        if (separator != std::string::npos) {
+            num_frames = std::stoull(range.substr(separator + 1), &parsed);
+            if (parsed != range.size() - separator - 1) {
+                return false;
+            }
+        }
+    } catch (const std::logic_error&) {
+        return false;
+    }
+    return true;
+}
+
+#if MICROPROFILE_ENABLED
+
+namespace {
+
+struct Scope {
+    u32 timer;
+    s64 begin;
+    s64 end;
+};
+
+struct ThreadState {
+    /// Position in the MicroProfile log of this thread up to which entries have been read
+    u32 read_position = 0;
+    bool seen = false;
+    std::string name;
+    /// Timer index and begin tick of the scopes currently entered
+    std::vector<std::pair<u32, s64>> stack;
+    std::vector<Scope> scopes;
+};
+
+struct Capture {
+    std::string path;
+    u64 first_frame;
+    u64 num_frames;
+    u64 frame = 0;
+
+    /// Reference for the 48 bit ticks in the MicroProfile log entries
+    MicroProfileLogEntry base_tick;
+    /// Ticks at which the captured frames start
+    std::vector<s64> frame_starts;
+    std::array<ThreadState, MICROPROFILE_MAX_THREADS> threads;
+
+    bool previous_force_enable;
+    bool previous_enable_all_groups;
+};
+
+std::atomic_bool running{false};
+std::mutex capture_mutex;
+std::unique_ptr<Capture> capture;
+
+s64 GetTick(const Capture& capture, MicroProfileLogEntry entry) {
+    return MicroProfileLogTickDifference(capture.base_tick, entry);
+}
+
+/// Reads the log entries of one thread that have been added since the last flip
+void ReadThreadLog(Capture& capture, ThreadState& thread, const MicroProfileThreadLog& log,
+                   bool capturing, s64 capture_begin) {
+    const u32 put = log.nPut.load(std::memory_order_acquire);
+    for (u32 i = thread.read_position; i != put; i = (i + 1) % MICROPROFILE_BUFFER_SIZE) {
+        const MicroProfileLogEntry entry = log.Log[i];
+        const u32 timer = static_cast<u32>(MicroProfileLogTimerIndex(entry));
+        switch (MicroProfileLogType(entry)) {
+        case MP_LOG_ENTER:
+            thread.stack.emplace_back(timer, GetTick(capture, entry));
+            break;
+        case MP_LOG_LEAVE: {
+            // Scopes that were entered before the capture started have no matching entry
+            auto it = thread.stack.rbegin();
+            while (it != thread.stack.rend() && it->first != timer) {
+                ++it;
+            }
+            if (it == thread.stack.rend()) {
+                break;
+            }
+            const s64 begin = it->second;
+            thread.stack.erase(std::prev(it.base()), thread.stack.end());
+            if (capturing && begin >= capture_begin) {
+                thread.scopes.push_back({timer, begin, GetTick(capture, entry)});
+            }
+            break;
+        }
+        default:
+            // Meta counters and GPU timestamps are not part of the trace
+            break;
+        }
+    }
+    thread.read_position = put;
+}
+
+std::string EscapeJSON(const char* string) {
+    std::string escaped;
+    for (; *string != '\0'; ++string) {
+        if (*string == '"' || *string == '\\') {
+            escaped += '\\';
+        }
+        escaped += *string;
+    }
+    return escaped;
+}
+
+void WriteTrace(const Capture& capture) {
+    FileUtil::IOFile file(capture.path, "w");
+    if (!file.IsOpen()) {
+        LOG_ERROR(Common, "Could not open {} to write the profiler trace", capture.path);
+        return;
+    }
+
+    const MicroProfile& profile = *MicroProfileGet();
+    const double ticks_to_us = 1000000.0 / MicroProfileTicksPerSecondCpu();
+
+    std::string json = "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+    bool first = true;
+    const auto add_event = [&json, &file, &first](const std::string& event) {
+        json += first ? "  " : ",\n  ";
+        json += event;
+        first = false;
+        // Flush regularly to keep the memory usage of long captures in check
+        if (json.size() >= 1024 * 1024) {
+            file.WriteString(json);
+            json.clear();
+        }
+    };
+
+    for (std::size_t i = 0; i < capture.frame_starts.size(); ++i) {
+        add_event(fmt::format(R"({{"name": "Frame {}", "ph": "i", "s": "g", "ts": {:.3f}, )"
+                              R"("pid": 0, "tid": 0}})",
+                              capture.first_frame + i, capture.frame_starts[i] * ticks_to_us));
+    }
+
+    for (std::size_t thread_index = 0; thread_index < capture.threads.size(); ++thread_index) {
+        const ThreadState& thread = capture.threads[thread_index];
+        if (thread.scopes.empty()) {
+            continue;
+        }
+
+        add_event(fmt::format(R"({{"name": "thread_name", "ph": "M", "pid": 0, "tid": {}, )"
+                              R"("args": {{"name": "{}"}}}})",
+                              thread_index, EscapeJSON(thread.name.c_str())));
+        for (const Scope& scope : thread.scopes) {
+            const MicroProfileTimerInfo& timer = profile.TimerInfo[scope.timer];
+            add_event(fmt::format(R"({{"name": "{}", "cat": "{}", "ph": "X", "ts": {:.3f}, )"
+                                  R"("dur": {:.3f}, "pid": 0, "tid": {}}})",
+                                  EscapeJSON(timer.pName),
+                                  EscapeJSON(profile.GroupInfo[timer.nGroupIndex].pName),
+                                  scope.begin * ticks_to_us,
+                                  (scope.end - scope.begin) * ticks_to_us, thread_index));
+        }
+    }
+
+    json += "\n]}\n";
+    file.WriteString(json);
+    LOG_INFO(Common, "Wrote the profiler trace of {} frames to {}", capture.frame_starts.size(),
+             capture.path);
+}
+
+/// Writes the trace and restores the MicroProfile state, capture_mutex must be held
+void Finish() {
+    running = false;
+    WriteTrace(*capture);
+    MicroProfileSetForceEnable(capture->previous_force_enable);
+    MicroProfileSetEnableAllGroups(capture->previous_enable_all_groups);
+    capture.reset();
+}
+
+} // Anonymous namespace
+
+void Start(const std::string& path, u64 first_frame, u64 num_frames) {
+    std::lock_guard lock{capture_mutex};
+    if (capture) {
+        LOG_WARNING(Common, "A profiler trace is already being captured");
+        return;
+    }
+
+    capture = std::make_unique<Capture>();
+    capture->path = path;
+    capture->first_frame = first_frame;
+    capture->num_frames = num_frames;
+    capture->base_tick = MP_LOG_TICK_MASK & MP_TICK();
+
+    {
+        std::lock_guard profile_lock{MicroProfileGetMutex()};
+        const MicroProfile& profile = *MicroProfileGet();
+        for (std::size_t i = 0; i < capture->threads.size(); ++i) {
+            if (const MicroProfileThreadLog* log = profile.Pool[i]) {
+                capture->threads[i].read_position = log->nPut.load(std::memory_order_acquire);
+                capture->threads[i].seen = true;
+            }
+        }
+    }
+
+    // Record all scopes, regardless of what the MicroProfile UI would show. This takes effect
+    // with the next flip.
+    capture->previous_force_enable = MicroProfileGetForceEnable();
+    capture->previous_enable_all_groups = MicroProfileGetEnableAllGroups();
+    MicroProfileSetForceEnable(true);
+    MicroProfileSetEnableAllGroups(true);
+
+    running = true;
+}
+
+void Stop() {
+    std::lock_guard lock{capture_mutex};
+    if (capture) {
+        Finish();
+    }
+}
+
+bool IsRunning() {
+    return running;
+}
+
+void OnFlip() {
+    if (!running.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    std::lock_guard lock{capture_mutex};
+    if (!capture) {
+        return;
+    }
+
+    const u64 frame = capture->frame++;
+    const bool capturing = frame >= capture->first_frame;
+    s64 capture_begin = 0;
+    if (capturing) {
+        if (capture->frame_starts.empty()) {
+            // The scopes read at this flip were recorded during the frame that just ended
+            capture->frame_starts.push_back(0);
+        }
+        capture_begin = capture->frame_starts.front();
+    }
+
+    {
+        std::lock_guard profile_lock{MicroProfileGetMutex()};
+        const MicroProfile& profile = *MicroProfileGet();
+        for (std::size_t i = 0; i < capture->threads.size(); ++i) {
+            const MicroProfileThreadLog* log = profile.Pool[i];
+            if (!log || log->nGpu) {
+                continue;
+            }
+
+            ThreadState& thread = capture->threads[i];
+            if (!thread.seen) {
+                // Thread created during the capture, its log starts at the beginning
+                thread.seen = true;
+                thread.read_position = 0;
+            }
+            thread.name = log->ThreadName;
+            ReadThreadLog(*capture, thread, *log, capturing, capture_begin);
+        }
+    }
+
+    const s64 frame_end = GetTick(*capture, MP_LOG_TICK_MASK & MP_TICK());
+    if (!capturing) {
+        // Scopes are only captured from the start of the first frame in the range on
+        capture->frame_starts.clear();
+        if (frame + 1 == capture->first_frame) {
+            capture->frame_starts.push_back(frame_end);
+        }
+        return;
+    }
+
+    if (capture->num_frames != 0 && frame + 1 == capture->first_frame + capture->num_frames) {
+        Finish();
+        return;
+    }
+    capture->frame_starts.push_back(frame_end);
+}
+
+#else
+
+void Start(const std::string& path, u64 first_frame, u64 num_frames) {
+    LOG_ERROR(Common, "Profiler traces are not available, MicroProfile is disabled");
+}
+
+void Stop() {}
+
+bool IsRunning() {
+    return false;
+}
+
+void OnFlip() {}
+
+#endif
+
+} // namespace Common::MicroProfileTrace
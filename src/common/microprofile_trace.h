@@ -0,0 +1,40 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <string>
+#include "common/common_types.h"
+
+/**
+ * Captures the MicroProfile scopes of all threads for a range of frames and writes them as a
+ * Chrome trace (JSON trace event format), which can be opened in chrome://tracing or Perfetto.
+ * This allows profiling without the MicroProfile UI, e.g. on machines without a display.
+ */
+namespace Common::MicroProfileTrace {
+
+/**
+ * Starts a capture. Frames are counted from this call.
+ * @param path File to write the trace to once the capture finishes
+ * @param first_frame First frame to capture
+ * @param num_frames Number of frames to capture, 0 to capture until Stop is called
+ */
+void Start(const std::string& path, u64 first_frame, u64 num_frames);
+
+/// Writes the trace if a capture is still running
+void Stop();
+
+/// Returns whether a capture is running
+bool IsRunning();
+
+/**
+ * Parses a frame range given on the command line, in the format FIRST[:COUNT].
+ * @returns false if the range is malformed
+ */
+bool ParseFrameRange(const std::string& range, u64& first_frame, u64& num_frames);
+
+/// Collects the scopes of the frame that just ended, must be called right after MicroProfileFlip
+void OnFlip();
+
+} // namespace Common::MicroProfileTrace
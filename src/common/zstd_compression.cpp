@@ -0,0 +1,77 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+#include "common/logging/log.h"
+#include "common/zstd_compression.h"
+
+namespace Common::Compression {
+
+#ifdef HAVE_ZSTD
+
+bool IsZSTDSupported() {
+    return true;
+}
+
+std::vector<u8> CompressDataZSTD(const u8* source, std::size_t source_size, s32 compression_level) {
+    compression_level = std::clamp(compression_level, 1, ZSTD_maxCLevel());
+
+    const std::size_t max_compressed_size = ZSTD_compressBound(source_size);
+    std::vector<u8> compressed(max_compressed_size);
+
+    const std::size_t compressed_size =
+        ZSTD_compress(compressed.data(), compressed.size(), source, source_size, compression_level);
+    if (ZSTD_isError(compressed_size)) {
+        LOG_ERROR(Common, "zstd compression failed: {}", ZSTD_getErrorName(compressed_size));
+        return {};
+    }
+
+    compressed.resize(compressed_size);
+    return compressed;
+}
+
+std::vector<u8> DecompressDataZSTD(const u8* source, std::size_t source_size,
+                                   std::size_t uncompressed_size) {
+    std::vector<u8> decompressed(uncompressed_size);
+    const std::size_t result =
+        ZSTD_decompress(decompressed.data(), decompressed.size(), source, source_size);
+    if (ZSTD_isError(result)) {
+        LOG_ERROR(Common, "zstd decompression failed: {}", ZSTD_getErrorName(result));
+        return {};
+    }
+    if (result != uncompressed_size) {
+        LOG_ERROR(Common, "zstd decompression returned {} bytes, expected {}", result,
+                  uncompressed_size);
+        return {};
+    }
+    return decompressed;
+}
+
+#else
+
+bool IsZSTDSupported() {
+    return false;
+}
+
+std::vector<u8> CompressDataZSTD(const u8* source, std::size_t source_size, s32 compression_level) {
+    return {};
+}
+
+std::vector<u8> DecompressDataZSTD(const u8* source, std::size_t source_size,
+                                   std::size_t uncompressed_size) {
+    LOG_ERROR(Common, "Cannot decompress data, Citra was built without zstd support");
+    return {};
+}
+
+#endif
+
+std::vector<u8> CompressDataZSTDDefault(const u8* source, std::size_t source_size) {
+    // Favor speed, this is used for recording while the emulator is running
+    return CompressDataZSTD(source, source_size, 3);
+}
+
+} // namespace Common::Compression
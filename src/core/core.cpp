@@ -2,11 +2,14 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <ctime>
 #include <memory>
 #include <utility>
+#include <fmt/chrono.h>
 #include "audio_core/dsp_interface.h"
 #include "audio_core/hle/hle.h"
 #include "audio_core/lle/lle.h"
+#include "common/file_util.h"
 #include "common/logging/log.h"
 #include "common/texture.h"
 #include "core/arm/arm_interface.h"
@@ -23,6 +26,7 @@
 #endif
 #include "core/custom_tex_cache.h"
 #include "core/gdbstub/gdbstub.h"
+#include "core/hle/kernel/call_stats.h"
 #include "core/hle/kernel/client_port.h"
 #include "core/hle/kernel/kernel.h"
 #include "core/hle/kernel/process.h"
@@ -154,6 +158,8 @@ System::ResultStatus System::Load(Frontend::EmuWindow& emu_window, const std::st
                   static_cast<u32>(load_result));
     }
     perf_stats = std::make_unique<PerfStats>(title_id);
+    perf_stats->SetSectionTimingEnabled(Settings::values.record_frame_times);
+    kernel->GetCallStats().SetEnabled(Settings::values.record_call_stats);
     custom_tex_cache = std::make_unique<Core::CustomTexCache>();
     if (Settings::values.custom_textures) {
         FileUtil::CreateFullPath(fmt::format("{}textures/{:016X}/",
@@ -179,7 +185,9 @@ void System::PrepareReschedule() {
 }
 
 PerfStats::Results System::GetAndResetPerfStats() {
-    return perf_stats->GetAndResetStats(timing->GetGlobalTimeUs());
+    PerfStats::Results results = perf_stats->GetAndResetStats(timing->GetGlobalTimeUs());
+    results.emulated_memory_used = kernel->GetUsedMemory();
+    return results;
 }
 
 void System::Reschedule() {
@@ -253,6 +261,24 @@ System::ResultStatus System::Init(Frontend::EmuWindow& emu_window, u32 system_mo
     return ResultStatus::Success;
 }
 
+void System::InitForKernelTests() {
+    memory = std::make_unique<Memory::MemorySystem>();
+    timing = std::make_unique<Timing>();
+    kernel = std::make_unique<Kernel::KernelSystem>(*memory, *timing,
+                                                    [this] { PrepareReschedule(); }, 0);
+    cpu_core = std::make_shared<ARM_DynCom>(this, *memory, USER32MODE);
+    kernel->SetCPU(cpu_core);
+    perf_stats = std::make_unique<PerfStats>(0);
+}
+
+void System::ShutdownForKernelTests() {
+    perf_stats.reset();
+    cpu_core.reset();
+    kernel.reset();
+    timing.reset();
+    memory.reset();
+}
+
 Service::SM::ServiceManager& System::ServiceManager() {
     return *service_manager;
 }
@@ -309,6 +335,14 @@ const VideoDumper::Backend& System::VideoDumper() const {
     return *video_dumper;
 }
 
+RPC::RPCServer& System::RPCServer() {
+    return *rpc_server;
+}
+
+const RPC::RPCServer& System::RPCServer() const {
+    return *rpc_server;
+}
+
 Core::CustomTexCache& System::CustomTexCache() {
     return *custom_tex_cache;
 }
@@ -340,6 +374,22 @@ void System::Shutdown() {
                                 perf_results.frametime * 1000.0);
     telemetry_session->AddField(Telemetry::FieldType::Performance, "Mean_Frametime_MS",
                                 perf_stats->GetMeanFrametime());
+    telemetry_session->AddField(Telemetry::FieldType::Performance, "Shutdown_HostMemoryResident",
+                                perf_results.host_memory_resident);
+
+    if (Settings::values.record_call_stats && app_loader) {
+        u64 title_id{0};
+        app_loader->ReadProgramId(title_id);
+        const std::time_t t = std::time(nullptr);
+        // %F Date format expanded is "%Y-%m-%d"
+        const std::string path =
+            fmt::format("{}/{:%F-%H-%M}_{:016X}_call_stats.json",
+                        FileUtil::GetUserPath(FileUtil::UserPath::LogDir), *std::localtime(&t),
+                        title_id);
+        if (!kernel->GetCallStats().DumpToFile(path)) {
+            LOG_ERROR(Core, "Failed to write call stats to {}", path);
+        }
+    }
 
     // Shutdown emulation session
     GDBStub::Shutdown();
@@ -113,6 +113,16 @@ public:
     /// Shutdown and then load again
     void Reset();
 
+    /**
+     * Initializes only the memory, timing, kernel, CPU and performance statistics, without a
+     * frontend, services or an application. This is for tests that run kernel code looking up the
+     * system instance, such as SVCs.
+     */
+    void InitForKernelTests();
+
+    /// Destroys the subsystems created by InitForKernelTests
+    void ShutdownForKernelTests();
+
     /// Request reset of the system
     void RequestReset() {
         reset_requested = true;
@@ -227,6 +237,12 @@ public:
     /// Gets a const reference to the video dumper backend
     const VideoDumper::Backend& VideoDumper() const;
 
+    /// Gets a reference to the RPC server
+    RPC::RPCServer& RPCServer();
+
+    /// Gets a const reference to the RPC server
+    const RPC::RPCServer& RPCServer() const;
+
     std::unique_ptr<PerfStats> perf_stats;
     FrameLimiter frame_limiter;
 
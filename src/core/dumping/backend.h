@@ -13,7 +13,8 @@
 namespace VideoDumper {
 /**
  * Frame dump data for a single screen
- * data is in RGB888 format, left to right then top to bottom
+ * data is in BGRA8888 format, left to right then bottom to top (as OpenGL returns pixel data
+ * starting from the lowest position)
  */
 class VideoFrame {
 public:
@@ -22,7 +23,7 @@ public:
     u32 stride;
     std::vector<u8> data;
 
-    VideoFrame(std::size_t width_ = 0, std::size_t height_ = 0, u8* data_ = nullptr);
+    VideoFrame(std::size_t width_ = 0, std::size_t height_ = 0);
 };
 
 class Backend {
@@ -30,7 +31,12 @@ public:
     virtual ~Backend();
     virtual bool StartDumping(const std::string& path, const std::string& format,
                               const Layout::FramebufferLayout& layout) = 0;
-    virtual void AddVideoFrame(const VideoFrame& frame) = 0;
+    /**
+     * Adds a frame to the dump. The pixel data is copied, so it only needs to be valid during the
+     * call.
+     * @param data Pixel data in the format described by VideoFrame
+     */
+    virtual void AddVideoFrame(const u8* data, std::size_t width, std::size_t height) = 0;
     virtual void AddAudioFrame(const AudioCore::StereoFrame16& frame) = 0;
     virtual void AddAudioSample(const std::array<s16, 2>& sample) = 0;
     virtual void StopDumping() = 0;
@@ -45,7 +51,8 @@ public:
                       const Layout::FramebufferLayout& /*layout*/) override {
         return false;
     }
-    void AddVideoFrame(const VideoFrame& /*frame*/) override {}
+    void AddVideoFrame(const u8* /*data*/, std::size_t /*width*/,
+                       std::size_t /*height*/) override {}
     void AddAudioFrame(const AudioCore::StereoFrame16& /*frame*/) override {}
     void AddAudioSample(const std::array<s16, 2>& /*sample*/) override {}
     void StopDumping() override {}
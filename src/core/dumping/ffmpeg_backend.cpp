@@ -2,10 +2,13 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <cstring>
 #include "common/assert.h"
 #include "common/file_util.h"
 #include "common/logging/log.h"
 #include "core/dumping/ffmpeg_backend.h"
+#include "core/settings.h"
 #include "video_core/renderer_base.h"
 #include "video_core/video_core.h"
 
@@ -27,6 +30,29 @@ void InitializeFFmpegLibraries() {
     initialized = true;
 }
 
+void LatencyStat::Add(std::chrono::steady_clock::duration duration) {
+    ++count;
+    total += duration;
+    max = std::max(max, duration);
+}
+
+void LatencyStat::Log(const char* stage) const {
+    using Milliseconds = std::chrono::duration<double, std::milli>;
+    const double average = count == 0 ? 0.0 : Milliseconds(total).count() / count;
+    LOG_INFO(Render, "{:>8}: average {:.3f} ms, max {:.3f} ms", stage, average,
+             Milliseconds(max).count());
+}
+
+void VideoDumpingStats::Log() const {
+    LOG_INFO(Render, "Video frames added: {}, dropped: {}, max queued: {}", frames_added,
+             frames_dropped, max_queued_frames);
+    wait.Log("wait");
+    copy.Log("copy");
+    queue.Log("queue");
+    convert.Log("convert");
+    encode.Log("encode");
+}
+
 FFmpegStream::~FFmpegStream() {
     Free();
 }
@@ -97,7 +123,6 @@ bool FFmpegVideoStream::Init(AVFormatContext* format_context, AVOutputFormat* ou
         return false;
 
     layout = layout_;
-    frame_count = 0;
 
     // Initialize video codec
     // Ensure VP9 codec here, also to avoid patent issues
@@ -164,27 +189,41 @@ void FFmpegVideoStream::Free() {
     sws_context.reset();
 }
 
-void FFmpegVideoStream::ProcessFrame(VideoFrame& frame) {
+void FFmpegVideoStream::ProcessFrame(const VideoFrame& frame, u64 frame_index,
+                                     VideoDumpingStats& stats) {
     if (frame.width != layout.width || frame.height != layout.height) {
         LOG_ERROR(Render, "Frame dropped: resolution does not match");
         return;
     }
-    // Prepare frame
-    current_frame->data[0] = frame.data.data();
-    current_frame->linesize[0] = frame.stride;
+    const auto convert_start = std::chrono::steady_clock::now();
+
+    // Prepare frame. Rows are stored bottom to top, so start at the last row and use a negative
+    // stride to flip the image while converting it.
+    current_frame->data[0] = const_cast<u8*>(frame.data.data()) + (frame.height - 1) * frame.stride;
+    current_frame->linesize[0] = -static_cast<int>(frame.stride);
     current_frame->format = pixel_format;
     current_frame->width = layout.width;
     current_frame->height = layout.height;
 
+    // The encoder may still hold a reference to the previous frame
+    if (av_frame_make_writable(scaled_frame.get()) < 0) {
+        LOG_ERROR(Render, "Frame dropped: could not make frame writable");
+        return;
+    }
+
     // Scale the frame
     if (sws_context) {
         sws_scale(sws_context.get(), current_frame->data, current_frame->linesize, 0, layout.height,
                   scaled_frame->data, scaled_frame->linesize);
     }
-    scaled_frame->pts = frame_count++;
+    scaled_frame->pts = frame_index;
+
+    const auto encode_start = std::chrono::steady_clock::now();
+    stats.convert.Add(encode_start - convert_start);
 
     // Encode frame
     SendFrame(scaled_frame.get());
+    stats.encode.Add(std::chrono::steady_clock::now() - encode_start);
 }
 
 FFmpegAudioStream::~FFmpegAudioStream() {
@@ -356,8 +395,9 @@ void FFmpegMuxer::Free() {
     format_context.reset();
 }
 
-void FFmpegMuxer::ProcessVideoFrame(VideoFrame& frame) {
-    video_stream.ProcessFrame(frame);
+void FFmpegMuxer::ProcessVideoFrame(const VideoFrame& frame, u64 frame_index,
+                                    VideoDumpingStats& stats) {
+    video_stream.ProcessFrame(frame, frame_index, stats);
 }
 
 void FFmpegMuxer::ProcessAudioFrame(VariableAudioFrame& channel0, VariableAudioFrame& channel1) {
@@ -406,27 +446,22 @@ bool FFmpegBackend::StartDumping(const std::string& path, const std::string& for
 
     if (video_processing_thread.joinable())
         video_processing_thread.join();
-    video_processing_thread = std::thread([&] {
-        event1.Set();
-        while (true) {
-            event2.Wait();
-            current_buffer = (current_buffer + 1) % 2;
-            next_buffer = (current_buffer + 1) % 2;
-            event1.Set();
-            // Process this frame
-            auto& frame = video_frame_buffers[current_buffer];
-            if (frame.width == 0 && frame.height == 0) {
-                // An empty frame marks the end of frame data
-                ffmpeg.FlushVideo();
-                break;
-            }
-            ffmpeg.ProcessVideoFrame(frame);
-        }
-        // Finish audio execution first if not done yet
-        if (audio_processing_thread.joinable())
-            audio_processing_thread.join();
-        EndDumping();
-    });
+
+    // Allocate all frame buffers up front, so that dumping does not allocate memory per frame
+    const std::size_t queue_size = std::max<u32>(Settings::values.video_dumping_queue_size, 1);
+    video_frame_buffers.clear();
+    video_frame_buffers.resize(queue_size);
+    for (auto& buffer : video_frame_buffers) {
+        buffer.frame = VideoFrame(layout.width, layout.height);
+    }
+    write_index = 0;
+    read_index = 0;
+    queued_frames = 0;
+    video_ended = false;
+    drop_frames = Settings::values.video_dumping_drop_frames;
+    video_stats = {};
+
+    video_processing_thread = std::thread([this] { VideoProcessingLoop(); });
 
     if (audio_processing_thread.joinable())
         audio_processing_thread.join();
@@ -450,10 +485,79 @@ bool FFmpegBackend::StartDumping(const std::string& path, const std::string& for
     return true;
 }
 
-void FFmpegBackend::AddVideoFrame(const VideoFrame& frame) {
-    event1.Wait();
-    video_frame_buffers[next_buffer] = std::move(frame);
-    event2.Set();
+void FFmpegBackend::VideoProcessingLoop() {
+    while (true) {
+        QueuedVideoFrame* buffer;
+        {
+            std::unique_lock lock{video_mutex};
+            frame_added.wait(lock, [this] { return queued_frames != 0 || video_ended; });
+            if (queued_frames == 0) {
+                // All frames have been processed after the end of frame data
+                break;
+            }
+            buffer = &video_frame_buffers[read_index];
+        }
+
+        video_stats.queue.Add(std::chrono::steady_clock::now() - buffer->added_time);
+        ffmpeg.ProcessVideoFrame(buffer->frame, buffer->index, video_stats);
+
+        {
+            std::lock_guard lock{video_mutex};
+            read_index = (read_index + 1) % video_frame_buffers.size();
+            --queued_frames;
+        }
+        frame_processed.notify_one();
+    }
+    ffmpeg.FlushVideo();
+
+    // Finish audio execution first if not done yet
+    if (audio_processing_thread.joinable())
+        audio_processing_thread.join();
+    EndDumping();
+}
+
+void FFmpegBackend::AddVideoFrame(const u8* data, std::size_t width, std::size_t height) {
+    const u64 index = video_stats.frames_added++;
+    const auto wait_start = std::chrono::steady_clock::now();
+
+    QueuedVideoFrame* buffer;
+    {
+        std::unique_lock lock{video_mutex};
+        if (queued_frames == video_frame_buffers.size()) {
+            if (drop_frames) {
+                ++video_stats.frames_dropped;
+                return;
+            }
+            frame_processed.wait(lock, [this] {
+                return queued_frames < video_frame_buffers.size() || video_ended;
+            });
+        }
+        if (video_ended) {
+            return;
+        }
+        buffer = &video_frame_buffers[write_index];
+    }
+
+    // The buffer at write_index is not touched by the processing thread until it is queued
+    const auto copy_start = std::chrono::steady_clock::now();
+    video_stats.wait.Add(copy_start - wait_start);
+
+    auto& frame = buffer->frame;
+    if (frame.width != width || frame.height != height) {
+        frame = VideoFrame(width, height);
+    }
+    std::memcpy(frame.data.data(), data, frame.data.size());
+    buffer->index = index;
+    buffer->added_time = std::chrono::steady_clock::now();
+    video_stats.copy.Add(buffer->added_time - copy_start);
+
+    {
+        std::lock_guard lock{video_mutex};
+        write_index = (write_index + 1) % video_frame_buffers.size();
+        ++queued_frames;
+        video_stats.max_queued_frames = std::max(video_stats.max_queued_frames, queued_frames);
+    }
+    frame_added.notify_one();
 }
 
 void FFmpegBackend::AddAudioFrame(const AudioCore::StereoFrame16& frame) {
@@ -482,7 +586,12 @@ void FFmpegBackend::StopDumping() {
     VideoCore::g_renderer->CleanupVideoDumping();
 
     // Flush the video processing queue
-    AddVideoFrame(VideoFrame());
+    {
+        std::lock_guard lock{video_mutex};
+        video_ended = true;
+    }
+    frame_added.notify_one();
+    frame_processed.notify_one();
     for (auto i : {0, 1}) {
         // Add remaining data to audio queue
         if (audio_buffers[i].size() >= 0) {
@@ -507,6 +616,7 @@ Layout::FramebufferLayout FFmpegBackend::GetLayout() const {
 
 void FFmpegBackend::EndDumping() {
     LOG_INFO(Render, "Ending frame dumping");
+    video_stats.Log();
 
     ffmpeg.WriteTrailer();
     ffmpeg.Free();
@@ -5,6 +5,7 @@
 #pragma once
 
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <limits>
 #include <memory>
@@ -29,6 +30,33 @@ using VariableAudioFrame = std::vector<s16>;
 
 void InitFFmpegLibraries();
 
+/// Accumulates the latency of one stage of the video dumping pipeline
+class LatencyStat {
+public:
+    void Add(std::chrono::steady_clock::duration duration);
+    void Log(const char* stage) const;
+
+private:
+    u64 count = 0;
+    std::chrono::steady_clock::duration total{};
+    std::chrono::steady_clock::duration max{};
+};
+
+/// Statistics of the stages a dumped video frame passes through
+struct VideoDumpingStats {
+    LatencyStat wait;    ///< Emulation thread waiting for a free buffer
+    LatencyStat copy;    ///< Emulation thread copying the frame into the buffer
+    LatencyStat queue;   ///< Frame waiting for the video processing thread
+    LatencyStat convert; ///< Flipping and color conversion
+    LatencyStat encode;  ///< Encoding and muxing
+
+    u64 frames_added = 0;
+    u64 frames_dropped = 0;
+    std::size_t max_queued_frames = 0;
+
+    void Log() const;
+};
+
 /**
  * Wrapper around FFmpeg AVCodecContext + AVStream.
  * Rescales/Resamples, encodes and writes a frame.
@@ -73,7 +101,13 @@ public:
     bool Init(AVFormatContext* format_context, AVOutputFormat* output_format,
               const Layout::FramebufferLayout& layout);
     void Free();
-    void ProcessFrame(VideoFrame& frame);
+
+    /**
+     * Converts and encodes a frame.
+     * @param frame_index Index of the frame since dumping started, used as its timestamp so that
+     *                    dropped frames leave a gap instead of shifting the following frames
+     */
+    void ProcessFrame(const VideoFrame& frame, u64 frame_index, VideoDumpingStats& stats);
 
 private:
     struct SwsContextDeleter {
@@ -82,8 +116,6 @@ private:
         }
     };
 
-    u64 frame_count{};
-
     std::unique_ptr<AVFrame, AVFrameDeleter> current_frame{};
     std::unique_ptr<AVFrame, AVFrameDeleter> scaled_frame{};
     std::unique_ptr<SwsContext, SwsContextDeleter> sws_context{};
@@ -132,7 +164,7 @@ public:
     bool Init(const std::string& path, const std::string& format,
               const Layout::FramebufferLayout& layout);
     void Free();
-    void ProcessVideoFrame(VideoFrame& frame);
+    void ProcessVideoFrame(const VideoFrame& frame, u64 frame_index, VideoDumpingStats& stats);
     void ProcessAudioFrame(VariableAudioFrame& channel0, VariableAudioFrame& channel1);
     void FlushVideo();
     void FlushAudio();
@@ -154,8 +186,8 @@ private:
 
 /**
  * FFmpeg video dumping backend.
- * This class implements a double buffer, and an audio queue to keep audio data
- * before enough data is received to form a frame.
+ * This class implements a ring of preallocated video frame buffers, and an audio queue to keep
+ * audio data before enough data is received to form a frame.
  */
 class FFmpegBackend : public Backend {
 public:
@@ -163,7 +195,7 @@ public:
     ~FFmpegBackend() override;
     bool StartDumping(const std::string& path, const std::string& format,
                       const Layout::FramebufferLayout& layout) override;
-    void AddVideoFrame(const VideoFrame& frame) override;
+    void AddVideoFrame(const u8* data, std::size_t width, std::size_t height) override;
     void AddAudioFrame(const AudioCore::StereoFrame16& frame) override;
     void AddAudioSample(const std::array<s16, 2>& sample) override;
     void StopDumping() override;
@@ -171,6 +203,13 @@ public:
     Layout::FramebufferLayout GetLayout() const override;
 
 private:
+    struct QueuedVideoFrame {
+        VideoFrame frame;
+        u64 index;
+        std::chrono::steady_clock::time_point added_time;
+    };
+
+    void VideoProcessingLoop();
     void CheckAudioBuffer();
     void EndDumping();
 
@@ -179,11 +218,22 @@ private:
     FFmpegMuxer ffmpeg{};
 
     Layout::FramebufferLayout video_layout;
-    std::array<VideoFrame, 2> video_frame_buffers;
-    u32 current_buffer = 0, next_buffer = 1;
-    Common::Event event1, event2;
+
+    /// Ring of frame buffers, allocated when dumping starts. Frames are added at write_index and
+    /// processed from read_index.
+    std::vector<QueuedVideoFrame> video_frame_buffers;
+    std::size_t write_index = 0;
+    std::size_t read_index = 0;
+    std::size_t queued_frames = 0;
+    bool video_ended = false;
+    bool drop_frames = false;
+    std::mutex video_mutex;
+    std::condition_variable frame_added;
+    std::condition_variable frame_processed;
     std::thread video_processing_thread;
 
+    VideoDumpingStats video_stats;
+
     /// An audio buffer used to temporarily hold audio data, before the size is big enough
     /// to be sent to the encoder as a frame
     std::array<VariableAudioFrame, 2> audio_buffers;
@@ -5,6 +5,7 @@
 #include <cinttypes>
 #include <cstring>
 #include <memory>
+#include <mutex>
 #include <cryptopp/aes.h>
 #include <cryptopp/modes.h>
 #include <cryptopp/sha.h>
@@ -24,6 +25,10 @@ namespace FileSys {
 static const int kMaxSections = 8;   ///< Maximum number of sections (files) in an ExeFs
 static const int kBlockSize = 0x200; ///< Size of ExeFS blocks (in bytes)
 
+/// Serializes the use of the global NCCH key slots, NCCHs can be opened from several threads at
+/// once (e.g. by the frontend's game list scanner).
+static std::mutex key_slot_mutex;
+
 /**
  * Attempts to patch a buffer using an IPS
  * @param ips Vector of the patches to apply
@@ -206,6 +211,7 @@ Loader::ResultStatus NCCHContainer::Load() {
                 secondary_key.fill(0);
             } else {
                 using namespace HW::AES;
+                std::lock_guard lock{key_slot_mutex};
                 InitKeys();
                 std::array<u8, 16> key_y_primary, key_y_secondary;
 
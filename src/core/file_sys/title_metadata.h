@@ -100,6 +100,8 @@ public:
     u16 GetContentTypeByIndex(u16 index) const;
     u64 GetContentSizeByIndex(u16 index) const;
     std::array<u8, 16> GetContentCTRByIndex(u16 index) const;
+    /// Returns the SHA-256 hash of the decrypted content
+    const std::array<u8, 0x20>& GetContentHashByIndex(u16 index) const;
 
     void SetTitleID(u64 title_id);
     void SetTitleType(u32 type);
@@ -5,6 +5,7 @@
 #pragma once
 
 #include <memory>
+#include <unordered_map>
 #include <vector>
 #include "common/common_types.h"
 #include "core/hle/kernel/object.h"
@@ -65,8 +66,15 @@ private:
     /// the resumed thread.
     std::shared_ptr<Thread> ResumeHighestPriorityThread(VAddr address);
 
-    /// Threads waiting for the address arbiter to be signaled.
-    std::vector<std::shared_ptr<Thread>> waiting_threads;
+    /// Removes a thread that timed out from the wait list of the address it was waiting on.
+    void RemoveWaitingThread(const std::shared_ptr<Thread>& thread);
+
+    /**
+     * Threads waiting for the address arbiter to be signaled, keyed by arbitration address. Each
+     * list is kept in the order the threads started waiting, so that signaling an address only has
+     * to look at the threads waiting on that address.
+     */
+    std::unordered_map<VAddr, std::vector<std::shared_ptr<Thread>>> waiting_threads;
 };
 
 } // namespace Kernel
@@ -0,0 +1,140 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <fmt/format.h>
+#include "common/file_util.h"
+#include "core/hle/kernel/call_stats.h"
+
+namespace Kernel {
+
+void CallStats::Entry::Add(u64 ns) {
+    min_ns = count == 0 ? ns : std::min(min_ns, ns);
+    max_ns = std::max(max_ns, ns);
+    ++count;
+    total_ns += ns;
+
+    std::size_t bucket = 0;
+    while ((ns >>= 1) != 0 && bucket < NUM_HISTOGRAM_BUCKETS - 1) {
+        ++bucket;
+    }
+    ++histogram[bucket];
+}
+
+void CallStats::SetEnabled(bool enabled_) {
+    enabled.store(enabled_, std::memory_order_relaxed);
+}
+
+void CallStats::Reset() {
+    std::lock_guard lock{mutex};
+    service_calls.clear();
+    svcs = {};
+}
+
+static u64 ToNanoseconds(CallStats::Clock::duration duration) {
+    return static_cast<u64>(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+}
+
+void CallStats::RecordServiceCall(const std::string& service_name, const char* function_name,
+                                  u32 header, Clock::duration duration) {
+    std::lock_guard lock{mutex};
+    auto& call = service_calls[service_name].try_emplace(header, ServiceCall{function_name, {}})
+                     .first->second;
+    call.stats.Add(ToNanoseconds(duration));
+}
+
+void CallStats::RecordSVC(u32 id, const char* name, Clock::duration duration) {
+    if (id >= svcs.size()) {
+        return;
+    }
+
+    std::lock_guard lock{mutex};
+    svcs[id].name = name;
+    svcs[id].stats.Add(ToNanoseconds(duration));
+}
+
+std::vector<CallStats::ServiceCallEntry> CallStats::GetServiceCallStats() const {
+    std::vector<ServiceCallEntry> entries;
+    {
+        std::lock_guard lock{mutex};
+        for (const auto& [service_name, calls] : service_calls) {
+            for (const auto& [header, call] : calls) {
+                entries.push_back({service_name, call.function_name, header, call.stats});
+            }
+        }
+    }
+
+    std::sort(entries.begin(), entries.end(), [](const auto& a, const auto& b) {
+        return a.stats.total_ns > b.stats.total_ns;
+    });
+    return entries;
+}
+
+std::vector<CallStats::SVCEntry> CallStats::GetSVCStats() const {
+    std::vector<SVCEntry> entries;
+    {
+        std::lock_guard lock{mutex};
+        for (u32 id = 0; id < svcs.size(); ++id) {
+            if (svcs[id].stats.count != 0) {
+                entries.push_back({id, svcs[id].name, svcs[id].stats});
+            }
+        }
+    }
+
+    std::sort(entries.begin(), entries.end(), [](const auto& a, const auto& b) {
+        return a.stats.total_ns > b.stats.total_ns;
+    });
+    return entries;
+}
+
+static std::string EscapeJSON(const std::string& string) {
+    std::string escaped;
+    for (const char c : string) {
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+        }
+        escaped += c;
+    }
+    return escaped;
+}
+
+static std::string EntryToJSON(const CallStats::Entry& entry) {
+    return fmt::format(
+        R"("count": {}, "total_ns": {}, "min_ns": {}, "max_ns": {}, "histogram_log2_ns": [{}])",
+        entry.count, entry.total_ns, entry.min_ns, entry.max_ns,
+        fmt::join(entry.histogram.begin(), entry.histogram.end(), ", "));
+}
+
+std::string CallStats::ToJSON() const {
+    std::string json = "{\n  \"services\": [";
+    bool first = true;
+    for (const auto& entry : GetServiceCallStats()) {
+        json += fmt::format(
+            R"({}
+    {{"service": "{}", "function": "{}", "header": "0x{:08X}", {}}})",
+            first ? "" : ",", EscapeJSON(entry.service_name), EscapeJSON(entry.function_name),
+            entry.header, EntryToJSON(entry.stats));
+        first = false;
+    }
+
+    json += "\n  ],\n  \"svcs\": [";
+    first = true;
+    for (const auto& entry : GetSVCStats()) {
+        json += fmt::format(R"({}
+    {{"svc": "{}", "id": "0x{:02X}", {}}})",
+                            first ? "" : ",", EscapeJSON(entry.name), entry.id,
+                            EntryToJSON(entry.stats));
+        first = false;
+    }
+    json += "\n  ]\n}\n";
+    return json;
+}
+
+bool CallStats::DumpToFile(const std::string& path) const {
+    const std::string json = ToJSON();
+    FileUtil::IOFile file(path, "w");
+    return file.IsOpen() && file.WriteString(json) == json.size();
+}
+
+} // namespace Kernel
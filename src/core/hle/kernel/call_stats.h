@@ -0,0 +1,100 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "common/common_types.h"
+
+namespace Kernel {
+
+/**
+ * Counts calls to HLE service commands and SVCs together with the host time spent in them, to
+ * find out which of them a slow title is spending its time in.
+ */
+class CallStats {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /// Number of histogram buckets, bucket i counts the calls that took [2^i, 2^(i+1)) ns
+    static constexpr std::size_t NUM_HISTOGRAM_BUCKETS = 32;
+
+    struct Entry {
+        u64 count = 0;
+        u64 total_ns = 0;
+        u64 min_ns = 0;
+        u64 max_ns = 0;
+        std::array<u64, NUM_HISTOGRAM_BUCKETS> histogram{};
+
+        void Add(u64 ns);
+    };
+
+    struct ServiceCallEntry {
+        std::string service_name;
+        std::string function_name;
+        u32 header;
+        Entry stats;
+    };
+
+    struct SVCEntry {
+        u32 id;
+        std::string name;
+        Entry stats;
+    };
+
+    /**
+     * Returns whether calls are being recorded. This is checked before timing a call, so that
+     * disabled stats only cost an atomic load.
+     */
+    bool IsEnabled() const {
+        return enabled.load(std::memory_order_relaxed);
+    }
+
+    void SetEnabled(bool enabled);
+
+    /// Clears all recorded calls
+    void Reset();
+
+    void RecordServiceCall(const std::string& service_name, const char* function_name, u32 header,
+                           Clock::duration duration);
+    void RecordSVC(u32 id, const char* name, Clock::duration duration);
+
+    /// Returns a snapshot of the stats of all service commands that have been called
+    std::vector<ServiceCallEntry> GetServiceCallStats() const;
+
+    /// Returns a snapshot of the stats of all SVCs that have been called
+    std::vector<SVCEntry> GetSVCStats() const;
+
+    /// Serializes the stats to JSON
+    std::string ToJSON() const;
+
+    /// Writes the stats as JSON to the given file
+    bool DumpToFile(const std::string& path) const;
+
+private:
+    struct ServiceCall {
+        const char* function_name;
+        Entry stats;
+    };
+
+    struct SVC {
+        const char* name = nullptr;
+        Entry stats;
+    };
+
+    std::atomic_bool enabled{false};
+
+    mutable std::mutex mutex;
+    /// Service name -> command header -> stats
+    std::unordered_map<std::string, std::unordered_map<u32, ServiceCall>> service_calls;
+    std::array<SVC, 0x80> svcs;
+};
+
+} // namespace Kernel
@@ -87,6 +87,25 @@ public:
         return DynamicObjectCast<T>(GetGeneric(handle));
     }
 
+    /**
+     * Looks up a handle without taking a reference to the object. The returned pointer is only
+     * valid for as long as the handle stays open, so it must not be stored. This is meant for SVCs
+     * that only use the object for the duration of the call.
+     * @return Borrowed pointer to the looked-up object, or `nullptr` if the handle is not valid.
+     */
+    Object* GetGenericRaw(Handle handle) const;
+
+    /**
+     * Looks up a handle while verifying its type, without taking a reference to the object.
+     * @see GetGenericRaw
+     * @return Borrowed pointer to the looked-up object, or `nullptr` if the handle is not valid or
+     *         its type differs from the requested one.
+     */
+    template <class T>
+    T* GetRaw(Handle handle) const {
+        return DynamicObjectCast<T>(GetGenericRaw(handle));
+    }
+
     /// Closes all handles held in this table.
     void Clear();
 
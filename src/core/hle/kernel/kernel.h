@@ -51,6 +51,7 @@ class ServerPort;
 class ClientSession;
 class ServerSession;
 class ResourceLimitList;
+class CallStats;
 class SharedMemory;
 class ThreadManager;
 class TimerManager;
@@ -208,7 +209,7 @@ public:
     /// Retrieves a process from the current list of processes.
     std::shared_ptr<Process> GetProcessById(u32 process_id) const;
 
-    std::shared_ptr<Process> GetCurrentProcess() const;
+    const std::shared_ptr<Process>& GetCurrentProcess() const;
     void SetCurrentProcess(std::shared_ptr<Process> process);
 
     void SetCurrentMemoryPageTable(Memory::PageTable* page_table);
@@ -229,8 +230,14 @@ public:
     IPCDebugger::Recorder& GetIPCRecorder();
     const IPCDebugger::Recorder& GetIPCRecorder() const;
 
+    CallStats& GetCallStats();
+    const CallStats& GetCallStats() const;
+
     MemoryRegionInfo* GetMemoryRegion(MemoryRegion region);
 
+    /// Returns the amount of FCRAM allocated from all the memory regions, in bytes.
+    u32 GetUsedMemory() const;
+
     void HandleSpecialMapping(VMManager& address_space, const AddressMapping& mapping);
 
     std::array<MemoryRegionInfo, 3> memory_regions;
@@ -283,6 +290,7 @@ private:
     std::unique_ptr<SharedPage::Handler> shared_page_handler;
 
     std::unique_ptr<IPCDebugger::Recorder> ipc_recorder;
+    std::unique_ptr<CallStats> call_stats;
 };
 
 } // namespace Kernel
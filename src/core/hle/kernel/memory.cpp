@@ -82,6 +82,14 @@ MemoryRegionInfo* KernelSystem::GetMemoryRegion(MemoryRegion region) {
     }
 }
 
+u32 KernelSystem::GetUsedMemory() const {
+    u32 used = 0;
+    for (const auto& region : memory_regions) {
+        used += region.used;
+    }
+    return used;
+}
+
 void KernelSystem::HandleSpecialMapping(VMManager& address_space, const AddressMapping& mapping) {
     using namespace Memory;
 
@@ -188,8 +188,7 @@ ResultVal<VAddr> Process::HeapAllocate(VAddr target, u32 size, VMAPermission per
         u32 interval_size = interval.upper() - interval.lower();
         LOG_DEBUG(Kernel, "Allocated FCRAM region lower={:08X}, upper={:08X}", interval.lower(),
                   interval.upper());
-        std::fill(kernel.memory.GetFCRAMPointer(interval.lower()),
-                  kernel.memory.GetFCRAMPointer(interval.upper()), 0);
+        kernel.memory.DiscardFCRAM(interval.lower(), interval_size);
         auto vma = vm_manager.MapBackingMemory(interval_target,
                                                kernel.memory.GetFCRAMPointer(interval.lower()),
                                                interval_size, memory_state);
@@ -219,7 +218,9 @@ ResultCode Process::HeapFree(VAddr target, u32 size) {
     // Free heaps block by block
     CASCADE_RESULT(auto backing_blocks, vm_manager.GetBackingBlocksForRange(target, size));
     for (const auto [backing_memory, block_size] : backing_blocks) {
-        memory_region->Free(kernel.memory.GetFCRAMOffset(backing_memory), block_size);
+        const u32 offset = kernel.memory.GetFCRAMOffset(backing_memory);
+        memory_region->Free(offset, block_size);
+        kernel.memory.DiscardFCRAM(offset, block_size);
     }
 
     ResultCode result = vm_manager.UnmapRange(target, size);
@@ -265,7 +266,7 @@ ResultVal<VAddr> Process::LinearAllocate(VAddr target, u32 size, VMAPermission p
 
     u8* backing_memory = kernel.memory.GetFCRAMPointer(physical_offset);
 
-    std::fill(backing_memory, backing_memory + size, 0);
+    kernel.memory.DiscardFCRAM(physical_offset, size);
     auto vma = vm_manager.MapBackingMemory(target, backing_memory, size, MemoryState::Continuous);
     ASSERT(vma.Succeeded());
     vm_manager.Reprotect(vma.Unwrap(), perms);
@@ -300,6 +301,7 @@ ResultCode Process::LinearFree(VAddr target, u32 size) {
 
     u32 physical_offset = target - GetLinearHeapAreaAddress(); // relative to FCRAM
     memory_region->Free(physical_offset, size);
+    kernel.memory.DiscardFCRAM(physical_offset, size);
 
     return RESULT_SUCCESS;
 }
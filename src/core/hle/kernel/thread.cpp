@@ -455,6 +455,18 @@ s32 Thread::GetWaitObjectIndex(const WaitObject* object) const {
     return static_cast<s32>(std::distance(match, wait_objects.rend()) - 1);
 }
 
+bool Thread::AreAllWaitObjectsReady() const {
+    const std::size_t count = wait_objects.size();
+    for (std::size_t i = 0; i < count; ++i) {
+        const std::size_t index = (wait_all_blocker + i) % count;
+        if (wait_objects[index]->ShouldWait(this)) {
+            wait_all_blocker = index;
+            return false;
+        }
+    }
+    return true;
+}
+
 VAddr Thread::GetCommandBufferAddress() const {
     // Offset from the start of TLS at which the IPC command buffer begins.
     constexpr u32 command_header_offset = 0x80;
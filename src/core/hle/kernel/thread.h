@@ -235,6 +235,15 @@ public:
      */
     s32 GetWaitObjectIndex(const WaitObject* object) const;
 
+    /**
+     * Checks whether all the objects a thread sleeping on WaitSynchronizationN with
+     * wait_all = true is waiting on are available. The object that blocked the previous check is
+     * tried first, as it is the most likely to still be unavailable, so re-checking a thread that
+     * can't run yet is usually a single ShouldWait call.
+     * @return True if the thread can acquire all of its wait objects.
+     */
+    bool AreAllWaitObjectsReady() const;
+
     /**
      * Stops a thread, invalidating it from further use
      */
@@ -292,6 +301,9 @@ public:
     // passed to WaitSynchronization1/N.
     std::vector<std::shared_ptr<WaitObject>> wait_objects;
 
+    /// Index in wait_objects of the object that blocked the last AreAllWaitObjectsReady call.
+    mutable std::size_t wait_all_blocker = 0;
+
     VAddr wait_address; ///< If waiting on an AddressArbiter, this is the arbitration address
 
     std::string name;
@@ -53,10 +53,7 @@ std::shared_ptr<Thread> WaitObject::GetHighestPriorityReadyThread() const {
         // in ThreadStatus::WaitSynchAll and the rest of the objects it is waiting on are ready.
         bool ready_to_run = true;
         if (thread->status == ThreadStatus::WaitSynchAll) {
-            ready_to_run = std::none_of(thread->wait_objects.begin(), thread->wait_objects.end(),
-                                        [&thread](const std::shared_ptr<WaitObject>& object) {
-                                            return object->ShouldWait(thread.get());
-                                        });
+            ready_to_run = thread->AreAllWaitObjectsReady();
         }
 
         if (ready_to_run) {
@@ -3,11 +3,20 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <cinttypes>
+#include <condition_variable>
 #include <cstddef>
 #include <cstring>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
 #include <cryptopp/aes.h>
 #include <cryptopp/modes.h>
+#include <cryptopp/sha.h>
 #include <fmt/format.h>
 #include "common/file_util.h"
 #include "common/logging/log.h"
@@ -76,13 +85,24 @@ struct TicketInfo {
 
 static_assert(sizeof(TicketInfo) == 0x18, "Ticket info structure size is wrong");
 
-class CIAFile::DecryptionState {
+// The hash of an installed content does not match the one in the TMD
+constexpr ResultCode ERROR_CONTENT_HASH_MISMATCH(ErrorDescription::NotAuthorized, ErrorModule::AM,
+                                                 ErrorSummary::InvalidState,
+                                                 ErrorLevel::Permanent);
+
+class CIAFile::ContentState {
 public:
-    std::vector<CryptoPP::CBC_Mode<CryptoPP::AES>::Decryption> content;
+    struct Content {
+        CryptoPP::CBC_Mode<CryptoPP::AES>::Decryption decryption;
+        CryptoPP::SHA256 hash;
+        FileUtil::IOFile file;
+    };
+
+    std::vector<Content> content;
 };
 
 CIAFile::CIAFile(Service::FS::MediaType media_type)
-    : media_type(media_type), decryption_state(std::make_unique<DecryptionState>()) {}
+    : media_type(media_type), content_state(std::make_unique<ContentState>()) {}
 
 CIAFile::~CIAFile() {
     Close();
@@ -131,13 +151,13 @@ ResultCode CIAFile::WriteTitleMetadata() {
 
     auto content_count = container.GetTitleMetadata().GetContentCount();
     content_written.resize(content_count);
+    content_state->content = std::vector<ContentState::Content>(content_count);
 
     if (auto title_key = container.GetTicket().GetTitleKey()) {
-        decryption_state->content.resize(content_count);
         for (std::size_t i = 0; i < content_count; ++i) {
             auto ctr = tmd.GetContentCTRByIndex(i);
-            decryption_state->content[i].SetKeyWithIV(title_key->data(), title_key->size(),
-                                                      ctr.data());
+            content_state->content[i].decryption.SetKeyWithIV(title_key->data(), title_key->size(),
+                                                               ctr.data());
         }
     }
 
@@ -146,6 +166,50 @@ ResultCode CIAFile::WriteTitleMetadata() {
     return RESULT_SUCCESS;
 }
 
+ResultCode CIAFile::WriteContentPart(u16 index, u8* buffer, std::size_t length) {
+    const FileSys::TitleMetadata& tmd = container.GetTitleMetadata();
+    auto& content = content_state->content[index];
+
+    // Keep the content file open until the content is complete
+    if (content_written[index] == 0) {
+        content.file =
+            FileUtil::IOFile(GetTitleContentPath(media_type, tmd.GetTitleID(), index, is_update),
+                             "wb");
+    }
+    if (!content.file.IsOpen())
+        return FileSys::ERROR_INSUFFICIENT_SPACE;
+
+    if (tmd.GetContentTypeByIndex(index) & FileSys::TMDContentTypeFlag::Encrypted) {
+        content.decryption.ProcessData(buffer, buffer, length);
+    }
+    content.hash.Update(buffer, length);
+
+    if (content.file.WriteBytes(buffer, length) != length)
+        return FileSys::ERROR_INSUFFICIENT_SPACE;
+
+    // Keep tabs on how much of this content ID has been written so new range_min
+    // values can be calculated.
+    content_written[index] += length;
+    LOG_DEBUG(Service_AM, "Wrote {:x} to content {}, total {:x}", length, index,
+              content_written[index]);
+
+    if (content_written[index] == container.GetContentSize(index)) {
+        content.file.Close();
+
+        std::array<u8, CryptoPP::SHA256::DIGESTSIZE> hash;
+        content.hash.Final(hash.data());
+        if (hash != tmd.GetContentHashByIndex(index)) {
+            LOG_ERROR(Service_AM, "Hash of content {} does not match the TMD", index);
+            // Mark the content as incomplete, so that the install is aborted when closing
+            FileUtil::Delete(GetTitleContentPath(media_type, tmd.GetTitleID(), index, is_update));
+            content_written[index] = 0;
+            return ERROR_CONTENT_HASH_MISMATCH;
+        }
+    }
+
+    return RESULT_SUCCESS;
+}
+
 ResultVal<std::size_t> CIAFile::WriteContentData(u64 offset, std::size_t length, const u8* buffer) {
     // Data is not being buffered, so we have to keep track of how much of each <ID>.app
     // has been written since we might get a written buffer which contains multiple .app
@@ -166,30 +230,14 @@ ResultVal<std::size_t> CIAFile::WriteContentData(u64 offset, std::size_t length,
             // Figure out how much of this content ID we have just recieved/can write out
             u64 available_to_write = std::min(offset_max, range_max) - range_min;
 
-            // Since the incoming TMD has already been written, we can use GetTitleContentPath
-            // to get the content paths to write to.
-            FileSys::TitleMetadata tmd = container.GetTitleMetadata();
-            FileUtil::IOFile file(GetTitleContentPath(media_type, tmd.GetTitleID(), i, is_update),
-                                  content_written[i] ? "ab" : "wb");
-
-            if (!file.IsOpen())
-                return FileSys::ERROR_INSUFFICIENT_SPACE;
-
-            std::vector<u8> temp(buffer + (range_min - offset),
-                                 buffer + (range_min - offset) + available_to_write);
-
-            if (tmd.GetContentTypeByIndex(static_cast<u16>(i)) &
-                FileSys::TMDContentTypeFlag::Encrypted) {
-                decryption_state->content[i].ProcessData(temp.data(), temp.data(), temp.size());
-            }
+            // The data is decrypted in place, so copy it into a buffer we own first
+            content_buffer.resize(std::max<std::size_t>(content_buffer.size(), available_to_write));
+            std::memcpy(content_buffer.data(), buffer + (range_min - offset), available_to_write);
 
-            file.WriteBytes(temp.data(), temp.size());
-
-            // Keep tabs on how much of this content ID has been written so new range_min
-            // values can be calculated.
-            content_written[i] += available_to_write;
-            LOG_DEBUG(Service_AM, "Wrote {:x} to content {}, total {:x}", available_to_write, i,
-                      content_written[i]);
+            auto result =
+                WriteContentPart(static_cast<u16>(i), content_buffer.data(), available_to_write);
+            if (result.IsError())
+                return result;
         }
     }
 
@@ -325,6 +373,111 @@ bool CIAFile::Close() const {
 
 void CIAFile::Flush() const {}
 
+ResultCode CIAFile::InstallContentsFromFile(
+    const std::string& path, const std::function<ProgressCallback>& update_callback) {
+    ASSERT(install_state == CIAInstallState::TMDLoaded);
+
+    // Large reads keep the number of requests to the host file system low
+    constexpr std::size_t CHUNK_SIZE = 4 * 1024 * 1024;
+
+    const std::size_t content_count = container.GetTitleMetadata().GetContentCount();
+    const std::size_t total_size = FileUtil::GetSize(path);
+    const u64 initial_written = written;
+    std::atomic<u64> content_bytes_written{0};
+
+    const auto install_content = [&](u16 index) -> ResultCode {
+        FileUtil::IOFile file(path, "rb");
+        if (!file.IsOpen() ||
+            !file.Seek(container.GetContentOffset(index) + content_written[index], SEEK_SET)) {
+            return FileSys::ERROR_NOT_FOUND;
+        }
+
+        std::array<std::vector<u8>, 2> buffers;
+        const auto read_chunk = [&file, &buffers](std::size_t buffer_index, std::size_t size) {
+            buffers[buffer_index].resize(size);
+            return file.ReadBytes(buffers[buffer_index].data(), size);
+        };
+
+        u64 remaining = container.GetContentSize(index) - content_written[index];
+        std::size_t current = 0;
+        std::future<std::size_t> next_read =
+            std::async(std::launch::deferred, read_chunk, current,
+                       static_cast<std::size_t>(std::min<u64>(remaining, CHUNK_SIZE)));
+        while (remaining > 0) {
+            const std::size_t length = next_read.get();
+            if (length == 0)
+                return FileSys::ERROR_NOT_FOUND;
+            remaining -= length;
+
+            // Read the next chunk while this one is decrypted, hashed and written
+            if (remaining > 0) {
+                next_read =
+                    std::async(std::launch::async, read_chunk, current ^ 1,
+                               static_cast<std::size_t>(std::min<u64>(remaining, CHUNK_SIZE)));
+            }
+
+            auto result = WriteContentPart(index, buffers[current].data(), length);
+            if (result.IsError())
+                return result;
+
+            content_bytes_written += length;
+            current ^= 1;
+        }
+        return RESULT_SUCCESS;
+    };
+
+    std::vector<ResultCode> results(content_count, RESULT_SUCCESS);
+    std::atomic<std::size_t> next_content{0};
+    std::atomic<bool> failed{false};
+    std::mutex done_mutex;
+    std::condition_variable done_cv;
+    std::size_t threads_done = 0;
+
+    const auto install_thread = [&] {
+        for (std::size_t i = next_content++; i < content_count && !failed; i = next_content++) {
+            results[i] = install_content(static_cast<u16>(i));
+            if (results[i].IsError())
+                failed = true;
+        }
+        {
+            std::lock_guard lock{done_mutex};
+            ++threads_done;
+        }
+        done_cv.notify_one();
+    };
+
+    // Contents are independent of each other, so they can be installed in parallel
+    const std::size_t num_threads = std::clamp<std::size_t>(
+        std::thread::hardware_concurrency(), 1, std::max<std::size_t>(content_count, 1));
+    std::vector<std::thread> threads;
+    for (std::size_t i = 0; i < num_threads; ++i) {
+        threads.emplace_back(install_thread);
+    }
+
+    // Report the progress from this thread, so that callers don't have to synchronize
+    while (true) {
+        {
+            std::unique_lock lock{done_mutex};
+            if (done_cv.wait_for(lock, std::chrono::milliseconds(100),
+                                 [&] { return threads_done == num_threads; })) {
+                break;
+            }
+        }
+        if (update_callback)
+            update_callback(initial_written + content_bytes_written, total_size);
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    written = initial_written + content_bytes_written;
+    for (const auto& result : results) {
+        if (result.IsError())
+            return result;
+    }
+    return RESULT_SUCCESS;
+}
+
 InstallStatus InstallCIA(const std::string& path,
                          std::function<ProgressCallback>&& update_callback) {
     LOG_INFO(Service_AM, "Installing {}...", path);
@@ -354,21 +507,26 @@ InstallStatus InstallCIA(const std::string& path,
         if (!file.IsOpen())
             return InstallStatus::ErrorFailedToOpenFile;
 
-        std::array<u8, 0x10000> buffer;
-        std::size_t total_bytes_read = 0;
-        while (total_bytes_read != file.GetSize()) {
-            std::size_t bytes_read = file.ReadBytes(buffer.data(), buffer.size());
-            auto result = installFile.Write(static_cast<u64>(total_bytes_read), bytes_read, true,
-                                            static_cast<u8*>(buffer.data()));
-
-            if (update_callback)
-                update_callback(total_bytes_read, file.GetSize());
-            if (result.Failed()) {
-                LOG_ERROR(Service_AM, "CIA file installation aborted with error code {:08x}",
-                          result.Code().raw);
-                return InstallStatus::ErrorAborted;
-            }
-            total_bytes_read += bytes_read;
+        // Everything up to the content (header, certificates, ticket and TMD) is small and goes
+        // through the regular write path, the contents are then read directly from the file
+        std::vector<u8> buffer(container.GetContentOffset());
+        if (file.ReadBytes(buffer.data(), buffer.size()) != buffer.size())
+            return InstallStatus::ErrorInvalid;
+        file.Close();
+
+        auto result = installFile.Write(0, buffer.size(), true, buffer.data());
+        if (result.Failed()) {
+            LOG_ERROR(Service_AM, "CIA file installation aborted with error code {:08x}",
+                      result.Code().raw);
+            return InstallStatus::ErrorAborted;
+        }
+
+        const ResultCode content_result =
+            installFile.InstallContentsFromFile(path, update_callback);
+        if (content_result.IsError()) {
+            LOG_ERROR(Service_AM, "CIA file installation aborted with error code {:08x}",
+                      content_result.raw);
+            return InstallStatus::ErrorAborted;
         }
         installFile.Close();
 
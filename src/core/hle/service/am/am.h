@@ -71,6 +71,17 @@ public:
     ResultCode WriteTicket();
     ResultCode WriteTitleMetadata();
     ResultVal<std::size_t> WriteContentData(u64 offset, std::size_t length, const u8* buffer);
+
+    /**
+     * Installs the contents directly from the CIA file they are read from, instead of having
+     * them written through Write. Contents are processed in parallel, reading the next part of a
+     * content while the current one is decrypted, hashed and written. Requires the TMD to be
+     * loaded already.
+     * @param path path of the CIA file
+     * @param update_callback callback function called with the install progress
+     */
+    ResultCode InstallContentsFromFile(const std::string& path,
+                                       const std::function<ProgressCallback>& update_callback);
     ResultVal<std::size_t> Write(u64 offset, std::size_t length, bool flush,
                                  const u8* buffer) override;
     u64 GetSize() const override;
@@ -79,6 +90,13 @@ public:
     void Flush() const override;
 
 private:
+    /**
+     * Decrypts the next part of a content in place, then hashes and writes it. Once the content
+     * is complete, its hash is verified against the TMD. Different contents may be written from
+     * different threads.
+     */
+    ResultCode WriteContentPart(u16 index, u8* buffer, std::size_t length);
+
     // Whether it's installing an update, and what step of installation it is at
     bool is_update = false;
     CIAInstallState install_state = CIAInstallState::InstallStarted;
@@ -92,8 +110,11 @@ private:
     std::vector<u64> content_written;
     Service::FS::MediaType media_type;
 
-    class DecryptionState;
-    std::unique_ptr<DecryptionState> decryption_state;
+    // Reused for copies of content data written through WriteContentData
+    std::vector<u8> content_buffer;
+
+    class ContentState;
+    std::unique_ptr<ContentState> content_state;
 };
 
 /**
@@ -14,7 +14,12 @@ static std::weak_ptr<GSP_GPU> gsp_gpu;
 
 void SignalInterrupt(InterruptId interrupt_id) {
     auto gpu = gsp_gpu.lock();
-    ASSERT(gpu != nullptr);
+    if (gpu == nullptr) {
+        // There is no GSP service (and no userland to notify) when replaying a CiTrace
+        LOG_TRACE(Service_GSP, "Ignoring interrupt {} without a GSP service",
+                  static_cast<u32>(interrupt_id));
+        return;
+    }
     return gpu->SignalInterrupt(interrupt_id);
 }
 
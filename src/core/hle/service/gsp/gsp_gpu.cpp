@@ -5,6 +5,7 @@
 #include <vector>
 #include "common/bit_field.h"
 #include "common/microprofile.h"
+#include "common/microprofile_trace.h"
 #include "common/swap.h"
 #include "core/core.h"
 #include "core/hle/ipc.h"
@@ -20,6 +21,7 @@
 #include "core/memory.h"
 #include "video_core/debug_utils/debug_utils.h"
 #include "video_core/gpu_debugger.h"
+#include "video_core/gpu_thread.h"
 
 // Main graphics debugger object - TODO: Here is probably not the best place for this
 GraphicsDebugger g_debugger;
@@ -307,6 +309,7 @@ ResultCode SetBufferSwap(u32 screen_id, const FrameBufferInfo& info) {
 
     if (screen_id == 0) {
         MicroProfileFlip();
+        Common::MicroProfileTrace::OnFlip();
         Core::System::GetInstance().perf_stats->EndGameFrame();
     }
 
@@ -343,6 +346,9 @@ void GSP_GPU::InvalidateDataCache(Kernel::HLERequestContext& ctx) {
     u32 size = rp.Pop<u32>();
     auto process = rp.PopObject<Kernel::Process>();
 
+    // The program is about to read memory the GPU wrote, which queued GPU work may still write
+    VideoCore::SynchronizeGPUThread();
+
     // TODO(purpasmart96): Verify return header on HW
 
     IPC::RequestBuilder rb = rp.MakeBuilder(1, 0);
@@ -4,6 +4,7 @@
 
 #include <algorithm>
 #include <cstring>
+#include <random>
 #include <cryptopp/osrng.h>
 #include "common/common_types.h"
 #include "common/logging/log.h"
@@ -20,6 +21,7 @@
 #include "core/hle/service/nwm/uds_connection.h"
 #include "core/hle/service/nwm/uds_data.h"
 #include "core/memory.h"
+#include "core/movie.h"
 
 namespace Service::NWM {
 
@@ -1383,10 +1385,16 @@ NWM_UDS::NWM_UDS(Core::System& system) : ServiceFramework("nwm::UDS"), system(sy
         "UDS::BeaconBroadcastCallback",
         [this](u64 userdata, s64 cycles_late) { BeaconBroadcastCallback(userdata, cycles_late); });
 
-    CryptoPP::AutoSeededRandomPool rng;
     auto mac = SharedPage::DefaultMac;
     // Keep the Nintendo 3DS MAC header and randomly generate the last 3 bytes
-    rng.GenerateBlock(static_cast<CryptoPP::byte*>(mac.data() + 3), 3);
+    if (const auto seed = Core::Movie::GetInstance().GetOverrideRandomSeed()) {
+        // Movies need the same MAC address on every run, titles may use it to seed their RNG
+        std::mt19937 rng(*seed);
+        std::generate(mac.begin() + 3, mac.end(), [&rng] { return static_cast<u8>(rng()); });
+    } else {
+        CryptoPP::AutoSeededRandomPool rng;
+        rng.GenerateBlock(static_cast<CryptoPP::byte*>(mac.data() + 3), 3);
+    }
 
     if (auto room_member = Network::GetRoomMember().lock()) {
         if (room_member->IsConnected()) {
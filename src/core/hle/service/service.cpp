@@ -8,8 +8,10 @@
 #include "common/logging/log.h"
 #include "core/core.h"
 #include "core/hle/ipc.h"
+#include "core/hle/kernel/call_stats.h"
 #include "core/hle/kernel/client_port.h"
 #include "core/hle/kernel/handle_table.h"
+#include "core/hle/kernel/kernel.h"
 #include "core/hle/kernel/process.h"
 #include "core/hle/kernel/server_port.h"
 #include "core/hle/kernel/server_session.h"
@@ -177,7 +179,17 @@ void ServiceFrameworkBase::HandleSyncRequest(Kernel::HLERequestContext& context)
 
     LOG_TRACE(Service, "{}",
               MakeFunctionString(info->name, GetServiceName(), context.CommandBuffer()));
+
+    auto& call_stats = Core::System::GetInstance().Kernel().GetCallStats();
+    if (!call_stats.IsEnabled()) {
+        handler_invoker(this, info->handler_callback, context);
+        return;
+    }
+
+    const auto start = Kernel::CallStats::Clock::now();
     handler_invoker(this, info->handler_callback, context);
+    call_stats.RecordServiceCall(GetServiceName(), info->name, header_code,
+                                 Kernel::CallStats::Clock::now() - start);
 }
 
 std::string ServiceFrameworkBase::GetFunctionName(u32 header) const {
@@ -7,6 +7,7 @@
 #include "core/hle/ipc.h"
 #include "core/hle/ipc_helpers.h"
 #include "core/hle/service/ssl_c.h"
+#include "core/movie.h"
 
 namespace Service::SSL {
 
@@ -14,9 +15,14 @@ void SSL_C::Initialize(Kernel::HLERequestContext& ctx) {
     IPC::RequestParser rp(ctx, 0x01, 0, 2);
     rp.PopPID();
 
-    // Seed random number generator when the SSL service is initialized
-    std::random_device rand_device;
-    rand_gen.seed(rand_device());
+    // Seed random number generator when the SSL service is initialized. Movies use a fixed seed,
+    // otherwise titles could request different random data during playback than when recording.
+    if (const auto seed = Core::Movie::GetInstance().GetOverrideRandomSeed()) {
+        rand_gen.seed(*seed);
+    } else {
+        std::random_device rand_device;
+        rand_gen.seed(rand_device());
+    }
 
     // Stub, return success
     IPC::RequestBuilder rb = rp.MakeBuilder(1, 0);
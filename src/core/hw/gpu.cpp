@@ -3,6 +3,7 @@
 // Refer to the license.txt file included.
 
 #include <cstring>
+#include <functional>
 #include <numeric>
 #include <type_traits>
 #include "common/alignment.h"
@@ -11,14 +12,17 @@
 #include "common/logging/log.h"
 #include "common/microprofile.h"
 #include "common/vector_math.h"
+#include "core/core.h"
 #include "core/core_timing.h"
 #include "core/hle/service/gsp/gsp.h"
 #include "core/hw/gpu.h"
 #include "core/hw/hw.h"
 #include "core/memory.h"
+#include "core/rpc/rpc_server.h"
 #include "core/tracer/recorder.h"
 #include "video_core/command_processor.h"
 #include "video_core/debug_utils/debug_utils.h"
+#include "video_core/gpu_thread.h"
 #include "video_core/rasterizer_interface.h"
 #include "video_core/renderer_base.h"
 #include "video_core/utils.h"
@@ -33,6 +37,19 @@ Memory::MemorySystem* g_memory;
 const u64 frame_ticks = static_cast<u64>(BASE_CLOCK_RATE_ARM11 / SCREEN_REFRESH_RATE);
 /// Event id for CoreTiming
 static Core::TimingEventType* vblank_event;
+/// Event id for completing work submitted to the GPU thread
+static Core::TimingEventType* gpu_work_event;
+
+/// Returns whether the register at the given index belongs to a memory fill or display transfer
+static bool IsMemoryTransferRegister(u32 index) {
+    const u32 fill_start = GPU_REG_INDEX(memory_fill_config[0]);
+    const u32 fill_end =
+        GPU_REG_INDEX(memory_fill_config[1]) + sizeof(Regs::MemoryFillConfig) / sizeof(u32);
+    const u32 transfer_start = GPU_REG_INDEX(display_transfer_config);
+    const u32 transfer_end = transfer_start + sizeof(Regs::DisplayTransferConfig) / sizeof(u32);
+    return (index >= fill_start && index < fill_end) ||
+           (index >= transfer_start && index < transfer_end);
+}
 
 template <typename T>
 inline void Read(T& var, const u32 raw_addr) {
@@ -45,6 +62,12 @@ inline void Read(T& var, const u32 raw_addr) {
         return;
     }
 
+    // Fills and transfers report completion before they have run on the GPU thread, so the
+    // program must not see their registers until that work is done
+    if (IsMemoryTransferRegister(index)) {
+        VideoCore::SynchronizeGPUThread();
+    }
+
     var = g_regs[addr / 4];
 }
 
@@ -385,6 +408,47 @@ static void TextureCopy(const Regs::DisplayTransferConfig& config) {
     }
 }
 
+/**
+ * Whether work can run on the GPU thread. The OpenGL rasterizer needs the OpenGL context of the
+ * emulation thread, and the trace recorder needs memory accesses in order with register writes.
+ */
+static bool UseGPUThread() {
+    return VideoCore::g_gpu_thread && !VideoCore::g_renderer->IsOpenGLRasterizerActive() &&
+           !(Pica::g_debug_context && Pica::g_debug_context->recorder);
+}
+
+/**
+ * Runs work triggered by a register write. If it goes to the GPU thread, the emulation thread
+ * waits for it and signals its interrupts at the next scheduler slice, so that the emulated CPU
+ * keeps running in the meantime.
+ */
+static void RunGPUWork(std::function<void()> work) {
+    if (UseGPUThread()) {
+        const u64 fence = VideoCore::g_gpu_thread->Submit(std::move(work));
+        Core::System::GetInstance().CoreTiming().ScheduleEvent(0, gpu_work_event, fence);
+        return;
+    }
+
+    // Work that is still queued, e.g. from before the rasterizer was switched, has to finish first
+    VideoCore::SynchronizeGPUThread();
+    work();
+}
+
+static void GPUWorkCallback(u64 fence, s64 cycles_late) {
+    if (!VideoCore::g_gpu_thread) {
+        return;
+    }
+
+    {
+        Core::FrameSectionScope frame_section{
+            Core::System::GetInstance().perf_stats.get(), Core::FrameSection::Gpu};
+        VideoCore::g_gpu_thread->WaitForFence(fence);
+    }
+    for (const auto interrupt_id : VideoCore::g_gpu_thread->TakeInterrupts(fence)) {
+        Service::GSP::SignalInterrupt(interrupt_id);
+    }
+}
+
 template <typename T>
 inline void Write(u32 addr, const T data) {
     addr -= HW::VADDR_GPU;
@@ -407,21 +471,27 @@ inline void Write(u32 addr, const T data) {
         auto& config = g_regs.memory_fill_config[is_second_filler];
 
         if (config.trigger) {
-            MemoryFill(config);
-            LOG_TRACE(HW_GPU, "MemoryFill from {:#010X} to {:#010X}", config.GetStartAddress(),
-                      config.GetEndAddress());
-
-            // It seems that it won't signal interrupt if "address_start" is zero.
-            // TODO: hwtest this
-            if (config.GetStartAddress() != 0) {
-                if (!is_second_filler) {
-                    Service::GSP::SignalInterrupt(Service::GSP::InterruptId::PSC0);
-                } else {
-                    Service::GSP::SignalInterrupt(Service::GSP::InterruptId::PSC1);
+            Core::FrameSectionScope frame_section{
+                Core::System::GetInstance().perf_stats.get(), Core::FrameSection::Gpu};
+            // The registers may be written again while the fill runs on the GPU thread
+            RunGPUWork([config = Regs::MemoryFillConfig{config}, is_second_filler] {
+                MemoryFill(config);
+                LOG_TRACE(HW_GPU, "MemoryFill from {:#010X} to {:#010X}",
+                          config.GetStartAddress(), config.GetEndAddress());
+
+                // It seems that it won't signal interrupt if "address_start" is zero.
+                // TODO: hwtest this
+                if (config.GetStartAddress() != 0) {
+                    if (!is_second_filler) {
+                        VideoCore::SignalInterrupt(Service::GSP::InterruptId::PSC0);
+                    } else {
+                        VideoCore::SignalInterrupt(Service::GSP::InterruptId::PSC1);
+                    }
                 }
-            }
+            });
 
-            // Reset "trigger" flag and set the "finish" flag
+            // Reset "trigger" flag and set the "finish" flag. Reads of these registers wait for
+            // the GPU thread, so the fill has completed by the time the program can see this.
             // NOTE: This was confirmed to happen on hardware even if "address_start" is zero.
             config.trigger.Assign(0);
             config.finished.Assign(1);
@@ -430,7 +500,8 @@ inline void Write(u32 addr, const T data) {
     }
 
     case GPU_REG_INDEX(display_transfer_config.trigger): {
-        MICROPROFILE_SCOPE(GPU_DisplayTransfer);
+        Core::FrameSectionScope frame_section{
+            Core::System::GetInstance().perf_stats.get(), Core::FrameSection::Gpu};
 
         const auto& config = g_regs.display_transfer_config;
         if (config.trigger & 1) {
@@ -439,28 +510,33 @@ inline void Write(u32 addr, const T data) {
                 Pica::g_debug_context->OnEvent(Pica::DebugContext::Event::IncomingDisplayTransfer,
                                                nullptr);
 
-            if (config.is_texture_copy) {
-                TextureCopy(config);
-                LOG_TRACE(HW_GPU,
-                          "TextureCopy: {:#X} bytes from {:#010X}({}+{})-> "
-                          "{:#010X}({}+{}), flags {:#010X}",
-                          config.texture_copy.size, config.GetPhysicalInputAddress(),
-                          config.texture_copy.input_width * 16, config.texture_copy.input_gap * 16,
-                          config.GetPhysicalOutputAddress(), config.texture_copy.output_width * 16,
-                          config.texture_copy.output_gap * 16, config.flags);
-            } else {
-                DisplayTransfer(config);
-                LOG_TRACE(HW_GPU,
-                          "DisplayTransfer: {:#010X}({}x{})-> "
-                          "{:#010X}({}x{}), dst format {:x}, flags {:#010X}",
-                          config.GetPhysicalInputAddress(), config.input_width.Value(),
-                          config.input_height.Value(), config.GetPhysicalOutputAddress(),
-                          config.output_width.Value(), config.output_height.Value(),
-                          static_cast<u32>(config.output_format.Value()), config.flags);
-            }
+            RunGPUWork([config = Regs::DisplayTransferConfig{config}] {
+                MICROPROFILE_SCOPE(GPU_DisplayTransfer);
+                if (config.is_texture_copy) {
+                    TextureCopy(config);
+                    LOG_TRACE(HW_GPU,
+                              "TextureCopy: {:#X} bytes from {:#010X}({}+{})-> "
+                              "{:#010X}({}+{}), flags {:#010X}",
+                              config.texture_copy.size, config.GetPhysicalInputAddress(),
+                              config.texture_copy.input_width * 16,
+                              config.texture_copy.input_gap * 16, config.GetPhysicalOutputAddress(),
+                              config.texture_copy.output_width * 16,
+                              config.texture_copy.output_gap * 16, config.flags);
+                } else {
+                    DisplayTransfer(config);
+                    LOG_TRACE(HW_GPU,
+                              "DisplayTransfer: {:#010X}({}x{})-> "
+                              "{:#010X}({}x{}), dst format {:x}, flags {:#010X}",
+                              config.GetPhysicalInputAddress(), config.input_width.Value(),
+                              config.input_height.Value(), config.GetPhysicalOutputAddress(),
+                              config.output_width.Value(), config.output_height.Value(),
+                              static_cast<u32>(config.output_format.Value()), config.flags);
+                }
+
+                VideoCore::SignalInterrupt(Service::GSP::InterruptId::PPF);
+            });
 
             g_regs.display_transfer_config.trigger = 0;
-            Service::GSP::SignalInterrupt(Service::GSP::InterruptId::PPF);
         }
         break;
     }
@@ -469,7 +545,8 @@ inline void Write(u32 addr, const T data) {
     case GPU_REG_INDEX(command_processor_config.trigger): {
         const auto& config = g_regs.command_processor_config;
         if (config.trigger & 1) {
-            MICROPROFILE_SCOPE(GPU_CmdlistProcessing);
+            Core::FrameSectionScope frame_section{
+                Core::System::GetInstance().perf_stats.get(), Core::FrameSection::Gpu};
 
             u32* buffer = (u32*)g_memory->GetPhysicalPointer(config.GetPhysicalAddress());
 
@@ -478,7 +555,12 @@ inline void Write(u32 addr, const T data) {
                                                                 config.GetPhysicalAddress());
             }
 
-            Pica::CommandProcessor::ProcessCommandList(buffer, config.size);
+            // Like on hardware, the program must keep the command list intact until the GPU
+            // signals P3D, so it does not need to be copied
+            RunGPUWork([buffer, size = static_cast<u32>(config.size)] {
+                MICROPROFILE_SCOPE(GPU_CmdlistProcessing);
+                Pica::CommandProcessor::ProcessCommandList(buffer, size);
+            });
 
             g_regs.command_processor_config.trigger = 0;
         }
@@ -512,8 +594,17 @@ template void Write<u8>(u32 addr, const u8 data);
 
 /// Update hardware
 static void VBlankCallback(u64 userdata, s64 cycles_late) {
+    {
+        // The frame is presented from the emulation thread, so it has to be complete
+        Core::FrameSectionScope frame_section{
+            Core::System::GetInstance().perf_stats.get(), Core::FrameSection::Gpu};
+        VideoCore::SynchronizeGPUThread();
+    }
     VideoCore::g_renderer->SwapBuffers();
 
+    // Send memory snapshots to scripting clients while the emulated state is consistent
+    Core::System::GetInstance().RPCServer().OnVBlank();
+
     // Signal to GSP that GPU interrupt has occurred
     // TODO(yuriks): hwtest to determine if PDC0 is for the Top screen and PDC1 for the Sub
     // screen, or if both use the same interrupts and these two instead determine the
@@ -559,6 +650,7 @@ void Init(Memory::MemorySystem& memory) {
 
     Core::Timing& timing = Core::System::GetInstance().CoreTiming();
     vblank_event = timing.RegisterEvent("GPU::VBlankCallback", VBlankCallback);
+    gpu_work_event = timing.RegisterEvent("GPU::GPUWorkCallback", GPUWorkCallback);
     timing.ScheduleEvent(frame_ticks, vblank_event);
 
     LOG_DEBUG(HW_GPU, "initialized OK");
@@ -8,6 +8,7 @@
 #include "common/assert.h"
 #include "common/common_types.h"
 #include "common/logging/log.h"
+#include "common/memory_util.h"
 #include "common/swap.h"
 #include "core/arm/arm_interface.h"
 #include "core/core.h"
@@ -15,6 +16,7 @@
 #include "core/hle/kernel/process.h"
 #include "core/hle/lock.h"
 #include "core/memory.h"
+#include "video_core/gpu_thread.h"
 #include "video_core/renderer_base.h"
 #include "video_core/video_core.h"
 
@@ -54,13 +56,33 @@ private:
     std::array<bool, NEW_LINEAR_HEAP_SIZE / PAGE_SIZE> new_linear_heap{};
 };
 
+/**
+ * Host memory backing a region of emulated physical memory. It is allocated directly from the OS,
+ * so that the pages only become resident once the emulated system touches them.
+ */
+class BackingMemory : NonCopyable {
+public:
+    explicit BackingMemory(std::size_t size)
+        : pointer(Common::AllocateMemoryPages(size)), size(size) {}
+
+    ~BackingMemory() {
+        Common::FreeMemoryPages(pointer, size);
+    }
+
+    u8* get() const {
+        return pointer;
+    }
+
+private:
+    u8* pointer;
+    std::size_t size;
+};
+
 class MemorySystem::Impl {
 public:
-    // Visual Studio would try to allocate these on compile time if they are std::array, which would
-    // exceed the memory limit.
-    std::unique_ptr<u8[]> fcram = std::make_unique<u8[]>(Memory::FCRAM_N3DS_SIZE);
-    std::unique_ptr<u8[]> vram = std::make_unique<u8[]>(Memory::VRAM_SIZE);
-    std::unique_ptr<u8[]> n3ds_extra_ram = std::make_unique<u8[]>(Memory::N3DS_EXTRA_RAM_SIZE);
+    BackingMemory fcram{Memory::FCRAM_N3DS_SIZE};
+    BackingMemory vram{Memory::VRAM_SIZE};
+    BackingMemory n3ds_extra_ram{Memory::N3DS_EXTRA_RAM_SIZE};
 
     PageTable* current_page_table = nullptr;
     RasterizerCacheMarker cache_marker;
@@ -407,6 +429,7 @@ void RasterizerFlushRegion(PAddr start, u32 size) {
         return;
     }
 
+    VideoCore::SynchronizeGPUThread();
     VideoCore::g_renderer->Rasterizer()->FlushRegion(start, size);
 }
 
@@ -415,6 +438,7 @@ void RasterizerInvalidateRegion(PAddr start, u32 size) {
         return;
     }
 
+    VideoCore::SynchronizeGPUThread();
     VideoCore::g_renderer->Rasterizer()->InvalidateRegion(start, size);
 }
 
@@ -425,6 +449,7 @@ void RasterizerFlushAndInvalidateRegion(PAddr start, u32 size) {
         return;
     }
 
+    VideoCore::SynchronizeGPUThread();
     VideoCore::g_renderer->Rasterizer()->FlushAndInvalidateRegion(start, size);
 }
 
@@ -435,6 +460,9 @@ void RasterizerFlushVirtualRegion(VAddr start, u32 size, FlushMode mode) {
         return;
     }
 
+    // Queued GPU work may read or write the region, e.g. before a GSP DMA
+    VideoCore::SynchronizeGPUThread();
+
     VAddr end = start + size;
 
     auto CheckRegion = [&](VAddr region_start, VAddr region_end, PAddr paddr_region_start) {
@@ -754,6 +782,13 @@ u8* MemorySystem::GetFCRAMPointer(u32 offset) {
     return impl->fcram.get() + offset;
 }
 
+void MemorySystem::DiscardFCRAM(u32 offset, u32 size) {
+    ASSERT(offset + size <= Memory::FCRAM_N3DS_SIZE);
+    // Queued GPU work must not access the pages while they are discarded
+    VideoCore::SynchronizeGPUThread();
+    Common::DiscardMemoryPages(impl->fcram.get() + offset, size);
+}
+
 void MemorySystem::SetDSP(AudioCore::DspInterface& dsp) {
     impl->dsp = &dsp;
 }
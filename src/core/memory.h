@@ -282,6 +282,13 @@ public:
     /// Gets pointer in FCRAM with given offset
     u8* GetFCRAMPointer(u32 offset);
 
+    /**
+     * Zeroes a range of FCRAM and releases the host memory backing it, until it is used again.
+     * @param offset Offset of the range from the beginning of FCRAM.
+     * @param size Size of the range in bytes.
+     */
+    void DiscardFCRAM(u32 offset, u32 size);
+
     /**
      * Mark each page touching the region as cached.
      */
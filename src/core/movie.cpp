@@ -20,6 +20,7 @@
 #include "core/hle/service/ir/extra_hid.h"
 #include "core/hle/service/ir/ir_rst.h"
 #include "core/movie.h"
+#include "core/movie_file.h"
 
 namespace Core {
 
@@ -106,22 +107,12 @@ struct ControllerState {
         } extra_hid_response;
     };
 };
-static_assert(sizeof(ControllerState) == 7, "ControllerState should be 7 bytes");
+static_assert(sizeof(ControllerState) == MovieRecordSize, "ControllerState should be 7 bytes");
 #pragma pack(pop)
 
-constexpr std::array<u8, 4> header_magic_bytes{{'C', 'T', 'M', 0x1B}};
+Movie::Movie() : reader(std::make_unique<MovieReader>()), writer(std::make_unique<MovieWriter>()) {}
 
-#pragma pack(push, 1)
-struct CTMHeader {
-    std::array<u8, 4> filetype;  /// Unique Identifier to check the file type (always "CTM"0x1B)
-    u64_le program_id;           /// ID of the ROM being executed. Also called title_id
-    std::array<u8, 20> revision; /// Git hash of the revision this movie was created with
-    u64_le clock_init_time;      /// The init time of the system clock
-
-    std::array<u8, 216> reserved; /// Make heading 256 bytes so it has consistent size
-};
-static_assert(sizeof(CTMHeader) == 256, "CTMHeader should be 256 bytes");
-#pragma pack(pop)
+Movie::~Movie() = default;
 
 bool Movie::IsPlayingInput() const {
     return play_mode == PlayMode::Playing;
@@ -131,18 +122,34 @@ bool Movie::IsRecordingInput() const {
 }
 
 void Movie::CheckInputEnd() {
-    if (current_byte + sizeof(ControllerState) > recorded_input.size()) {
+    if (reader->IsAtEnd()) {
         LOG_INFO(Movie, "Playback finished");
-        play_mode = PlayMode::None;
-        init_time = 0;
-        playback_completion_callback();
+        EndPlayback();
+    }
+}
+
+void Movie::EndPlayback() {
+    play_mode = PlayMode::None;
+    init_time = 0;
+    reader->Close();
+    playback_completion_callback();
+}
+
+bool Movie::ReadControllerState(ControllerState& controller_state) {
+    if (!reader->Read(reinterpret_cast<u8*>(&controller_state))) {
+        LOG_ERROR(Movie, "Failed to read input {} of the movie, stopping playback",
+                  reader->Tell());
+        EndPlayback();
+        return false;
     }
+    return true;
 }
 
 void Movie::Play(Service::HID::PadState& pad_state, s16& circle_pad_x, s16& circle_pad_y) {
     ControllerState s;
-    std::memcpy(&s, &recorded_input[current_byte], sizeof(ControllerState));
-    current_byte += sizeof(ControllerState);
+    if (!ReadControllerState(s)) {
+        return;
+    }
 
     if (s.type != ControllerStateType::PadAndCircle) {
         LOG_ERROR(Movie,
@@ -172,8 +179,9 @@ void Movie::Play(Service::HID::PadState& pad_state, s16& circle_pad_x, s16& circ
 
 void Movie::Play(Service::HID::TouchDataEntry& touch_data) {
     ControllerState s;
-    std::memcpy(&s, &recorded_input[current_byte], sizeof(ControllerState));
-    current_byte += sizeof(ControllerState);
+    if (!ReadControllerState(s)) {
+        return;
+    }
 
     if (s.type != ControllerStateType::Touch) {
         LOG_ERROR(Movie,
@@ -189,8 +197,9 @@ void Movie::Play(Service::HID::TouchDataEntry& touch_data) {
 
 void Movie::Play(Service::HID::AccelerometerDataEntry& accelerometer_data) {
     ControllerState s;
-    std::memcpy(&s, &recorded_input[current_byte], sizeof(ControllerState));
-    current_byte += sizeof(ControllerState);
+    if (!ReadControllerState(s)) {
+        return;
+    }
 
     if (s.type != ControllerStateType::Accelerometer) {
         LOG_ERROR(Movie,
@@ -206,8 +215,9 @@ void Movie::Play(Service::HID::AccelerometerDataEntry& accelerometer_data) {
 
 void Movie::Play(Service::HID::GyroscopeDataEntry& gyroscope_data) {
     ControllerState s;
-    std::memcpy(&s, &recorded_input[current_byte], sizeof(ControllerState));
-    current_byte += sizeof(ControllerState);
+    if (!ReadControllerState(s)) {
+        return;
+    }
 
     if (s.type != ControllerStateType::Gyroscope) {
         LOG_ERROR(Movie,
@@ -223,8 +233,9 @@ void Movie::Play(Service::HID::GyroscopeDataEntry& gyroscope_data) {
 
 void Movie::Play(Service::IR::PadState& pad_state, s16& c_stick_x, s16& c_stick_y) {
     ControllerState s;
-    std::memcpy(&s, &recorded_input[current_byte], sizeof(ControllerState));
-    current_byte += sizeof(ControllerState);
+    if (!ReadControllerState(s)) {
+        return;
+    }
 
     if (s.type != ControllerStateType::IrRst) {
         LOG_ERROR(Movie,
@@ -241,8 +252,9 @@ void Movie::Play(Service::IR::PadState& pad_state, s16& c_stick_x, s16& c_stick_
 
 void Movie::Play(Service::IR::ExtraHIDResponse& extra_hid_response) {
     ControllerState s;
-    std::memcpy(&s, &recorded_input[current_byte], sizeof(ControllerState));
-    current_byte += sizeof(ControllerState);
+    if (!ReadControllerState(s)) {
+        return;
+    }
 
     if (s.type != ControllerStateType::ExtraHidResponse) {
         LOG_ERROR(
@@ -263,9 +275,7 @@ void Movie::Play(Service::IR::ExtraHIDResponse& extra_hid_response) {
 }
 
 void Movie::Record(const ControllerState& controller_state) {
-    recorded_input.resize(current_byte + sizeof(ControllerState));
-    std::memcpy(&recorded_input[current_byte], &controller_state, sizeof(ControllerState));
-    current_byte += sizeof(ControllerState);
+    writer->Write(reinterpret_cast<const u8*>(&controller_state));
 }
 
 void Movie::Record(const Service::HID::PadState& pad_state, const s16& circle_pad_x,
@@ -358,6 +368,14 @@ u64 Movie::GetOverrideInitTime() const {
     return init_time;
 }
 
+std::optional<u32> Movie::GetOverrideRandomSeed() const {
+    if (!init_time) {
+        return std::nullopt;
+    }
+    // The init time is stored in the movie header, so derive the seed from it
+    return static_cast<u32>(init_time ^ (init_time >> 32));
+}
+
 Movie::ValidationResult Movie::ValidateHeader(const CTMHeader& header, u64 program_id) const {
     if (header_magic_bytes != header.filetype) {
         LOG_ERROR(Movie, "Playback file does not have valid header");
@@ -384,12 +402,6 @@ Movie::ValidationResult Movie::ValidateHeader(const CTMHeader& header, u64 progr
 
 void Movie::SaveMovie() {
     LOG_INFO(Movie, "Saving recorded movie to '{}'", record_movie_file);
-    FileUtil::IOFile save_record(record_movie_file, "wb");
-
-    if (!save_record.IsGood()) {
-        LOG_ERROR(Movie, "Unable to open file to save movie");
-        return;
-    }
 
     CTMHeader header = {};
     header.filetype = header_magic_bytes;
@@ -402,10 +414,8 @@ void Movie::SaveMovie() {
                            new CryptoPP::HexDecoder(new CryptoPP::StringSink(rev_bytes)));
     std::memcpy(header.revision.data(), rev_bytes.data(), sizeof(CTMHeader::revision));
 
-    save_record.WriteBytes(&header, sizeof(CTMHeader));
-    save_record.WriteBytes(recorded_input.data(), recorded_input.size());
-
-    if (!save_record.IsGood()) {
+    // The inputs were streamed to the file while recording, only the index and header are left
+    if (!writer->Close(header)) {
         LOG_ERROR(Movie, "Error saving movie");
     }
 }
@@ -413,26 +423,27 @@ void Movie::SaveMovie() {
 void Movie::StartPlayback(const std::string& movie_file,
                           std::function<void()> completion_callback) {
     LOG_INFO(Movie, "Loading Movie for playback");
-    FileUtil::IOFile save_record(movie_file, "rb");
-    const u64 size = save_record.GetSize();
 
-    if (save_record.IsGood() && size > sizeof(CTMHeader)) {
-        CTMHeader header;
-        save_record.ReadArray(&header, 1);
-        if (ValidateHeader(header) != ValidationResult::Invalid) {
+    // Only the header and chunk index are read here, the inputs are decoded one chunk at a time
+    if (reader->Open(movie_file) && reader->GetRecordCount() > 0) {
+        if (ValidateHeader(reader->GetHeader()) != ValidationResult::Invalid) {
             play_mode = PlayMode::Playing;
-            recorded_input.resize(size - sizeof(CTMHeader));
-            save_record.ReadArray(recorded_input.data(), recorded_input.size());
-            current_byte = 0;
             playback_completion_callback = completion_callback;
+        } else {
+            reader->Close();
         }
     } else {
         LOG_ERROR(Movie, "Failed to playback movie: Unable to open '{}'", movie_file);
+        reader->Close();
     }
 }
 
 void Movie::StartRecording(const std::string& movie_file) {
     LOG_INFO(Movie, "Enabling Movie recording");
+    if (!writer->Open(movie_file)) {
+        LOG_ERROR(Movie, "Failed to record movie: Unable to create '{}'", movie_file);
+        return;
+    }
     play_mode = PlayMode::Recording;
     record_movie_file = movie_file;
 }
@@ -492,18 +503,19 @@ void Movie::Shutdown() {
     }
 
     play_mode = PlayMode::None;
-    recorded_input.resize(0);
+    reader->Close();
     record_movie_file.clear();
-    current_byte = 0;
     init_time = 0;
 }
 
 template <typename... Targs>
 void Movie::Handle(Targs&... Fargs) {
     if (IsPlayingInput()) {
-        ASSERT(current_byte + sizeof(ControllerState) <= recorded_input.size());
+        ASSERT(!reader->IsAtEnd());
         Play(Fargs...);
-        CheckInputEnd();
+        if (IsPlayingInput()) {
+            CheckInputEnd();
+        }
     } else if (IsRecordingInput()) {
         Record(Fargs...);
     }
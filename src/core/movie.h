@@ -5,6 +5,8 @@
 #pragma once
 
 #include <functional>
+#include <memory>
+#include <optional>
 #include "common/common_types.h"
 
 namespace Service {
@@ -23,10 +25,15 @@ union PadState;
 namespace Core {
 struct CTMHeader;
 struct ControllerState;
+class MovieReader;
+class MovieWriter;
 enum class PlayMode;
 
 class Movie {
 public:
+    Movie();
+    ~Movie();
+
     enum class ValidationResult {
         OK,
         RevisionDismatch,
@@ -55,6 +62,12 @@ public:
 
     /// Get the init time that would override the one in the settings
     u64 GetOverrideInitTime() const;
+
+    /**
+     * Get the seed that replaces host entropy for emulated random number generators, so that
+     * recording and playback see the same random data. Only set while a movie is in use.
+     */
+    std::optional<u32> GetOverrideRandomSeed() const;
     u64 GetMovieProgramID(const std::string& movie_file) const;
 
     void Shutdown();
@@ -102,6 +115,8 @@ private:
     static Movie s_instance;
 
     void CheckInputEnd();
+    void EndPlayback();
+    bool ReadControllerState(ControllerState& controller_state);
 
     template <typename... Targs>
     void Handle(Targs&... Fargs);
@@ -128,9 +143,9 @@ private:
 
     PlayMode play_mode;
     std::string record_movie_file;
-    std::vector<u8> recorded_input;
+    std::unique_ptr<MovieReader> reader;
+    std::unique_ptr<MovieWriter> writer;
     u64 init_time;
     std::function<void()> playback_completion_callback;
-    std::size_t current_byte = 0;
 };
 } // namespace Core
\ No newline at end of file
@@ -0,0 +1,366 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <utility>
+#include "common/logging/log.h"
+#include "common/zstd_compression.h"
+#include "core/movie_file.h"
+
+namespace Core {
+
+using RecordPayload = std::array<u8, MovieRecordSize - 1>;
+
+/**
+ * Replaces the payload of every record with its difference (XOR) to the previous record of the
+ * same type, then stores the records byte plane by byte plane. Inputs mostly repeat from one poll
+ * to the next, so this leaves long runs of zeroes for the compressor.
+ */
+static std::vector<u8> EncodeChunk(const std::vector<u8>& records) {
+    const std::size_t count = records.size() / MovieRecordSize;
+    std::array<RecordPayload, 256> previous{};
+    std::vector<u8> encoded(records.size());
+    for (std::size_t i = 0; i < count; ++i) {
+        const u8* record = &records[i * MovieRecordSize];
+        RecordPayload& reference = previous[record[0]];
+        encoded[i] = record[0];
+        for (std::size_t byte = 1; byte < MovieRecordSize; ++byte) {
+            encoded[byte * count + i] = record[byte] ^ reference[byte - 1];
+            reference[byte - 1] = record[byte];
+        }
+    }
+    return encoded;
+}
+
+static std::vector<u8> DecodeChunk(const std::vector<u8>& encoded) {
+    const std::size_t count = encoded.size() / MovieRecordSize;
+    std::array<RecordPayload, 256> previous{};
+    std::vector<u8> records(encoded.size());
+    for (std::size_t i = 0; i < count; ++i) {
+        u8* record = &records[i * MovieRecordSize];
+        record[0] = encoded[i];
+        RecordPayload& reference = previous[record[0]];
+        for (std::size_t byte = 1; byte < MovieRecordSize; ++byte) {
+            record[byte] = encoded[byte * count + i] ^ reference[byte - 1];
+            reference[byte - 1] = record[byte];
+        }
+    }
+    return records;
+}
+
+bool MovieWriter::Open(const std::string& path) {
+    pending.clear();
+    index.clear();
+    record_count = 0;
+    failed = false;
+
+    if (!file.Open(path, "wb")) {
+        LOG_ERROR(Movie, "Unable to create movie file '{}'", path);
+        return false;
+    }
+
+    // Written again on Close, until then the movie can only be indexed by walking its chunks
+    CTMHeader header{};
+    header.filetype = header_magic_bytes;
+    header.format = static_cast<u32>(MovieFormat::Chunked);
+    if (file.WriteObject(header) != 1) {
+        failed = true;
+    }
+    pending.reserve(MovieChunkRecords * MovieRecordSize);
+    return true;
+}
+
+void MovieWriter::Write(const u8* record) {
+    pending.insert(pending.end(), record, record + MovieRecordSize);
+    ++record_count;
+    if (pending.size() == MovieChunkRecords * MovieRecordSize) {
+        FlushChunk();
+    }
+}
+
+void MovieWriter::FlushChunk() {
+    if (pending.empty()) {
+        return;
+    }
+
+    const u32 count = static_cast<u32>(pending.size() / MovieRecordSize);
+    const std::vector<u8> encoded = EncodeChunk(pending);
+    std::vector<u8> compressed =
+        Common::Compression::CompressDataZSTDDefault(encoded.data(), encoded.size());
+
+    CTMChunkHeader chunk_header;
+    chunk_header.record_count = static_cast<u16>(count);
+    chunk_header.flags = 0;
+    if (compressed.empty()) {
+        // Zstandard is optional, store the chunk as it is rather than losing it
+        compressed = encoded;
+        chunk_header.flags = static_cast<u16>(MovieChunkFlags::Uncompressed);
+    }
+    chunk_header.compressed_size = static_cast<u32>(compressed.size());
+
+    CTMChunkIndexEntry entry;
+    entry.offset = file.Tell();
+    entry.first_record = record_count - count;
+    entry.record_count = count;
+    entry.compressed_size = static_cast<u32>(compressed.size());
+
+    if (file.WriteObject(chunk_header) != 1 ||
+        file.WriteBytes(compressed.data(), compressed.size()) != compressed.size()) {
+        LOG_ERROR(Movie, "Failed to write movie chunk at record {}", entry.first_record);
+        failed = true;
+    }
+    // Keep the chunks on disk in case recording is interrupted
+    file.Flush();
+
+    index.push_back(entry);
+    pending.clear();
+}
+
+bool MovieWriter::Close(CTMHeader header) {
+    if (!file.IsOpen()) {
+        return false;
+    }
+
+    FlushChunk();
+
+    header.filetype = header_magic_bytes;
+    header.format = static_cast<u32>(MovieFormat::Chunked);
+    header.chunk_count = static_cast<u32>(index.size());
+    header.index_offset = file.Tell();
+    header.record_count = record_count;
+
+    if (file.WriteArray(index.data(), index.size()) != index.size() ||
+        !file.Seek(0, SEEK_SET) || file.WriteObject(header) != 1) {
+        failed = true;
+    }
+
+    const bool success = !failed && file.IsGood();
+    file.Close();
+    pending.clear();
+    index.clear();
+    return success;
+}
+
+bool MovieReader::Open(const std::string& path) {
+    Close();
+
+    if (!file.Open(path, "rb") || file.ReadArray(&header, 1) != 1 ||
+        header.filetype != header_magic_bytes) {
+        LOG_ERROR(Movie, "'{}' is not a valid movie file", path);
+        Close();
+        return false;
+    }
+
+    switch (static_cast<MovieFormat>(static_cast<u32>(header.format))) {
+    case MovieFormat::Flat: {
+        // Index the flat records as if they were stored in uncompressed chunks
+        const u64 count = (file.GetSize() - sizeof(CTMHeader)) / MovieRecordSize;
+        for (u64 first = 0; first < count; first += MovieChunkRecords) {
+            CTMChunkIndexEntry entry;
+            entry.offset = sizeof(CTMHeader) + first * MovieRecordSize;
+            entry.first_record = first;
+            entry.record_count = static_cast<u32>(std::min<u64>(MovieChunkRecords, count - first));
+            entry.compressed_size = 0;
+            index.push_back(entry);
+        }
+        break;
+    }
+    case MovieFormat::Chunked:
+        if (!ReadIndex()) {
+            index.clear();
+            file.Clear();
+        }
+        if (index.empty() && !BuildIndex()) {
+            LOG_ERROR(Movie, "Unable to index movie file '{}'", path);
+            Close();
+            return false;
+        }
+        break;
+    default:
+        LOG_ERROR(Movie, "Movie file '{}' has unknown format {}", path,
+                  static_cast<u32>(header.format));
+        Close();
+        return false;
+    }
+
+    record_count = index.empty() ? 0 : index.back().first_record + index.back().record_count;
+    return true;
+}
+
+bool MovieReader::ReadIndex() {
+    if (header.index_offset == 0) {
+        LOG_WARNING(Movie, "Movie has no chunk index, it was probably not closed properly");
+        return false;
+    }
+
+    const u64 size = file.GetSize();
+    const bool index_fits =
+        header.index_offset >= sizeof(CTMHeader) && header.index_offset <= size &&
+        (size - header.index_offset) / sizeof(CTMChunkIndexEntry) >= header.chunk_count;
+    if (index_fits) {
+        index.resize(header.chunk_count);
+    }
+    if (!index_fits || !file.Seek(header.index_offset, SEEK_SET) ||
+        file.ReadArray(index.data(), index.size()) != index.size()) {
+        LOG_WARNING(Movie, "Failed to read the chunk index of the movie");
+        return false;
+    }
+
+    // The index comes from the file, so make sure that every chunk is inside the file and that
+    // the chunks cover the records without gaps before using it
+    u64 first = 0;
+    for (const CTMChunkIndexEntry& entry : index) {
+        if (entry.first_record != first || entry.record_count == 0 ||
+            entry.record_count > MovieChunkRecords || entry.offset < sizeof(CTMHeader) ||
+            entry.offset > size ||
+            size - entry.offset < sizeof(CTMChunkHeader) + entry.compressed_size) {
+            LOG_WARNING(Movie, "Movie has an invalid chunk index");
+            return false;
+        }
+        first += entry.record_count;
+    }
+    return true;
+}
+
+bool MovieReader::BuildIndex() {
+    // A movie that was closed has its index after the chunks, which must not be taken for a chunk
+    const u64 size = header.index_offset > sizeof(CTMHeader) && header.index_offset < file.GetSize()
+                         ? header.index_offset
+                         : file.GetSize();
+    u64 offset = sizeof(CTMHeader);
+    u64 first = 0;
+    while (offset + sizeof(CTMChunkHeader) <= size &&
+           (header.record_count == 0 || first < header.record_count)) {
+        CTMChunkHeader chunk_header;
+        if (!file.Seek(offset, SEEK_SET) || file.ReadArray(&chunk_header, 1) != 1) {
+            return false;
+        }
+        if (offset + sizeof(CTMChunkHeader) + chunk_header.compressed_size > size ||
+            chunk_header.record_count == 0 || chunk_header.record_count > MovieChunkRecords) {
+            // The last chunk was cut off, or the rest of the file is not a chunk
+            break;
+        }
+
+        CTMChunkIndexEntry entry;
+        entry.offset = offset;
+        entry.first_record = first;
+        entry.record_count = chunk_header.record_count;
+        entry.compressed_size = chunk_header.compressed_size;
+        index.push_back(entry);
+
+        first += chunk_header.record_count;
+        offset += sizeof(CTMChunkHeader) + chunk_header.compressed_size;
+    }
+    return true;
+}
+
+void MovieReader::Close() {
+    file.Close();
+    header = {};
+    index.clear();
+    record_count = 0;
+    position = 0;
+    current_chunk = 0;
+    chunk_loaded = false;
+    chunk_records.clear();
+}
+
+bool MovieReader::LoadChunk(std::size_t chunk) {
+    const CTMChunkIndexEntry& entry = index[chunk];
+    const std::size_t size = entry.record_count * MovieRecordSize;
+    chunk_loaded = false;
+
+    if (header.format == static_cast<u32>(MovieFormat::Flat)) {
+        chunk_records.resize(size);
+        if (!file.Seek(entry.offset, SEEK_SET) ||
+            file.ReadBytes(chunk_records.data(), size) != size) {
+            LOG_ERROR(Movie, "Failed to read movie records at record {}", entry.first_record);
+            return false;
+        }
+    } else {
+        CTMChunkHeader chunk_header;
+        std::vector<u8> compressed(entry.compressed_size);
+        if (!file.Seek(entry.offset, SEEK_SET) || file.ReadArray(&chunk_header, 1) != 1 ||
+            file.ReadBytes(compressed.data(), compressed.size()) != compressed.size()) {
+            LOG_ERROR(Movie, "Failed to read movie chunk at record {}", entry.first_record);
+            return false;
+        }
+        const bool uncompressed =
+            chunk_header.flags & static_cast<u16>(MovieChunkFlags::Uncompressed);
+        const std::vector<u8> encoded =
+            uncompressed ? std::move(compressed)
+                         : Common::Compression::DecompressDataZSTD(compressed.data(),
+                                                                   compressed.size(), size);
+        if (encoded.size() != size) {
+            LOG_ERROR(Movie, "Failed to decompress movie chunk at record {}", entry.first_record);
+            return false;
+        }
+        chunk_records = DecodeChunk(encoded);
+    }
+
+    current_chunk = chunk;
+    chunk_loaded = true;
+    return true;
+}
+
+bool MovieReader::Read(u8* record) {
+    if (IsAtEnd()) {
+        return false;
+    }
+
+    if (!chunk_loaded || position < index[current_chunk].first_record ||
+        position >= index[current_chunk].first_record + index[current_chunk].record_count) {
+        const auto it = std::upper_bound(index.begin(), index.end(), position,
+                                         [](u64 value, const CTMChunkIndexEntry& entry) {
+                                             return value < entry.first_record;
+                                         });
+        if (!LoadChunk(static_cast<std::size_t>(it - index.begin()) - 1)) {
+            return false;
+        }
+    }
+
+    const u64 offset = (position - index[current_chunk].first_record) * MovieRecordSize;
+    std::memcpy(record, &chunk_records[offset], MovieRecordSize);
+    ++position;
+    return true;
+}
+
+bool MovieReader::Seek(u64 record) {
+    if (record > record_count) {
+        return false;
+    }
+    position = record;
+    return true;
+}
+
+bool ConvertMovie(const std::string& input_path, const std::string& output_path) {
+    MovieReader reader;
+    if (!reader.Open(input_path)) {
+        return false;
+    }
+
+    MovieWriter writer;
+    if (!writer.Open(output_path)) {
+        return false;
+    }
+
+    std::array<u8, MovieRecordSize> record;
+    while (reader.Read(record.data())) {
+        writer.Write(record.data());
+    }
+    const bool read_all = reader.IsAtEnd();
+    const bool written = writer.Close(reader.GetHeader());
+    if (!read_all || !written) {
+        LOG_ERROR(Movie, "Failed to convert movie '{}' to '{}'", input_path, output_path);
+        return false;
+    }
+
+    LOG_INFO(Movie, "Converted {} records from '{}' to '{}'", reader.GetRecordCount(), input_path,
+             output_path);
+    return true;
+}
+
+} // namespace Core
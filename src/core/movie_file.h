@@ -0,0 +1,178 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "common/common_types.h"
+#include "common/file_util.h"
+#include "common/swap.h"
+
+namespace Core {
+
+/// Size of a single recorded controller state
+constexpr std::size_t MovieRecordSize = 7;
+/// Number of records that are encoded and compressed together. Chunks can be decoded on their own,
+/// which is what allows seeking in a movie.
+constexpr u32 MovieChunkRecords = 4096;
+
+constexpr std::array<u8, 4> header_magic_bytes{{'C', 'T', 'M', 0x1B}};
+
+enum class MovieFormat : u32 {
+    /// The records follow the header one after another, uncompressed
+    Flat = 0,
+    /// The records are stored in compressed chunks, followed by an index of the chunks
+    Chunked = 1,
+};
+
+#pragma pack(push, 1)
+struct CTMHeader {
+    std::array<u8, 4> filetype;  /// Unique Identifier to check the file type (always "CTM"0x1B)
+    u64_le program_id;           /// ID of the ROM being executed. Also called title_id
+    std::array<u8, 20> revision; /// Git hash of the revision this movie was created with
+    u64_le clock_init_time;      /// The init time of the system clock
+    u32_le format;               /// Layout of the records, see MovieFormat
+    u32_le chunk_count;          /// Number of chunks in the chunk index
+    u64_le index_offset;         /// Offset of the chunk index, 0 if the recording was interrupted
+    u64_le record_count;         /// Number of records in all chunks
+
+    std::array<u8, 192> reserved; /// Make heading 256 bytes so it has consistent size
+};
+static_assert(sizeof(CTMHeader) == 256, "CTMHeader should be 256 bytes");
+
+enum class MovieChunkFlags : u16 {
+    /// The chunk holds the encoded records as they are, used when Zstandard is not available
+    Uncompressed = 1 << 0,
+};
+
+/// Precedes the data of every chunk
+struct CTMChunkHeader {
+    u16_le record_count;
+    u16_le flags;           /// Combination of MovieChunkFlags
+    u32_le compressed_size; /// Size of the data that follows the header
+};
+static_assert(sizeof(CTMChunkHeader) == 8, "CTMChunkHeader should be 8 bytes");
+static_assert(MovieChunkRecords <= 0xFFFF, "The record count of a chunk must fit in 16 bits");
+
+/// Entry of the chunk index at the end of a chunked movie
+struct CTMChunkIndexEntry {
+    u64_le offset;       /// Offset of the chunk header in the file
+    u64_le first_record; /// Number of records in all previous chunks
+    u32_le record_count;
+    u32_le compressed_size;
+};
+static_assert(sizeof(CTMChunkIndexEntry) == 24, "CTMChunkIndexEntry should be 24 bytes");
+#pragma pack(pop)
+
+/**
+ * Writes a chunked movie while it is being recorded, so that only the current chunk is kept in
+ * memory. The chunk index is written when the writer is closed.
+ */
+class MovieWriter {
+public:
+    /**
+     * Creates the movie file and writes a preliminary header, which is replaced on Close. If the
+     * writer is never closed, the chunks written so far can still be played back.
+     * @returns false if the file could not be created
+     */
+    bool Open(const std::string& path);
+
+    /// Appends a record of MovieRecordSize bytes
+    void Write(const u8* record);
+
+    /**
+     * Writes the remaining records, the chunk index and the final header.
+     * @param header Header to write, its format, chunk and record fields are filled in
+     * @returns false if writing the movie failed at any point
+     */
+    bool Close(CTMHeader header);
+
+    bool IsOpen() const {
+        return file.IsOpen();
+    }
+
+    u64 GetRecordCount() const {
+        return record_count;
+    }
+
+private:
+    void FlushChunk();
+
+    FileUtil::IOFile file;
+    std::vector<u8> pending;
+    std::vector<CTMChunkIndexEntry> index;
+    u64 record_count = 0;
+    bool failed = false;
+};
+
+/**
+ * Reads the records of a flat or chunked movie one chunk at a time.
+ */
+class MovieReader {
+public:
+    /**
+     * Opens a movie and reads its header and chunk index. Chunked movies without a valid index,
+     * which happens when recording was interrupted, are indexed by walking their chunk headers.
+     * @returns false if the file is not a valid movie
+     */
+    bool Open(const std::string& path);
+
+    void Close();
+
+    const CTMHeader& GetHeader() const {
+        return header;
+    }
+
+    u64 GetRecordCount() const {
+        return record_count;
+    }
+
+    /// Returns the index of the record the next Read returns
+    u64 Tell() const {
+        return position;
+    }
+
+    bool IsAtEnd() const {
+        return position >= record_count;
+    }
+
+    /**
+     * Reads the next record of MovieRecordSize bytes.
+     * @returns false at the end of the movie or if its chunk could not be read
+     */
+    bool Read(u8* record);
+
+    /**
+     * Moves to the given record, only decoding the chunk that contains it.
+     * @returns false if the record is past the end of the movie
+     */
+    bool Seek(u64 record);
+
+private:
+    bool LoadChunk(std::size_t chunk);
+    /// Reads the chunk index of a chunked movie, returns false if it is missing or invalid
+    bool ReadIndex();
+    bool BuildIndex();
+
+    FileUtil::IOFile file;
+    CTMHeader header{};
+    std::vector<CTMChunkIndexEntry> index;
+    u64 record_count = 0;
+    u64 position = 0;
+
+    std::size_t current_chunk = 0;
+    bool chunk_loaded = false;
+    std::vector<u8> chunk_records;
+};
+
+/**
+ * Converts a movie of any format into a chunked movie, keeping its header fields.
+ * @returns false if the input could not be read or the output could not be written
+ */
+bool ConvertMovie(const std::string& input_path, const std::string& output_path);
+
+} // namespace Core
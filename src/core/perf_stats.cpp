@@ -4,13 +4,13 @@
 
 #include <algorithm>
 #include <chrono>
-#include <iterator>
+#include <cmath>
 #include <mutex>
-#include <numeric>
 #include <thread>
 #include <fmt/chrono.h>
 #include <fmt/format.h>
 #include "common/file_util.h"
+#include "common/memory_util.h"
 #include "core/hw/gpu.h"
 #include "core/perf_stats.h"
 #include "core/settings.h"
@@ -26,7 +26,9 @@ constexpr std::size_t IgnoreFrames = 5;
 
 namespace Core {
 
-PerfStats::PerfStats(u64 title_id) : title_id(title_id) {}
+thread_local FrameSectionScope* FrameSectionScope::current = nullptr;
+
+PerfStats::PerfStats(u64 title_id) : title_id(title_id), frame_history(FrameHistorySize) {}
 
 PerfStats::~PerfStats() {
     if (!Settings::values.record_frame_times || title_id == 0) {
@@ -34,15 +36,30 @@ PerfStats::~PerfStats() {
     }
 
     const std::time_t t = std::time(nullptr);
-    std::ostringstream stream;
-    std::copy(perf_history.begin() + IgnoreFrames, perf_history.begin() + current_index,
-              std::ostream_iterator<double>(stream, "\n"));
+    std::string csv = "frametime_ms,length_ms,cpu_ms,gpu_ms,hle_ms,frame_limiter_ms,"
+                      "vertex_uploaded_bytes,vertex_reused_bytes,index_uploaded_bytes,"
+                      "index_reused_bytes,uniform_uploaded_bytes,lut_uploaded_bytes,"
+                      "present_latency_ms,dropped_frames\n";
+    const auto to_ms = [](u32 us) { return us / 1000.0; };
+    const std::vector<FrameRecord> history = GetFrameHistory();
+    for (std::size_t i = frames_recorded <= FrameHistorySize ? IgnoreFrames : 0;
+         i < history.size(); ++i) {
+        const FrameRecord& frame = history[i];
+        csv += fmt::format("{:.3f},{:.3f}", to_ms(frame.frametime_us), to_ms(frame.length_us));
+        for (const u32 section_us : frame.section_us) {
+            csv += fmt::format(",{:.3f}", to_ms(section_us));
+        }
+        for (const u32 bytes : frame.upload_bytes) {
+            csv += fmt::format(",{}", bytes);
+        }
+        csv += fmt::format(",{:.3f},{}\n", to_ms(frame.present_latency_us), frame.dropped_frames);
+    }
     const std::string& path = FileUtil::GetUserPath(FileUtil::UserPath::LogDir);
     // %F Date format expanded is "%Y-%m-%d"
     const std::string filename =
         fmt::format("{}/{:%F-%H-%M}_{:016X}.csv", path, *std::localtime(&t), title_id);
     FileUtil::IOFile file(filename, "w");
-    file.WriteString(stream.str());
+    file.WriteString(csv);
 }
 
 void PerfStats::BeginSystemFrame() {
@@ -56,32 +73,175 @@ void PerfStats::EndSystemFrame() {
 
     auto frame_end = Clock::now();
     const auto frame_time = frame_end - frame_begin;
-    if (current_index < perf_history.size()) {
-        perf_history[current_index++] =
-            std::chrono::duration<double, std::milli>(frame_time).count();
-    }
     accumulated_frametime += frame_time;
     system_frames += 1;
 
     previous_frame_length = frame_end - previous_frame_end;
     previous_frame_end = frame_end;
+
+    FrameRecord record{};
+    record.frametime_us = static_cast<u32>(duration_cast<microseconds>(frame_time).count());
+    record.length_us = static_cast<u32>(duration_cast<microseconds>(previous_frame_length).count());
+
+    // Whatever is not attributed to another section is spent running the emulated CPU
+    Clock::duration cpu_time = previous_frame_length;
+    for (std::size_t i = 0; i < NumFrameSections; ++i) {
+        if (i == static_cast<std::size_t>(FrameSection::Cpu)) {
+            continue;
+        }
+        const Clock::duration time{section_time[i].exchange(0, std::memory_order_relaxed)};
+        record.section_us[i] = static_cast<u32>(duration_cast<microseconds>(time).count());
+        cpu_time -= time;
+    }
+    record.section_us[static_cast<std::size_t>(FrameSection::Cpu)] = static_cast<u32>(
+        duration_cast<microseconds>(std::max(cpu_time, Clock::duration::zero())).count());
+
+    for (std::size_t i = 0; i < NumUploadCounters; ++i) {
+        record.upload_bytes[i] =
+            static_cast<u32>(upload_bytes[i].exchange(0, std::memory_order_relaxed));
+    }
+
+    if (presented_frames > 0) {
+        record.present_latency_us = static_cast<u32>(
+            duration_cast<microseconds>(present_latency / presented_frames).count());
+    }
+    record.dropped_frames = dropped_frames;
+    present_latency = Clock::duration::zero();
+    presented_frames = 0;
+    dropped_frames = 0;
+
+    AddFrameRecord(record);
 }
 
-void PerfStats::EndGameFrame() {
+void PerfStats::AddPresentedFrame(Clock::duration latency) {
     std::lock_guard lock{object_mutex};
 
-    game_frames += 1;
+    present_latency += latency;
+    presented_frames += 1;
 }
 
-double PerfStats::GetMeanFrametime() {
+void PerfStats::AddDroppedFrame() {
     std::lock_guard lock{object_mutex};
 
-    if (current_index <= IgnoreFrames) {
-        return 0;
+    dropped_frames += 1;
+}
+
+void PerfStats::AddFrameRecord(const FrameRecord& record) {
+    const u64 index = frames_recorded.load(std::memory_order_relaxed);
+    HistoryEntry& entry = frame_history[index % FrameHistorySize];
+    entry.frametime_us.store(record.frametime_us, std::memory_order_relaxed);
+    entry.length_us.store(record.length_us, std::memory_order_relaxed);
+    for (std::size_t i = 0; i < NumFrameSections; ++i) {
+        entry.section_us[i].store(record.section_us[i], std::memory_order_relaxed);
+    }
+    for (std::size_t i = 0; i < NumUploadCounters; ++i) {
+        entry.upload_bytes[i].store(record.upload_bytes[i], std::memory_order_relaxed);
+    }
+    entry.present_latency_us.store(record.present_latency_us, std::memory_order_relaxed);
+    entry.dropped_frames.store(record.dropped_frames, std::memory_order_relaxed);
+    frames_recorded.store(index + 1, std::memory_order_release);
+}
+
+std::vector<PerfStats::FrameRecord> PerfStats::GetFrameHistory(std::size_t max_frames) const {
+    const u64 end = frames_recorded.load(std::memory_order_acquire);
+    const u64 begin = end - std::min<u64>({end, max_frames, FrameHistorySize});
+
+    std::vector<FrameRecord> history(end - begin);
+    for (u64 index = begin; index < end; ++index) {
+        const HistoryEntry& entry = frame_history[index % FrameHistorySize];
+        FrameRecord& record = history[index - begin];
+        record.frametime_us = entry.frametime_us.load(std::memory_order_relaxed);
+        record.length_us = entry.length_us.load(std::memory_order_relaxed);
+        for (std::size_t i = 0; i < NumFrameSections; ++i) {
+            record.section_us[i] = entry.section_us[i].load(std::memory_order_relaxed);
+        }
+        for (std::size_t i = 0; i < NumUploadCounters; ++i) {
+            record.upload_bytes[i] = entry.upload_bytes[i].load(std::memory_order_relaxed);
+        }
+        record.present_latency_us = entry.present_latency_us.load(std::memory_order_relaxed);
+        record.dropped_frames = entry.dropped_frames.load(std::memory_order_relaxed);
+    }
+
+    // Drop the frames the emulation thread may have overwritten while they were being copied. The
+    // frame after the last recorded one is being written to the slot of the oldest one.
+    const u64 new_end = frames_recorded.load(std::memory_order_acquire);
+    if (new_end + 1 > begin + FrameHistorySize) {
+        const u64 overwritten = new_end + 1 - FrameHistorySize - begin;
+        history.erase(history.begin(),
+                      history.begin() + std::min<u64>(overwritten, history.size()));
     }
-    const double sum = std::accumulate(perf_history.begin() + IgnoreFrames,
-                                       perf_history.begin() + current_index, 0);
-    return sum / (current_index - IgnoreFrames);
+    return history;
+}
+
+PerfStats::FrameTimeSummary PerfStats::GetFrameTimeSummary(double hitch_threshold_ms) const {
+    std::vector<FrameRecord> history = GetFrameHistory();
+    if (frames_recorded <= FrameHistorySize) {
+        history.erase(history.begin(),
+                      history.begin() + std::min<std::size_t>(IgnoreFrames, history.size()));
+    }
+
+    FrameTimeSummary summary{};
+    summary.frames = history.size();
+    if (history.empty()) {
+        return summary;
+    }
+
+    std::vector<double> frametimes;
+    frametimes.reserve(history.size());
+    std::size_t presenting_frames = 0;
+    for (const FrameRecord& frame : history) {
+        const double frametime_ms = frame.frametime_us / 1000.0;
+        frametimes.push_back(frametime_ms);
+        summary.mean_ms += frametime_ms;
+        if (frametime_ms > hitch_threshold_ms) {
+            ++summary.hitches;
+        }
+        for (std::size_t i = 0; i < NumFrameSections; ++i) {
+            summary.section_mean_ms[i] += frame.section_us[i] / 1000.0;
+        }
+        for (std::size_t i = 0; i < NumUploadCounters; ++i) {
+            summary.upload_mean_bytes[i] += frame.upload_bytes[i];
+        }
+        if (frame.present_latency_us > 0) {
+            const double latency_ms = frame.present_latency_us / 1000.0;
+            summary.present_latency_mean_ms += latency_ms;
+            summary.present_latency_max_ms = std::max(summary.present_latency_max_ms, latency_ms);
+            ++presenting_frames;
+        }
+        summary.dropped_frames += frame.dropped_frames;
+    }
+    summary.mean_ms /= history.size();
+    for (double& section_mean_ms : summary.section_mean_ms) {
+        section_mean_ms /= history.size();
+    }
+    for (double& upload_mean_bytes : summary.upload_mean_bytes) {
+        upload_mean_bytes /= history.size();
+    }
+    if (presenting_frames > 0) {
+        summary.present_latency_mean_ms /= presenting_frames;
+    }
+
+    // Nearest-rank percentiles
+    std::sort(frametimes.begin(), frametimes.end());
+    const auto percentile = [&frametimes](double p) {
+        const auto rank = static_cast<std::size_t>(std::ceil(p / 100.0 * frametimes.size()));
+        return frametimes[std::clamp<std::size_t>(rank, 1, frametimes.size()) - 1];
+    };
+    summary.p50_ms = percentile(50.0);
+    summary.p95_ms = percentile(95.0);
+    summary.p99_ms = percentile(99.0);
+    summary.max_ms = frametimes.back();
+    return summary;
+}
+
+void PerfStats::EndGameFrame() {
+    std::lock_guard lock{object_mutex};
+
+    game_frames += 1;
+}
+
+double PerfStats::GetMeanFrametime() {
+    return GetFrameTimeSummary().mean_ms;
 }
 
 PerfStats::Results PerfStats::GetAndResetStats(microseconds current_system_time_us) {
@@ -99,6 +259,7 @@ PerfStats::Results PerfStats::GetAndResetStats(microseconds current_system_time_
     results.frametime = duration_cast<DoubleSecs>(accumulated_frametime).count() /
                         static_cast<double>(system_frames);
     results.emulation_speed = system_us_per_second.count() / 1'000'000.0;
+    results.host_memory_resident = Common::GetResidentMemoryUsage();
 
     // Reset counters
     reset_point = now;
@@ -9,11 +9,34 @@
 #include <chrono>
 #include <cstddef>
 #include <mutex>
+#include <vector>
 #include "common/common_types.h"
 #include "common/thread.h"
 
 namespace Core {
 
+/// Parts of a frame that the host time spent on it is split into
+enum class FrameSection : std::size_t {
+    Cpu,          ///< Emulated CPU and everything not covered by the other sections
+    Gpu,          ///< PICA command lists, display transfers, memory fills and presentation
+    Hle,          ///< SVCs and the HLE services called through them
+    FrameLimiter, ///< Waiting in the frame limiter before the frame
+};
+
+constexpr std::size_t NumFrameSections = 4;
+
+/// Data copied from emulated memory to the host GPU, counted in bytes per frame
+enum class UploadCounter : std::size_t {
+    VertexUploaded,  ///< Vertex arrays uploaded for accelerated draws
+    VertexReused,    ///< Vertex arrays of accelerated draws that were already on the host GPU
+    IndexUploaded,   ///< Index arrays uploaded for accelerated draws
+    IndexReused,     ///< Index arrays of accelerated draws that were already on the host GPU
+    UniformUploaded, ///< Uniform blocks of the shaders
+    LUTUploaded,     ///< Lighting, fog and procedural texture lookup tables
+};
+
+constexpr std::size_t NumUploadCounters = 6;
+
 /**
  * Class to manage and query performance/timing statistics. All public functions of this class are
  * thread-safe unless stated otherwise.
@@ -35,8 +58,56 @@ public:
         double frametime;
         /// Ratio of walltime / emulated time elapsed
         double emulation_speed;
+        /// Physical memory currently used by the emulator process, in bytes
+        u64 host_memory_resident;
+        /// FCRAM currently allocated by the emulated system, in bytes
+        u64 emulated_memory_used;
     };
 
+    struct FrameRecord {
+        /// Walltime of the frame, excluding any waits, in microseconds
+        u32 frametime_us;
+        /// Walltime since the end of the previous frame, in microseconds
+        u32 length_us;
+        /// Share of the frame length spent in each FrameSection, in microseconds
+        std::array<u32, NumFrameSections> section_us;
+        /// Bytes counted by each UploadCounter during the frame
+        std::array<u32, NumUploadCounters> upload_bytes;
+        /// Mean time from the end of rendering to the presentation of the rendered frames that
+        /// were presented during the frame, in microseconds. 0 if none was presented.
+        u32 present_latency_us;
+        /// Number of rendered frames that were replaced by newer ones before being presented
+        u32 dropped_frames;
+    };
+
+    struct FrameTimeSummary {
+        /// Number of frames the summary covers
+        std::size_t frames;
+        /// Frametime statistics, in milliseconds
+        double mean_ms;
+        double p50_ms;
+        double p95_ms;
+        double p99_ms;
+        double max_ms;
+        /// Number of frames whose frametime exceeded the hitch threshold
+        std::size_t hitches;
+        /// Mean time per frame spent in each FrameSection, in milliseconds
+        std::array<double, NumFrameSections> section_mean_ms;
+        /// Mean bytes per frame counted by each UploadCounter
+        std::array<double, NumUploadCounters> upload_mean_bytes;
+        /// Mean and maximum presentation latency over the frames during which a rendered frame was
+        /// presented, in milliseconds
+        double present_latency_mean_ms;
+        double present_latency_max_ms;
+        /// Total number of rendered frames that were never presented
+        std::size_t dropped_frames;
+    };
+
+    /// Frames kept in the frame history, an hour of frames at 60 fps
+    static constexpr std::size_t FrameHistorySize = 216000;
+    /// Default hitch threshold, twice the length of an emulated frame at 59.83 Hz
+    static constexpr double DefaultHitchThresholdMs = 33.43;
+
     void BeginSystemFrame();
     void EndSystemFrame();
     void EndGameFrame();
@@ -48,6 +119,53 @@ public:
      */
     double GetMeanFrametime();
 
+    /**
+     * Returns up to max_frames of the most recent frames in the frame history, oldest first.
+     * This does not block the emulation thread, which adds the frames.
+     */
+    std::vector<FrameRecord> GetFrameHistory(std::size_t max_frames = FrameHistorySize) const;
+
+    /**
+     * Returns frametime percentiles, the number of hitches and the mean section times over the
+     * frame history, skipping the first frames after boot.
+     */
+    FrameTimeSummary GetFrameTimeSummary(
+        double hitch_threshold_ms = DefaultHitchThresholdMs) const;
+
+    /**
+     * Sets whether FrameSectionScope measures the time spent in each section. This is off by
+     * default, as the HLE section is entered on every SVC. While it is off, the whole frame is
+     * counted as CPU time.
+     */
+    void SetSectionTimingEnabled(bool enabled) {
+        section_timing_enabled.store(enabled, std::memory_order_relaxed);
+    }
+
+    bool IsSectionTimingEnabled() const {
+        return section_timing_enabled.load(std::memory_order_relaxed);
+    }
+
+    /// Adds host time to a section of the current frame, usually through FrameSectionScope
+    void AddSectionTime(FrameSection section, Clock::duration duration) {
+        section_time[static_cast<std::size_t>(section)].fetch_add(duration.count(),
+                                                                  std::memory_order_relaxed);
+    }
+
+    /// Counts data uploaded to the host GPU during the current frame
+    void AddUploadedBytes(UploadCounter counter, std::size_t bytes) {
+        upload_bytes[static_cast<std::size_t>(counter)].fetch_add(bytes,
+                                                                 std::memory_order_relaxed);
+    }
+
+    /**
+     * Records a rendered frame that the frontend presented for the first time, given the time
+     * since the renderer finished it
+     */
+    void AddPresentedFrame(Clock::duration latency);
+
+    /// Records a rendered frame that was replaced by a newer one before it could be presented
+    void AddDroppedFrame();
+
     /**
      * Gets the ratio between walltime and the emulated time of the previous system frame. This is
      * useful for scaling inputs or outputs moving between the two time domains.
@@ -57,13 +175,39 @@ public:
 private:
     std::mutex object_mutex{};
 
+    /// Ring buffer entry of the frame history, stored as atomics so readers never block
+    struct HistoryEntry {
+        std::atomic<u32> frametime_us;
+        std::atomic<u32> length_us;
+        std::array<std::atomic<u32>, NumFrameSections> section_us;
+        std::array<std::atomic<u32>, NumUploadCounters> upload_bytes;
+        std::atomic<u32> present_latency_us;
+        std::atomic<u32> dropped_frames;
+    };
+
+    void AddFrameRecord(const FrameRecord& record);
+
     /// Title ID for the game that is running. 0 if there is no game running yet
     u64 title_id{0};
-    /// Current index for writing to the perf_history array
-    std::size_t current_index{0};
-    /// Stores an hour of historical frametime data useful for processing and tracking performance
-    /// regressions with code changes.
-    std::array<double, 216000> perf_history = {};
+    /// Stores the most recent frames, useful for processing and tracking performance
+    /// regressions with code changes. Only written by the emulation thread.
+    std::vector<HistoryEntry> frame_history;
+    /// Number of frames added to the frame history so far
+    std::atomic<u64> frames_recorded{0};
+
+    /// Whether FrameSectionScope measures section times
+    std::atomic_bool section_timing_enabled{false};
+    /// Host time spent in each section since the end of the previous frame
+    std::array<std::atomic<Clock::rep>, NumFrameSections> section_time{};
+    /// Bytes counted by each UploadCounter since the end of the previous frame
+    std::array<std::atomic<u64>, NumUploadCounters> upload_bytes{};
+
+    /// Total presentation latency and number of the frames presented since the end of the
+    /// previous frame
+    Clock::duration present_latency = Clock::duration::zero();
+    u32 presented_frames = 0;
+    /// Number of rendered frames dropped since the end of the previous frame
+    u32 dropped_frames = 0;
 
     /// Point when the cumulative counters were reset
     Clock::time_point reset_point = Clock::now();
@@ -85,6 +229,46 @@ private:
     Clock::duration previous_frame_length = Clock::duration::zero();
 };
 
+/**
+ * Attributes the walltime of its lifetime to a section of the current frame. Scopes can be
+ * nested on a thread, the time spent in an inner scope only counts towards the inner section.
+ * Without PerfStats, which is the case when no system is loaded, or with section timing disabled,
+ * the scope does nothing.
+ */
+class FrameSectionScope {
+public:
+    FrameSectionScope(PerfStats* perf_stats_, FrameSection section)
+        : perf_stats(perf_stats_ && perf_stats_->IsSectionTimingEnabled() ? perf_stats_ : nullptr),
+          section(section) {
+        if (perf_stats) {
+            parent = current;
+            start = PerfStats::Clock::now();
+            current = this;
+        }
+    }
+
+    ~FrameSectionScope() {
+        if (!perf_stats) {
+            return;
+        }
+        const auto duration = PerfStats::Clock::now() - start;
+        perf_stats->AddSectionTime(section, duration - child_time);
+        if (parent) {
+            parent->child_time += duration;
+        }
+        current = parent;
+    }
+
+private:
+    PerfStats* perf_stats;
+    FrameSection section;
+    FrameSectionScope* parent = nullptr;
+    PerfStats::Clock::time_point start;
+    PerfStats::Clock::duration child_time = PerfStats::Clock::duration::zero();
+
+    static thread_local FrameSectionScope* current;
+};
+
 class FrameLimiter {
 public:
     using Clock = std::chrono::high_resolution_clock;
@@ -4,8 +4,8 @@
 
 #pragma once
 
-#include <array>
 #include <functional>
+#include <vector>
 #include "common/common_types.h"
 
 namespace RPC {
@@ -14,6 +14,16 @@ enum class PacketType {
     Undefined = 0,
     ReadMemory,
     WriteMemory,
+    /// Reads a list of (address, size) ranges, replying with the concatenated data
+    ReadMemoryBatch,
+    /// Registers a list of (address, size) ranges to be sent once per frame, replying with the id
+    /// of the new subscription
+    Subscribe,
+    /// Removes the subscription with the given id
+    Unsubscribe,
+    /// Sent by the server on every VBlank for each subscription. The packet id is the id of the
+    /// subscription, the data is the frame number followed by the contents of all ranges.
+    SubscriptionUpdate,
 };
 
 struct PacketHeader {
@@ -23,15 +33,32 @@ struct PacketHeader {
     u32 packet_size;
 };
 
-constexpr u32 CURRENT_VERSION = 1;
+/// Location of a memory range in ReadMemoryBatch and Subscribe requests
+struct MemoryRange {
+    u32 address;
+    u32 size;
+};
+
+constexpr u32 CURRENT_VERSION = 2;
 constexpr u32 MIN_PACKET_SIZE = sizeof(PacketHeader);
-constexpr u32 MAX_PACKET_DATA_SIZE = 32;
+/// Maximum packet data size of the datagram transport, small enough to avoid IP fragmentation
+constexpr u32 MAX_PACKET_DATA_SIZE = 1024;
 constexpr u32 MAX_PACKET_SIZE = MIN_PACKET_SIZE + MAX_PACKET_DATA_SIZE;
-constexpr u32 MAX_READ_SIZE = MAX_PACKET_DATA_SIZE;
+/// Maximum packet data size of the stream transport, which is used for large block reads
+constexpr u32 MAX_STREAM_PACKET_DATA_SIZE = 16 * 1024 * 1024;
 
 class Packet {
 public:
-    Packet(const PacketHeader& header, u8* data, std::function<void(Packet&)> send_reply_callback);
+    /**
+     * Creates a packet from a received request.
+     * @param header Header of the request
+     * @param data Packet data of the request, header.packet_size bytes
+     * @param max_data_size Maximum packet data size the transport can send back
+     * @param send_reply_callback Sends the packet back to its origin, returning false if the
+     *                            origin can no longer be reached
+     */
+    Packet(const PacketHeader& header, const u8* data, u32 max_data_size,
+           std::function<bool(Packet&)> send_reply_callback);
 
     u32 GetVersion() const {
         return header.version;
@@ -41,38 +68,58 @@ public:
         return header.id;
     }
 
+    void SetId(u32 id) {
+        header.id = id;
+    }
+
     PacketType GetPacketType() const {
         return header.packet_type;
     }
 
+    void SetPacketType(PacketType type) {
+        header.packet_type = type;
+    }
+
     u32 GetPacketDataSize() const {
         return header.packet_size;
     }
 
+    /// Maximum packet data size of replies to this packet
+    u32 GetMaxPacketDataSize() const {
+        return max_data_size;
+    }
+
     const PacketHeader& GetHeader() const {
         return header;
     }
 
-    std::array<u8, MAX_PACKET_DATA_SIZE>& GetPacketData() {
+    std::vector<u8>& GetPacketData() {
+        return packet_data;
+    }
+
+    const std::vector<u8>& GetPacketData() const {
         return packet_data;
     }
 
     void SetPacketDataSize(u32 size) {
         header.packet_size = size;
+        packet_data.resize(size);
     }
 
-    void SendReply() {
-        send_reply_callback(*this);
+    const std::function<bool(Packet&)>& GetSendReplyCallback() const {
+        return send_reply_callback;
     }
 
-private:
-    void HandleReadMemory(u32 address, u32 data_size);
-    void HandleWriteMemory(u32 address, const u8* data, u32 data_size);
+    bool SendReply() {
+        return send_reply_callback(*this);
+    }
 
+private:
     struct PacketHeader header;
-    std::array<u8, MAX_PACKET_DATA_SIZE> packet_data;
+    std::vector<u8> packet_data;
+    u32 max_data_size;
 
-    std::function<void(Packet&)> send_reply_callback;
+    std::function<bool(Packet&)> send_reply_callback;
 };
 
 } // namespace RPC
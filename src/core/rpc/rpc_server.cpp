@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <cstring>
 #include "common/logging/log.h"
 #include "core/arm/arm_interface.h"
 #include "core/core.h"
@@ -24,27 +26,54 @@ RPCServer::~RPCServer() {
     LOG_INFO(RPC_Server, "RPC stopped.");
 }
 
-void RPCServer::HandleReadMemory(Packet& packet, u32 address, u32 data_size) {
-    if (data_size > MAX_READ_SIZE) {
-        return;
+static u64 GetTotalSize(const std::vector<MemoryRange>& ranges) {
+    u64 total_size = 0;
+    for (const auto& range : ranges) {
+        total_size += range.size;
+    }
+    return total_size;
+}
+
+/// Reads the given ranges from the current process, storing their contents one after another
+static void ReadRanges(const std::vector<MemoryRange>& ranges, u8* dest_buffer) {
+    auto& system = Core::System::GetInstance();
+    const auto process = system.Kernel().GetCurrentProcess();
+    for (const auto& range : ranges) {
+        if (process) {
+            system.Memory().ReadBlock(*process, range.address, dest_buffer, range.size);
+        } else {
+            std::memset(dest_buffer, 0, range.size);
+        }
+        dest_buffer += range.size;
     }
+}
 
+void RPCServer::HandleReadMemory(Packet& packet, u32 address, u32 data_size) {
     // Note: Memory read occurs asynchronously from the state of the emulator
-    Core::System::GetInstance().Memory().ReadBlock(
-        *Core::System::GetInstance().Kernel().GetCurrentProcess(), address,
-        packet.GetPacketData().data(), data_size);
     packet.SetPacketDataSize(data_size);
+    ReadRanges({{address, data_size}}, packet.GetPacketData().data());
     packet.SendReply();
 }
 
+/// Checks that [address, address + size) lies within one of the regions RPC clients may write to
+static bool IsWritableRange(u32 address, u32 size) {
+    // Computed in 64 bits so that the end of the range can't wrap around
+    const u64 end = static_cast<u64>(address) + size;
+    const auto in_region = [address, end](u32 region_start, u32 region_end) {
+        return address >= region_start && end <= region_end;
+    };
+    return in_region(Memory::PROCESS_IMAGE_VADDR, Memory::PROCESS_IMAGE_VADDR_END) ||
+           in_region(Memory::HEAP_VADDR, Memory::HEAP_VADDR_END) ||
+           in_region(Memory::N3DS_EXTRA_RAM_VADDR, Memory::N3DS_EXTRA_RAM_VADDR_END);
+}
+
 void RPCServer::HandleWriteMemory(Packet& packet, u32 address, const u8* data, u32 data_size) {
+    auto& system = Core::System::GetInstance();
+    const auto process = system.Kernel().GetCurrentProcess();
     // Only allow writing to certain memory regions
-    if ((address >= Memory::PROCESS_IMAGE_VADDR && address <= Memory::PROCESS_IMAGE_VADDR_END) ||
-        (address >= Memory::HEAP_VADDR && address <= Memory::HEAP_VADDR_END) ||
-        (address >= Memory::N3DS_EXTRA_RAM_VADDR && address <= Memory::N3DS_EXTRA_RAM_VADDR_END)) {
+    if (process && IsWritableRange(address, data_size)) {
         // Note: Memory write occurs asynchronously from the state of the emulator
-        Core::System::GetInstance().Memory().WriteBlock(
-            *Core::System::GetInstance().Kernel().GetCurrentProcess(), address, data, data_size);
+        system.Memory().WriteBlock(*process, address, data, data_size);
         // If the memory happens to be executable code, make sure the changes become visible
         Core::CPU().InvalidateCacheRange(address, data_size);
     }
@@ -52,6 +81,90 @@ void RPCServer::HandleWriteMemory(Packet& packet, u32 address, const u8* data, u
     packet.SendReply();
 }
 
+bool RPCServer::HandleReadMemoryBatch(Packet& packet, const std::vector<MemoryRange>& ranges) {
+    const u64 total_size = GetTotalSize(ranges);
+    if (total_size > packet.GetMaxPacketDataSize()) {
+        return false;
+    }
+
+    // Note: Like single reads, batched reads occur asynchronously from the state of the emulator
+    packet.SetPacketDataSize(static_cast<u32>(total_size));
+    ReadRanges(ranges, packet.GetPacketData().data());
+    packet.SendReply();
+    return true;
+}
+
+bool RPCServer::HandleSubscribe(Packet& packet, std::vector<MemoryRange> ranges) {
+    // Updates carry the frame number in front of the range contents
+    if (sizeof(u32) + GetTotalSize(ranges) > packet.GetMaxPacketDataSize()) {
+        return false;
+    }
+
+    u32 subscription_id;
+    {
+        std::lock_guard lock{subscription_mutex};
+        if (subscriptions.size() >= MAX_SUBSCRIPTIONS) {
+            LOG_WARNING(RPC_Server, "Too many subscriptions, rejecting new subscription");
+            return false;
+        }
+
+        subscription_id = next_subscription_id++;
+        if (next_subscription_id == 0) {
+            next_subscription_id = 1;
+        }
+        subscriptions.push_back({subscription_id, packet.GetVersion(), std::move(ranges),
+                                 packet.GetSendReplyCallback()});
+    }
+
+    packet.SetPacketDataSize(sizeof(subscription_id));
+    std::memcpy(packet.GetPacketData().data(), &subscription_id, sizeof(subscription_id));
+    packet.SendReply();
+    return true;
+}
+
+void RPCServer::HandleUnsubscribe(Packet& packet, u32 subscription_id) {
+    // Replies with 1 if the subscription was removed and 0 if there was no such subscription
+    u32 removed = 0;
+    {
+        std::lock_guard lock{subscription_mutex};
+        const auto it = std::find_if(
+            subscriptions.begin(), subscriptions.end(),
+            [subscription_id](const Subscription& entry) { return entry.id == subscription_id; });
+        if (it != subscriptions.end()) {
+            subscriptions.erase(it);
+            removed = 1;
+        }
+    }
+
+    packet.SetPacketDataSize(sizeof(removed));
+    std::memcpy(packet.GetPacketData().data(), &removed, sizeof(removed));
+    packet.SendReply();
+}
+
+void RPCServer::OnVBlank() {
+    std::lock_guard lock{subscription_mutex};
+    ++frame_number;
+
+    const auto it = std::remove_if(
+        subscriptions.begin(), subscriptions.end(), [this](const Subscription& subscription) {
+            const PacketHeader header{subscription.version, subscription.id,
+                                      PacketType::SubscriptionUpdate, 0};
+            Packet update(header, nullptr, 0, subscription.send_update_callback);
+            update.SetPacketDataSize(
+                static_cast<u32>(sizeof(frame_number) + GetTotalSize(subscription.ranges)));
+            std::memcpy(update.GetPacketData().data(), &frame_number, sizeof(frame_number));
+            ReadRanges(subscription.ranges, update.GetPacketData().data() + sizeof(frame_number));
+
+            if (!update.SendReply()) {
+                LOG_INFO(RPC_Server, "Subscriber of subscription {} is gone, removing it",
+                         subscription.id);
+                return true;
+            }
+            return false;
+        });
+    subscriptions.erase(it, subscriptions.end());
+}
+
 bool RPCServer::ValidatePacket(const PacketHeader& packet_header) {
     if (packet_header.version <= CURRENT_VERSION) {
         switch (packet_header.packet_type) {
@@ -61,6 +174,18 @@ bool RPCServer::ValidatePacket(const PacketHeader& packet_header) {
                 return true;
             }
             break;
+        case PacketType::ReadMemoryBatch:
+        case PacketType::Subscribe:
+            if (packet_header.packet_size >= sizeof(MemoryRange) &&
+                packet_header.packet_size % sizeof(MemoryRange) == 0) {
+                return true;
+            }
+            break;
+        case PacketType::Unsubscribe:
+            if (packet_header.packet_size == sizeof(u32)) {
+                return true;
+            }
+            break;
         default:
             break;
         }
@@ -68,31 +193,53 @@ bool RPCServer::ValidatePacket(const PacketHeader& packet_header) {
     return false;
 }
 
+static std::vector<MemoryRange> ParseMemoryRanges(const Packet& packet) {
+    std::vector<MemoryRange> ranges(packet.GetPacketDataSize() / sizeof(MemoryRange));
+    std::memcpy(ranges.data(), packet.GetPacketData().data(), ranges.size() * sizeof(MemoryRange));
+    return ranges;
+}
+
 void RPCServer::HandleSingleRequest(std::unique_ptr<Packet> request_packet) {
     bool success = false;
 
     if (ValidatePacket(request_packet->GetHeader())) {
-        // Currently, all request types use the address/data_size wire format
-        u32 address = 0;
-        u32 data_size = 0;
-        std::memcpy(&address, request_packet->GetPacketData().data(), sizeof(address));
-        std::memcpy(&data_size, request_packet->GetPacketData().data() + sizeof(address),
-                    sizeof(data_size));
-
         switch (request_packet->GetPacketType()) {
         case PacketType::ReadMemory:
-            if (data_size > 0 && data_size <= MAX_READ_SIZE) {
-                HandleReadMemory(*request_packet, address, data_size);
-                success = true;
-            }
-            break;
-        case PacketType::WriteMemory:
-            if (data_size > 0 && data_size <= MAX_PACKET_DATA_SIZE - (sizeof(u32) * 2)) {
+        case PacketType::WriteMemory: {
+            // Single reads and writes use the address/data_size wire format
+            u32 address = 0;
+            u32 data_size = 0;
+            std::memcpy(&address, request_packet->GetPacketData().data(), sizeof(address));
+            std::memcpy(&data_size, request_packet->GetPacketData().data() + sizeof(address),
+                        sizeof(data_size));
+
+            if (request_packet->GetPacketType() == PacketType::ReadMemory) {
+                if (data_size > 0 && data_size <= request_packet->GetMaxPacketDataSize()) {
+                    HandleReadMemory(*request_packet, address, data_size);
+                    success = true;
+                }
+            } else if (data_size > 0 &&
+                       data_size <= request_packet->GetPacketDataSize() - (sizeof(u32) * 2)) {
                 const u8* data = request_packet->GetPacketData().data() + (sizeof(u32) * 2);
                 HandleWriteMemory(*request_packet, address, data, data_size);
                 success = true;
             }
             break;
+        }
+        case PacketType::ReadMemoryBatch:
+            success = HandleReadMemoryBatch(*request_packet, ParseMemoryRanges(*request_packet));
+            break;
+        case PacketType::Subscribe:
+            success = HandleSubscribe(*request_packet, ParseMemoryRanges(*request_packet));
+            break;
+        case PacketType::Unsubscribe: {
+            u32 subscription_id = 0;
+            std::memcpy(&subscription_id, request_packet->GetPacketData().data(),
+                        sizeof(subscription_id));
+            HandleUnsubscribe(*request_packet, subscription_id);
+            success = true;
+            break;
+        }
         default:
             break;
         }
@@ -126,8 +273,14 @@ void RPCServer::Start() {
 }
 
 void RPCServer::Stop() {
-    server.Stop();
+    // Replies and updates are sent through the transports, so stop using them before they go away
+    QueueRequest(nullptr);
     request_handler_thread.join();
+    {
+        std::lock_guard lock{subscription_mutex};
+        subscriptions.clear();
+    }
+    server.Stop();
 }
 
 }; // namespace RPC
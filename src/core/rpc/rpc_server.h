@@ -5,17 +5,17 @@
 #pragma once
 
 #include <condition_variable>
+#include <functional>
 #include <memory>
 #include <mutex>
 #include <thread>
+#include <vector>
 #include "common/threadsafe_queue.h"
+#include "core/rpc/packet.h"
 #include "core/rpc/server.h"
 
 namespace RPC {
 
-class Packet;
-struct PacketHeader;
-
 class RPCServer {
 public:
     RPCServer();
@@ -23,18 +23,42 @@ public:
 
     void QueueRequest(std::unique_ptr<RPC::Packet> request);
 
+    /**
+     * Sends the contents of all subscribed memory ranges to their subscribers. Called by the
+     * emulation thread on VBlank, so that every update reflects a consistent emulator state.
+     */
+    void OnVBlank();
+
 private:
+    struct Subscription {
+        u32 id;
+        u32 version;
+        std::vector<MemoryRange> ranges;
+        std::function<bool(Packet&)> send_update_callback;
+    };
+
+    /// Maximum number of active subscriptions, across all clients
+    static constexpr std::size_t MAX_SUBSCRIPTIONS = 64;
+
     void Start();
     void Stop();
     void HandleReadMemory(Packet& packet, u32 address, u32 data_size);
     void HandleWriteMemory(Packet& packet, u32 address, const u8* data, u32 data_size);
+    bool HandleReadMemoryBatch(Packet& packet, const std::vector<MemoryRange>& ranges);
+    bool HandleSubscribe(Packet& packet, std::vector<MemoryRange> ranges);
+    void HandleUnsubscribe(Packet& packet, u32 subscription_id);
     bool ValidatePacket(const PacketHeader& packet_header);
     void HandleSingleRequest(std::unique_ptr<Packet> request);
     void HandleRequestsLoop();
 
     Server server;
-    Common::SPSCQueue<std::unique_ptr<Packet>> request_queue;
+    Common::MPSCQueue<std::unique_ptr<Packet>> request_queue;
     std::thread request_handler_thread;
+
+    std::mutex subscription_mutex;
+    std::vector<Subscription> subscriptions;
+    u32 next_subscription_id = 1;
+    u32 frame_number = 0;
 };
 
 } // namespace RPC
@@ -10,6 +10,7 @@ namespace RPC {
 
 class RPCServer;
 class UDPServer;
+class TCPServer;
 class Packet;
 
 class Server {
@@ -23,6 +24,7 @@ public:
 private:
     RPCServer& rpc_server;
     std::unique_ptr<UDPServer> udp_server;
+    std::unique_ptr<TCPServer> tcp_server;
 };
 
 } // namespace RPC
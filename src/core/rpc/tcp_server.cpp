@@ -0,0 +1,194 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <atomic>
+#include <cstring>
+#include <deque>
+#include <thread>
+#include <vector>
+#include <boost/asio.hpp>
+#include "common/common_types.h"
+#include "common/logging/log.h"
+#include "core/rpc/packet.h"
+#include "core/rpc/tcp_server.h"
+
+namespace RPC {
+
+/// Amount of reply data that may wait for a client before the client is considered stuck
+constexpr std::size_t MAX_PENDING_REPLY_SIZE = 64 * 1024 * 1024;
+
+namespace {
+/// A single client connection. Packets are framed by their PacketHeader.
+class Session : public std::enable_shared_from_this<Session> {
+public:
+    Session(boost::asio::io_context& io_context,
+            std::function<void(std::unique_ptr<Packet>)> new_request_callback)
+        : socket(io_context), new_request_callback(std::move(new_request_callback)) {}
+
+    boost::asio::ip::tcp::socket& GetSocket() {
+        return socket;
+    }
+
+    void Start() {
+        // Requests are small and latency sensitive
+        boost::system::error_code error;
+        socket.set_option(boost::asio::ip::tcp::no_delay(true), error);
+        ReadHeader();
+    }
+
+    /// Queues a packet to be sent to the client. Returns false if the client is gone.
+    bool Send(Packet& packet) {
+        if (closed) {
+            return false;
+        }
+
+        auto buffer =
+            std::make_shared<std::vector<u8>>(MIN_PACKET_SIZE + packet.GetPacketDataSize());
+        const auto header = packet.GetHeader();
+        std::memcpy(buffer->data(), &header, sizeof(header));
+        std::memcpy(buffer->data() + MIN_PACKET_SIZE, packet.GetPacketData().data(),
+                    packet.GetPacketDataSize());
+
+        if (pending_size.fetch_add(buffer->size()) + buffer->size() > MAX_PENDING_REPLY_SIZE) {
+            LOG_WARNING(RPC_Server, "Client does not receive its replies, disconnecting");
+            closed = true;
+            boost::asio::post(socket.get_executor(),
+                              [self = shared_from_this()] { self->Close(); });
+            return false;
+        }
+
+        // All socket operations happen on the I/O thread
+        boost::asio::post(socket.get_executor(),
+                          [self = shared_from_this(), buffer = std::move(buffer)]() mutable {
+                              self->write_queue.push_back(std::move(buffer));
+                              if (self->write_queue.size() == 1) {
+                                  self->WriteNext();
+                              }
+                          });
+        return true;
+    }
+
+private:
+    void ReadHeader() {
+        boost::asio::async_read(
+            socket, boost::asio::buffer(&request_header, sizeof(request_header)),
+            [self = shared_from_this()](const boost::system::error_code& error, std::size_t) {
+                if (error) {
+                    self->Close();
+                    return;
+                }
+                if (self->request_header.packet_size > MAX_STREAM_PACKET_DATA_SIZE) {
+                    LOG_WARNING(RPC_Server, "Received message with wrong size: {}",
+                                self->request_header.packet_size);
+                    self->Close();
+                    return;
+                }
+                self->request_data.resize(self->request_header.packet_size);
+                self->ReadData();
+            });
+    }
+
+    void ReadData() {
+        boost::asio::async_read(
+            socket, boost::asio::buffer(request_data),
+            [self = shared_from_this()](const boost::system::error_code& error, std::size_t) {
+                if (error) {
+                    self->Close();
+                    return;
+                }
+
+                std::weak_ptr<Session> weak_self = self;
+                auto send_reply_callback = [weak_self](Packet& reply_packet) {
+                    const auto session = weak_self.lock();
+                    return session && session->Send(reply_packet);
+                };
+                self->new_request_callback(std::make_unique<Packet>(
+                    self->request_header, self->request_data.data(), MAX_STREAM_PACKET_DATA_SIZE,
+                    std::move(send_reply_callback)));
+
+                self->ReadHeader();
+            });
+    }
+
+    void WriteNext() {
+        boost::asio::async_write(
+            socket, boost::asio::buffer(*write_queue.front()),
+            [self = shared_from_this()](const boost::system::error_code& error, std::size_t) {
+                self->pending_size -= self->write_queue.front()->size();
+                self->write_queue.pop_front();
+                if (error) {
+                    LOG_WARNING(RPC_Server, "Failed to send reply: {}", error.message());
+                    self->Close();
+                    return;
+                }
+                if (!self->write_queue.empty()) {
+                    self->WriteNext();
+                }
+            });
+    }
+
+    void Close() {
+        closed = true;
+        boost::system::error_code error;
+        socket.close(error);
+    }
+
+    boost::asio::ip::tcp::socket socket;
+    std::function<void(std::unique_ptr<Packet>)> new_request_callback;
+
+    PacketHeader request_header{};
+    std::vector<u8> request_data;
+
+    std::deque<std::shared_ptr<std::vector<u8>>> write_queue;
+    std::atomic<std::size_t> pending_size{0};
+    std::atomic<bool> closed{false};
+};
+} // Anonymous namespace
+
+class TCPServer::Impl {
+public:
+    explicit Impl(std::function<void(std::unique_ptr<Packet>)> new_request_callback)
+        // Use the same port as the UDP server
+        : acceptor(io_context, boost::asio::ip::tcp::endpoint(boost::asio::ip::tcp::v4(), 45987)),
+          new_request_callback(std::move(new_request_callback)) {
+
+        StartAccept();
+        worker_thread = std::thread([this] { io_context.run(); });
+    }
+
+    ~Impl() {
+        io_context.stop();
+        worker_thread.join();
+    }
+
+private:
+    void StartAccept() {
+        auto session = std::make_shared<Session>(io_context, new_request_callback);
+        acceptor.async_accept(session->GetSocket(),
+                              [this, session](const boost::system::error_code& error) {
+                                  if (error) {
+                                      LOG_WARNING(RPC_Server, "Failed to accept connection: {}",
+                                                  error.message());
+                                  } else {
+                                      LOG_INFO(RPC_Server, "Client connected");
+                                      session->Start();
+                                  }
+                                  StartAccept();
+                              });
+    }
+
+    std::thread worker_thread;
+
+    boost::asio::io_context io_context;
+    boost::asio::ip::tcp::acceptor acceptor;
+
+    std::function<void(std::unique_ptr<Packet>)> new_request_callback;
+};
+
+TCPServer::TCPServer(std::function<void(std::unique_ptr<Packet>)> new_request_callback)
+    : impl(std::make_unique<Impl>(new_request_callback)) {}
+
+TCPServer::~TCPServer() = default;
+
+} // namespace RPC
@@ -0,0 +1,25 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <functional>
+#include <memory>
+
+namespace RPC {
+
+class Packet;
+
+/// Stream transport of the RPC server, which allows packets larger than a datagram
+class TCPServer {
+public:
+    explicit TCPServer(std::function<void(std::unique_ptr<Packet>)> new_request_callback);
+    ~TCPServer();
+
+private:
+    class Impl;
+    std::unique_ptr<Impl> impl;
+};
+
+} // namespace RPC
@@ -2,6 +2,7 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <mutex>
 #include <thread>
 #include <boost/asio.hpp>
 #include "common/common_types.h"
@@ -44,10 +45,10 @@ private:
             std::memcpy(&header, request_buffer.data(), sizeof(header));
             if ((size - MIN_PACKET_SIZE) == header.packet_size) {
                 u8* data = request_buffer.data() + MIN_PACKET_SIZE;
-                std::function<void(Packet&)> send_reply_callback =
+                std::function<bool(Packet&)> send_reply_callback =
                     std::bind(&Impl::SendReply, this, remote_endpoint, std::placeholders::_1);
-                std::unique_ptr<Packet> new_packet =
-                    std::make_unique<Packet>(header, data, send_reply_callback);
+                std::unique_ptr<Packet> new_packet = std::make_unique<Packet>(
+                    header, data, MAX_PACKET_DATA_SIZE, send_reply_callback);
 
                 // Send the request to the upper layer for handling
                 new_request_callback(std::move(new_packet));
@@ -58,7 +59,7 @@ private:
         StartReceive();
     }
 
-    void SendReply(boost::asio::ip::udp::endpoint endpoint, Packet& reply_packet) {
+    bool SendReply(boost::asio::ip::udp::endpoint endpoint, Packet& reply_packet) {
         std::vector<u8> reply_buffer(MIN_PACKET_SIZE + reply_packet.GetPacketDataSize());
         auto reply_header = reply_packet.GetHeader();
 
@@ -66,17 +67,23 @@ private:
         std::memcpy(reply_buffer.data() + (4 * sizeof(u32)), reply_packet.GetPacketData().data(),
                     reply_packet.GetPacketDataSize());
 
+        // Replies are sent from the request handler thread, subscription updates from the
+        // emulation thread
         boost::system::error_code error;
-        socket.send_to(boost::asio::buffer(reply_buffer), endpoint, 0, error);
+        {
+            std::lock_guard lock{send_mutex};
+            socket.send_to(boost::asio::buffer(reply_buffer), endpoint, 0, error);
+        }
 
         if (error) {
             LOG_WARNING(RPC_Server, "Failed to send reply: {}", error.message());
-        } else {
-            LOG_INFO(RPC_Server, "Sent reply version({}) id=({}) type=({}) size=({})",
-                     reply_packet.GetVersion(), reply_packet.GetId(),
-                     static_cast<u32>(reply_packet.GetPacketType()),
-                     reply_packet.GetPacketDataSize());
+            return false;
         }
+        LOG_TRACE(RPC_Server, "Sent reply version({}) id=({}) type=({}) size=({})",
+                  reply_packet.GetVersion(), reply_packet.GetId(),
+                  static_cast<u32>(reply_packet.GetPacketType()),
+                  reply_packet.GetPacketDataSize());
+        return true;
     }
 
     std::thread worker_thread;
@@ -85,6 +92,7 @@ private:
     boost::asio::ip::udp::socket socket;
     std::array<u8, MAX_PACKET_SIZE> request_buffer;
     boost::asio::ip::udp::endpoint remote_endpoint;
+    std::mutex send_mutex;
 
     std::function<void(std::unique_ptr<Packet>)> new_request_callback;
 };
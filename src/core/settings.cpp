@@ -24,7 +24,8 @@ void Apply() {
     GDBStub::SetServerPort(values.gdbstub_port);
     GDBStub::ToggleServer(values.use_gdbstub);
 
-    VideoCore::g_hw_renderer_enabled = values.use_hw_renderer;
+    // The null renderer has no graphics context and always rasterizes in software
+    VideoCore::g_hw_renderer_enabled = values.use_hw_renderer && !values.use_null_renderer;
     VideoCore::g_shader_jit_enabled = values.use_shader_jit;
     VideoCore::g_hw_shader_enabled = values.use_hw_shader;
     VideoCore::g_hw_shader_accurate_mul = values.shaders_accurate_mul;
@@ -73,8 +74,11 @@ void LogSettings() {
     LOG_INFO(Config, "Citra Configuration:");
     LogSetting("Core_UseCpuJit", Settings::values.use_cpu_jit);
     LogSetting("Renderer_UseGLES", Settings::values.use_gles);
+    LogSetting("Renderer_UseNullRenderer", Settings::values.use_null_renderer);
     LogSetting("Renderer_UseHwRenderer", Settings::values.use_hw_renderer);
     LogSetting("Renderer_UseHwShader", Settings::values.use_hw_shader);
+    LogSetting("Renderer_UseAsyncGpu", Settings::values.use_async_gpu);
+    LogSetting("Renderer_UseVertexBufferCache", Settings::values.use_vertex_buffer_cache);
     LogSetting("Renderer_ShadersAccurateMul", Settings::values.shaders_accurate_mul);
     LogSetting("Renderer_UseShaderJit", Settings::values.use_shader_jit);
     LogSetting("Renderer_UseResolutionFactor", Settings::values.resolution_factor);
@@ -88,6 +92,8 @@ void LogSettings() {
     LogSetting("Layout_SwapScreen", Settings::values.swap_screen);
     LogSetting("Utility_DumpTextures", Settings::values.dump_textures);
     LogSetting("Utility_CustomTextures", Settings::values.custom_textures);
+    LogSetting("Utility_VideoDumpingQueueSize", Settings::values.video_dumping_queue_size);
+    LogSetting("Utility_VideoDumpingDropFrames", Settings::values.video_dumping_drop_frames);
     LogSetting("Audio_EnableDspLle", Settings::values.enable_dsp_lle);
     LogSetting("Audio_EnableDspLleMultithread", Settings::values.enable_dsp_lle_multithread);
     LogSetting("Audio_OutputEngine", Settings::values.sink_id);
@@ -139,10 +139,13 @@ struct Values {
 
     // Renderer
     bool use_gles;
+    bool use_null_renderer;
     bool use_hw_renderer;
     bool use_hw_shader;
     bool shaders_accurate_mul;
     bool use_shader_jit;
+    bool use_async_gpu;
+    bool use_vertex_buffer_cache;
     u16 resolution_factor;
     bool use_frame_limit;
     u16 frame_limit;
@@ -172,6 +175,8 @@ struct Values {
     bool dump_textures;
     bool custom_textures;
     bool preload_textures;
+    u32 video_dumping_queue_size;
+    bool video_dumping_drop_frames;
 
     bool use_vsync_new;
 
@@ -192,6 +197,7 @@ struct Values {
 
     // Debugging
     bool record_frame_times;
+    bool record_call_stats;
     bool use_gdbstub;
     u16 gdbstub_port;
     std::string log_filter;
@@ -18,7 +18,7 @@ struct CTHeader {
     }
 
     static u32 ExpectedVersion() {
-        return 1;
+        return 2;
     }
 
     char magic[4];
@@ -56,10 +56,32 @@ struct CTHeader {
         // - Lookup tables for procedural textures
     } initial_state_offsets;
 
+    // Version 1: Offset of the array of stream elements, stored after all memory data.
+    // Version 2: Offset of the first CTChunkHeader. Chunks follow each other until the end of the
+    //            file.
     u32 stream_offset;
     u32 stream_size;
 };
 
+/**
+ * Since version 2, the command stream is stored in self-contained chunks, which are written while
+ * recording. The (possibly compressed) payload of a chunk consists of num_elements
+ * CTStreamElements followed by data_size bytes of memory data. CTMemoryLoad::file_offset then
+ * refers to an offset in the concatenated memory data of all chunks rather than to a file offset.
+ */
+struct CTChunkHeader {
+    enum : u32 {
+        COMPRESSION_NONE = 0,
+        COMPRESSION_ZSTD = 1,
+    } compression;
+
+    u32 num_elements;
+    u32 data_size;
+
+    /// Size of the payload as stored in the file
+    u32 stored_size;
+};
+
 enum CTStreamElementType : u32 {
     FrameMarker = 0xE1,
     MemoryLoad = 0xE2,
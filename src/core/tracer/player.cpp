@@ -0,0 +1,372 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <iterator>
+#include <utility>
+#include "common/file_util.h"
+#include "common/logging/log.h"
+#include "common/zstd_compression.h"
+#include "core/hw/gpu.h"
+#include "core/hw/hw.h"
+#include "core/hw/lcd.h"
+#include "core/memory.h"
+#include "core/tracer/player.h"
+#include "video_core/pica_state.h"
+#include "video_core/pica_types.h"
+#include "video_core/renderer_base.h"
+#include "video_core/video_core.h"
+
+namespace CiTrace {
+
+Player::Player(Memory::MemorySystem& memory) : memory(memory) {}
+Player::~Player() = default;
+
+bool Player::Load(const std::string& filename) {
+    FileUtil::IOFile file(filename, "rb");
+    if (!file.IsOpen()) {
+        LOG_ERROR(HW_GPU, "Could not open CiTrace file {}", filename);
+        return false;
+    }
+
+    std::vector<u8> data(file.GetSize());
+    if (file.ReadBytes(data.data(), data.size()) != data.size()) {
+        LOG_ERROR(HW_GPU, "Could not read CiTrace file {}", filename);
+        return false;
+    }
+
+    return Load(std::move(data));
+}
+
+bool Player::Load(std::vector<u8> data) {
+    file_data = std::move(data);
+    stream.clear();
+    memory_data.clear();
+    frame_count = 0;
+
+    const auto in_bounds = [this](u64 offset, u64 size) {
+        return offset <= file_data.size() && size <= file_data.size() - offset;
+    };
+
+    if (!in_bounds(0, sizeof(CTHeader))) {
+        LOG_ERROR(HW_GPU, "CiTrace is too small to contain a header");
+        return false;
+    }
+    std::memcpy(&header, file_data.data(), sizeof(CTHeader));
+
+    if (std::memcmp(header.magic, CTHeader::ExpectedMagicWord(), 4) != 0) {
+        LOG_ERROR(HW_GPU, "Invalid CiTrace magic word");
+        return false;
+    }
+    if (header.version != 1 && header.version != CTHeader::ExpectedVersion()) {
+        LOG_ERROR(HW_GPU, "Unsupported CiTrace version {}", header.version);
+        return false;
+    }
+
+    const auto& initial = header.initial_state_offsets;
+    const std::pair<u32, u32> initial_ranges[] = {
+        {initial.gpu_registers, initial.gpu_registers_size},
+        {initial.lcd_registers, initial.lcd_registers_size},
+        {initial.pica_registers, initial.pica_registers_size},
+        {initial.default_attributes, initial.default_attributes_size},
+        {initial.vs_program_binary, initial.vs_program_binary_size},
+        {initial.vs_swizzle_data, initial.vs_swizzle_data_size},
+        {initial.vs_float_uniforms, initial.vs_float_uniforms_size},
+        {initial.gs_program_binary, initial.gs_program_binary_size},
+        {initial.gs_swizzle_data, initial.gs_swizzle_data_size},
+        {initial.gs_float_uniforms, initial.gs_float_uniforms_size},
+    };
+    for (const auto& [offset, size] : initial_ranges) {
+        if (!in_bounds(offset, static_cast<u64>(size) * sizeof(u32))) {
+            LOG_ERROR(HW_GPU, "CiTrace initial state is out of bounds");
+            return false;
+        }
+    }
+
+    if (header.version == 1) {
+        if (!in_bounds(header.stream_offset,
+                       static_cast<u64>(header.stream_size) * sizeof(CTStreamElement))) {
+            LOG_ERROR(HW_GPU, "CiTrace command stream is out of bounds");
+            return false;
+        }
+
+        stream.resize(header.stream_size);
+        std::memcpy(stream.data(), file_data.data() + header.stream_offset,
+                    stream.size() * sizeof(CTStreamElement));
+    } else if (!LoadChunks()) {
+        return false;
+    }
+
+    for (const auto& element : stream) {
+        switch (element.type) {
+        case FrameMarker:
+            ++frame_count;
+            break;
+        case MemoryLoad:
+            if (element.memory_load.file_offset > GetMemoryData().size() ||
+                element.memory_load.size >
+                    GetMemoryData().size() - element.memory_load.file_offset) {
+                LOG_ERROR(HW_GPU, "CiTrace memory load is out of bounds");
+                return false;
+            }
+            break;
+        case RegisterWrite:
+            break;
+        default:
+            LOG_ERROR(HW_GPU, "Unknown CiTrace stream element type {:#x}",
+                      static_cast<u32>(element.type));
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool Player::LoadChunks() {
+    u64 offset = header.stream_offset;
+    while (offset < file_data.size()) {
+        CTChunkHeader chunk;
+        if (file_data.size() - offset < sizeof(chunk)) {
+            LOG_ERROR(HW_GPU, "CiTrace chunk header is out of bounds");
+            return false;
+        }
+        std::memcpy(&chunk, file_data.data() + offset, sizeof(chunk));
+        offset += sizeof(chunk);
+
+        if (file_data.size() - offset < chunk.stored_size) {
+            LOG_ERROR(HW_GPU, "CiTrace chunk is out of bounds");
+            return false;
+        }
+        const u8* stored = file_data.data() + offset;
+        offset += chunk.stored_size;
+
+        const u64 elements_size = static_cast<u64>(chunk.num_elements) * sizeof(CTStreamElement);
+        const u64 payload_size = elements_size + chunk.data_size;
+
+        std::vector<u8> decompressed;
+        const u8* payload = stored;
+        switch (chunk.compression) {
+        case CTChunkHeader::COMPRESSION_NONE:
+            if (chunk.stored_size != payload_size) {
+                LOG_ERROR(HW_GPU, "CiTrace chunk has an invalid size");
+                return false;
+            }
+            break;
+        case CTChunkHeader::COMPRESSION_ZSTD:
+            if (!Common::Compression::IsZSTDSupported()) {
+                LOG_ERROR(HW_GPU, "CiTrace is compressed, but zstd support is not available");
+                return false;
+            }
+            decompressed = Common::Compression::DecompressDataZSTD(stored, chunk.stored_size,
+                                                                   payload_size);
+            if (decompressed.size() != payload_size) {
+                LOG_ERROR(HW_GPU, "Could not decompress CiTrace chunk");
+                return false;
+            }
+            payload = decompressed.data();
+            break;
+        default:
+            LOG_ERROR(HW_GPU, "Unknown CiTrace chunk compression {:#x}",
+                      static_cast<u32>(chunk.compression));
+            return false;
+        }
+
+        const std::size_t first_element = stream.size();
+        stream.resize(first_element + chunk.num_elements);
+        std::memcpy(stream.data() + first_element, payload, elements_size);
+        memory_data.insert(memory_data.end(), payload + elements_size, payload + payload_size);
+    }
+
+    if (stream.size() != header.stream_size) {
+        LOG_ERROR(HW_GPU, "CiTrace contains {} stream elements, expected {}", stream.size(),
+                  header.stream_size);
+        return false;
+    }
+    return true;
+}
+
+const std::vector<u8>& Player::GetMemoryData() const {
+    return header.version == 1 ? file_data : memory_data;
+}
+
+const u32* Player::GetInitialState(u32 offset) const {
+    return reinterpret_cast<const u32*>(file_data.data() + offset);
+}
+
+static void RestoreShaderSetup(Pica::Shader::ShaderSetup& setup, const u32* program_binary,
+                               std::size_t program_binary_size, const u32* swizzle_data,
+                               std::size_t swizzle_data_size, const u32* float_uniforms,
+                               std::size_t float_uniforms_size) {
+    std::memcpy(setup.program_code.data(), program_binary,
+                std::min(program_binary_size, setup.program_code.size()) * sizeof(u32));
+    std::memcpy(setup.swizzle_data.data(), swizzle_data,
+                std::min(swizzle_data_size, setup.swizzle_data.size()) * sizeof(u32));
+    setup.MarkProgramCodeDirty();
+    setup.MarkSwizzleDataDirty();
+
+    // Float uniforms are stored as float24 values, four components per uniform
+    const std::size_t num_uniforms =
+        std::min<std::size_t>(float_uniforms_size / 4, std::size(setup.uniforms.f));
+    for (std::size_t i = 0; i < num_uniforms; ++i) {
+        for (std::size_t comp = 0; comp < 4; ++comp) {
+            setup.uniforms.f[i][comp] = Pica::float24::FromRaw(float_uniforms[4 * i + comp]);
+        }
+    }
+}
+
+static void RestoreShaderUniformRegs(Pica::Shader::ShaderSetup& setup,
+                                     const Pica::ShaderRegs& config) {
+    for (std::size_t i = 0; i < setup.uniforms.b.size(); ++i) {
+        setup.uniforms.b[i] = (config.bool_uniforms.Value() & (1 << i)) != 0;
+    }
+    for (std::size_t i = 0; i < setup.uniforms.i.size(); ++i) {
+        const auto& values = config.int_uniforms[i];
+        setup.uniforms.i[i] = Common::Vec4<u8>(values.x, values.y, values.z, values.w);
+    }
+}
+
+void Player::RestoreInitialState() {
+    const auto& initial = header.initial_state_offsets;
+
+    std::memcpy(&GPU::g_regs, GetInitialState(initial.gpu_registers),
+                std::min<std::size_t>(initial.gpu_registers_size * sizeof(u32),
+                                      sizeof(GPU::g_regs)));
+    std::memcpy(&LCD::g_regs, GetInitialState(initial.lcd_registers),
+                std::min<std::size_t>(initial.lcd_registers_size * sizeof(u32),
+                                      sizeof(LCD::g_regs)));
+
+    auto& state = Pica::g_state;
+    std::memcpy(&state.regs, GetInitialState(initial.pica_registers),
+                std::min<std::size_t>(initial.pica_registers_size * sizeof(u32),
+                                      sizeof(state.regs)));
+
+    const u32* default_attributes = GetInitialState(initial.default_attributes);
+    const std::size_t num_attributes = std::min<std::size_t>(
+        initial.default_attributes_size / 4, std::size(state.input_default_attributes.attr));
+    for (std::size_t i = 0; i < num_attributes; ++i) {
+        for (std::size_t comp = 0; comp < 4; ++comp) {
+            state.input_default_attributes.attr[i][comp] =
+                Pica::float24::FromRaw(default_attributes[4 * i + comp]);
+        }
+    }
+
+    RestoreShaderSetup(state.vs, GetInitialState(initial.vs_program_binary),
+                       initial.vs_program_binary_size, GetInitialState(initial.vs_swizzle_data),
+                       initial.vs_swizzle_data_size, GetInitialState(initial.vs_float_uniforms),
+                       initial.vs_float_uniforms_size);
+    RestoreShaderSetup(state.gs, GetInitialState(initial.gs_program_binary),
+                       initial.gs_program_binary_size, GetInitialState(initial.gs_swizzle_data),
+                       initial.gs_swizzle_data_size, GetInitialState(initial.gs_float_uniforms),
+                       initial.gs_float_uniforms_size);
+    RestoreShaderUniformRegs(state.vs, state.regs.vs);
+    RestoreShaderUniformRegs(state.gs, state.regs.gs);
+
+    // Let the rasterizer pick up the restored register state
+    auto* rasterizer = VideoCore::g_renderer->Rasterizer();
+    for (u32 id = 0; id < Pica::Regs::NUM_REGS; ++id) {
+        rasterizer->NotifyPicaRegisterChanged(id);
+    }
+}
+
+void Player::Replay(const std::function<void(std::size_t frame)>& frame_callback) {
+    RestoreInitialState();
+
+    std::size_t frame = 0;
+    for (const auto& element : stream) {
+        switch (element.type) {
+        case FrameMarker:
+            frame_callback(frame++);
+            break;
+        case MemoryLoad:
+            ApplyMemoryLoad(element.memory_load);
+            break;
+        case RegisterWrite:
+            ApplyRegisterWrite(element.register_write);
+            break;
+        }
+    }
+
+    // Render targets and transfer results stay in memory, clear them so that they can't leak
+    // into the next replay. This happens after the last frame to keep it out of frame times.
+    VideoCore::g_renderer->Rasterizer()->FlushAll();
+    if (!written_memory_known) {
+        FindWrittenMemory();
+    }
+    ClearWrittenMemory();
+}
+
+void Player::FindWrittenMemory() {
+    // Memory starts out cleared, so the pages that aren't zero are the ones that were written.
+    // Replays are deterministic, later replays write to the same pages.
+    static const std::array<u8, Memory::PAGE_SIZE> zero_page{};
+    for (const auto& [start, size] : {std::pair<PAddr, u32>{Memory::VRAM_PADDR, Memory::VRAM_SIZE},
+                                      {Memory::FCRAM_PADDR, Memory::FCRAM_N3DS_SIZE}}) {
+        const u8* pointer = memory.GetPhysicalPointer(start);
+        for (u32 offset = 0; offset < size; offset += Memory::PAGE_SIZE) {
+            if (std::memcmp(pointer + offset, zero_page.data(), zero_page.size()) == 0) {
+                continue;
+            }
+            const PAddr addr = start + offset;
+            if (!written_memory.empty() && written_memory.back().second == addr) {
+                written_memory.back().second += Memory::PAGE_SIZE;
+            } else {
+                written_memory.emplace_back(addr, addr + Memory::PAGE_SIZE);
+            }
+        }
+    }
+    written_memory_known = true;
+}
+
+void Player::ClearWrittenMemory() {
+    auto* rasterizer = VideoCore::g_renderer->Rasterizer();
+    for (const auto& [start, end] : written_memory) {
+        std::memset(memory.GetPhysicalPointer(start), 0, end - start);
+        rasterizer->InvalidateRegion(start, end - start);
+    }
+}
+
+void Player::ApplyMemoryLoad(const CTMemoryLoad& load) {
+    if (load.size == 0) {
+        return;
+    }
+
+    if (!memory.IsValidPhysicalAddress(load.physical_address) ||
+        !memory.IsValidPhysicalAddress(load.physical_address + load.size - 1)) {
+        LOG_ERROR(HW_GPU, "Skipping CiTrace memory load to invalid address {:#010X}",
+                  load.physical_address);
+        return;
+    }
+
+    std::memcpy(memory.GetPhysicalPointer(load.physical_address),
+                GetMemoryData().data() + load.file_offset, load.size);
+    VideoCore::g_renderer->Rasterizer()->InvalidateRegion(load.physical_address, load.size);
+}
+
+void Player::ApplyRegisterWrite(const CTRegisterWrite& write) {
+    // The recorder stores physical addresses, the MMIO handlers expect virtual ones
+    const u32 addr = write.physical_address - Memory::IO_AREA_PADDR + Memory::IO_AREA_VADDR;
+
+    switch (write.size) {
+    case CTRegisterWrite::SIZE_8:
+        HW::Write<u8>(addr, static_cast<u8>(write.value));
+        break;
+    case CTRegisterWrite::SIZE_16:
+        HW::Write<u16>(addr, static_cast<u16>(write.value));
+        break;
+    case CTRegisterWrite::SIZE_32:
+        HW::Write<u32>(addr, static_cast<u32>(write.value));
+        break;
+    case CTRegisterWrite::SIZE_64:
+        HW::Write<u64>(addr, write.value);
+        break;
+    default:
+        LOG_ERROR(HW_GPU, "Unknown CiTrace register write size {:#x}",
+                  static_cast<u32>(write.size));
+        break;
+    }
+}
+
+} // namespace CiTrace
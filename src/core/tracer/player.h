@@ -0,0 +1,84 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+#include "common/common_types.h"
+#include "core/tracer/citrace.h"
+
+namespace Memory {
+class MemorySystem;
+}
+
+namespace CiTrace {
+
+/**
+ * Replays CiTrace files recorded by CiTrace::Recorder. The recorded register writes are fed through
+ * the regular MMIO handlers, so command lists are processed by video_core with whichever rasterizer
+ * is currently active. No CPU emulation or loaded application is required, but the video core must
+ * have been initialized.
+ */
+class Player {
+public:
+    explicit Player(Memory::MemorySystem& memory);
+    ~Player();
+
+    /**
+     * Loads the CiTrace file with the given filename.
+     * @returns true on success, false if the file could not be read or is not a valid CiTrace
+     */
+    bool Load(const std::string& filename);
+
+    /**
+     * Loads a CiTrace from memory.
+     * @returns true on success, false if the data is not a valid CiTrace
+     */
+    bool Load(std::vector<u8> data);
+
+    /// Returns the number of frames in the loaded trace
+    std::size_t GetFrameCount() const {
+        return frame_count;
+    }
+
+    /// Restores the GPU, LCD and Pica state from the beginning of the recording
+    void RestoreInitialState();
+
+    /**
+     * Replays the whole command stream once, starting from the initial state. Physical memory is
+     * expected to be cleared before the first replay. Each replay clears the memory it wrote to
+     * once it is done, so every replay sees the same memory as the first one.
+     * @param frame_callback Invoked at every frame marker with the index of the finished frame
+     */
+    void Replay(const std::function<void(std::size_t frame)>& frame_callback);
+
+private:
+    const u32* GetInitialState(u32 offset) const;
+    bool LoadChunks();
+    const std::vector<u8>& GetMemoryData() const;
+    void ApplyMemoryLoad(const CTMemoryLoad& load);
+    void ApplyRegisterWrite(const CTRegisterWrite& write);
+    void FindWrittenMemory();
+    void ClearWrittenMemory();
+
+    Memory::MemorySystem& memory;
+
+    std::vector<u8> file_data;
+    CTHeader header{};
+    std::vector<CTStreamElement> stream;
+    std::size_t frame_count = 0;
+
+    /// Memory data decoded from the stream chunks of version 2 traces. Memory loads of version 1
+    /// traces refer to file_data instead.
+    std::vector<u8> memory_data;
+
+    /// Ranges of FCRAM and VRAM that the first replay left non-zero, as [start, end) addresses
+    std::vector<std::pair<PAddr, PAddr>> written_memory;
+    bool written_memory_known = false;
+};
+
+} // namespace CiTrace
@@ -2,19 +2,68 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <chrono>
 #include <cstring>
+#include <limits>
+#include <fmt/format.h>
 #include "common/assert.h"
+#include "common/cityhash.h"
 #include "common/file_util.h"
 #include "common/logging/log.h"
+#include "common/zstd_compression.h"
 #include "core/tracer/recorder.h"
 
 namespace CiTrace {
 
-Recorder::Recorder(const InitialState& initial_state) : initial_state(initial_state) {}
+/// Maximum amount of recorded data waiting for the writer thread before the GPU thread is blocked
+constexpr std::size_t MAX_QUEUED_BYTES = 64 * 1024 * 1024;
 
-void Recorder::Finish(const std::string& filename) {
+/// Uncompressed size after which a chunk is written out
+constexpr std::size_t CHUNK_SIZE = 4 * 1024 * 1024;
+
+/// Memory ranges are deduplicated at this granularity, aligned to physical addresses
+constexpr u32 DEDUP_PAGE_SIZE = 0x1000;
+
+static std::size_t GetQueuedSize(const std::vector<u8>& memory) {
+    return sizeof(CTStreamElement) + memory.size();
+}
+
+Recorder::Recorder(const InitialState& initial_state) {
+    temp_filename = fmt::format("{}citrace/recording_{}.ctf.part",
+                                FileUtil::GetUserPath(FileUtil::UserPath::CacheDir),
+                                std::chrono::steady_clock::now().time_since_epoch().count());
+    FileUtil::CreateFullPath(temp_filename);
+    file = std::make_unique<FileUtil::IOFile>(temp_filename, "wb");
+    if (!file->IsOpen()) {
+        LOG_ERROR(HW_GPU, "Could not create CiTrace file {}", temp_filename);
+        write_failed = true;
+    }
+
+    WriteInitialState(initial_state);
+
+    writer_thread = std::thread([this] { WriterLoop(); });
+}
+
+Recorder::~Recorder() {
+    if (!writer_thread.joinable()) {
+        return;
+    }
+
+    // The recording was never finished, discard it
+    {
+        std::lock_guard lock{queue_mutex};
+        stop_requested = true;
+    }
+    queue_not_empty.notify_one();
+    writer_thread.join();
+
+    file->Close();
+    FileUtil::Delete(temp_filename);
+}
+
+void Recorder::WriteInitialState(const InitialState& initial_state) {
     // Setup CiTrace header
-    CTHeader header;
     std::memcpy(header.magic, CTHeader::ExpectedMagicWord(), 4);
     header.version = CTHeader::ExpectedVersion();
     header.header_size = sizeof(CTHeader);
@@ -22,174 +71,102 @@ void Recorder::Finish(const std::string& filename) {
     // Calculate file offsets
     auto& initial = header.initial_state_offsets;
 
-    initial.gpu_registers_size = static_cast<u32>(initial_state.gpu_registers.size());
-    initial.lcd_registers_size = static_cast<u32>(initial_state.lcd_registers.size());
-    initial.pica_registers_size = static_cast<u32>(initial_state.pica_registers.size());
-    initial.default_attributes_size = static_cast<u32>(initial_state.default_attributes.size());
-    initial.vs_program_binary_size = static_cast<u32>(initial_state.vs_program_binary.size());
-    initial.vs_swizzle_data_size = static_cast<u32>(initial_state.vs_swizzle_data.size());
-    initial.vs_float_uniforms_size = static_cast<u32>(initial_state.vs_float_uniforms.size());
-    initial.gs_program_binary_size = static_cast<u32>(initial_state.gs_program_binary.size());
-    initial.gs_swizzle_data_size = static_cast<u32>(initial_state.gs_swizzle_data.size());
-    initial.gs_float_uniforms_size = static_cast<u32>(initial_state.gs_float_uniforms.size());
-    header.stream_size = static_cast<u32>(stream.size());
-
-    initial.gpu_registers = sizeof(header);
-    initial.lcd_registers = initial.gpu_registers + initial.gpu_registers_size * sizeof(u32);
-    initial.pica_registers = initial.lcd_registers + initial.lcd_registers_size * sizeof(u32);
-    ;
-    initial.default_attributes = initial.pica_registers + initial.pica_registers_size * sizeof(u32);
-    initial.vs_program_binary =
-        initial.default_attributes + initial.default_attributes_size * sizeof(u32);
-    initial.vs_swizzle_data =
-        initial.vs_program_binary + initial.vs_program_binary_size * sizeof(u32);
-    initial.vs_float_uniforms =
-        initial.vs_swizzle_data + initial.vs_swizzle_data_size * sizeof(u32);
-    initial.gs_program_binary =
-        initial.vs_float_uniforms + initial.vs_float_uniforms_size * sizeof(u32);
-    initial.gs_swizzle_data =
-        initial.gs_program_binary + initial.gs_program_binary_size * sizeof(u32);
-    initial.gs_float_uniforms =
-        initial.gs_swizzle_data + initial.gs_swizzle_data_size * sizeof(u32);
-    header.stream_offset = initial.gs_float_uniforms + initial.gs_float_uniforms_size * sizeof(u32);
-
-    // Iterate through stream elements, update relevant stream element data
-    for (auto& stream_element : stream) {
-        switch (stream_element.data.type) {
-        case MemoryLoad: {
-            auto& file_offset = memory_regions[stream_element.hash];
-            if (!stream_element.uses_existing_data) {
-                file_offset = header.stream_offset;
-            }
-            stream_element.data.memory_load.file_offset = file_offset;
-            break;
-        }
+    const std::vector<u32>* arrays[] = {
+        &initial_state.gpu_registers,      &initial_state.lcd_registers,
+        &initial_state.pica_registers,     &initial_state.default_attributes,
+        &initial_state.vs_program_binary,  &initial_state.vs_swizzle_data,
+        &initial_state.vs_float_uniforms,  &initial_state.gs_program_binary,
+        &initial_state.gs_swizzle_data,    &initial_state.gs_float_uniforms,
+    };
+    std::pair<u32*, u32*> offsets[] = {
+        {&initial.gpu_registers, &initial.gpu_registers_size},
+        {&initial.lcd_registers, &initial.lcd_registers_size},
+        {&initial.pica_registers, &initial.pica_registers_size},
+        {&initial.default_attributes, &initial.default_attributes_size},
+        {&initial.vs_program_binary, &initial.vs_program_binary_size},
+        {&initial.vs_swizzle_data, &initial.vs_swizzle_data_size},
+        {&initial.vs_float_uniforms, &initial.vs_float_uniforms_size},
+        {&initial.gs_program_binary, &initial.gs_program_binary_size},
+        {&initial.gs_swizzle_data, &initial.gs_swizzle_data_size},
+        {&initial.gs_float_uniforms, &initial.gs_float_uniforms_size},
+    };
+    static_assert(std::size(arrays) == std::size(offsets));
+
+    u32 offset = sizeof(CTHeader);
+    for (std::size_t i = 0; i < std::size(arrays); ++i) {
+        const u32 size = static_cast<u32>(arrays[i]->size());
+        std::memcpy(offsets[i].first, &offset, sizeof(u32));
+        std::memcpy(offsets[i].second, &size, sizeof(u32));
+        offset += size * sizeof(u32);
+    }
 
-        default:
-            // Other commands don't use any extra data
-            DEBUG_ASSERT(stream_element.extra_data.size() == 0);
-            break;
-        }
-        header.stream_offset += static_cast<u32>(stream_element.extra_data.size());
-    }
-
-    try {
-        // Open file and write header
-        FileUtil::IOFile file(filename, "wb");
-        std::size_t written = file.WriteObject(header);
-        if (written != 1 || file.Tell() != initial.gpu_registers)
-            throw "Failed to write header";
-
-        // Write initial state
-        written =
-            file.WriteArray(initial_state.gpu_registers.data(), initial_state.gpu_registers.size());
-        if (written != initial_state.gpu_registers.size() || file.Tell() != initial.lcd_registers)
-            throw "Failed to write GPU registers";
-
-        written =
-            file.WriteArray(initial_state.lcd_registers.data(), initial_state.lcd_registers.size());
-        if (written != initial_state.lcd_registers.size() || file.Tell() != initial.pica_registers)
-            throw "Failed to write LCD registers";
-
-        written = file.WriteArray(initial_state.pica_registers.data(),
-                                  initial_state.pica_registers.size());
-        if (written != initial_state.pica_registers.size() ||
-            file.Tell() != initial.default_attributes)
-            throw "Failed to write Pica registers";
-
-        written = file.WriteArray(initial_state.default_attributes.data(),
-                                  initial_state.default_attributes.size());
-        if (written != initial_state.default_attributes.size() ||
-            file.Tell() != initial.vs_program_binary)
-            throw "Failed to write default vertex attributes";
-
-        written = file.WriteArray(initial_state.vs_program_binary.data(),
-                                  initial_state.vs_program_binary.size());
-        if (written != initial_state.vs_program_binary.size() ||
-            file.Tell() != initial.vs_swizzle_data)
-            throw "Failed to write vertex shader program binary";
-
-        written = file.WriteArray(initial_state.vs_swizzle_data.data(),
-                                  initial_state.vs_swizzle_data.size());
-        if (written != initial_state.vs_swizzle_data.size() ||
-            file.Tell() != initial.vs_float_uniforms)
-            throw "Failed to write vertex shader swizzle data";
-
-        written = file.WriteArray(initial_state.vs_float_uniforms.data(),
-                                  initial_state.vs_float_uniforms.size());
-        if (written != initial_state.vs_float_uniforms.size() ||
-            file.Tell() != initial.gs_program_binary)
-            throw "Failed to write vertex shader float uniforms";
-
-        written = file.WriteArray(initial_state.gs_program_binary.data(),
-                                  initial_state.gs_program_binary.size());
-        if (written != initial_state.gs_program_binary.size() ||
-            file.Tell() != initial.gs_swizzle_data)
-            throw "Failed to write geomtry shader program binary";
-
-        written = file.WriteArray(initial_state.gs_swizzle_data.data(),
-                                  initial_state.gs_swizzle_data.size());
-        if (written != initial_state.gs_swizzle_data.size() ||
-            file.Tell() != initial.gs_float_uniforms)
-            throw "Failed to write geometry shader swizzle data";
-
-        written = file.WriteArray(initial_state.gs_float_uniforms.data(),
-                                  initial_state.gs_float_uniforms.size());
-        if (written != initial_state.gs_float_uniforms.size() ||
-            file.Tell() != initial.gs_float_uniforms + sizeof(u32) * initial.gs_float_uniforms_size)
-            throw "Failed to write geometry shader float uniforms";
-
-        // Iterate through stream elements, write "extra data"
-        for (const auto& stream_element : stream) {
-            if (stream_element.extra_data.size() == 0)
-                continue;
+    // The stream is written in chunks following the initial state. Its size is filled in when the
+    // recording is finished.
+    header.stream_offset = offset;
+    header.stream_size = 0;
 
-            written =
-                file.WriteBytes(stream_element.extra_data.data(), stream_element.extra_data.size());
-            if (written != stream_element.extra_data.size())
-                throw "Failed to write extra data";
-        }
+    WriteBytes(reinterpret_cast<const u8*>(&header), sizeof(header));
+    for (const auto* array : arrays) {
+        WriteBytes(reinterpret_cast<const u8*>(array->data()), array->size() * sizeof(u32));
+    }
+}
 
-        if (file.Tell() != header.stream_offset)
-            throw "Unexpected end of extra data";
+void Recorder::Finish(const std::string& filename) {
+    {
+        std::lock_guard lock{queue_mutex};
+        stop_requested = true;
+    }
+    queue_not_empty.notify_one();
+    writer_thread.join();
 
-        // Write actual stream elements
-        for (const auto& stream_element : stream) {
-            if (1 != file.WriteObject(stream_element.data))
-                throw "Failed to write stream element";
+    header.stream_size = total_elements;
+    if (!write_failed && (!file->Seek(0, SEEK_SET) || file->WriteObject(header) != 1)) {
+        LOG_ERROR(HW_GPU, "Writing CiTrace file failed: Failed to write header");
+        write_failed = true;
+    }
+    file->Close();
+
+    if (write_failed) {
+        FileUtil::Delete(temp_filename);
+        return;
+    }
+
+    if (FileUtil::Exists(filename)) {
+        FileUtil::Delete(filename);
+    }
+    // Renaming fails across file systems, fall back to copying the file in that case
+    if (!FileUtil::Rename(temp_filename, filename)) {
+        if (!FileUtil::Copy(temp_filename, filename)) {
+            LOG_ERROR(HW_GPU, "Writing CiTrace file failed: Could not move {} to {}",
+                      temp_filename, filename);
         }
-    } catch (const char* str) {
-        LOG_ERROR(HW_GPU, "Writing CiTrace file failed: {}", str);
+        FileUtil::Delete(temp_filename);
     }
 }
 
 void Recorder::FrameFinished() {
-    stream.push_back({{FrameMarker}});
+    QueueElement element{};
+    element.data.type = FrameMarker;
+    Push(std::move(element));
 }
 
 void Recorder::MemoryAccessed(const u8* data, u32 size, u32 physical_address) {
-    StreamElement element = {{MemoryLoad}};
+    QueueElement element{};
+    element.data.type = MemoryLoad;
     element.data.memory_load.size = size;
     element.data.memory_load.physical_address = physical_address;
 
-    // Compute hash over given memory region to check if the contents are already stored internally
-    boost::crc_32_type result;
-    result.process_bytes(data, size);
-    element.hash = result.checksum();
+    // The memory may change before the writer thread gets to it, so a copy is always required.
+    // Hashing and deduplication happen on the writer thread.
+    element.memory.assign(data, data + size);
 
-    element.uses_existing_data = (memory_regions.find(element.hash) != memory_regions.end());
-    if (!element.uses_existing_data) {
-        element.extra_data.resize(size);
-        memcpy(element.extra_data.data(), data, size);
-        memory_regions.insert({element.hash, 0}); // file offset will be initialized in Finish()
-    }
-
-    stream.push_back(element);
+    Push(std::move(element));
 }
 
 template <typename T>
 void Recorder::RegisterWritten(u32 physical_address, T value) {
-    StreamElement element = {{RegisterWrite}};
+    QueueElement element{};
+    element.data.type = RegisterWrite;
     element.data.register_write.size =
         (sizeof(T) == 1) ? CTRegisterWrite::SIZE_8
                          : (sizeof(T) == 2) ? CTRegisterWrite::SIZE_16
@@ -198,7 +175,171 @@ void Recorder::RegisterWritten(u32 physical_address, T value) {
     element.data.register_write.physical_address = physical_address;
     element.data.register_write.value = value;
 
-    stream.push_back(element);
+    Push(std::move(element));
+}
+
+void Recorder::Push(QueueElement element) {
+    const std::size_t size = GetQueuedSize(element.memory);
+    bool was_empty;
+    {
+        std::unique_lock lock{queue_mutex};
+        // Always accept an element when nothing is queued, even if it exceeds the limit by itself
+        queue_not_full.wait(lock, [this, size] {
+            return queued_bytes == 0 || queued_bytes + size <= MAX_QUEUED_BYTES;
+        });
+        queued_bytes += size;
+        was_empty = queue.empty();
+        queue.push_back(std::move(element));
+    }
+    if (was_empty) {
+        queue_not_empty.notify_one();
+    }
+}
+
+void Recorder::WriterLoop() {
+    std::vector<QueueElement> batch;
+    while (true) {
+        {
+            std::unique_lock lock{queue_mutex};
+            queue_not_empty.wait(lock, [this] { return stop_requested || !queue.empty(); });
+            if (queue.empty()) {
+                break;
+            }
+            batch.swap(queue);
+        }
+
+        std::size_t batch_bytes = 0;
+        for (const auto& element : batch) {
+            ProcessElement(element);
+            batch_bytes += GetQueuedSize(element.memory);
+        }
+        batch.clear();
+
+        {
+            std::lock_guard lock{queue_mutex};
+            queued_bytes -= batch_bytes;
+        }
+        queue_not_full.notify_all();
+    }
+
+    FlushChunk();
+}
+
+void Recorder::ProcessElement(const QueueElement& element) {
+    if (element.data.type == MemoryLoad) {
+        ProcessMemoryLoad(element);
+    } else {
+        chunk_elements.push_back(element.data);
+    }
+
+    if (chunk_elements.size() * sizeof(CTStreamElement) + chunk_data.size() >= CHUNK_SIZE) {
+        FlushChunk();
+    }
+}
+
+void Recorder::ProcessMemoryLoad(const QueueElement& element) {
+    const u8* data = element.memory.data();
+    const u32 size = static_cast<u32>(element.memory.size());
+    const u32 address = element.data.memory_load.physical_address;
+
+    // Split the range at page boundaries, so that pages shared by different ranges (e.g. a
+    // partially updated vertex buffer) are only stored once
+    u32 offset = 0;
+    while (offset < size) {
+        const u32 piece_address = address + offset;
+        const u32 piece_size =
+            std::min(size - offset, DEDUP_PAGE_SIZE - piece_address % DEDUP_PAGE_SIZE);
+        const u8* piece = data + offset;
+
+        const Common::uint128 hash128 =
+            Common::CityHash128(reinterpret_cast<const char*>(piece), piece_size);
+        const MemoryHash hash{Common::Uint128Low64(hash128), Common::Uint128High64(hash128)};
+
+        u64 data_offset;
+        const auto it = memory_regions.find(hash);
+        if (it != memory_regions.end()) {
+            data_offset = it->second;
+        } else {
+            data_offset = total_data_size + chunk_data.size();
+            if (data_offset + piece_size > std::numeric_limits<u32>::max()) {
+                if (!write_failed) {
+                    LOG_ERROR(HW_GPU, "Writing CiTrace file failed: Too much memory data");
+                    write_failed = true;
+                }
+                return;
+            }
+            chunk_data.insert(chunk_data.end(), piece, piece + piece_size);
+            memory_regions.emplace(hash, static_cast<u32>(data_offset));
+        }
+
+        // Extend the previous load of this range if both the stored data and the target memory are
+        // contiguous, which is the common case for data that has not been seen before
+        if (offset != 0) {
+            auto& previous = chunk_elements.back().memory_load;
+            if (previous.file_offset + previous.size == data_offset &&
+                previous.physical_address + previous.size == piece_address) {
+                previous.size += piece_size;
+                offset += piece_size;
+                continue;
+            }
+        }
+
+        CTStreamElement load{};
+        load.type = MemoryLoad;
+        load.memory_load.file_offset = static_cast<u32>(data_offset);
+        load.memory_load.size = piece_size;
+        load.memory_load.physical_address = piece_address;
+        chunk_elements.push_back(load);
+
+        offset += piece_size;
+    }
+}
+
+void Recorder::FlushChunk() {
+    if (chunk_elements.empty() && chunk_data.empty()) {
+        return;
+    }
+
+    CTChunkHeader chunk{};
+    chunk.num_elements = static_cast<u32>(chunk_elements.size());
+    chunk.data_size = static_cast<u32>(chunk_data.size());
+
+    const std::size_t elements_size = chunk_elements.size() * sizeof(CTStreamElement);
+    std::vector<u8> compressed;
+    if (Common::Compression::IsZSTDSupported()) {
+        std::vector<u8> payload(elements_size + chunk_data.size());
+        std::memcpy(payload.data(), chunk_elements.data(), elements_size);
+        std::memcpy(payload.data() + elements_size, chunk_data.data(), chunk_data.size());
+        compressed = Common::Compression::CompressDataZSTDDefault(payload.data(), payload.size());
+    }
+
+    if (!compressed.empty() && compressed.size() < elements_size + chunk_data.size()) {
+        chunk.compression = CTChunkHeader::COMPRESSION_ZSTD;
+        chunk.stored_size = static_cast<u32>(compressed.size());
+        WriteBytes(reinterpret_cast<const u8*>(&chunk), sizeof(chunk));
+        WriteBytes(compressed.data(), compressed.size());
+    } else {
+        chunk.compression = CTChunkHeader::COMPRESSION_NONE;
+        chunk.stored_size = static_cast<u32>(elements_size + chunk_data.size());
+        WriteBytes(reinterpret_cast<const u8*>(&chunk), sizeof(chunk));
+        WriteBytes(reinterpret_cast<const u8*>(chunk_elements.data()), elements_size);
+        WriteBytes(chunk_data.data(), chunk_data.size());
+    }
+
+    total_elements += static_cast<u32>(chunk_elements.size());
+    total_data_size += chunk_data.size();
+    chunk_elements.clear();
+    chunk_data.clear();
+}
+
+void Recorder::WriteBytes(const u8* data, std::size_t size) {
+    if (write_failed || size == 0) {
+        return;
+    }
+    if (file->WriteBytes(data, size) != size) {
+        LOG_ERROR(HW_GPU, "Writing CiTrace file failed: Could not write to {}", temp_filename);
+        write_failed = true;
+    }
 }
 
 template void Recorder::RegisterWritten(u32, u8);
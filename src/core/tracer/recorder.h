@@ -4,13 +4,20 @@
 
 #pragma once
 
+#include <condition_variable>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <vector>
-#include <boost/crc.hpp>
 #include "common/common_types.h"
 #include "core/tracer/citrace.h"
 
+namespace FileUtil {
+class IOFile;
+}
+
 namespace CiTrace {
 
 class Recorder {
@@ -29,11 +36,15 @@ public:
     };
 
     /**
-     * Recorder constructor
+     * Recorder constructor. Recording is streamed to a temporary file by a background thread
+     * until Finish is called.
      * @param initial_state Initial recorder state
      */
     explicit Recorder(const InitialState& initial_state);
 
+    /// Discards the recording if it has not been finished
+    ~Recorder();
+
     /// Finish recording of this Citrace and save it using the given filename.
     void Finish(const std::string& filename);
 
@@ -55,33 +66,66 @@ public:
     void RegisterWritten(u32 physical_address, T value);
 
 private:
-    // Initial state of recording start
-    InitialState initial_state;
-
-    // Command stream
-    struct StreamElement {
+    // Command stream element as queued for the writer thread
+    struct QueueElement {
         CTStreamElement data;
 
-        /**
-         * Extra data to store along "core" data.
-         * This is e.g. used for data used in MemoryUpdates.
-         */
-        std::vector<u8> extra_data;
+        /// Copy of the accessed memory for MemoryLoads
+        std::vector<u8> memory;
+    };
+
+    /// 128-bit content hash of a stored memory range
+    struct MemoryHash {
+        u64 low;
+        u64 high;
 
-        /// Optional CRC hash (e.g. for hashing memory regions)
-        boost::crc_32_type::value_type hash;
+        bool operator==(const MemoryHash& other) const {
+            return low == other.low && high == other.high;
+        }
+    };
 
-        /// If true, refer to data already written to the output file instead of extra_data
-        bool uses_existing_data;
+    struct MemoryHashHasher {
+        std::size_t operator()(const MemoryHash& hash) const {
+            return static_cast<std::size_t>(hash.low);
+        }
     };
 
-    std::vector<StreamElement> stream;
+    void WriteInitialState(const InitialState& initial_state);
+
+    /// Queues an element for the writer thread, blocking while the queue is full
+    void Push(QueueElement element);
+
+    void WriterLoop();
+    void ProcessElement(const QueueElement& element);
+    void ProcessMemoryLoad(const QueueElement& element);
+    void FlushChunk();
+    void WriteBytes(const u8* data, std::size_t size);
+
+    std::string temp_filename;
+    std::unique_ptr<FileUtil::IOFile> file;
+    CTHeader header{};
+
+    // State shared with the writer thread
+    std::mutex queue_mutex;
+    std::condition_variable queue_not_empty;
+    std::condition_variable queue_not_full;
+    std::vector<QueueElement> queue;
+    std::size_t queued_bytes = 0;
+    bool stop_requested = false;
+    std::thread writer_thread;
+
+    // State owned by the writer thread
+    std::vector<CTStreamElement> chunk_elements;
+    std::vector<u8> chunk_data;
+    u64 total_data_size = 0;
+    u32 total_elements = 0;
+    bool write_failed = false;
 
     /**
-     * Internal cache which maps hashes of memory contents to file offsets at which those memory
-     * contents are stored.
+     * Internal cache which maps hashes of memory contents to the offsets in the recorded memory
+     * data at which those memory contents are stored.
      */
-    std::unordered_map<boost::crc_32_type::value_type /*hash*/, u32 /*file_offset*/> memory_regions;
+    std::unordered_map<MemoryHash, u32, MemoryHashHasher> memory_regions;
 };
 
 } // namespace CiTrace
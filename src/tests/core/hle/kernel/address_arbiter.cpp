@@ -0,0 +1,123 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "core/arm/dyncom/arm_dyncom.h"
+#include "core/core_timing.h"
+#include "core/hle/kernel/address_arbiter.h"
+#include "core/hle/kernel/process.h"
+#include "core/hle/kernel/thread.h"
+#include "core/memory.h"
+
+namespace Kernel {
+
+TEST_CASE("AddressArbiter stress", "[core][kernel]") {
+    Core::Timing timing;
+    Memory::MemorySystem memory;
+    Kernel::KernelSystem kernel(memory, timing, [] {}, 0);
+    kernel.SetCPU(std::make_shared<ARM_DynCom>(nullptr, memory, USER32MODE));
+
+    auto process = kernel.CreateProcess(kernel.CreateCodeSet("", 0));
+    kernel.MapSharedPages(process->vm_manager);
+    kernel.SetCurrentProcess(process);
+
+    constexpr int num_threads = 256;
+    constexpr int num_addresses = 8;
+
+    std::vector<std::shared_ptr<Thread>> threads;
+    for (int i = 0; i < num_threads; ++i) {
+        const u32 priority = ThreadPrioUserlandMax + (i * 7) % 16;
+        threads.push_back(kernel
+                              .CreateThread("thread", Memory::SHARED_PAGE_VADDR, priority, 0, 0,
+                                            Memory::HEAP_VADDR_END, *process)
+                              .Unwrap());
+    }
+
+    // Thread local storage is zero-initialized, so it can be used as arbitration addresses.
+    std::vector<VAddr> addresses;
+    for (int i = 0; i < num_addresses; ++i) {
+        addresses.push_back(threads[i]->GetTLSAddress());
+    }
+
+    auto arbiter = kernel.CreateAddressArbiter();
+    const auto address_of = [&](int thread_index) {
+        return addresses[thread_index % num_addresses];
+    };
+
+    for (int i = 0; i < num_threads; ++i) {
+        REQUIRE(arbiter->ArbitrateAddress(threads[i], ArbitrationType::WaitIfLessThan,
+                                          address_of(i), 1, 0) == RESULT_SUCCESS);
+        REQUIRE(threads[i]->status == ThreadStatus::WaitArb);
+    }
+
+    const auto count_waiting = [&](VAddr address) {
+        int count = 0;
+        for (int i = 0; i < num_threads; ++i) {
+            if (address_of(i) == address && threads[i]->status == ThreadStatus::WaitArb)
+                ++count;
+        }
+        return count;
+    };
+
+    SECTION("signaling one thread picks the highest priority, oldest waiter") {
+        const VAddr address = addresses[0];
+        std::vector<int> woken;
+        while (count_waiting(address) > 0) {
+            REQUIRE(arbiter->ArbitrateAddress(nullptr, ArbitrationType::Signal, address, 1, 0) ==
+                    RESULT_SUCCESS);
+            for (int i = 0; i < num_threads; ++i) {
+                if (address_of(i) == address && threads[i]->status == ThreadStatus::Ready &&
+                    std::find(woken.begin(), woken.end(), i) == woken.end()) {
+                    woken.push_back(i);
+                }
+            }
+        }
+
+        REQUIRE(woken.size() == num_threads / num_addresses);
+        for (std::size_t i = 1; i < woken.size(); ++i) {
+            const auto& prev = threads[woken[i - 1]];
+            const auto& next = threads[woken[i]];
+            REQUIRE(prev->current_priority <= next->current_priority);
+            if (prev->current_priority == next->current_priority) {
+                REQUIRE(woken[i - 1] < woken[i]);
+            }
+        }
+
+        // No other address was affected.
+        for (int i = 1; i < num_addresses; ++i) {
+            REQUIRE(count_waiting(addresses[i]) == num_threads / num_addresses);
+        }
+    }
+
+    SECTION("signaling all threads only wakes the threads on that address") {
+        REQUIRE(arbiter->ArbitrateAddress(nullptr, ArbitrationType::Signal, addresses[1], -1, 0) ==
+                RESULT_SUCCESS);
+        REQUIRE(count_waiting(addresses[1]) == 0);
+        for (int i = 0; i < num_addresses; ++i) {
+            if (i != 1) {
+                REQUIRE(count_waiting(addresses[i]) == num_threads / num_addresses);
+            }
+        }
+    }
+
+    SECTION("signaling more threads than are waiting wakes them all") {
+        REQUIRE(arbiter->ArbitrateAddress(nullptr, ArbitrationType::Signal, addresses[2],
+                                          0x7FFFFFFF, 0) == RESULT_SUCCESS);
+        REQUIRE(count_waiting(addresses[2]) == 0);
+    }
+
+    SECTION("signaling an address nobody waits on is a no-op") {
+        REQUIRE(arbiter->ArbitrateAddress(nullptr, ArbitrationType::Signal,
+                                          threads.back()->GetTLSAddress(), -1, 0) ==
+                RESULT_SUCCESS);
+        for (int i = 0; i < num_addresses; ++i) {
+            REQUIRE(count_waiting(addresses[i]) == num_threads / num_addresses);
+        }
+    }
+}
+
+} // namespace Kernel
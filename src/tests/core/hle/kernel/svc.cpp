@@ -0,0 +1,138 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <memory>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "core/arm/arm_interface.h"
+#include "core/core.h"
+#include "core/hle/ipc_helpers.h"
+#include "core/hle/kernel/client_session.h"
+#include "core/hle/kernel/event.h"
+#include "core/hle/kernel/hle_ipc.h"
+#include "core/hle/kernel/process.h"
+#include "core/hle/kernel/server_session.h"
+#include "core/hle/kernel/svc.h"
+#include "core/hle/kernel/thread.h"
+#include "core/memory.h"
+
+namespace Kernel {
+
+namespace {
+
+/// Replies to every request right away, so that SendSyncRequest doesn't do any service work
+class EchoHandler final : public SessionRequestHandler {
+public:
+    void HandleSyncRequest(HLERequestContext& context) override {
+        IPC::RequestParser rp(context, 0x1, 0, 0);
+        IPC::RequestBuilder rb = rp.MakeBuilder(1, 0);
+        rb.Push(RESULT_SUCCESS);
+    }
+
+protected:
+    std::unique_ptr<SessionDataBase> MakeSessionData() override {
+        return std::make_unique<SessionDataBase>();
+    }
+};
+
+/// Sets up the system instance for the SVCs and tears it down again
+struct KernelTestSystem {
+    KernelTestSystem() {
+        Core::System::GetInstance().InitForKernelTests();
+    }
+    ~KernelTestSystem() {
+        Core::System::GetInstance().ShutdownForKernelTests();
+    }
+};
+
+} // anonymous namespace
+
+// Measures svcWaitSynchronizationN and svcSendSyncRequest as called by the emulated CPU, from the
+// register arguments to the result. Hidden by default, run with `tests "[benchmark]"`.
+TEST_CASE("SVC hot path throughput", "[.][benchmark][core][kernel]") {
+    KernelTestSystem test_system;
+    Core::System& system = Core::System::GetInstance();
+    KernelSystem& kernel = system.Kernel();
+    ARM_Interface& cpu = system.CPU();
+    SVCContext svc{system};
+
+    auto process = kernel.CreateProcess(kernel.CreateCodeSet("", 0));
+    process->status = ProcessStatus::Running;
+    kernel.MapSharedPages(process->vm_manager);
+    kernel.SetCurrentProcess(process);
+
+    auto thread = kernel
+                      .CreateThread("main", Memory::SHARED_PAGE_VADDR, ThreadPrioUserlandMax, 0, 0,
+                                    Memory::HEAP_VADDR_END, *process)
+                      .Unwrap();
+    kernel.GetThreadManager().Reschedule();
+    REQUIRE(kernel.GetThreadManager().GetCurrentThread() == thread.get());
+
+    constexpr int iterations = 200000;
+    const auto measure = [&](auto&& call) {
+        std::chrono::steady_clock::duration total{};
+        for (int i = 0; i < iterations; ++i) {
+            total += call();
+        }
+        return std::chrono::duration<double, std::nano>(total).count() / iterations;
+    };
+
+    SECTION("WaitSynchronizationN") {
+        // Only the last event is ready, so that every object is checked
+        constexpr u32 num_handles = 16;
+        std::vector<std::shared_ptr<Event>> events;
+        for (u32 i = 0; i < num_handles; ++i) {
+            events.push_back(kernel.CreateEvent(ResetType::Sticky));
+            const Handle handle = process->handle_table.Create(events.back()).Unwrap();
+            system.Memory().Write32(thread->GetTLSAddress() + i * sizeof(Handle), handle);
+        }
+        events.back()->Signal();
+
+        const double ns = measure([&] {
+            cpu.SetReg(0, 0); // Timeout, low word
+            cpu.SetReg(1, thread->GetTLSAddress());
+            cpu.SetReg(2, num_handles);
+            cpu.SetReg(3, 0); // Wait for any
+            cpu.SetReg(4, 0); // Timeout, high word
+
+            const auto start = std::chrono::steady_clock::now();
+            svc.CallSVC(0x25);
+            const auto duration = std::chrono::steady_clock::now() - start;
+
+            REQUIRE(cpu.GetReg(0) == RESULT_SUCCESS.raw);
+            REQUIRE(cpu.GetReg(1) == num_handles - 1);
+            return duration;
+        });
+        WARN("svcWaitSynchronizationN with " << num_handles << " handles: " << ns << " ns");
+    }
+
+    SECTION("SendSyncRequest") {
+        auto [server, client] = kernel.CreateSessionPair("echo");
+        auto handler = std::make_shared<EchoHandler>();
+        server->SetHleHandler(handler);
+        handler->ClientConnected(server);
+        const Handle handle = process->handle_table.Create(client).Unwrap();
+
+        const double ns = measure([&] {
+            system.Memory().Write32(thread->GetCommandBufferAddress(), IPC::MakeHeader(0x1, 0, 0));
+            cpu.SetReg(0, handle);
+
+            const auto start = std::chrono::steady_clock::now();
+            svc.CallSVC(0x32);
+            const auto duration = std::chrono::steady_clock::now() - start;
+
+            REQUIRE(cpu.GetReg(0) == RESULT_SUCCESS.raw);
+            REQUIRE(thread->status == ThreadStatus::WaitIPC);
+
+            // Skip the simulated IPC delay and run the thread again
+            thread->ResumeFromWait();
+            kernel.GetThreadManager().Reschedule();
+            return duration;
+        });
+        WARN("svcSendSyncRequest to an HLE session: " << ns << " ns");
+    }
+}
+
+} // namespace Kernel
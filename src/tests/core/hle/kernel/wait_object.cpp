@@ -0,0 +1,93 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "core/arm/dyncom/arm_dyncom.h"
+#include "core/core_timing.h"
+#include "core/hle/kernel/event.h"
+#include "core/hle/kernel/process.h"
+#include "core/hle/kernel/thread.h"
+#include "core/memory.h"
+
+namespace Kernel {
+
+static void WaitOn(const std::shared_ptr<Thread>& thread,
+                   const std::vector<std::shared_ptr<Event>>& events, bool wait_all) {
+    thread->status = wait_all ? ThreadStatus::WaitSynchAll : ThreadStatus::WaitSynchAny;
+    thread->wait_objects.assign(events.begin(), events.end());
+    for (const auto& event : events) {
+        event->AddWaitingThread(thread);
+    }
+}
+
+TEST_CASE("WaitObject wakes up WaitSynchAll threads", "[core][kernel]") {
+    Core::Timing timing;
+    Memory::MemorySystem memory;
+    Kernel::KernelSystem kernel(memory, timing, [] {}, 0);
+    kernel.SetCPU(std::make_shared<ARM_DynCom>(nullptr, memory, USER32MODE));
+
+    auto process = kernel.CreateProcess(kernel.CreateCodeSet("", 0));
+    kernel.MapSharedPages(process->vm_manager);
+    kernel.SetCurrentProcess(process);
+
+    constexpr int num_threads = 64;
+    constexpr int num_events = 16;
+
+    std::vector<std::shared_ptr<Event>> events;
+    for (int i = 0; i < num_events; ++i) {
+        events.push_back(kernel.CreateEvent(ResetType::Sticky));
+    }
+
+    std::vector<std::shared_ptr<Thread>> threads;
+    for (int i = 0; i < num_threads; ++i) {
+        threads.push_back(kernel
+                              .CreateThread("thread", Memory::SHARED_PAGE_VADDR,
+                                            ThreadPrioUserlandMax + i % 8, 0, 0,
+                                            Memory::HEAP_VADDR_END, *process)
+                              .Unwrap());
+        WaitOn(threads.back(), events, true);
+    }
+
+    const auto all_have_status = [&](ThreadStatus status) {
+        return std::all_of(threads.begin(), threads.end(),
+                           [status](const auto& thread) { return thread->status == status; });
+    };
+
+    SECTION("threads only wake up once every object is available") {
+        // Signal the events in reverse order, so that the first object checked is the last one to
+        // become available.
+        for (int i = num_events - 1; i > 0; --i) {
+            events[i]->Signal();
+            REQUIRE(all_have_status(ThreadStatus::WaitSynchAll));
+        }
+
+        events[0]->Signal();
+        REQUIRE(all_have_status(ThreadStatus::Ready));
+        for (const auto& thread : threads) {
+            REQUIRE(thread->wait_objects.empty());
+        }
+        for (const auto& event : events) {
+            REQUIRE(event->GetWaitingThreads().empty());
+        }
+    }
+
+    SECTION("an object becoming unavailable again blocks the threads") {
+        for (int i = 0; i < num_events - 1; ++i) {
+            events[i]->Signal();
+        }
+        REQUIRE(all_have_status(ThreadStatus::WaitSynchAll));
+
+        events[0]->Clear();
+        events[num_events - 1]->Signal();
+        REQUIRE(all_have_status(ThreadStatus::WaitSynchAll));
+
+        events[0]->Signal();
+        REQUIRE(all_have_status(ThreadStatus::Ready));
+    }
+}
+
+} // namespace Kernel
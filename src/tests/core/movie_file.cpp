@@ -0,0 +1,176 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <string>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "common/file_util.h"
+#include "core/movie_file.h"
+
+namespace Core {
+
+using Record = std::array<u8, MovieRecordSize>;
+
+static std::vector<Record> MakeRecords(std::size_t count) {
+    std::vector<Record> records(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        // Alternate between a few input types, with inputs that change every now and then
+        records[i][0] = static_cast<u8>(i % 3);
+        for (std::size_t byte = 1; byte < MovieRecordSize; ++byte) {
+            records[i][byte] = static_cast<u8>((i / 100) * byte + records[i][0]);
+        }
+    }
+    return records;
+}
+
+static void WriteChunked(const std::string& path, const std::vector<Record>& records) {
+    MovieWriter writer;
+    REQUIRE(writer.Open(path));
+    for (const Record& record : records) {
+        writer.Write(record.data());
+    }
+    CTMHeader header{};
+    header.program_id = 0x0004000000123400;
+    header.clock_init_time = 12345;
+    REQUIRE(writer.Close(header));
+}
+
+static void RequireRecords(MovieReader& reader, const std::vector<Record>& records,
+                           std::size_t first) {
+    Record record;
+    for (std::size_t i = first; i < records.size(); ++i) {
+        REQUIRE(reader.Read(record.data()));
+        REQUIRE(record == records[i]);
+    }
+    REQUIRE(reader.IsAtEnd());
+    REQUIRE(!reader.Read(record.data()));
+}
+
+TEST_CASE("MovieFile - Chunked round trip", "[core][movie]") {
+    const std::string path = "./test_movie_chunked.ctm";
+    const std::vector<Record> records = MakeRecords(MovieChunkRecords * 2 + 123);
+    WriteChunked(path, records);
+
+    MovieReader reader;
+    REQUIRE(reader.Open(path));
+    REQUIRE(reader.GetHeader().format == static_cast<u32>(MovieFormat::Chunked));
+    REQUIRE(reader.GetHeader().chunk_count == 3);
+    REQUIRE(reader.GetHeader().program_id == 0x0004000000123400);
+    REQUIRE(reader.GetHeader().clock_init_time == 12345);
+    REQUIRE(reader.GetRecordCount() == records.size());
+    RequireRecords(reader, records, 0);
+
+    // Seeking only decodes the chunk containing the record
+    REQUIRE(reader.Seek(MovieChunkRecords + 7));
+    RequireRecords(reader, records, MovieChunkRecords + 7);
+    REQUIRE(!reader.Seek(records.size() + 1));
+
+    reader.Close();
+    FileUtil::Delete(path);
+}
+
+TEST_CASE("MovieFile - Flat movie conversion", "[core][movie]") {
+    const std::string flat_path = "./test_movie_flat.ctm";
+    const std::string chunked_path = "./test_movie_converted.ctm";
+    const std::vector<Record> records = MakeRecords(MovieChunkRecords + 1);
+
+    CTMHeader header{};
+    header.filetype = header_magic_bytes;
+    header.program_id = 0x0004000000567800;
+    {
+        FileUtil::IOFile file(flat_path, "wb");
+        REQUIRE(file.WriteObject(header) == 1);
+        REQUIRE(file.WriteArray(records.data(), records.size()) == records.size());
+    }
+
+    MovieReader reader;
+    REQUIRE(reader.Open(flat_path));
+    REQUIRE(reader.GetRecordCount() == records.size());
+    RequireRecords(reader, records, 0);
+    reader.Close();
+
+    REQUIRE(ConvertMovie(flat_path, chunked_path));
+    REQUIRE(reader.Open(chunked_path));
+    REQUIRE(reader.GetHeader().format == static_cast<u32>(MovieFormat::Chunked));
+    REQUIRE(reader.GetHeader().program_id == 0x0004000000567800);
+    RequireRecords(reader, records, 0);
+
+    reader.Close();
+    FileUtil::Delete(flat_path);
+    FileUtil::Delete(chunked_path);
+}
+
+TEST_CASE("MovieFile - Interrupted recording", "[core][movie]") {
+    const std::string path = "./test_movie_interrupted.ctm";
+    const std::vector<Record> records = MakeRecords(MovieChunkRecords * 2);
+    {
+        // Never closed, so only the chunks that were flushed while recording are in the file
+        MovieWriter writer;
+        REQUIRE(writer.Open(path));
+        for (const Record& record : records) {
+            writer.Write(record.data());
+        }
+        writer.Write(records[0].data());
+    }
+
+    MovieReader reader;
+    REQUIRE(reader.Open(path));
+    REQUIRE(reader.GetRecordCount() == records.size());
+    RequireRecords(reader, records, 0);
+
+    reader.Close();
+    FileUtil::Delete(path);
+}
+
+TEST_CASE("MovieFile - Corrupted chunk index", "[core][movie]") {
+    const std::string path = "./test_movie_corrupted.ctm";
+    const std::vector<Record> records = MakeRecords(MovieChunkRecords * 2 + 123);
+    WriteChunked(path, records);
+
+    FileUtil::IOFile file(path, "r+b");
+    CTMHeader header;
+    REQUIRE(file.ReadArray(&header, 1) == 1);
+    std::array<CTMChunkIndexEntry, 3> index;
+    REQUIRE(header.chunk_count == index.size());
+    REQUIRE(file.Seek(header.index_offset, SEEK_SET));
+    REQUIRE(file.ReadArray(index.data(), index.size()) == index.size());
+    const u64 index_offset = header.index_offset;
+
+    SECTION("too many chunks") {
+        header.chunk_count = 0xFFFFFFFF;
+    }
+    SECTION("index past the end of the file") {
+        header.index_offset = file.GetSize() + 1;
+    }
+    SECTION("first chunk not at the first record") {
+        index[0].first_record = 5;
+    }
+    SECTION("gap between chunks") {
+        index[2].first_record = index[2].first_record + 1;
+    }
+    SECTION("too many records in a chunk") {
+        index[1].record_count = MovieChunkRecords + 1;
+    }
+    SECTION("chunk past the end of the file") {
+        index[2].compressed_size = 0x7FFFFFFF;
+    }
+
+    REQUIRE(file.Seek(0, SEEK_SET));
+    REQUIRE(file.WriteObject(header) == 1);
+    REQUIRE(file.Seek(index_offset, SEEK_SET));
+    REQUIRE(file.WriteArray(index.data(), index.size()) == index.size());
+    file.Close();
+
+    // The chunks themselves are intact, so they are indexed by walking them instead
+    MovieReader reader;
+    REQUIRE(reader.Open(path));
+    REQUIRE(reader.GetRecordCount() == records.size());
+    RequireRecords(reader, records, 0);
+
+    reader.Close();
+    FileUtil::Delete(path);
+}
+
+} // namespace Core
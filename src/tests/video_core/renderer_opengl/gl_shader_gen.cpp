@@ -0,0 +1,57 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <catch2/catch.hpp>
+#include "video_core/regs.h"
+#include "video_core/renderer_opengl/gl_shader_gen.h"
+
+using OpenGL::PicaFSConfig;
+
+static Pica::Regs MakeRegs() {
+    Pica::Regs regs{};
+    regs.framebuffer.output_merger.alpha_test.enable.Assign(1);
+    regs.framebuffer.output_merger.alpha_test.func.Assign(
+        Pica::FramebufferRegs::CompareFunc::LessThan);
+    regs.texturing.main_config.texture3_enable.Assign(1);
+    regs.texturing.proctex_lut.width.Assign(128);
+    regs.texturing.tev_stage0.color_op.Assign(Pica::TexturingRegs::TevStageConfig::Operation::Add);
+    regs.lighting.disable.Assign(0);
+    regs.lighting.max_light_index.Assign(3);
+    regs.lighting.light[2].config.directional.Assign(1);
+    return regs;
+}
+
+TEST_CASE("PicaFSConfig - Updating every group matches a full build", "[video_core]") {
+    const Pica::Regs regs = MakeRegs();
+
+    PicaFSConfig config;
+    config.Update(regs, PicaFSConfig::AllGroups);
+    REQUIRE(config == PicaFSConfig::BuildFromRegs(regs));
+}
+
+TEST_CASE("PicaFSConfig - Updating a group matches a full build", "[video_core]") {
+    Pica::Regs regs = MakeRegs();
+    PicaFSConfig config = PicaFSConfig::BuildFromRegs(regs);
+
+    SECTION("TEV stages") {
+        regs.texturing.tev_stage3.color_scale.Assign(2);
+        REQUIRE(config != PicaFSConfig::BuildFromRegs(regs));
+        config.Update(regs, PicaFSConfig::TevGroup);
+    }
+
+    SECTION("Fewer lights") {
+        // The lights that are no longer used have to be cleared
+        regs.lighting.max_light_index.Assign(1);
+        REQUIRE(config != PicaFSConfig::BuildFromRegs(regs));
+        config.Update(regs, PicaFSConfig::LightingGroup);
+    }
+
+    SECTION("Procedural texture disabled") {
+        regs.texturing.main_config.texture3_enable.Assign(0);
+        REQUIRE(config != PicaFSConfig::BuildFromRegs(regs));
+        config.Update(regs, PicaFSConfig::TexturingGroup | PicaFSConfig::ProcTexGroup);
+    }
+
+    REQUIRE(config == PicaFSConfig::BuildFromRegs(regs));
+}
@@ -0,0 +1,65 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <random>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "common/color.h"
+#include "video_core/scanout.h"
+
+using PixelFormat = GPU::Regs::PixelFormat;
+
+static Common::Vec4<u8> DecodeReference(PixelFormat format, const u8* pixel) {
+    switch (format) {
+    case PixelFormat::RGBA8:
+        return Color::DecodeRGBA8(pixel);
+    case PixelFormat::RGB8:
+        return Color::DecodeRGB8(pixel);
+    case PixelFormat::RGB565:
+        return Color::DecodeRGB565(pixel);
+    case PixelFormat::RGB5A1:
+        return Color::DecodeRGB5A1(pixel);
+    case PixelFormat::RGBA4:
+    default:
+        return Color::DecodeRGBA4(pixel);
+    }
+}
+
+static void TestConversion(PixelFormat format, u32 width) {
+    constexpr u32 height = 5;
+    constexpr u32 padding = 12;
+    const u32 bytes_per_pixel = GPU::Regs::BytesPerPixel(format);
+    const u32 stride = width * bytes_per_pixel + padding;
+
+    std::mt19937 random(width * 8 + static_cast<u32>(format));
+    std::vector<u8> source(stride * height);
+    for (u8& byte : source) {
+        byte = static_cast<u8>(random());
+    }
+
+    std::vector<u8> dest(width * height * 4);
+    VideoCore::ConvertScanoutToRGBA8(format, source.data(), stride, dest.data(), width, height);
+
+    for (u32 y = 0; y < height; ++y) {
+        for (u32 x = 0; x < width; ++x) {
+            const Common::Vec4<u8> expected =
+                DecodeReference(format, &source[y * stride + x * bytes_per_pixel]);
+            const u8* pixel = &dest[(y * width + x) * 4];
+            REQUIRE(pixel[0] == expected.r());
+            REQUIRE(pixel[1] == expected.g());
+            REQUIRE(pixel[2] == expected.b());
+            REQUIRE(pixel[3] == expected.a());
+        }
+    }
+}
+
+TEST_CASE("Scanout - Conversion matches the color decoders", "[video_core]") {
+    for (const PixelFormat format : {PixelFormat::RGBA8, PixelFormat::RGB8, PixelFormat::RGB565,
+                                     PixelFormat::RGB5A1, PixelFormat::RGBA4}) {
+        // Widths that leave pixels after the last full vector, with rows padded past the width
+        for (const u32 width : {1u, 7u, 8u, 29u, 240u}) {
+            TestConversion(format, width);
+        }
+    }
+}
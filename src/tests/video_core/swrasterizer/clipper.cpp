@@ -0,0 +1,223 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <random>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "common/hash.h"
+#include "core/memory.h"
+#include "video_core/pica_state.h"
+#include "video_core/shader/shader.h"
+#include "video_core/swrasterizer/swrasterizer.h"
+#include "video_core/video_core.h"
+
+using Pica::float24;
+using Pica::Shader::OutputVertex;
+
+namespace {
+
+constexpr u32 FramebufferWidth = 128;
+constexpr u32 FramebufferHeight = 128;
+constexpr PAddr FramebufferAddress = Memory::VRAM_PADDR;
+constexpr std::size_t FramebufferSize = FramebufferWidth * FramebufferHeight * 4;
+
+/// Encodes a float as the raw float24 value stored in the registers, only for normal numbers
+u32 ToFloat24Raw(float value) {
+    if (value == 0.0f) {
+        return 0;
+    }
+    u32 hex;
+    std::memcpy(&hex, &value, sizeof(hex));
+    const u32 sign = hex >> 31;
+    const u32 exponent = ((hex >> 23) & 0xFF) - 64;
+    const u32 mantissa = (hex >> 7) & 0xFFFF;
+    return (sign << 23) | (exponent << 16) | mantissa;
+}
+
+/// Renders the vertex colors into an RGBA8 framebuffer at the start of VRAM, without depth test
+class SWRasterizerTest {
+public:
+    explicit SWRasterizerTest(bool clip_enable) {
+        VideoCore::g_memory = &memory;
+
+        auto& regs = Pica::g_state.regs;
+        std::memset(&regs, 0, sizeof(regs));
+        regs.lighting.disable.Assign(1);
+
+        regs.rasterizer.viewport_size_x.Assign(ToFloat24Raw(FramebufferWidth / 2));
+        regs.rasterizer.viewport_size_y.Assign(ToFloat24Raw(FramebufferHeight / 2));
+        if (clip_enable) {
+            // Keeps the part of the view volume in front of the plane x + y = 0.5w
+            const float coeffs[] = {-1.0f, -1.0f, 0.0f, 0.5f};
+            regs.rasterizer.clip_enable.Assign(1);
+            for (std::size_t i = 0; i < 4; ++i) {
+                regs.rasterizer.clip_coef[i].Assign(ToFloat24Raw(coeffs[i]));
+            }
+        }
+
+        auto& framebuffer = regs.framebuffer.framebuffer;
+        framebuffer.allow_color_write.Assign(0xF);
+        framebuffer.color_format.Assign(Pica::FramebufferRegs::ColorFormat::RGBA8);
+        framebuffer.color_buffer_address.Assign(FramebufferAddress / 8);
+        framebuffer.width.Assign(FramebufferWidth);
+        framebuffer.height.Assign(FramebufferHeight - 1);
+
+        auto& output_merger = regs.framebuffer.output_merger;
+        output_merger.logic_op.Assign(Pica::FramebufferRegs::LogicOp::Copy);
+        output_merger.red_enable.Assign(1);
+        output_merger.green_enable.Assign(1);
+        output_merger.blue_enable.Assign(1);
+        output_merger.alpha_enable.Assign(1);
+    }
+
+    ~SWRasterizerTest() {
+        VideoCore::g_memory = nullptr;
+    }
+
+    /// Limits rasterization to a single pixel, which leaves the clipper as the main cost of a draw
+    void SetClippingOnly(bool clipping_only) {
+        auto& scissor_test = Pica::g_state.regs.rasterizer.scissor_test;
+        scissor_test.mode.Assign(clipping_only ? Pica::RasterizerRegs::ScissorMode::Include
+                                               : Pica::RasterizerRegs::ScissorMode::Disabled);
+    }
+
+    void Draw(const std::vector<OutputVertex>& vertices, std::size_t first, std::size_t count) {
+        for (std::size_t i = first * 3; i < (first + count) * 3; i += 3) {
+            rasterizer.AddTriangle(vertices[i], vertices[i + 1], vertices[i + 2]);
+        }
+        rasterizer.DrawTriangles();
+    }
+
+    std::vector<u8> ReadFramebuffer() {
+        const u8* data = memory.GetPhysicalPointer(FramebufferAddress);
+        return {data, data + FramebufferSize};
+    }
+
+    void ClearFramebuffer() {
+        std::memset(memory.GetPhysicalPointer(FramebufferAddress), 0, FramebufferSize);
+    }
+
+private:
+    Memory::MemorySystem memory;
+    VideoCore::SWRasterizer rasterizer;
+};
+
+/**
+ * Generates triangles in clip space, so that they are inside of the view volume, outside of it or
+ * cross it as chosen by the given extents.
+ * @param xy_extent Positions have x and y in [-xy_extent * w, xy_extent * w]
+ * @param min_w Smallest w of the triangles, non-positive values put them behind the camera
+ * @param size Largest distance of the other two vertices from the first, relative to w
+ */
+std::vector<OutputVertex> GenerateTriangles(std::size_t count, float xy_extent, float min_w,
+                                            float size, u32 seed) {
+    std::mt19937 random(seed);
+    const auto Uniform = [&random](float min, float max) {
+        return std::uniform_real_distribution<float>(min, max)(random);
+    };
+    const auto UniformVec4 = [&Uniform](float min, float max) {
+        return Common::MakeVec(
+            float24::FromFloat32(Uniform(min, max)), float24::FromFloat32(Uniform(min, max)),
+            float24::FromFloat32(Uniform(min, max)), float24::FromFloat32(Uniform(min, max)));
+    };
+
+    std::vector<OutputVertex> vertices(count * 3);
+    for (std::size_t triangle = 0; triangle < count; ++triangle) {
+        const float w = Uniform(min_w, 2.0f);
+        const float x = Uniform(-xy_extent, xy_extent) * w;
+        const float y = Uniform(-xy_extent, xy_extent) * w;
+        const float z = Uniform(-0.9f, -0.1f) * w;
+        for (std::size_t i = 0; i < 3; ++i) {
+            OutputVertex& vertex = vertices[triangle * 3 + i];
+            std::memset(&vertex, 0, sizeof(vertex));
+            const float offset = i == 0 ? 0.0f : size * std::abs(w);
+            vertex.pos = Common::MakeVec(float24::FromFloat32(x + Uniform(-offset, offset)),
+                                         float24::FromFloat32(y + Uniform(-offset, offset)),
+                                         float24::FromFloat32(z + Uniform(-offset, offset)),
+                                         float24::FromFloat32(w));
+            vertex.quat = UniformVec4(-1.0f, 1.0f);
+            vertex.color = UniformVec4(0.0f, 1.0f);
+        }
+    }
+    return vertices;
+}
+
+} // anonymous namespace
+
+TEST_CASE("SWRasterizer - Batched clipping matches clipping one triangle at a time",
+          "[video_core]") {
+    const bool clip_enable = GENERATE(false, true);
+    SWRasterizerTest test(clip_enable);
+
+    std::vector<OutputVertex> vertices = GenerateTriangles(500, 1.5f, -0.5f, 0.5f, 1234);
+
+    // Values that the plane tests have to handle like float24 does, 0 * inf is 0 there
+    const float inf = std::numeric_limits<float>::infinity();
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    const Common::Vec4<float> special_positions[] = {
+        {0.0f, 0.0f, 0.0f, inf},  {inf, 0.0f, -0.5f, 1.0f}, {-inf, inf, 0.0f, inf},
+        {0.0f, 0.0f, -inf, 1.0f}, {nan, 0.0f, -0.5f, 1.0f}, {0.0f, 0.0f, 0.0f, nan},
+        {0.0f, 0.0f, -0.5f, 0.0f},
+    };
+    for (std::size_t i = 0; i < std::size(special_positions); ++i) {
+        const auto& position = special_positions[i];
+        vertices[i * 7 % vertices.size()].pos = {
+            float24::FromFloat32(position.x), float24::FromFloat32(position.y),
+            float24::FromFloat32(position.z), float24::FromFloat32(position.w)};
+    }
+
+    // A whole batch computes most outcodes four vertices at a time, while a single triangle only
+    // has the three vertices that are left over for the scalar plane tests
+    const std::size_t count = vertices.size() / 3;
+    test.Draw(vertices, 0, count);
+    const std::vector<u8> batched = test.ReadFramebuffer();
+
+    test.ClearFramebuffer();
+    for (std::size_t triangle = 0; triangle < count; ++triangle) {
+        test.Draw(vertices, triangle, 1);
+    }
+    const std::vector<u8> single = test.ReadFramebuffer();
+
+    REQUIRE(std::count(batched.begin(), batched.end(), 0) != batched.size());
+    REQUIRE(batched == single);
+}
+
+// Measures draws through the clipper, once with full rasterization and once with rasterization
+// limited to a single pixel. Hidden by default, run with `tests "[benchmark]"`. The framebuffer
+// hashes show whether a change to the clipper renders the same pixels.
+TEST_CASE("SWRasterizer - Clipping throughput", "[.][benchmark][video_core]") {
+    SWRasterizerTest test(false);
+
+    constexpr std::size_t count = 10000;
+    constexpr int iterations = 10;
+    const auto measure = [&](const char* name, const std::vector<OutputVertex>& vertices) {
+        for (const bool clipping_only : {false, true}) {
+            test.SetClippingOnly(clipping_only);
+            std::chrono::steady_clock::duration total{};
+            for (int i = 0; i < iterations; ++i) {
+                test.ClearFramebuffer();
+                const auto start = std::chrono::steady_clock::now();
+                test.Draw(vertices, 0, count);
+                total += std::chrono::steady_clock::now() - start;
+            }
+            const std::vector<u8> framebuffer = test.ReadFramebuffer();
+            const double ns = std::chrono::duration<double, std::nano>(total).count();
+            WARN(name << (clipping_only ? ", clipping only: " : ": ")
+                      << ns / (iterations * count) << " ns/triangle, framebuffer hash " << std::hex
+                      << Common::ComputeHash64(framebuffer.data(), framebuffer.size()));
+        }
+    };
+
+    // Small triangles, so that the clipper has a larger share of the time
+    measure("Inside", GenerateTriangles(count, 0.9f, 0.5f, 0.02f, 1));
+    measure("Outside", GenerateTriangles(count, 8.0f, 0.5f, 0.02f, 2));
+    measure("Crossing", GenerateTriangles(count, 1.0f, 0.5f, 0.2f, 3));
+    measure("Mixed", GenerateTriangles(count, 2.0f, -0.5f, 0.1f, 4));
+}
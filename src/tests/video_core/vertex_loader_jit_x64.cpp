@@ -0,0 +1,112 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <catch2/catch.hpp>
+#include "core/memory.h"
+#include "video_core/debug_utils/debug_utils.h"
+#include "video_core/pica_state.h"
+#include "video_core/regs_pipeline.h"
+#include "video_core/shader/shader.h"
+#include "video_core/vertex_loader.h"
+#include "video_core/vertex_loader_jit_x64.h"
+#include "video_core/video_core.h"
+
+using Format = Pica::PipelineRegs::VertexAttributeFormat;
+
+static Pica::PipelineRegs MakeRegs() {
+    Pica::PipelineRegs regs{};
+    auto& config = regs.vertex_attributes;
+    config.base_address.Assign(Memory::FCRAM_PADDR / 16);
+    config.format0.Assign(Format::FLOAT);
+    config.size0.Assign(2);
+    config.format1.Assign(Format::SHORT);
+    config.size1.Assign(1);
+    config.format2.Assign(Format::UBYTE);
+    config.size2.Assign(3);
+    config.format3.Assign(Format::BYTE);
+    config.size3.Assign(2);
+    config.format4.Assign(Format::FLOAT);
+    config.size4.Assign(3);
+    config.attribute_mask.Assign(1 << 5);
+    config.max_attribute_index.Assign(5);
+
+    // Attributes 0, 1 and 2, 20 bytes per vertex
+    auto& loader0 = config.attribute_loaders[0];
+    loader0.comp0.Assign(0);
+    loader0.comp1.Assign(1);
+    loader0.comp2.Assign(2);
+    loader0.byte_count.Assign(20);
+    loader0.component_count.Assign(3);
+
+    // Attribute 3, 4 bytes of padding and attribute 4, 24 bytes per vertex
+    auto& loader1 = config.attribute_loaders[1];
+    loader1.data_offset.Assign(0x1000);
+    loader1.comp0.Assign(3);
+    loader1.comp1.Assign(12);
+    loader1.comp2.Assign(4);
+    loader1.byte_count.Assign(24);
+    loader1.component_count.Assign(3);
+    return regs;
+}
+
+static void WriteVertices(u8* data, int count) {
+    for (int v = 0; v < count; ++v) {
+        const float position[3] = {v * 0.5f, -v * 1.0f, 3.25f};
+        const s16 shorts[2] = {static_cast<s16>(-v * 300), static_cast<s16>(v * 511)};
+        const u8 ubytes[4] = {static_cast<u8>(v * 3), static_cast<u8>(255 - v), 128,
+                              static_cast<u8>(v)};
+        u8* vertex0 = data + v * 20;
+        std::memcpy(vertex0, position, sizeof(position));
+        std::memcpy(vertex0 + 12, shorts, sizeof(shorts));
+        std::memcpy(vertex0 + 16, ubytes, sizeof(ubytes));
+
+        const s8 bytes[3] = {static_cast<s8>(-v), static_cast<s8>(v), -128};
+        const float color[4] = {1.0f / (v + 1), 0.25f, -2.0f, v * 100.0f};
+        u8* vertex1 = data + 0x1000 + v * 24;
+        std::memcpy(vertex1, bytes, sizeof(bytes));
+        std::memcpy(vertex1 + 8, color, sizeof(color));
+    }
+}
+
+TEST_CASE("VertexLoaderJit - Matches the interpreter", "[video_core][vertex_loader]") {
+    if (!Pica::VertexLoaderJit::IsSupported()) {
+        return;
+    }
+
+    Memory::MemorySystem memory;
+    VideoCore::g_memory = &memory;
+    constexpr int vertex_count = 64;
+    WriteVertices(memory.GetPhysicalPointer(Memory::FCRAM_PADDR), vertex_count);
+    Pica::g_state.input_default_attributes.attr[5] = {
+        Pica::float24::FromFloat32(7.0f), Pica::float24::FromFloat32(8.0f),
+        Pica::float24::FromFloat32(9.0f), Pica::float24::FromFloat32(10.0f)};
+
+    const Pica::PipelineRegs regs = MakeRegs();
+    const bool jit_enabled = VideoCore::g_shader_jit_enabled;
+    VideoCore::g_shader_jit_enabled = false;
+    const Pica::VertexLoader interpreter(regs);
+    VideoCore::g_shader_jit_enabled = true;
+    const Pica::VertexLoader jit(regs);
+
+    const u32 base_address = regs.vertex_attributes.GetPhysicalBaseAddress();
+    const auto arrays = jit.GetAttributeArrays(base_address);
+    REQUIRE(arrays.valid);
+
+    Pica::DebugUtils::MemoryAccessTracker memory_accesses;
+    for (int v = 0; v < vertex_count; ++v) {
+        Pica::Shader::AttributeBuffer expected{};
+        Pica::Shader::AttributeBuffer result{};
+        interpreter.LoadVertex(base_address, arrays, v, v, expected, memory_accesses);
+        jit.LoadVertex(base_address, arrays, v, v, result, memory_accesses);
+        for (int i = 0; i < jit.GetNumTotalAttributes(); ++i) {
+            for (int comp = 0; comp < 4; ++comp) {
+                REQUIRE(result.attr[i][comp].ToFloat32() == expected.attr[i][comp].ToFloat32());
+            }
+        }
+    }
+
+    VideoCore::g_shader_jit_enabled = jit_enabled;
+    VideoCore::g_memory = nullptr;
+}
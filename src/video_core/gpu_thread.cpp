@@ -0,0 +1,130 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include "common/microprofile.h"
+#include "common/thread.h"
+#include "core/hle/service/gsp/gsp.h"
+#include "video_core/gpu_thread.h"
+
+namespace VideoCore {
+
+std::unique_ptr<GPUThread> g_gpu_thread;
+
+MICROPROFILE_DEFINE(GPU_ThreadWait, "GPU", "Wait for GPU thread", MP_RGB(200, 100, 100));
+
+GPUThread::GPUThread() {
+    thread = std::thread([this] {
+        Common::SetCurrentThreadName("GPUThread");
+        MicroProfileOnThreadCreate("GPUThread");
+        ThreadLoop();
+#if MICROPROFILE_ENABLED
+        MicroProfileOnThreadExit();
+#endif
+    });
+    thread_id = thread.get_id();
+}
+
+GPUThread::~GPUThread() {
+    {
+        std::lock_guard lock{queue_mutex};
+        stop = true;
+    }
+    work_available.notify_one();
+    thread.join();
+}
+
+void GPUThread::ThreadLoop() {
+    while (true) {
+        std::pair<u64, std::function<void()>> item;
+        {
+            std::unique_lock lock{queue_mutex};
+            work_available.wait(lock, [this] { return stop || !queue.empty(); });
+            if (queue.empty()) {
+                // Only stop once all submitted work has finished
+                return;
+            }
+            item = std::move(queue.front());
+            queue.pop_front();
+        }
+
+        running_fence = item.first;
+        item.second();
+
+        {
+            std::lock_guard lock{queue_mutex};
+            last_completed_fence.store(item.first, std::memory_order_release);
+        }
+        work_done.notify_all();
+    }
+}
+
+u64 GPUThread::Submit(std::function<void()> work) {
+    u64 fence;
+    {
+        std::lock_guard lock{queue_mutex};
+        fence = ++last_submitted_fence;
+        queue.emplace_back(fence, std::move(work));
+    }
+    work_available.notify_one();
+    return fence;
+}
+
+void GPUThread::WaitForFence(u64 fence) {
+    if (last_completed_fence.load(std::memory_order_acquire) >= fence) {
+        return;
+    }
+
+    MICROPROFILE_SCOPE(GPU_ThreadWait);
+    std::unique_lock lock{queue_mutex};
+    work_done.wait(lock, [this, fence] {
+        return last_completed_fence.load(std::memory_order_relaxed) >= fence;
+    });
+}
+
+void GPUThread::Synchronize() {
+    u64 fence;
+    {
+        std::lock_guard lock{queue_mutex};
+        fence = last_submitted_fence;
+    }
+    WaitForFence(fence);
+}
+
+bool GPUThread::IsGPUThread() const {
+    return std::this_thread::get_id() == thread_id;
+}
+
+void GPUThread::RaiseInterrupt(Service::GSP::InterruptId interrupt_id) {
+    std::lock_guard lock{interrupt_mutex};
+    pending_interrupts.emplace_back(running_fence, interrupt_id);
+}
+
+std::vector<Service::GSP::InterruptId> GPUThread::TakeInterrupts(u64 fence) {
+    std::vector<Service::GSP::InterruptId> interrupts;
+    std::lock_guard lock{interrupt_mutex};
+    // Interrupts are raised in submission order, so the ones up to the fence are at the front
+    auto it = pending_interrupts.begin();
+    for (; it != pending_interrupts.end() && it->first <= fence; ++it) {
+        interrupts.push_back(it->second);
+    }
+    pending_interrupts.erase(pending_interrupts.begin(), it);
+    return interrupts;
+}
+
+void SignalInterrupt(Service::GSP::InterruptId interrupt_id) {
+    if (g_gpu_thread && g_gpu_thread->IsGPUThread()) {
+        g_gpu_thread->RaiseInterrupt(interrupt_id);
+    } else {
+        Service::GSP::SignalInterrupt(interrupt_id);
+    }
+}
+
+void SynchronizeGPUThread() {
+    if (g_gpu_thread && !g_gpu_thread->IsGPUThread()) {
+        g_gpu_thread->Synchronize();
+    }
+}
+
+} // namespace VideoCore
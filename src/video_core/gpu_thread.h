@@ -0,0 +1,91 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "common/common_types.h"
+
+namespace Service::GSP {
+enum class InterruptId : u8;
+}
+
+namespace VideoCore {
+
+/**
+ * Runs PICA command lists, memory fills and display transfers on a separate host thread, so that
+ * they overlap with CPU emulation. Work runs in submission order and every submission is
+ * identified by a fence, which increases with each submission.
+ *
+ * The kernel must only be accessed from the emulation thread, so interrupts raised by the work are
+ * collected and only handed out by TakeInterrupts once the emulation thread has waited for them.
+ * This keeps the point in emulated time at which they are signaled independent of the host.
+ */
+class GPUThread {
+public:
+    GPUThread();
+    ~GPUThread();
+
+    /// Queues work to run on the GPU thread, returning its fence
+    u64 Submit(std::function<void()> work);
+
+    /// Blocks until the work with the given fence and all work before it have finished
+    void WaitForFence(u64 fence);
+
+    /// Blocks until all submitted work has finished
+    void Synchronize();
+
+    /// Returns whether the calling thread is the GPU thread
+    bool IsGPUThread() const;
+
+    /// Records an interrupt raised by the work that is currently running on the GPU thread
+    void RaiseInterrupt(Service::GSP::InterruptId interrupt_id);
+
+    /// Removes and returns the interrupts raised by the work up to the given fence
+    std::vector<Service::GSP::InterruptId> TakeInterrupts(u64 fence);
+
+private:
+    void ThreadLoop();
+
+    std::thread thread;
+    std::thread::id thread_id;
+
+    std::mutex queue_mutex;
+    std::condition_variable work_available;
+    std::condition_variable work_done;
+    std::deque<std::pair<u64, std::function<void()>>> queue;
+    bool stop = false;
+
+    u64 last_submitted_fence = 0;
+    std::atomic<u64> last_completed_fence{0};
+    u64 running_fence = 0;
+
+    std::mutex interrupt_mutex;
+    std::vector<std::pair<u64, Service::GSP::InterruptId>> pending_interrupts;
+};
+
+/// The GPU thread, only created if asynchronous GPU emulation is enabled
+extern std::unique_ptr<GPUThread> g_gpu_thread;
+
+/**
+ * Signals a GPU interrupt to the emulated program. On the GPU thread, the interrupt is deferred
+ * until the emulation thread has waited for the work that raised it.
+ */
+void SignalInterrupt(Service::GSP::InterruptId interrupt_id);
+
+/**
+ * Waits for all queued GPU work. Must be called by the emulation thread before it accesses memory
+ * that queued work may write. Does nothing when called from the GPU thread itself.
+ */
+void SynchronizeGPUThread();
+
+} // namespace VideoCore
@@ -7,6 +7,7 @@
 #include "video_core/pica.h"
 #include "video_core/pica_state.h"
 #include "video_core/renderer_base.h"
+#include "video_core/vertex_loader.h"
 #include "video_core/video_core.h"
 
 namespace Pica {
@@ -19,6 +20,7 @@ void Init() {
 
 void Shutdown() {
     Shader::Shutdown();
+    ClearVertexLoaderCache();
 }
 
 template <typename T>
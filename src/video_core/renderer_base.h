@@ -69,6 +69,12 @@ public:
 
     void RefreshRasterizerSetting();
 
+    /// Returns whether the rasterizer in use is the OpenGL one, which only works on the thread
+    /// that owns the OpenGL context
+    bool IsOpenGLRasterizerActive() const {
+        return opengl_rasterizer_active;
+    }
+
 protected:
     Frontend::EmuWindow& render_window; ///< Reference to the render window handle.
     std::unique_ptr<VideoCore::RasterizerInterface> rasterizer;
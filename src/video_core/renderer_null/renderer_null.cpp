@@ -0,0 +1,113 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <limits>
+#include <utility>
+#include "common/hash.h"
+#include "common/logging/log.h"
+#include "core/core.h"
+#include "core/core_timing.h"
+#include "core/dumping/backend.h"
+#include "core/frontend/emu_window.h"
+#include "core/hw/gpu.h"
+#include "core/hw/lcd.h"
+#include "core/memory.h"
+#include "core/tracer/recorder.h"
+#include "video_core/debug_utils/debug_utils.h"
+#include "video_core/renderer_null/renderer_null.h"
+#include "video_core/video_core.h"
+
+namespace VideoCore {
+
+RendererNull::RendererNull(Frontend::EmuWindow& window) : RendererBase{window} {}
+RendererNull::~RendererNull() = default;
+
+Core::System::ResultStatus RendererNull::Init() {
+    RefreshRasterizerSetting();
+    return Core::System::ResultStatus::Success;
+}
+
+void RendererNull::ShutDown() {}
+
+void RendererNull::SwapBuffers() {
+    auto& system = Core::System::GetInstance();
+    if (frame_callback) {
+        Core::FrameSectionScope present_section{system.perf_stats.get(), Core::FrameSection::Gpu};
+        frame_callback(m_current_frame, HashScreens());
+    }
+    m_current_frame++;
+
+    if (g_renderer_screenshot_requested.exchange(false)) {
+        LOG_ERROR(Render, "Screenshots are not supported by the null renderer");
+    }
+
+    system.perf_stats->EndSystemFrame();
+
+    render_window.PollEvents();
+
+    {
+        Core::FrameSectionScope limiter_section{system.perf_stats.get(),
+                                                Core::FrameSection::FrameLimiter};
+        system.frame_limiter.DoFrameLimiting(system.CoreTiming().GetGlobalTimeUs());
+    }
+    system.perf_stats->BeginSystemFrame();
+
+    RefreshRasterizerSetting();
+
+    if (Pica::g_debug_context && Pica::g_debug_context->recorder) {
+        Pica::g_debug_context->recorder->FrameFinished();
+    }
+}
+
+void RendererNull::PrepareVideoDumping() {
+    LOG_ERROR(Render, "Video dumping is not supported by the null renderer");
+}
+
+void RendererNull::SetFrameCallback(FrameCallback callback) {
+    frame_callback = std::move(callback);
+}
+
+/// Returns a pointer to the framebuffer, or nullptr if it isn't entirely inside one memory region
+static const u8* GetFramebufferPointer(PAddr addr, std::size_t size) {
+    const u64 end_addr = static_cast<u64>(addr) + size;
+    if (size == 0 || end_addr > std::numeric_limits<PAddr>::max()) {
+        return nullptr;
+    }
+
+    // GetPhysicalPointer accepts the end of a region as an open right bound
+    const u8* data = g_memory->GetPhysicalPointer(addr);
+    const u8* end = g_memory->GetPhysicalPointer(static_cast<PAddr>(end_addr));
+    if (data == nullptr || end != data + size) {
+        return nullptr;
+    }
+    return data;
+}
+
+RendererNull::ScreenHashes RendererNull::HashScreens() {
+    ScreenHashes hashes{};
+    for (std::size_t i = 0; i < hashes.size(); ++i) {
+        const auto& color_fill =
+            i == 0 ? LCD::g_regs.color_fill_top : LCD::g_regs.color_fill_bottom;
+        if (color_fill.is_enabled) {
+            const u32 color = color_fill.raw;
+            hashes[i] = Common::ComputeHash64(&color, sizeof(color));
+            continue;
+        }
+
+        const auto& framebuffer = GPU::g_regs.framebuffer_config[i];
+        const PAddr framebuffer_addr =
+            framebuffer.active_fb == 0 ? framebuffer.address_left1 : framebuffer.address_left2;
+        const std::size_t size = static_cast<std::size_t>(framebuffer.stride) * framebuffer.height;
+        const u8* data = GetFramebufferPointer(framebuffer_addr, size);
+        if (data == nullptr) {
+            LOG_ERROR(Render, "Screen {} has an invalid framebuffer at {:#010X}", i,
+                      framebuffer_addr);
+            continue;
+        }
+        hashes[i] = Common::ComputeHash64(data, size);
+    }
+    return hashes;
+}
+
+} // namespace VideoCore
@@ -0,0 +1,59 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <functional>
+#include "common/common_types.h"
+#include "video_core/renderer_base.h"
+
+namespace VideoCore {
+
+/**
+ * Renderer that never presents anything. Guest rendering goes through the software rasterizer into
+ * emulated memory, so no graphics context is required. Used by frontends without a display, e.g.
+ * for batch runs on machines without a GPU.
+ */
+class RendererNull : public RendererBase {
+public:
+    /// Hashes of the top (left eye) and bottom screen contents at the end of a frame
+    using ScreenHashes = std::array<u64, 2>;
+    using FrameCallback = std::function<void(int frame, const ScreenHashes& hashes)>;
+
+    explicit RendererNull(Frontend::EmuWindow& window);
+    ~RendererNull() override;
+
+    /// Initialize the renderer
+    Core::System::ResultStatus Init() override;
+
+    /// Shutdown the renderer
+    void ShutDown() override;
+
+    /// Finalizes the guest frame, hashing the screens if a frame callback is set
+    void SwapBuffers() override;
+
+    /// Nothing is ever presented
+    void TryPresent(int timeout_ms) override {}
+
+    /// Video dumping is not supported without a graphics context
+    void PrepareVideoDumping() override;
+
+    /// Video dumping is not supported without a graphics context
+    void CleanupVideoDumping() override {}
+
+    /**
+     * Sets a callback invoked from the emulation thread at the end of every guest frame. The
+     * framebuffers are only hashed while a callback is set.
+     */
+    void SetFrameCallback(FrameCallback callback);
+
+    /// Hashes the contents of the currently displayed framebuffers in emulated memory
+    static ScreenHashes HashScreens();
+
+private:
+    FrameCallback frame_callback;
+};
+
+} // namespace VideoCore
@@ -15,7 +15,9 @@
 #include "common/microprofile.h"
 #include "common/scope_exit.h"
 #include "common/vector_math.h"
+#include "core/core.h"
 #include "core/hw/gpu.h"
+#include "core/perf_stats.h"
 #include "video_core/pica_state.h"
 #include "video_core/regs_framebuffer.h"
 #include "video_core/regs_rasterizer.h"
@@ -25,6 +27,7 @@
 #include "video_core/renderer_opengl/gl_vars.h"
 #include "video_core/renderer_opengl/pica_to_gl.h"
 #include "video_core/renderer_opengl/renderer_opengl.h"
+#include "video_core/vertex_loader.h"
 #include "video_core/video_core.h"
 
 namespace OpenGL {
@@ -45,11 +48,10 @@ static bool IsVendorAmd() {
 }
 
 RasterizerOpenGL::RasterizerOpenGL(Frontend::EmuWindow& window)
-    : is_amd(IsVendorAmd()), shader_dirty(true),
+    : is_amd(IsVendorAmd()),
       vertex_buffer(GL_ARRAY_BUFFER, VERTEX_BUFFER_SIZE, is_amd),
       uniform_buffer(GL_UNIFORM_BUFFER, UNIFORM_BUFFER_SIZE, false),
-      index_buffer(GL_ELEMENT_ARRAY_BUFFER, INDEX_BUFFER_SIZE, false),
-      texture_buffer(GL_TEXTURE_BUFFER, TEXTURE_BUFFER_SIZE, false), emu_window{window} {
+      index_buffer(GL_ELEMENT_ARRAY_BUFFER, INDEX_BUFFER_SIZE, false), emu_window{window} {
 
     allow_shadow = GLAD_GL_ARB_shader_image_load_store && GLAD_GL_ARB_shader_image_size &&
                    GLAD_GL_ARB_framebuffer_no_attachments;
@@ -89,17 +91,20 @@ RasterizerOpenGL::RasterizerOpenGL(Frontend::EmuWindow& window)
     hw_vao.Create();
 
     uniform_block_data.dirty = true;
+    uniform_block_data.vs_dirty = true;
 
-    uniform_block_data.lighting_lut_dirty.fill(true);
+    for (auto& dirty_range : uniform_block_data.lighting_lut_dirty) {
+        dirty_range.AddAll(256);
+    }
     uniform_block_data.lighting_lut_dirty_any = true;
 
-    uniform_block_data.fog_lut_dirty = true;
+    uniform_block_data.fog_lut_dirty.AddAll(128);
 
-    uniform_block_data.proctex_noise_lut_dirty = true;
-    uniform_block_data.proctex_color_map_dirty = true;
-    uniform_block_data.proctex_alpha_map_dirty = true;
-    uniform_block_data.proctex_lut_dirty = true;
-    uniform_block_data.proctex_diff_lut_dirty = true;
+    uniform_block_data.proctex_noise_lut_dirty.AddAll(128);
+    uniform_block_data.proctex_color_map_dirty.AddAll(128);
+    uniform_block_data.proctex_alpha_map_dirty.AddAll(128);
+    uniform_block_data.proctex_lut_dirty.AddAll(256);
+    uniform_block_data.proctex_diff_lut_dirty.AddAll(256);
 
     glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniform_buffer_alignment);
     uniform_size_aligned_vs =
@@ -152,9 +157,9 @@ RasterizerOpenGL::RasterizerOpenGL(Frontend::EmuWindow& window)
     state.texture_buffer_lut_rgba.texture_buffer = texture_buffer_lut_rgba.handle;
     state.Apply();
     glActiveTexture(TextureUnits::TextureBufferLUT_RG.Enum());
-    glTexBuffer(GL_TEXTURE_BUFFER, GL_RG32F, texture_buffer.GetHandle());
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RG32F, uniform_buffer.GetHandle());
     glActiveTexture(TextureUnits::TextureBufferLUT_RGBA.Enum());
-    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, texture_buffer.GetHandle());
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, uniform_buffer.GetHandle());
 
     // Bind index buffer for hardware shader path
     state.draw.vertex_array = hw_vao.handle;
@@ -211,6 +216,11 @@ void RasterizerOpenGL::SyncEntireState() {
     SyncProcTexBias();
     SyncShadowBias();
     SyncShadowTextureBias();
+
+    // Bind the fragment shader, the later draws compare against its config
+    fs_config = PicaFSConfig::BuildFromRegs(Pica::g_state.regs);
+    fs_config_dirty = 0;
+    shader_program_manager->UseFragmentShader(fs_config);
 }
 
 /**
@@ -265,22 +275,18 @@ RasterizerOpenGL::VertexArrayInfo RasterizerOpenGL::AnalyzeVertexArray(bool is_i
 
     u32 vertex_min;
     u32 vertex_max;
+    GLuint index_buffer_handle = 0;
     if (is_indexed) {
         const auto& index_info = regs.pipeline.index_array;
         PAddr address = vertex_attributes.GetPhysicalBaseAddress() + index_info.offset;
-        const u8* index_address_8 = VideoCore::g_memory->GetPhysicalPointer(address);
-        const u16* index_address_16 = reinterpret_cast<const u16*>(index_address_8);
         bool index_u16 = index_info.format != 0;
 
-        vertex_min = 0xFFFF;
-        vertex_max = 0;
-        std::size_t size = regs.pipeline.num_vertices * (index_u16 ? 2 : 1);
-        res_cache.FlushRegion(address, size, nullptr);
-        for (u32 index = 0; index < regs.pipeline.num_vertices; ++index) {
-            u32 vertex = index_u16 ? index_address_16[index] : index_address_8[index];
-            vertex_min = std::min(vertex_min, vertex);
-            vertex_max = std::max(vertex_max, vertex);
-        }
+        // The vertex range of cached index arrays is only computed when they are uploaded
+        const auto index_array =
+            vertex_buffer_cache.GetIndexArray(address, regs.pipeline.num_vertices, index_u16);
+        vertex_min = index_array.vertex_min;
+        vertex_max = index_array.vertex_max;
+        index_buffer_handle = index_array.buffer;
     } else {
         vertex_min = regs.pipeline.vertex_offset;
         vertex_max = regs.pipeline.vertex_offset + regs.pipeline.num_vertices - 1;
@@ -294,11 +300,11 @@ RasterizerOpenGL::VertexArrayInfo RasterizerOpenGL::AnalyzeVertexArray(bool is_i
         }
     }
 
-    return {vertex_min, vertex_max, vs_input_size};
+    return {vertex_min, vertex_max, vs_input_size, index_buffer_handle};
 }
 
-void RasterizerOpenGL::SetupVertexArray(u8* array_ptr, GLintptr buffer_offset,
-                                        GLuint vs_input_index_min, GLuint vs_input_index_max) {
+u32 RasterizerOpenGL::SetupVertexArray(u8* array_ptr, GLintptr buffer_offset,
+                                       GLuint vs_input_index_min, GLuint vs_input_index_max) {
     MICROPROFILE_SCOPE(OpenGL_VAO);
     const auto& regs = Pica::g_state.regs;
     const auto& vertex_attributes = regs.pipeline.vertex_attributes;
@@ -309,50 +315,68 @@ void RasterizerOpenGL::SetupVertexArray(u8* array_ptr, GLintptr buffer_offset,
     state.Apply();
 
     std::array<bool, 16> enable_attributes{};
+    std::array<GLuint, 12> loader_buffers{};
+    std::array<GLintptr, 12> loader_buffer_offsets{};
+    u32 streamed_size = 0;
 
-    for (const auto& loader : vertex_attributes.attribute_loaders) {
+    for (std::size_t i = 0; i < loader_buffers.size(); ++i) {
+        const auto& loader = vertex_attributes.attribute_loaders[i];
         if (loader.component_count == 0 || loader.byte_count == 0) {
             continue;
         }
 
-        u32 offset = 0;
-        for (u32 comp = 0; comp < loader.component_count && comp < 12; ++comp) {
-            u32 attribute_index = loader.GetComponent(comp);
-            if (attribute_index < 12) {
-                if (vertex_attributes.GetNumElements(attribute_index) != 0) {
-                    offset = Common::AlignUp(
-                        offset, vertex_attributes.GetElementSizeInBytes(attribute_index));
-
-                    u32 input_reg = regs.vs.GetRegisterForAttribute(attribute_index);
-                    GLint size = vertex_attributes.GetNumElements(attribute_index);
-                    GLenum type = vs_attrib_types[static_cast<u32>(
-                        vertex_attributes.GetFormat(attribute_index))];
-                    GLsizei stride = loader.byte_count;
-                    glVertexAttribPointer(input_reg, size, type, GL_FALSE, stride,
-                                          reinterpret_cast<GLvoid*>(buffer_offset + offset));
-                    enable_attributes[input_reg] = true;
-
-                    offset += vertex_attributes.GetStride(attribute_index);
-                }
-            } else {
-                // Attribute ids 12, 13, 14 and 15 signify 4, 8, 12 and 16-byte paddings,
-                // respectively
-                offset = Common::AlignUp(offset, 4);
-                offset += (attribute_index - 11) * 4;
-            }
-        }
-
         PAddr data_addr =
             base_address + loader.data_offset + (vs_input_index_min * loader.byte_count);
 
         u32 vertex_num = vs_input_index_max - vs_input_index_min + 1;
         u32 data_size = loader.byte_count * vertex_num;
 
+        loader_buffers[i] = vertex_buffer_cache.GetVertexArray(data_addr, data_size);
+        if (loader_buffers[i] != 0) {
+            continue;
+        }
+
+        // Arrays that are rewritten all the time are streamed instead
         res_cache.FlushRegion(data_addr, data_size, nullptr);
         std::memcpy(array_ptr, VideoCore::g_memory->GetPhysicalPointer(data_addr), data_size);
 
+        loader_buffers[i] = vertex_buffer.GetHandle();
+        loader_buffer_offsets[i] = buffer_offset;
         array_ptr += data_size;
         buffer_offset += data_size;
+        streamed_size += data_size;
+    }
+
+    // The layout of the attributes within the loaders is the one of the cached vertex loader, which
+    // the software pipeline uses as well
+    const Pica::VertexLoader& vertex_loader = Pica::GetVertexLoader(regs.pipeline);
+    GLuint bound_buffer = vertex_buffer.GetHandle();
+    for (std::size_t attribute_index = 0; attribute_index < 12; ++attribute_index) {
+        const u32 loader = vertex_loader.GetAttributeLoader(attribute_index);
+        if (vertex_loader.GetAttributeElements(attribute_index) == 0 ||
+            loader_buffers[loader] == 0) {
+            continue;
+        }
+
+        // Attribute pointers refer to the buffer bound when they are specified
+        if (loader_buffers[loader] != bound_buffer) {
+            bound_buffer = loader_buffers[loader];
+            glBindBuffer(GL_ARRAY_BUFFER, bound_buffer);
+        }
+
+        u32 input_reg = regs.vs.GetRegisterForAttribute(attribute_index);
+        GLint size = vertex_loader.GetAttributeElements(attribute_index);
+        GLenum type =
+            vs_attrib_types[static_cast<u32>(vertex_loader.GetAttributeFormat(attribute_index))];
+        GLsizei stride = vertex_loader.GetAttributeStride(attribute_index);
+        GLintptr offset =
+            loader_buffer_offsets[loader] + vertex_loader.GetAttributeOffset(attribute_index);
+        glVertexAttribPointer(input_reg, size, type, GL_FALSE, stride,
+                              reinterpret_cast<GLvoid*>(offset));
+        enable_attributes[input_reg] = true;
+    }
+    if (bound_buffer != vertex_buffer.GetHandle()) {
+        glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer.GetHandle());
     }
 
     for (std::size_t i = 0; i < enable_attributes.size(); ++i) {
@@ -374,6 +398,7 @@ void RasterizerOpenGL::SetupVertexArray(u8* array_ptr, GLintptr buffer_offset,
             }
         }
     }
+    return streamed_size;
 }
 
 bool RasterizerOpenGL::SetupVertexShader() {
@@ -433,7 +458,8 @@ bool RasterizerOpenGL::AccelerateDrawBatchInternal(bool is_indexed) {
     const auto& regs = Pica::g_state.regs;
     GLenum primitive_mode = GetCurrentPrimitiveMode();
 
-    auto [vs_input_index_min, vs_input_index_max, vs_input_size] = AnalyzeVertexArray(is_indexed);
+    auto [vs_input_index_min, vs_input_index_max, vs_input_size, cached_index_buffer] =
+        AnalyzeVertexArray(is_indexed);
 
     if (vs_input_size > VERTEX_BUFFER_SIZE) {
         LOG_WARNING(Render_OpenGL, "Too large vertex input size {}", vs_input_size);
@@ -446,8 +472,11 @@ bool RasterizerOpenGL::AccelerateDrawBatchInternal(bool is_indexed) {
     u8* buffer_ptr;
     GLintptr buffer_offset;
     std::tie(buffer_ptr, buffer_offset, std::ignore) = vertex_buffer.Map(vs_input_size, 4);
-    SetupVertexArray(buffer_ptr, buffer_offset, vs_input_index_min, vs_input_index_max);
-    vertex_buffer.Unmap(vs_input_size);
+    const u32 streamed_size =
+        SetupVertexArray(buffer_ptr, buffer_offset, vs_input_index_min, vs_input_index_max);
+    vertex_buffer.Unmap(streamed_size);
+    Core::System::GetInstance().perf_stats->AddUploadedBytes(Core::UploadCounter::VertexUploaded,
+                                                             streamed_size);
 
     shader_program_manager->ApplyTo(state);
     state.Apply();
@@ -461,12 +490,22 @@ bool RasterizerOpenGL::AccelerateDrawBatchInternal(bool is_indexed) {
             return false;
         }
 
-        const u8* index_data = VideoCore::g_memory->GetPhysicalPointer(
-            regs.pipeline.vertex_attributes.GetPhysicalBaseAddress() +
-            regs.pipeline.index_array.offset);
-        std::tie(buffer_ptr, buffer_offset, std::ignore) = index_buffer.Map(index_buffer_size, 4);
-        std::memcpy(buffer_ptr, index_data, index_buffer_size);
-        index_buffer.Unmap(index_buffer_size);
+        // The element array binding is part of the VAO, and the stream buffer is mapped through it
+        if (cached_index_buffer != 0) {
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, cached_index_buffer);
+            buffer_offset = 0;
+        } else {
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffer.GetHandle());
+            const u8* index_data = VideoCore::g_memory->GetPhysicalPointer(
+                regs.pipeline.vertex_attributes.GetPhysicalBaseAddress() +
+                regs.pipeline.index_array.offset);
+            std::tie(buffer_ptr, buffer_offset, std::ignore) =
+                index_buffer.Map(index_buffer_size, 4);
+            std::memcpy(buffer_ptr, index_data, index_buffer_size);
+            index_buffer.Unmap(index_buffer_size);
+            Core::System::GetInstance().perf_stats->AddUploadedBytes(
+                Core::UploadCounter::IndexUploaded, index_buffer_size);
+        }
 
         glDrawRangeElementsBaseVertex(
             primitive_mode, vs_input_index_min, vs_input_index_max, regs.pipeline.num_vertices,
@@ -488,6 +527,8 @@ bool RasterizerOpenGL::Draw(bool accelerate, bool is_indexed) {
     MICROPROFILE_SCOPE(OpenGL_Drawing);
     const auto& regs = Pica::g_state.regs;
 
+    vertex_buffer_cache.BeginDraw();
+
     bool shadow_rendering = regs.framebuffer.output_merger.fragment_operation_mode ==
                             Pica::FramebufferRegs::FragmentOperationMode::Shadow;
 
@@ -757,15 +798,11 @@ bool RasterizerOpenGL::Draw(bool accelerate, bool is_indexed) {
     }
 
     // Sync and bind the shader
-    if (shader_dirty) {
+    if (fs_config_dirty != 0) {
         SetShader();
-        shader_dirty = false;
     }
 
-    // Sync the LUTs within the texture buffer
-    SyncAndUploadLUTs();
-
-    // Sync the uniform data
+    // Sync the LUTs and the uniform data
     UploadUniforms(accelerate);
 
     // Viewport can have negative offsets or larger
@@ -842,11 +879,15 @@ bool RasterizerOpenGL::Draw(bool accelerate, bool is_indexed) {
         auto interval = color_surface->GetSubRectInterval(draw_rect_unscaled);
         res_cache.InvalidateRegion(boost::icl::first(interval), boost::icl::length(interval),
                                    color_surface);
+        vertex_buffer_cache.InvalidateRegion(boost::icl::first(interval),
+                                             boost::icl::length(interval));
     }
     if (depth_surface != nullptr && write_depth_fb) {
         auto interval = depth_surface->GetSubRectInterval(draw_rect_unscaled);
         res_cache.InvalidateRegion(boost::icl::first(interval), boost::icl::length(interval),
                                    depth_surface);
+        vertex_buffer_cache.InvalidateRegion(boost::icl::first(interval),
+                                             boost::icl::length(interval));
     }
 
     return succeeded;
@@ -883,12 +924,14 @@ void RasterizerOpenGL::NotifyPicaRegisterChanged(u32 id) {
 
     // Depth buffering
     case PICA_REG_INDEX(rasterizer.depthmap_enable):
-        shader_dirty = true;
+        fs_config_dirty |= PicaFSConfig::RasterizerGroup;
         break;
 
     // Blending
+    // (This also holds the fragment operation mode)
     case PICA_REG_INDEX(framebuffer.output_merger.alphablend_enable):
         SyncBlendEnabled();
+        fs_config_dirty |= PicaFSConfig::FramebufferGroup;
         break;
     case PICA_REG_INDEX(framebuffer.output_merger.alpha_blending):
         SyncBlendFuncs();
@@ -900,6 +943,7 @@ void RasterizerOpenGL::NotifyPicaRegisterChanged(u32 id) {
     // Shadow texture
     case PICA_REG_INDEX(texturing.shadow):
         SyncShadowTextureBias();
+        fs_config_dirty |= PicaFSConfig::TexturingGroup;
         break;
 
     // Fog state
@@ -914,7 +958,8 @@ void RasterizerOpenGL::NotifyPicaRegisterChanged(u32 id) {
     case PICA_REG_INDEX(texturing.fog_lut_data[5]):
     case PICA_REG_INDEX(texturing.fog_lut_data[6]):
     case PICA_REG_INDEX(texturing.fog_lut_data[7]):
-        uniform_block_data.fog_lut_dirty = true;
+        // The offset was already advanced past the written entry
+        uniform_block_data.fog_lut_dirty.Add((regs.texturing.fog_lut_offset - 1) % 128);
         break;
 
     // ProcTex state
@@ -922,7 +967,7 @@ void RasterizerOpenGL::NotifyPicaRegisterChanged(u32 id) {
     case PICA_REG_INDEX(texturing.proctex_lut):
     case PICA_REG_INDEX(texturing.proctex_lut_offset):
         SyncProcTexBias();
-        shader_dirty = true;
+        fs_config_dirty |= PicaFSConfig::ProcTexGroup;
         break;
 
     case PICA_REG_INDEX(texturing.proctex_noise_u):
@@ -938,31 +983,34 @@ void RasterizerOpenGL::NotifyPicaRegisterChanged(u32 id) {
     case PICA_REG_INDEX(texturing.proctex_lut_data[4]):
     case PICA_REG_INDEX(texturing.proctex_lut_data[5]):
     case PICA_REG_INDEX(texturing.proctex_lut_data[6]):
-    case PICA_REG_INDEX(texturing.proctex_lut_data[7]):
+    case PICA_REG_INDEX(texturing.proctex_lut_data[7]): {
         using Pica::TexturingRegs;
+        // The index was already advanced past the written entry
+        const u32 index = (regs.texturing.proctex_lut_config.index - 1) & 0xFF;
         switch (regs.texturing.proctex_lut_config.ref_table.Value()) {
         case TexturingRegs::ProcTexLutTable::Noise:
-            uniform_block_data.proctex_noise_lut_dirty = true;
+            uniform_block_data.proctex_noise_lut_dirty.Add(index % 128);
             break;
         case TexturingRegs::ProcTexLutTable::ColorMap:
-            uniform_block_data.proctex_color_map_dirty = true;
+            uniform_block_data.proctex_color_map_dirty.Add(index % 128);
             break;
         case TexturingRegs::ProcTexLutTable::AlphaMap:
-            uniform_block_data.proctex_alpha_map_dirty = true;
+            uniform_block_data.proctex_alpha_map_dirty.Add(index % 128);
             break;
         case TexturingRegs::ProcTexLutTable::Color:
-            uniform_block_data.proctex_lut_dirty = true;
+            uniform_block_data.proctex_lut_dirty.Add(index);
             break;
         case TexturingRegs::ProcTexLutTable::ColorDiff:
-            uniform_block_data.proctex_diff_lut_dirty = true;
+            uniform_block_data.proctex_diff_lut_dirty.Add(index);
             break;
         }
         break;
+    }
 
     // Alpha test
     case PICA_REG_INDEX(framebuffer.output_merger.alpha_test):
         SyncAlphaTest();
-        shader_dirty = true;
+        fs_config_dirty |= PicaFSConfig::FramebufferGroup;
         break;
 
     // Sync GL stencil test + stencil write mask
@@ -1003,7 +1051,7 @@ void RasterizerOpenGL::NotifyPicaRegisterChanged(u32 id) {
 
     // Scissor test
     case PICA_REG_INDEX(rasterizer.scissor_test.mode):
-        shader_dirty = true;
+        fs_config_dirty |= PicaFSConfig::RasterizerGroup;
         break;
 
     // Logic op
@@ -1012,12 +1060,12 @@ void RasterizerOpenGL::NotifyPicaRegisterChanged(u32 id) {
         break;
 
     case PICA_REG_INDEX(texturing.main_config):
-        shader_dirty = true;
+        fs_config_dirty |= PicaFSConfig::TexturingGroup | PicaFSConfig::ProcTexGroup;
         break;
 
     // Texture 0 type
     case PICA_REG_INDEX(texturing.texture0.type):
-        shader_dirty = true;
+        fs_config_dirty |= PicaFSConfig::TexturingGroup;
         break;
 
     // TEV stages
@@ -1047,7 +1095,7 @@ void RasterizerOpenGL::NotifyPicaRegisterChanged(u32 id) {
     case PICA_REG_INDEX(texturing.tev_stage5.color_op):
     case PICA_REG_INDEX(texturing.tev_stage5.color_scale):
     case PICA_REG_INDEX(texturing.tev_combiner_buffer_input):
-        shader_dirty = true;
+        fs_config_dirty |= PicaFSConfig::TevGroup;
         break;
     case PICA_REG_INDEX(texturing.tev_stage0.const_r):
         SyncTevConstColor(0, regs.texturing.tev_stage0);
@@ -1082,6 +1130,7 @@ void RasterizerOpenGL::NotifyPicaRegisterChanged(u32 id) {
     case PICA_REG_INDEX(lighting.lut_input):
     case PICA_REG_INDEX(lighting.lut_scale):
     case PICA_REG_INDEX(lighting.light_enable):
+        fs_config_dirty |= PicaFSConfig::LightingGroup;
         break;
 
     // Fragment lighting specular 0 color
@@ -1265,7 +1314,7 @@ void RasterizerOpenGL::NotifyPicaRegisterChanged(u32 id) {
     case PICA_REG_INDEX(lighting.light[5].config):
     case PICA_REG_INDEX(lighting.light[6].config):
     case PICA_REG_INDEX(lighting.light[7].config):
-        shader_dirty = true;
+        fs_config_dirty |= PicaFSConfig::LightingGroup;
         break;
 
     // Fragment lighting distance attenuation bias
@@ -1335,10 +1384,28 @@ void RasterizerOpenGL::NotifyPicaRegisterChanged(u32 id) {
     case PICA_REG_INDEX(lighting.lut_data[6]):
     case PICA_REG_INDEX(lighting.lut_data[7]): {
         auto& lut_config = regs.lighting.lut_config;
-        uniform_block_data.lighting_lut_dirty[lut_config.type] = true;
+        // The index was already advanced past the written entry
+        uniform_block_data.lighting_lut_dirty[lut_config.type].Add((lut_config.index - 1) & 0xFF);
         uniform_block_data.lighting_lut_dirty_any = true;
         break;
     }
+
+    // Vertex shader uniforms
+    case PICA_REG_INDEX(vs.bool_uniforms):
+    case PICA_REG_INDEX(vs.int_uniforms[0]):
+    case PICA_REG_INDEX(vs.int_uniforms[1]):
+    case PICA_REG_INDEX(vs.int_uniforms[2]):
+    case PICA_REG_INDEX(vs.int_uniforms[3]):
+    case PICA_REG_INDEX(vs.uniform_setup.set_value[0]):
+    case PICA_REG_INDEX(vs.uniform_setup.set_value[1]):
+    case PICA_REG_INDEX(vs.uniform_setup.set_value[2]):
+    case PICA_REG_INDEX(vs.uniform_setup.set_value[3]):
+    case PICA_REG_INDEX(vs.uniform_setup.set_value[4]):
+    case PICA_REG_INDEX(vs.uniform_setup.set_value[5]):
+    case PICA_REG_INDEX(vs.uniform_setup.set_value[6]):
+    case PICA_REG_INDEX(vs.uniform_setup.set_value[7]):
+        uniform_block_data.vs_dirty = true;
+        break;
     }
 }
 
@@ -1355,12 +1422,14 @@ void RasterizerOpenGL::FlushRegion(PAddr addr, u32 size) {
 void RasterizerOpenGL::InvalidateRegion(PAddr addr, u32 size) {
     MICROPROFILE_SCOPE(OpenGL_CacheManagement);
     res_cache.InvalidateRegion(addr, size, nullptr);
+    vertex_buffer_cache.InvalidateRegion(addr, size);
 }
 
 void RasterizerOpenGL::FlushAndInvalidateRegion(PAddr addr, u32 size) {
     MICROPROFILE_SCOPE(OpenGL_CacheManagement);
     res_cache.FlushRegion(addr, size);
     res_cache.InvalidateRegion(addr, size, nullptr);
+    vertex_buffer_cache.InvalidateRegion(addr, size);
 }
 
 bool RasterizerOpenGL::AccelerateDisplayTransfer(const GPU::Regs::DisplayTransferConfig& config) {
@@ -1411,6 +1480,7 @@ bool RasterizerOpenGL::AccelerateDisplayTransfer(const GPU::Regs::DisplayTransfe
         return false;
 
     res_cache.InvalidateRegion(dst_params.addr, dst_params.size, dst_surface);
+    vertex_buffer_cache.InvalidateRegion(dst_params.addr, dst_params.size);
     return true;
 }
 
@@ -1496,6 +1566,7 @@ bool RasterizerOpenGL::AccelerateTextureCopy(const GPU::Regs::DisplayTransferCon
     }
 
     res_cache.InvalidateRegion(dst_params.addr, dst_params.size, dst_surface);
+    vertex_buffer_cache.InvalidateRegion(dst_params.addr, dst_params.size);
     return true;
 }
 
@@ -1505,6 +1576,7 @@ bool RasterizerOpenGL::AccelerateFill(const GPU::Regs::MemoryFillConfig& config)
         return false;
 
     res_cache.InvalidateRegion(dst_surface->addr, dst_surface->size, dst_surface);
+    vertex_buffer_cache.InvalidateRegion(dst_surface->addr, dst_surface->size);
     return true;
 }
 
@@ -1622,8 +1694,18 @@ void RasterizerOpenGL::SamplerInfo::SyncWithConfig(
 }
 
 void RasterizerOpenGL::SetShader() {
-    auto config = PicaFSConfig::BuildFromRegs(Pica::g_state.regs);
-    shader_program_manager->UseFragmentShader(config);
+    PicaFSConfig config = fs_config;
+    config.Update(Pica::g_state.regs, fs_config_dirty);
+    fs_config_dirty = 0;
+
+    // Games often write the same state again between draws, in which case the bound shader is
+    // still the right one and the hash and lookup of the config can be skipped
+    if (config == fs_config) {
+        return;
+    }
+
+    fs_config = config;
+    shader_program_manager->UseFragmentShader(fs_config);
 }
 
 void RasterizerOpenGL::SyncClipEnabled() {
@@ -1945,177 +2027,130 @@ void RasterizerOpenGL::SyncShadowTextureBias() {
     }
 }
 
-void RasterizerOpenGL::SyncAndUploadLUTs() {
-    constexpr std::size_t max_size = sizeof(GLvec2) * 256 * Pica::LightingRegs::NumLightingSampler +
-                                     sizeof(GLvec2) * 128 +     // fog
-                                     sizeof(GLvec2) * 128 * 3 + // proctex: noise + color + alpha
-                                     sizeof(GLvec4) * 256 +     // proctex
-                                     sizeof(GLvec4) * 256;      // proctex diff
-
-    if (!uniform_block_data.lighting_lut_dirty_any && !uniform_block_data.fog_lut_dirty &&
-        !uniform_block_data.proctex_noise_lut_dirty &&
-        !uniform_block_data.proctex_color_map_dirty &&
-        !uniform_block_data.proctex_alpha_map_dirty && !uniform_block_data.proctex_lut_dirty &&
-        !uniform_block_data.proctex_diff_lut_dirty) {
-        return;
-    }
-
-    u8* buffer;
-    GLintptr offset;
-    bool invalidate;
+std::size_t RasterizerOpenGL::SyncAndUploadLUTs(u8* buffer, GLintptr offset, bool invalidate) {
     std::size_t bytes_used = 0;
-    glBindBuffer(GL_TEXTURE_BUFFER, texture_buffer.GetHandle());
-    std::tie(buffer, offset, invalidate) = texture_buffer.Map(max_size, sizeof(GLvec4));
 
-    // Sync the lighting luts
-    if (uniform_block_data.lighting_lut_dirty_any || invalidate) {
-        for (unsigned index = 0; index < uniform_block_data.lighting_lut_dirty.size(); index++) {
-            if (uniform_block_data.lighting_lut_dirty[index] || invalidate) {
-                std::array<GLvec2, 256> new_data;
-                const auto& source_lut = Pica::g_state.lighting.luts[index];
-                std::transform(source_lut.begin(), source_lut.end(), new_data.begin(),
-                               [](const auto& entry) {
-                                   return GLvec2{entry.ToFloat(), entry.DiffToFloat()};
-                               });
-
-                if (new_data != lighting_lut_data[index] || invalidate) {
-                    lighting_lut_data[index] = new_data;
-                    std::memcpy(buffer + bytes_used, new_data.data(),
-                                new_data.size() * sizeof(GLvec2));
-                    uniform_block_data.data.lighting_lut_offset[index / 4][index % 4] =
-                        (offset + bytes_used) / sizeof(GLvec2);
-                    uniform_block_data.dirty = true;
-                    bytes_used += new_data.size() * sizeof(GLvec2);
-                }
-                uniform_block_data.lighting_lut_dirty[index] = false;
-            }
-        }
-    }
-    uniform_block_data.lighting_lut_dirty_any = false;
-
-    // Sync the fog lut
-    if (uniform_block_data.fog_lut_dirty || invalidate) {
-        std::array<GLvec2, 128> new_data;
-
-        std::transform(Pica::g_state.fog.lut.begin(), Pica::g_state.fog.lut.end(), new_data.begin(),
-                       [](const auto& entry) {
-                           return GLvec2{entry.ToFloat(), entry.DiffToFloat()};
-                       });
-
-        if (new_data != fog_lut_data || invalidate) {
-            fog_lut_data = new_data;
-            std::memcpy(buffer + bytes_used, new_data.data(), new_data.size() * sizeof(GLvec2));
-            uniform_block_data.data.fog_lut_offset = (offset + bytes_used) / sizeof(GLvec2);
-            uniform_block_data.dirty = true;
-            bytes_used += new_data.size() * sizeof(GLvec2);
+    // Only the written entries of a LUT are converted and compared to what is on the host GPU. As
+    // the buffer is streamed, a LUT with any changed entry is written again as a whole.
+    auto SyncLUT = [this, buffer, offset, invalidate, &bytes_used](
+                       const auto& lut, auto& lut_data, LUTDirtyRange& dirty_range,
+                       GLint& lut_offset, auto convert) {
+        if (invalidate) {
+            dirty_range.AddAll(static_cast<u32>(lut_data.size()));
         }
-        uniform_block_data.fog_lut_dirty = false;
-    }
-
-    // helper function for SyncProcTexNoiseLUT/ColorMap/AlphaMap
-    auto SyncProcTexValueLUT = [this, buffer, offset, invalidate, &bytes_used](
-                                   const std::array<Pica::State::ProcTex::ValueEntry, 128>& lut,
-                                   std::array<GLvec2, 128>& lut_data, GLint& lut_offset) {
-        std::array<GLvec2, 128> new_data;
-        std::transform(lut.begin(), lut.end(), new_data.begin(), [](const auto& entry) {
-            return GLvec2{entry.ToFloat(), entry.DiffToFloat()};
-        });
-
-        if (new_data != lut_data || invalidate) {
-            lut_data = new_data;
-            std::memcpy(buffer + bytes_used, new_data.data(), new_data.size() * sizeof(GLvec2));
-            lut_offset = (offset + bytes_used) / sizeof(GLvec2);
-            uniform_block_data.dirty = true;
-            bytes_used += new_data.size() * sizeof(GLvec2);
+        if (!dirty_range.IsDirty()) {
+            return;
         }
-    };
-
-    // Sync the proctex noise lut
-    if (uniform_block_data.proctex_noise_lut_dirty || invalidate) {
-        SyncProcTexValueLUT(Pica::g_state.proctex.noise_table, proctex_noise_lut_data,
-                            uniform_block_data.data.proctex_noise_lut_offset);
-        uniform_block_data.proctex_noise_lut_dirty = false;
-    }
-
-    // Sync the proctex color map
-    if (uniform_block_data.proctex_color_map_dirty || invalidate) {
-        SyncProcTexValueLUT(Pica::g_state.proctex.color_map_table, proctex_color_map_data,
-                            uniform_block_data.data.proctex_color_map_offset);
-        uniform_block_data.proctex_color_map_dirty = false;
-    }
-
-    // Sync the proctex alpha map
-    if (uniform_block_data.proctex_alpha_map_dirty || invalidate) {
-        SyncProcTexValueLUT(Pica::g_state.proctex.alpha_map_table, proctex_alpha_map_data,
-                            uniform_block_data.data.proctex_alpha_map_offset);
-        uniform_block_data.proctex_alpha_map_dirty = false;
-    }
-
-    // Sync the proctex lut
-    if (uniform_block_data.proctex_lut_dirty || invalidate) {
-        std::array<GLvec4, 256> new_data;
 
-        std::transform(Pica::g_state.proctex.color_table.begin(),
-                       Pica::g_state.proctex.color_table.end(), new_data.begin(),
-                       [](const auto& entry) {
-                           auto rgba = entry.ToVector() / 255.0f;
-                           return GLvec4{rgba.r(), rgba.g(), rgba.b(), rgba.a()};
-                       });
+        bool changed = invalidate;
+        for (u32 index = dirty_range.begin; index < dirty_range.end; ++index) {
+            const auto new_entry = convert(lut[index]);
+            if (new_entry != lut_data[index]) {
+                lut_data[index] = new_entry;
+                changed = true;
+            }
+        }
+        dirty_range = {};
 
-        if (new_data != proctex_lut_data || invalidate) {
-            proctex_lut_data = new_data;
-            std::memcpy(buffer + bytes_used, new_data.data(), new_data.size() * sizeof(GLvec4));
-            uniform_block_data.data.proctex_lut_offset = (offset + bytes_used) / sizeof(GLvec4);
+        if (changed) {
+            const std::size_t entry_size = sizeof(lut_data[0]);
+            std::memcpy(buffer + bytes_used, lut_data.data(), lut_data.size() * entry_size);
+            lut_offset = static_cast<GLint>((offset + bytes_used) / entry_size);
             uniform_block_data.dirty = true;
-            bytes_used += new_data.size() * sizeof(GLvec4);
+            bytes_used += lut_data.size() * entry_size;
         }
-        uniform_block_data.proctex_lut_dirty = false;
-    }
-
-    // Sync the proctex difference lut
-    if (uniform_block_data.proctex_diff_lut_dirty || invalidate) {
-        std::array<GLvec4, 256> new_data;
+    };
 
-        std::transform(Pica::g_state.proctex.color_diff_table.begin(),
-                       Pica::g_state.proctex.color_diff_table.end(), new_data.begin(),
-                       [](const auto& entry) {
-                           auto rgba = entry.ToVector() / 255.0f;
-                           return GLvec4{rgba.r(), rgba.g(), rgba.b(), rgba.a()};
-                       });
+    const auto ValueToGL = [](const auto& entry) {
+        return GLvec2{entry.ToFloat(), entry.DiffToFloat()};
+    };
+    const auto ColorToGL = [](const auto& entry) {
+        auto rgba = entry.ToVector() / 255.0f;
+        return GLvec4{rgba.r(), rgba.g(), rgba.b(), rgba.a()};
+    };
 
-        if (new_data != proctex_diff_lut_data || invalidate) {
-            proctex_diff_lut_data = new_data;
-            std::memcpy(buffer + bytes_used, new_data.data(), new_data.size() * sizeof(GLvec4));
-            uniform_block_data.data.proctex_diff_lut_offset =
-                (offset + bytes_used) / sizeof(GLvec4);
-            uniform_block_data.dirty = true;
-            bytes_used += new_data.size() * sizeof(GLvec4);
+    // Sync the lighting luts
+    if (uniform_block_data.lighting_lut_dirty_any || invalidate) {
+        for (unsigned index = 0; index < uniform_block_data.lighting_lut_dirty.size(); index++) {
+            SyncLUT(Pica::g_state.lighting.luts[index], lighting_lut_data[index],
+                    uniform_block_data.lighting_lut_dirty[index],
+                    uniform_block_data.data.lighting_lut_offset[index / 4][index % 4], ValueToGL);
         }
-        uniform_block_data.proctex_diff_lut_dirty = false;
     }
+    uniform_block_data.lighting_lut_dirty_any = false;
 
-    texture_buffer.Unmap(bytes_used);
+    // Sync the fog lut
+    SyncLUT(Pica::g_state.fog.lut, fog_lut_data, uniform_block_data.fog_lut_dirty,
+            uniform_block_data.data.fog_lut_offset, ValueToGL);
+
+    // Sync the proctex luts
+    const auto& proctex = Pica::g_state.proctex;
+    SyncLUT(proctex.noise_table, proctex_noise_lut_data, uniform_block_data.proctex_noise_lut_dirty,
+            uniform_block_data.data.proctex_noise_lut_offset, ValueToGL);
+    SyncLUT(proctex.color_map_table, proctex_color_map_data,
+            uniform_block_data.proctex_color_map_dirty,
+            uniform_block_data.data.proctex_color_map_offset, ValueToGL);
+    SyncLUT(proctex.alpha_map_table, proctex_alpha_map_data,
+            uniform_block_data.proctex_alpha_map_dirty,
+            uniform_block_data.data.proctex_alpha_map_offset, ValueToGL);
+    SyncLUT(proctex.color_table, proctex_lut_data, uniform_block_data.proctex_lut_dirty,
+            uniform_block_data.data.proctex_lut_offset, ColorToGL);
+    SyncLUT(proctex.color_diff_table, proctex_diff_lut_data,
+            uniform_block_data.proctex_diff_lut_dirty,
+            uniform_block_data.data.proctex_diff_lut_offset, ColorToGL);
+
+    return bytes_used;
 }
 
 void RasterizerOpenGL::UploadUniforms(bool accelerate_draw) {
+    constexpr std::size_t max_lut_size =
+        sizeof(GLvec2) * 256 * Pica::LightingRegs::NumLightingSampler +
+        sizeof(GLvec2) * 128 +     // fog
+        sizeof(GLvec2) * 128 * 3 + // proctex: noise + color + alpha
+        sizeof(GLvec4) * 256 +     // proctex
+        sizeof(GLvec4) * 256;      // proctex diff
+
     // glBindBufferRange below also changes the generic buffer binding point, so we sync the state
     // first
     state.draw.uniform_buffer = uniform_buffer.GetHandle();
     state.Apply();
 
-    bool sync_vs = accelerate_draw;
+    bool sync_luts = uniform_block_data.lighting_lut_dirty_any ||
+                     uniform_block_data.fog_lut_dirty.IsDirty() ||
+                     uniform_block_data.proctex_noise_lut_dirty.IsDirty() ||
+                     uniform_block_data.proctex_color_map_dirty.IsDirty() ||
+                     uniform_block_data.proctex_alpha_map_dirty.IsDirty() ||
+                     uniform_block_data.proctex_lut_dirty.IsDirty() ||
+                     uniform_block_data.proctex_diff_lut_dirty.IsDirty();
+    bool sync_vs = accelerate_draw && uniform_block_data.vs_dirty;
     bool sync_fs = uniform_block_data.dirty;
 
-    if (!sync_vs && !sync_fs)
+    if (!sync_luts && !sync_vs && !sync_fs)
         return;
 
-    std::size_t uniform_size = uniform_size_aligned_vs + uniform_size_aligned_fs;
-    std::size_t used_bytes = 0;
+    // The LUTs and the uniform blocks share one mapping. The LUTs go first, which only need to be
+    // aligned to their entries.
+    const std::size_t alignment =
+        std::max<std::size_t>(uniform_buffer_alignment, sizeof(GLvec4));
+    std::size_t max_size =
+        max_lut_size + alignment + uniform_size_aligned_vs + uniform_size_aligned_fs;
     u8* uniforms;
     GLintptr offset;
     bool invalidate;
-    std::tie(uniforms, offset, invalidate) =
-        uniform_buffer.Map(uniform_size, uniform_buffer_alignment);
+    std::tie(uniforms, offset, invalidate) = uniform_buffer.Map(max_size, alignment);
+
+    auto& perf_stats = *Core::System::GetInstance().perf_stats;
+    std::size_t used_bytes = SyncAndUploadLUTs(uniforms, offset, invalidate);
+    if (used_bytes > 0) {
+        perf_stats.AddUploadedBytes(Core::UploadCounter::LUTUploaded, used_bytes);
+        used_bytes = Common::AlignUp<std::size_t>(used_bytes, uniform_buffer_alignment);
+    }
+
+    // The uniform blocks bound before the buffer was invalidated are gone
+    if (invalidate) {
+        uniform_block_data.vs_dirty = true;
+    }
+    sync_vs = accelerate_draw && uniform_block_data.vs_dirty;
 
     if (sync_vs) {
         VSUniformData vs_uniforms;
@@ -2123,15 +2158,18 @@ void RasterizerOpenGL::UploadUniforms(bool accelerate_draw) {
         std::memcpy(uniforms + used_bytes, &vs_uniforms, sizeof(vs_uniforms));
         glBindBufferRange(GL_UNIFORM_BUFFER, static_cast<GLuint>(UniformBindings::VS),
                           uniform_buffer.GetHandle(), offset + used_bytes, sizeof(VSUniformData));
+        uniform_block_data.vs_dirty = false;
         used_bytes += uniform_size_aligned_vs;
+        perf_stats.AddUploadedBytes(Core::UploadCounter::UniformUploaded, sizeof(VSUniformData));
     }
 
-    if (sync_fs || invalidate) {
+    if (uniform_block_data.dirty || invalidate) {
         std::memcpy(uniforms + used_bytes, &uniform_block_data.data, sizeof(UniformData));
         glBindBufferRange(GL_UNIFORM_BUFFER, static_cast<GLuint>(UniformBindings::Common),
                           uniform_buffer.GetHandle(), offset + used_bytes, sizeof(UniformData));
         uniform_block_data.dirty = false;
         used_bytes += uniform_size_aligned_fs;
+        perf_stats.AddUploadedBytes(Core::UploadCounter::UniformUploaded, sizeof(UniformData));
     }
 
     uniform_buffer.Unmap(used_bytes);
@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <algorithm>
 #include <array>
 #include <cstddef>
 #include <cstring>
@@ -26,6 +27,7 @@
 #include "video_core/renderer_opengl/gl_shader_manager.h"
 #include "video_core/renderer_opengl/gl_state.h"
 #include "video_core/renderer_opengl/gl_stream_buffer.h"
+#include "video_core/renderer_opengl/gl_vertex_buffer_cache.h"
 #include "video_core/renderer_opengl/pica_to_gl.h"
 #include "video_core/shader/shader.h"
 
@@ -137,7 +139,8 @@ private:
     /// Syncs the clip coefficients to match the PICA register
     void SyncClipCoef();
 
-    /// Sets the OpenGL shader in accordance with the current PICA register state
+    /// Sets the OpenGL shader in accordance with the current PICA register state, rebuilding only
+    /// the parts of the fragment shader config whose registers were written
     void SetShader();
 
     /// Syncs the cull mode to match the PICA register
@@ -227,10 +230,11 @@ private:
     /// Syncs the shadow texture bias to match the PICA register
     void SyncShadowTextureBias();
 
-    /// Syncs and uploads the lighting, fog and proctex LUTs
-    void SyncAndUploadLUTs();
+    /// Syncs the lighting, fog and proctex LUTs into the mapped uniform buffer, returns the number
+    /// of bytes written
+    std::size_t SyncAndUploadLUTs(u8* buffer, GLintptr offset, bool invalidate);
 
-    /// Upload the uniform blocks to the uniform buffer object
+    /// Uploads the LUTs and the uniform blocks that changed to the uniform buffer object
     void UploadUniforms(bool accelerate_draw);
 
     /// Generic draw function for DrawTriangles and AccelerateDrawBatch
@@ -243,14 +247,16 @@ private:
         u32 vs_input_index_min;
         u32 vs_input_index_max;
         u32 vs_input_size;
+        /// Cached buffer holding the indices, 0 if they have to be streamed
+        GLuint index_buffer;
     };
 
     /// Retrieve the range and the size of the input vertex
     VertexArrayInfo AnalyzeVertexArray(bool is_indexed);
 
-    /// Setup vertex array for AccelerateDrawBatch
-    void SetupVertexArray(u8* array_ptr, GLintptr buffer_offset, GLuint vs_input_index_min,
-                          GLuint vs_input_index_max);
+    /// Setup vertex array for AccelerateDrawBatch, returns the number of bytes streamed
+    u32 SetupVertexArray(u8* array_ptr, GLintptr buffer_offset, GLuint vs_input_index_min,
+                         GLuint vs_input_index_max);
 
     /// Setup vertex shader for AccelerateDrawBatch
     bool SetupVertexShader();
@@ -264,24 +270,54 @@ private:
     GLuint default_texture;
 
     RasterizerCacheOpenGL res_cache;
+    VertexBufferCache vertex_buffer_cache{res_cache};
 
     Frontend::EmuWindow& emu_window;
 
     std::vector<HardwareVertex> vertex_batch;
 
-    bool shader_dirty;
+    /// Fragment shader config of the bound shader, and the PicaFSConfig::RegGroup bits of the
+    /// register groups written since it was built
+    PicaFSConfig fs_config;
+    u32 fs_config_dirty = 0;
+
+    /// Entries [begin, end) of a LUT that were written since it was last synced
+    struct LUTDirtyRange {
+        u32 begin = 0;
+        u32 end = 0;
+
+        bool IsDirty() const {
+            return begin != end;
+        }
+
+        void Add(u32 index) {
+            if (IsDirty()) {
+                begin = std::min(begin, index);
+                end = std::max(end, index + 1);
+            } else {
+                begin = index;
+                end = index + 1;
+            }
+        }
+
+        void AddAll(u32 size) {
+            begin = 0;
+            end = size;
+        }
+    };
 
     struct {
         UniformData data;
-        std::array<bool, Pica::LightingRegs::NumLightingSampler> lighting_lut_dirty;
+        std::array<LUTDirtyRange, Pica::LightingRegs::NumLightingSampler> lighting_lut_dirty;
         bool lighting_lut_dirty_any;
-        bool fog_lut_dirty;
-        bool proctex_noise_lut_dirty;
-        bool proctex_color_map_dirty;
-        bool proctex_alpha_map_dirty;
-        bool proctex_lut_dirty;
-        bool proctex_diff_lut_dirty;
+        LUTDirtyRange fog_lut_dirty;
+        LUTDirtyRange proctex_noise_lut_dirty;
+        LUTDirtyRange proctex_color_map_dirty;
+        LUTDirtyRange proctex_alpha_map_dirty;
+        LUTDirtyRange proctex_lut_dirty;
+        LUTDirtyRange proctex_diff_lut_dirty;
         bool dirty;
+        bool vs_dirty;
     } uniform_block_data = {};
 
     std::unique_ptr<ShaderProgramManager> shader_program_manager;
@@ -289,8 +325,8 @@ private:
     // They shall be big enough for about one frame.
     static constexpr std::size_t VERTEX_BUFFER_SIZE = 16 * 1024 * 1024;
     static constexpr std::size_t INDEX_BUFFER_SIZE = 1 * 1024 * 1024;
-    static constexpr std::size_t UNIFORM_BUFFER_SIZE = 2 * 1024 * 1024;
-    static constexpr std::size_t TEXTURE_BUFFER_SIZE = 1 * 1024 * 1024;
+    // Holds both the uniform blocks and the LUTs read through the buffer textures
+    static constexpr std::size_t UNIFORM_BUFFER_SIZE = 3 * 1024 * 1024;
 
     OGLVertexArray sw_vao; // VAO for software shader draw
     OGLVertexArray hw_vao; // VAO for hardware shader / accelerate draw
@@ -300,7 +336,6 @@ private:
     OGLStreamBuffer vertex_buffer;
     OGLStreamBuffer uniform_buffer;
     OGLStreamBuffer index_buffer;
-    OGLStreamBuffer texture_buffer;
     OGLFramebuffer framebuffer;
     GLint uniform_buffer_alignment;
     std::size_t uniform_size_aligned_vs;
@@ -482,6 +482,10 @@ public:
     /// Flush all cached resources tracked by this cache manager
     void FlushAll();
 
+    /// Increase/decrease the number of cached resources in pages touching the specified region.
+    /// Writes to pages with cached resources are reported through InvalidateRegion.
+    void UpdatePagesCachedCount(PAddr addr, u32 size, int delta);
+
 private:
     void DuplicateSurface(const Surface& src_surface, const Surface& dest_surface);
 
@@ -497,9 +501,6 @@ private:
     /// Remove surface from the cache
     void UnregisterSurface(const Surface& surface);
 
-    /// Increase/decrease the number of surface in pages touching the specified region
-    void UpdatePagesCachedCount(PAddr addr, u32 size, int delta);
-
     SurfaceCache surface_cache;
     PageMap cached_pages;
     SurfaceMap dirty_regions;
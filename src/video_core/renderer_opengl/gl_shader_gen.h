@@ -125,10 +125,32 @@ struct PicaFSConfigState {
  * two separate shaders sharing the same key.
  */
 struct PicaFSConfig : Common::HashableStruct<PicaFSConfigState> {
+    /// Groups of registers the config is built from, as bits of the mask passed to Update()
+    enum RegGroup : u32 {
+        /// Scissor test mode and depth map enable
+        RasterizerGroup = 1 << 0,
+        /// Alpha test and fragment operation mode
+        FramebufferGroup = 1 << 1,
+        /// Texture unit configuration, apart from the procedural texture
+        TexturingGroup = 1 << 2,
+        /// TEV stages, the combiner buffer input and the fog mode
+        TevGroup = 1 << 3,
+        LightingGroup = 1 << 4,
+        ProcTexGroup = 1 << 5,
+        AllGroups = (1 << 6) - 1,
+    };
 
     /// Construct a PicaFSConfig with the given Pica register configuration.
     static PicaFSConfig BuildFromRegs(const Pica::Regs& regs);
 
+    /**
+     * Rebuilds the parts of the config that come from the given register groups, leaving the
+     * others as they are. Updating every group gives the same config as BuildFromRegs().
+     * @param regs Pica register configuration
+     * @param groups Mask of RegGroup bits to rebuild
+     */
+    void Update(const Pica::Regs& regs, u32 groups);
+
     bool TevStageUpdatesCombinerBufferColor(unsigned stage_index) const {
         return (stage_index < 4) && (state.combiner_buffer_input & (1 << stage_index));
     }
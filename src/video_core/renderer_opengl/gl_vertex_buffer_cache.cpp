@@ -0,0 +1,256 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include "common/logging/log.h"
+#include "common/microprofile.h"
+#include "core/core.h"
+#include "core/perf_stats.h"
+#include "core/settings.h"
+#include "video_core/renderer_opengl/gl_rasterizer_cache.h"
+#include "video_core/renderer_opengl/gl_vertex_buffer_cache.h"
+#include "video_core/video_core.h"
+
+#ifdef ARCHITECTURE_x86_64
+#include <emmintrin.h>
+#endif // ARCHITECTURE_x86_64
+
+MICROPROFILE_DEFINE(OpenGL_VertexUpload, "OpenGL", "Vertex Buffer Upload", MP_RGB(100, 200, 100));
+
+namespace OpenGL {
+
+/// Arrays written to this many times after being cached are streamed from then on
+constexpr u32 MaxInvalidations = 3;
+/// Limits of the cache, the least recently used entries are evicted beyond them
+constexpr std::size_t MaxCachedSize = 64 * 1024 * 1024;
+constexpr std::size_t MaxEntries = 8192;
+
+/// Returns the smallest and the largest index, scanning 16 bytes at a time where possible
+static std::pair<u32, u32> GetIndexRange(const u8* indices, u32 count, bool index_u16) {
+    u32 vertex_min = 0xFFFF;
+    u32 vertex_max = 0;
+    u32 i = 0;
+
+#ifdef ARCHITECTURE_x86_64
+    if (index_u16) {
+        // SSE2 only has signed 16-bit min/max, so the indices are biased into the signed range
+        const __m128i bias = _mm_set1_epi16(-0x8000);
+        __m128i min = _mm_set1_epi16(0x7FFF);
+        __m128i max = _mm_set1_epi16(-0x8000);
+        for (; i + 8 <= count; i += 8) {
+            const __m128i values = _mm_xor_si128(
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(indices + i * 2)), bias);
+            min = _mm_min_epi16(min, values);
+            max = _mm_max_epi16(max, values);
+        }
+        if (i != 0) {
+            alignas(16) std::array<u16, 8> mins;
+            alignas(16) std::array<u16, 8> maxs;
+            _mm_store_si128(reinterpret_cast<__m128i*>(mins.data()), _mm_xor_si128(min, bias));
+            _mm_store_si128(reinterpret_cast<__m128i*>(maxs.data()), _mm_xor_si128(max, bias));
+            vertex_min = *std::min_element(mins.begin(), mins.end());
+            vertex_max = *std::max_element(maxs.begin(), maxs.end());
+        }
+    } else {
+        __m128i min = _mm_set1_epi8(-1);
+        __m128i max = _mm_setzero_si128();
+        for (; i + 16 <= count; i += 16) {
+            const __m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(indices + i));
+            min = _mm_min_epu8(min, values);
+            max = _mm_max_epu8(max, values);
+        }
+        if (i != 0) {
+            alignas(16) std::array<u8, 16> mins;
+            alignas(16) std::array<u8, 16> maxs;
+            _mm_store_si128(reinterpret_cast<__m128i*>(mins.data()), min);
+            _mm_store_si128(reinterpret_cast<__m128i*>(maxs.data()), max);
+            vertex_min = *std::min_element(mins.begin(), mins.end());
+            vertex_max = *std::max_element(maxs.begin(), maxs.end());
+        }
+    }
+#endif // ARCHITECTURE_x86_64
+
+    const u16* indices_16 = reinterpret_cast<const u16*>(indices);
+    for (; i < count; ++i) {
+        const u32 vertex = index_u16 ? indices_16[i] : indices[i];
+        vertex_min = std::min(vertex_min, vertex);
+        vertex_max = std::max(vertex_max, vertex);
+    }
+    return {vertex_min, vertex_max};
+}
+
+static void AddUploadedBytes(Core::UploadCounter counter, u32 size) {
+    Core::System::GetInstance().perf_stats->AddUploadedBytes(counter, size);
+}
+
+VertexBufferCache::VertexBufferCache(RasterizerCacheOpenGL& res_cache) : res_cache(res_cache) {}
+
+VertexBufferCache::~VertexBufferCache() {
+    for (EntryMap* entries : {&vertex_entries, &index_entries}) {
+        for (auto& pair : *entries) {
+            Release(pair.second);
+        }
+    }
+}
+
+GLuint VertexBufferCache::GetVertexArray(PAddr addr, u32 size) {
+    const u64 key = (static_cast<u64>(addr) << 32) | size;
+    Entry* entry = GetEntry(vertex_entries, key, addr, size);
+    if (entry == nullptr) {
+        return 0;
+    }
+
+    if (entry->valid) {
+        AddUploadedBytes(Core::UploadCounter::VertexReused, size);
+    } else {
+        Upload(*entry);
+        AddUploadedBytes(Core::UploadCounter::VertexUploaded, size);
+    }
+    return entry->buffer.handle;
+}
+
+VertexBufferCache::IndexArray VertexBufferCache::GetIndexArray(PAddr addr, u32 count,
+                                                               bool index_u16) {
+    const u32 size = count * (index_u16 ? 2 : 1);
+    const u64 key = (static_cast<u64>(addr) << 32) | (count << 1) | (index_u16 ? 1 : 0);
+    Entry* entry = GetEntry(index_entries, key, addr, size);
+    if (entry == nullptr) {
+        res_cache.FlushRegion(addr, size, nullptr);
+        const auto [vertex_min, vertex_max] =
+            GetIndexRange(VideoCore::g_memory->GetPhysicalPointer(addr), count, index_u16);
+        return {0, vertex_min, vertex_max};
+    }
+
+    if (entry->valid) {
+        AddUploadedBytes(Core::UploadCounter::IndexReused, size);
+    } else {
+        Upload(*entry);
+        std::tie(entry->vertex_min, entry->vertex_max) =
+            GetIndexRange(VideoCore::g_memory->GetPhysicalPointer(addr), count, index_u16);
+        AddUploadedBytes(Core::UploadCounter::IndexUploaded, size);
+    }
+    return {entry->buffer.handle, entry->vertex_min, entry->vertex_max};
+}
+
+VertexBufferCache::Entry* VertexBufferCache::GetEntry(EntryMap& entries, u64 key, PAddr addr,
+                                                      u32 size) {
+    if (!Settings::values.use_vertex_buffer_cache) {
+        return nullptr;
+    }
+
+    auto [it, inserted] = entries.try_emplace(key);
+    Entry& entry = it->second;
+    if (inserted) {
+        entry.addr = addr;
+        entry.size = size;
+    }
+    entry.last_use = draw_counter;
+
+    if (!entry.valid && entry.invalidations >= MaxInvalidations) {
+        return nullptr;
+    }
+    if (!entry.valid && (inserted || cached_size + size > MaxCachedSize)) {
+        // Make room before the new buffer is allocated, the entries of the current draw, this one
+        // included, are never evicted
+        EvictEntries(size);
+    }
+    return &entry;
+}
+
+void VertexBufferCache::Upload(Entry& entry) {
+    MICROPROFILE_SCOPE(OpenGL_VertexUpload);
+
+    res_cache.FlushRegion(entry.addr, entry.size, nullptr);
+
+    // The copy write target is not tracked by OpenGLState, so the current bindings are kept
+    entry.buffer.Create();
+    glBindBuffer(GL_COPY_WRITE_BUFFER, entry.buffer.handle);
+    glBufferData(GL_COPY_WRITE_BUFFER, entry.size,
+                 VideoCore::g_memory->GetPhysicalPointer(entry.addr), GL_STATIC_DRAW);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    res_cache.UpdatePagesCachedCount(entry.addr, entry.size, 1);
+    cached_intervals.add({entry.addr, entry.addr + entry.size});
+    cached_size += entry.size;
+    entry.valid = true;
+}
+
+void VertexBufferCache::Release(Entry& entry) {
+    if (!entry.valid) {
+        return;
+    }
+    res_cache.UpdatePagesCachedCount(entry.addr, entry.size, -1);
+    cached_size -= entry.size;
+    entry.buffer.Release();
+    entry.valid = false;
+}
+
+void VertexBufferCache::InvalidateRegion(PAddr addr, u32 size) {
+    const auto interval = boost::icl::interval<PAddr>::right_open(addr, addr + size);
+    if (size == 0 || !boost::icl::intersects(cached_intervals, interval)) {
+        return;
+    }
+
+    for (EntryMap* entries : {&vertex_entries, &index_entries}) {
+        for (auto& pair : *entries) {
+            Entry& entry = pair.second;
+            if (entry.valid && entry.addr < addr + size && addr < entry.addr + entry.size) {
+                Release(entry);
+                ++entry.invalidations;
+            }
+        }
+    }
+    RebuildCachedIntervals();
+}
+
+void VertexBufferCache::EvictEntries(u32 new_size) {
+    const std::size_t num_entries = vertex_entries.size() + index_entries.size();
+    if (num_entries <= MaxEntries && cached_size + new_size <= MaxCachedSize) {
+        return;
+    }
+
+    // Evict down to three quarters of the limits, so that this doesn't happen on every upload
+    std::vector<std::tuple<u64, EntryMap*, u64>> by_use;
+    by_use.reserve(num_entries);
+    for (EntryMap* entries : {&vertex_entries, &index_entries}) {
+        for (const auto& pair : *entries) {
+            by_use.emplace_back(pair.second.last_use, entries, pair.first);
+        }
+    }
+    std::sort(by_use.begin(), by_use.end());
+
+    std::size_t remaining_entries = num_entries;
+    for (const auto& [last_use, entries, key] : by_use) {
+        if (last_use == draw_counter ||
+            (remaining_entries <= MaxEntries * 3 / 4 &&
+             cached_size + new_size <= MaxCachedSize * 3 / 4)) {
+            break;
+        }
+        auto it = entries->find(key);
+        Release(it->second);
+        entries->erase(it);
+        --remaining_entries;
+    }
+    LOG_DEBUG(Render_OpenGL, "Evicted {} vertex buffer cache entries",
+              num_entries - remaining_entries);
+    RebuildCachedIntervals();
+}
+
+void VertexBufferCache::RebuildCachedIntervals() {
+    cached_intervals.clear();
+    for (EntryMap* entries : {&vertex_entries, &index_entries}) {
+        for (const auto& pair : *entries) {
+            const Entry& entry = pair.second;
+            if (entry.valid) {
+                cached_intervals.add({entry.addr, entry.addr + entry.size});
+            }
+        }
+    }
+}
+
+} // namespace OpenGL
@@ -0,0 +1,93 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <unordered_map>
+#include <boost/icl/interval_set.hpp>
+#include <glad/glad.h>
+#include "common/common_types.h"
+#include "core/memory.h"
+#include "video_core/renderer_opengl/gl_resource_manager.h"
+
+namespace OpenGL {
+
+class RasterizerCacheOpenGL;
+
+/**
+ * Keeps the vertex and index arrays of accelerated draws in GL buffers across draws, so that static
+ * geometry is only uploaded again once the emulated system wrote to it. The pages of the cached
+ * arrays are marked as cached in the rasterizer cache, which routes writes to them through
+ * InvalidateRegion.
+ */
+class VertexBufferCache : NonCopyable {
+public:
+    struct IndexArray {
+        /// Buffer holding the indices, 0 if they have to be streamed
+        GLuint buffer;
+        /// Range of the vertices referenced by the indices
+        u32 vertex_min;
+        u32 vertex_max;
+    };
+
+    explicit VertexBufferCache(RasterizerCacheOpenGL& res_cache);
+    ~VertexBufferCache();
+
+    /**
+     * Returns the buffer holding the vertex array in the given range, uploading it if it isn't
+     * cached yet. Returns 0 for arrays that are rewritten too often to be cached, or for all arrays
+     * when the cache is disabled in the settings, which have to be streamed instead.
+     */
+    GLuint GetVertexArray(PAddr addr, u32 size);
+
+    /// Like GetVertexArray, but also returns the range of the vertices the indices refer to
+    IndexArray GetIndexArray(PAddr addr, u32 count, bool index_u16);
+
+    /**
+     * Starts a new draw. The arrays used since the last call are protected from eviction, as the
+     * draw may still bind them.
+     */
+    void BeginDraw() {
+        ++draw_counter;
+    }
+
+    /// Drops the cached arrays overlapping the region
+    void InvalidateRegion(PAddr addr, u32 size);
+
+private:
+    struct Entry {
+        OGLBuffer buffer;
+        PAddr addr;
+        u32 size;
+        /// Vertex range of index arrays
+        u32 vertex_min = 0;
+        u32 vertex_max = 0;
+        /// Whether the buffer holds the current contents of the range
+        bool valid = false;
+        /// Number of times the range was written to after it was cached
+        u32 invalidations = 0;
+        /// Value of draw_counter when the entry was last used
+        u64 last_use = 0;
+    };
+
+    using EntryMap = std::unordered_map<u64, Entry>;
+
+    /// Looks up or creates the entry of a range, returning null if the range has to be streamed
+    Entry* GetEntry(EntryMap& entries, u64 key, PAddr addr, u32 size);
+    void Upload(Entry& entry);
+    void Release(Entry& entry);
+    /// Evicts the least recently used entries if the cache exceeds its limits
+    void EvictEntries(u32 new_size);
+    void RebuildCachedIntervals();
+
+    RasterizerCacheOpenGL& res_cache;
+    EntryMap vertex_entries;
+    EntryMap index_entries;
+    /// Union of the ranges of all valid entries, to quickly skip unrelated invalidations
+    boost::icl::interval_set<PAddr> cached_intervals;
+    std::size_t cached_size = 0;
+    u64 draw_counter = 0;
+};
+
+} // namespace OpenGL
@@ -10,6 +10,7 @@
 #include <deque>
 #include <memory>
 #include <mutex>
+#include <optional>
 #include <glad/glad.h>
 #include <queue>
 #include "common/assert.h"
@@ -32,6 +33,7 @@
 #include "video_core/renderer_opengl/gl_vars.h"
 #include "video_core/renderer_opengl/post_processing_opengl.h"
 #include "video_core/renderer_opengl/renderer_opengl.h"
+#include "video_core/scanout.h"
 #include "video_core/video_core.h"
 
 namespace Frontend {
@@ -45,15 +47,20 @@ struct Frame {
     OpenGL::OGLFramebuffer present{}; /// FBO created on the present thread
     GLsync render_fence{};            /// Fence created on the render thread
     GLsync present_fence{};           /// Fence created on the presentation thread
+
+    /// When the render thread finished the frame, to measure the presentation latency
+    Core::PerfStats::Clock::time_point render_time{};
+    /// Whether the frame was presented since it was rendered
+    bool presented = false;
 };
 } // namespace Frontend
 
 namespace OpenGL {
 
-// If the size of this is too small, it ends up creating a soft cap on FPS as the renderer will have
-// to wait on available presentation frames. There doesn't seem to be much of a downside to a larger
-// number but 9 swap textures at 60FPS presentation allows for 800% speed so thats probably fine
-constexpr std::size_t SWAP_CHAIN_SIZE = 9;
+// One frame is held by the presentation thread, one is the newest rendered frame waiting to be
+// presented and one is being rendered. When no frame is free, the renderer replaces the waiting
+// frame instead of waiting for the presentation thread, so it never waits on vsync.
+constexpr std::size_t SWAP_CHAIN_SIZE = 3;
 
 class OGLTextureMailbox : public Frontend::TextureMailbox {
 public:
@@ -130,6 +137,8 @@ public:
         if (free_queue.empty()) {
             auto frame = present_queue.back();
             present_queue.pop_back();
+            lock.unlock();
+            Core::System::GetInstance().perf_stats->AddDroppedFrame();
             return frame;
         }
 
@@ -140,6 +149,8 @@ public:
 
     void ReleaseRenderFrame(Frontend::Frame* frame) override {
         std::unique_lock<std::mutex> lock(swap_chain_lock);
+        frame->render_time = Core::PerfStats::Clock::now();
+        frame->presented = false;
         present_queue.push_front(frame);
         present_cv.notify_one();
     }
@@ -163,11 +174,17 @@ public:
         Frontend::Frame* frame = present_queue.front();
         present_queue.pop_front();
         // remove all old entries from the present queue and move them back to the free_queue
+        const std::size_t dropped_frames = present_queue.size();
         for (auto f : present_queue) {
             free_queue.push(f);
         }
         present_queue.clear();
         previous_frame = frame;
+        lock.unlock();
+
+        for (std::size_t i = 0; i < dropped_frames; ++i) {
+            Core::System::GetInstance().perf_stats->AddDroppedFrame();
+        }
         return frame;
     }
 };
@@ -276,13 +293,21 @@ RendererOpenGL::RendererOpenGL(Frontend::EmuWindow& window) : RendererBase{windo
     window.mailbox = std::make_unique<OGLTextureMailbox>();
 }
 
-RendererOpenGL::~RendererOpenGL() = default;
+RendererOpenGL::~RendererOpenGL() {
+    for (const auto& [present_fence, render_fence] : retired_fences) {
+        glDeleteSync(render_fence);
+        glDeleteSync(present_fence);
+    }
+}
 
 MICROPROFILE_DEFINE(OpenGL_RenderFrame, "OpenGL", "Render Frame", MP_RGB(128, 128, 64));
 MICROPROFILE_DEFINE(OpenGL_WaitPresent, "OpenGL", "Wait For Present", MP_RGB(128, 128, 128));
 
 /// Swap buffers (render frame)
 void RendererOpenGL::SwapBuffers() {
+    std::optional<Core::FrameSectionScope> present_section{
+        std::in_place, Core::System::GetInstance().perf_stats.get(), Core::FrameSection::Gpu};
+
     // Maintain the rasterizer's state as a priority
     OpenGLState prev_state = OpenGLState::GetCurState();
     state.Apply();
@@ -304,22 +329,28 @@ void RendererOpenGL::SwapBuffers() {
         // Clean up sync objects before drawing
 
         // INTEL driver workaround. We can't delete the previous render sync object until we are
-        // sure that the presentation is done
+        // sure that the presentation is done. Rather than blocking until then, the sync objects
+        // are retired and deleted by a later frame that finds the presentation done.
         if (frame->present_fence) {
-            glClientWaitSync(frame->present_fence, 0, GL_TIMEOUT_IGNORED);
-        }
-
-        // delete the draw fence if the frame wasn't presented
-        if (frame->render_fence) {
+            // wait for the presentation to be done on the host GPU, without blocking this thread
+            glWaitSync(frame->present_fence, 0, GL_TIMEOUT_IGNORED);
+            retired_fences.emplace_back(frame->present_fence, frame->render_fence);
+            frame->present_fence = 0;
+        } else if (frame->render_fence) {
+            // delete the draw fence if the frame wasn't presented
             glDeleteSync(frame->render_fence);
-            frame->render_fence = 0;
         }
+        frame->render_fence = 0;
 
-        // wait for the presentation to be done
-        if (frame->present_fence) {
-            glWaitSync(frame->present_fence, 0, GL_TIMEOUT_IGNORED);
-            glDeleteSync(frame->present_fence);
-            frame->present_fence = 0;
+        // Presentations finish in order, so stop at the first one that is still pending
+        while (!retired_fences.empty()) {
+            const auto [present_fence, render_fence] = retired_fences.front();
+            if (glClientWaitSync(present_fence, 0, 0) == GL_TIMEOUT_EXPIRED) {
+                break;
+            }
+            glDeleteSync(render_fence);
+            glDeleteSync(present_fence);
+            retired_fences.pop_front();
         }
     }
 
@@ -342,12 +373,17 @@ void RendererOpenGL::SwapBuffers() {
         m_current_frame++;
     }
 
+    present_section.reset();
     Core::System::GetInstance().perf_stats->EndSystemFrame();
 
     render_window.PollEvents();
 
-    Core::System::GetInstance().frame_limiter.DoFrameLimiting(
-        Core::System::GetInstance().CoreTiming().GetGlobalTimeUs());
+    {
+        Core::FrameSectionScope limiter_section{
+            Core::System::GetInstance().perf_stats.get(), Core::FrameSection::FrameLimiter};
+        Core::System::GetInstance().frame_limiter.DoFrameLimiting(
+            Core::System::GetInstance().CoreTiming().GetGlobalTimeUs());
+    }
     Core::System::GetInstance().perf_stats->BeginSystemFrame();
 
     prev_state.Apply();
@@ -449,8 +485,8 @@ void RendererOpenGL::RenderVideoDumping() {
         glBindBuffer(GL_PIXEL_PACK_BUFFER, frame_dumping_pbos[next_pbo].handle);
 
         GLubyte* pixels = static_cast<GLubyte*>(glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY));
-        VideoDumper::VideoFrame frame_data{layout.width, layout.height, pixels};
-        Core::System::GetInstance().VideoDumper().AddVideoFrame(frame_data);
+        Core::System::GetInstance().VideoDumper().AddVideoFrame(pixels, layout.width,
+                                                                layout.height);
 
         glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
         glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
@@ -480,13 +516,9 @@ void RendererOpenGL::LoadFBToScreenInfo(const GPU::Regs::FramebufferConfig& fram
     int bpp = GPU::Regs::BytesPerPixel(framebuffer.color_format);
     std::size_t pixel_stride = framebuffer.stride / bpp;
 
-    // OpenGL only supports specifying a stride in units of pixels, not bytes, unfortunately
+    // The rasterizer cache takes the stride in units of pixels, not bytes
     ASSERT(pixel_stride * bpp == framebuffer.stride);
 
-    // Ensure no bad interactions with GL_UNPACK_ALIGNMENT, which by default
-    // only allows rows to have a memory alignement of 4.
-    ASSERT(pixel_stride % 4 == 0);
-
     if (!Rasterizer()->AccelerateDisplay(framebuffer, framebuffer_addr,
                                          static_cast<u32>(pixel_stride), screen_info)) {
         // Reset the screen info's display texture to its own permanent texture
@@ -496,12 +528,29 @@ void RendererOpenGL::LoadFBToScreenInfo(const GPU::Regs::FramebufferConfig& fram
         Memory::RasterizerFlushRegion(framebuffer_addr, framebuffer.stride * framebuffer.height);
 
         const u8* framebuffer_data = VideoCore::g_memory->GetPhysicalPointer(framebuffer_addr);
+        if (framebuffer_data == nullptr) {
+            LOG_ERROR(Render_OpenGL, "Framebuffer at 0x{:08x} is not in physical memory",
+                      framebuffer_addr);
+            return;
+        }
+
+        // Convert the framebuffer to RGBA8 straight into a PBO, orphaning its previous contents
+        const GLsizeiptr upload_size = framebuffer.width * framebuffer.height * 4;
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, scanout_pbos[next_scanout_pbo].handle);
+        next_scanout_pbo = (next_scanout_pbo + 1) % scanout_pbos.size();
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, upload_size, nullptr, GL_STREAM_DRAW);
+        u8* pixels = static_cast<u8*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, upload_size,
+                                                       GL_MAP_WRITE_BIT |
+                                                           GL_MAP_INVALIDATE_BUFFER_BIT));
+        VideoCore::ConvertScanoutToRGBA8(framebuffer.color_format, framebuffer_data,
+                                         framebuffer.stride, pixels, framebuffer.width,
+                                         framebuffer.height);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
 
         state.texture_units[0].texture_2d = screen_info.texture.resource.handle;
         state.Apply();
 
         glActiveTexture(GL_TEXTURE0);
-        glPixelStorei(GL_UNPACK_ROW_LENGTH, (GLint)pixel_stride);
 
         // Update existing texture
         // TODO: Test what happens on hardware when you change the framebuffer dimensions so that
@@ -509,10 +558,9 @@ void RendererOpenGL::LoadFBToScreenInfo(const GPU::Regs::FramebufferConfig& fram
         // TODO: Applications could theoretically crash Citra here by specifying too large
         //       framebuffer sizes. We should make sure that this cannot happen.
         glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, framebuffer.width, framebuffer.height,
-                        screen_info.texture.gl_format, screen_info.texture.gl_type,
-                        framebuffer_data);
+                        screen_info.texture.gl_format, screen_info.texture.gl_type, nullptr);
 
-        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
 
         state.texture_units[0].texture_2d = 0;
         state.Apply();
@@ -590,6 +638,10 @@ void RendererOpenGL::InitOpenGLObjects() {
         screen_info.display_texture = screen_info.texture.resource.handle;
     }
 
+    for (auto& pbo : scanout_pbos) {
+        pbo.Create();
+    }
+
     state.texture_units[0].texture_2d = 0;
     state.Apply();
 }
@@ -660,46 +712,11 @@ void RendererOpenGL::ConfigureFramebufferTexture(TextureInfo& texture,
     texture.width = framebuffer.width;
     texture.height = framebuffer.height;
 
-    switch (format) {
-    case GPU::Regs::PixelFormat::RGBA8:
-        internal_format = GL_RGBA;
-        texture.gl_format = GL_RGBA;
-        texture.gl_type = GLES ? GL_UNSIGNED_BYTE : GL_UNSIGNED_INT_8_8_8_8;
-        break;
-
-    case GPU::Regs::PixelFormat::RGB8:
-        // This pixel format uses BGR since GL_UNSIGNED_BYTE specifies byte-order, unlike every
-        // specific OpenGL type used in this function using native-endian (that is, little-endian
-        // mostly everywhere) for words or half-words.
-        // TODO: check how those behave on big-endian processors.
-        internal_format = GL_RGB;
-
-        // GLES Dosen't support BGR , Use RGB instead
-        texture.gl_format = GLES ? GL_RGB : GL_BGR;
-        texture.gl_type = GL_UNSIGNED_BYTE;
-        break;
-
-    case GPU::Regs::PixelFormat::RGB565:
-        internal_format = GL_RGB;
-        texture.gl_format = GL_RGB;
-        texture.gl_type = GL_UNSIGNED_SHORT_5_6_5;
-        break;
-
-    case GPU::Regs::PixelFormat::RGB5A1:
-        internal_format = GL_RGBA;
-        texture.gl_format = GL_RGBA;
-        texture.gl_type = GL_UNSIGNED_SHORT_5_5_5_1;
-        break;
-
-    case GPU::Regs::PixelFormat::RGBA4:
-        internal_format = GL_RGBA;
-        texture.gl_format = GL_RGBA;
-        texture.gl_type = GL_UNSIGNED_SHORT_4_4_4_4;
-        break;
-
-    default:
-        UNIMPLEMENTED();
-    }
+    // Every format is converted to RGBA8 on scanout, the format is only kept to reconfigure the
+    // texture when it changes
+    internal_format = GL_RGBA8;
+    texture.gl_format = GL_RGBA;
+    texture.gl_type = GL_UNSIGNED_BYTE;
 
     state.texture_units[0].texture_2d = texture.resource.handle;
     state.Apply();
@@ -899,10 +916,20 @@ void RendererOpenGL::TryPresent(int timeout_ms) {
     glBlitFramebuffer(0, 0, frame->width, frame->height, 0, 0, layout.width, layout.height,
                       GL_COLOR_BUFFER_BIT, GL_LINEAR);
 
-    /* insert fence for the main thread to block on */
+    /* insert fence for the render thread to wait on */
+    if (frame->present_fence) {
+        // The frame was presented before, nothing waits on the old fence anymore
+        glDeleteSync(frame->present_fence);
+    }
     frame->present_fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
     glFlush();
 
+    if (!frame->presented) {
+        frame->presented = true;
+        Core::System::GetInstance().perf_stats->AddPresentedFrame(Core::PerfStats::Clock::now() -
+                                                                  frame->render_time);
+    }
+
     glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
 }
 
@@ -5,6 +5,8 @@
 #pragma once
 
 #include <array>
+#include <deque>
+#include <utility>
 #include <glad/glad.h>
 #include "common/common_types.h"
 #include "common/math_util.h"
@@ -103,6 +105,11 @@ private:
     /// Display information for top and bottom screens respectively
     std::array<ScreenInfo, 3> screen_infos;
 
+    /// PBOs the framebuffers are converted into when they are not in the rasterizer cache, used in
+    /// turn so that filling one doesn't wait for the upload from the other
+    std::array<OGLBuffer, 2> scanout_pbos;
+    std::size_t next_scanout_pbo = 0;
+
     // Shader uniform location indices
     GLuint uniform_modelview_matrix;
     GLuint uniform_color_texture;
@@ -130,6 +137,10 @@ private:
     std::array<OGLBuffer, 2> frame_dumping_pbos;
     GLuint current_pbo = 1;
     GLuint next_pbo = 0;
+
+    /// Render and present fences of the frames whose presentation may still be running on the
+    /// host GPU, deleted once it is done
+    std::deque<std::pair<GLsync, GLsync>> retired_fences;
 };
 
 } // namespace OpenGL
@@ -0,0 +1,172 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstddef>
+#include "common/assert.h"
+#include "common/color.h"
+#include "common/logging/log.h"
+#include "common/microprofile.h"
+#include "common/vector_math.h"
+#include "video_core/scanout.h"
+
+#ifdef ARCHITECTURE_x86_64
+#include <emmintrin.h>
+#endif // ARCHITECTURE_x86_64
+
+MICROPROFILE_DEFINE(GPU_Scanout, "GPU", "Framebuffer Scanout", MP_RGB(100, 100, 200));
+
+namespace VideoCore {
+
+using PixelFormat = GPU::Regs::PixelFormat;
+
+template <PixelFormat format>
+constexpr u32 ScanoutBytesPerPixel =
+    format == PixelFormat::RGBA8 ? 4 : (format == PixelFormat::RGB8 ? 3 : 2);
+
+template <PixelFormat format>
+static Common::Vec4<u8> DecodeScanoutPixel(const u8* source) {
+    if constexpr (format == PixelFormat::RGBA8) {
+        return Color::DecodeRGBA8(source);
+    } else if constexpr (format == PixelFormat::RGB8) {
+        return Color::DecodeRGB8(source);
+    } else if constexpr (format == PixelFormat::RGB565) {
+        return Color::DecodeRGB565(source);
+    } else if constexpr (format == PixelFormat::RGB5A1) {
+        return Color::DecodeRGB5A1(source);
+    } else {
+        return Color::DecodeRGBA4(source);
+    }
+}
+
+#ifdef ARCHITECTURE_x86_64
+/// Expands 4, 5 and 6-bit components in 16-bit lanes to 8 bits, like Color::Convert*To8
+static __m128i Expand4To8(__m128i value) {
+    return _mm_or_si128(_mm_slli_epi16(value, 4), value);
+}
+
+static __m128i Expand5To8(__m128i value) {
+    return _mm_or_si128(_mm_slli_epi16(value, 3), _mm_srli_epi16(value, 2));
+}
+
+static __m128i Expand6To8(__m128i value) {
+    return _mm_or_si128(_mm_slli_epi16(value, 2), _mm_srli_epi16(value, 4));
+}
+
+/// Stores 8 RGBA8 pixels, given their 8-bit components in 16-bit lanes
+static void StorePixels(u8* dest, __m128i r, __m128i g, __m128i b, __m128i a) {
+    const __m128i rg = _mm_or_si128(r, _mm_slli_epi16(g, 8));
+    const __m128i ba = _mm_or_si128(b, _mm_slli_epi16(a, 8));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest), _mm_unpacklo_epi16(rg, ba));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + 16), _mm_unpackhi_epi16(rg, ba));
+}
+
+/// Converts the pixels at the start of a row that fill whole vectors, returns how many it converted
+template <PixelFormat format>
+static u32 ConvertRowSSE2(const u8* source, u8* dest, u32 width) {
+    u32 x = 0;
+    if constexpr (format == PixelFormat::RGBA8) {
+        for (; x + 4 <= width; x += 4) {
+            __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + x * 4));
+            // Reverse the bytes of each pixel, first within its halves and then the halves
+            pixels = _mm_or_si128(_mm_slli_epi16(pixels, 8), _mm_srli_epi16(pixels, 8));
+            pixels = _mm_shufflelo_epi16(pixels, _MM_SHUFFLE(2, 3, 0, 1));
+            pixels = _mm_shufflehi_epi16(pixels, _MM_SHUFFLE(2, 3, 0, 1));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + x * 4), pixels);
+        }
+    } else if constexpr (format == PixelFormat::RGB8) {
+        // Four pixels take twelve bytes, but sixteen are loaded, so stop before the last two
+        const __m128i byte_mask = _mm_set1_epi32(0xFF);
+        const __m128i opaque = _mm_set1_epi32(0xFF000000);
+        for (; x + 6 <= width; x += 4) {
+            const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + x * 3));
+            // Move each pixel to the start of its own 32-bit lane, as B G R and a stray byte
+            const __m128i pixels = _mm_unpacklo_epi64(
+                _mm_unpacklo_epi32(bytes, _mm_srli_si128(bytes, 3)),
+                _mm_unpacklo_epi32(_mm_srli_si128(bytes, 6), _mm_srli_si128(bytes, 9)));
+            const __m128i r = _mm_and_si128(_mm_srli_epi32(pixels, 16), byte_mask);
+            const __m128i g = _mm_and_si128(pixels, _mm_slli_epi32(byte_mask, 8));
+            const __m128i b = _mm_slli_epi32(_mm_and_si128(pixels, byte_mask), 16);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + x * 4),
+                             _mm_or_si128(_mm_or_si128(r, g), _mm_or_si128(b, opaque)));
+        }
+    } else {
+        for (; x + 8 <= width; x += 8) {
+            const __m128i pixels =
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + x * 2));
+            if constexpr (format == PixelFormat::RGB565) {
+                const __m128i mask5 = _mm_set1_epi16(0x1F);
+                const __m128i mask6 = _mm_set1_epi16(0x3F);
+                StorePixels(dest + x * 4, Expand5To8(_mm_srli_epi16(pixels, 11)),
+                            Expand6To8(_mm_and_si128(_mm_srli_epi16(pixels, 5), mask6)),
+                            Expand5To8(_mm_and_si128(pixels, mask5)), _mm_set1_epi16(0xFF));
+            } else if constexpr (format == PixelFormat::RGB5A1) {
+                const __m128i mask5 = _mm_set1_epi16(0x1F);
+                // Spread the alpha bit over the lane and keep the low byte
+                const __m128i alpha =
+                    _mm_srli_epi16(_mm_srai_epi16(_mm_slli_epi16(pixels, 15), 15), 8);
+                StorePixels(dest + x * 4, Expand5To8(_mm_srli_epi16(pixels, 11)),
+                            Expand5To8(_mm_and_si128(_mm_srli_epi16(pixels, 6), mask5)),
+                            Expand5To8(_mm_and_si128(_mm_srli_epi16(pixels, 1), mask5)), alpha);
+            } else {
+                const __m128i mask4 = _mm_set1_epi16(0xF);
+                StorePixels(dest + x * 4, Expand4To8(_mm_srli_epi16(pixels, 12)),
+                            Expand4To8(_mm_and_si128(_mm_srli_epi16(pixels, 8), mask4)),
+                            Expand4To8(_mm_and_si128(_mm_srli_epi16(pixels, 4), mask4)),
+                            Expand4To8(_mm_and_si128(pixels, mask4)));
+            }
+        }
+    }
+    return x;
+}
+#endif // ARCHITECTURE_x86_64
+
+template <PixelFormat format>
+static void ConvertScanout(const u8* source, u32 source_stride, u8* dest, u32 width, u32 height) {
+    constexpr u32 bytes_per_pixel = ScanoutBytesPerPixel<format>;
+    for (u32 y = 0; y < height; ++y) {
+        const u8* source_row = source + static_cast<std::size_t>(y) * source_stride;
+        u8* dest_row = dest + static_cast<std::size_t>(y) * width * 4;
+
+        u32 x = 0;
+#ifdef ARCHITECTURE_x86_64
+        x = ConvertRowSSE2<format>(source_row, dest_row, width);
+#endif // ARCHITECTURE_x86_64
+        for (; x < width; ++x) {
+            const Common::Vec4<u8> color =
+                DecodeScanoutPixel<format>(source_row + x * bytes_per_pixel);
+            u8* pixel = dest_row + x * 4;
+            pixel[0] = color.r();
+            pixel[1] = color.g();
+            pixel[2] = color.b();
+            pixel[3] = color.a();
+        }
+    }
+}
+
+void ConvertScanoutToRGBA8(PixelFormat format, const u8* source, u32 source_stride, u8* dest,
+                           u32 width, u32 height) {
+    MICROPROFILE_SCOPE(GPU_Scanout);
+
+    switch (format) {
+    case PixelFormat::RGBA8:
+        ConvertScanout<PixelFormat::RGBA8>(source, source_stride, dest, width, height);
+        break;
+    case PixelFormat::RGB8:
+        ConvertScanout<PixelFormat::RGB8>(source, source_stride, dest, width, height);
+        break;
+    case PixelFormat::RGB565:
+        ConvertScanout<PixelFormat::RGB565>(source, source_stride, dest, width, height);
+        break;
+    case PixelFormat::RGB5A1:
+        ConvertScanout<PixelFormat::RGB5A1>(source, source_stride, dest, width, height);
+        break;
+    case PixelFormat::RGBA4:
+        ConvertScanout<PixelFormat::RGBA4>(source, source_stride, dest, width, height);
+        break;
+    default:
+        UNREACHABLE_MSG("Unknown framebuffer format {:x}", static_cast<u32>(format));
+    }
+}
+
+} // namespace VideoCore
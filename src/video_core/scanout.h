@@ -0,0 +1,26 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include "common/common_types.h"
+#include "core/hw/gpu.h"
+
+namespace VideoCore {
+
+/**
+ * Converts an LCD framebuffer to RGBA8 with the components in byte order, which is the layout of
+ * GL_RGBA with GL_UNSIGNED_BYTE. The conversion matches Color::Decode* for every pixel format.
+ * LCD framebuffers are always linear, so the rows are converted in order.
+ * @param format Pixel format of the framebuffer
+ * @param source Pointer to the first row of the framebuffer
+ * @param source_stride Distance between the starts of two rows of the framebuffer, in bytes
+ * @param dest Pointer to the converted image, with rows of width * 4 bytes and no padding
+ * @param width Width of the framebuffer, in pixels
+ * @param height Height of the framebuffer, in pixels
+ */
+void ConvertScanoutToRGBA8(GPU::Regs::PixelFormat format, const u8* source, u32 source_stride,
+                           u8* dest, u32 width, u32 height);
+
+} // namespace VideoCore
@@ -5,10 +5,12 @@
 #include <algorithm>
 #include <array>
 #include <cstddef>
+#include <vector>
 #include <boost/container/static_vector.hpp>
 #include "common/bit_field.h"
 #include "common/common_types.h"
 #include "common/logging/log.h"
+#include "common/microprofile.h"
 #include "common/vector_math.h"
 #include "video_core/pica_state.h"
 #include "video_core/pica_types.h"
@@ -16,8 +18,14 @@
 #include "video_core/swrasterizer/clipper.h"
 #include "video_core/swrasterizer/rasterizer.h"
 
+#ifdef ARCHITECTURE_x86_64
+#include <xmmintrin.h>
+#endif // ARCHITECTURE_x86_64
+
 using Pica::Rasterizer::Vertex;
 
+MICROPROFILE_DEFINE(GPU_Clipping, "GPU", "Clipping", MP_RGB(50, 50, 240));
+
 namespace Pica::Clipper {
 
 struct ClippingEdge {
@@ -29,14 +37,22 @@ public:
                                                                     float24::FromFloat32(0)))
         : coeffs(coeffs), bias(bias) {}
 
-    bool IsInside(const Vertex& vertex) const {
+    bool IsInside(const OutputVertex& vertex) const {
         return Common::Dot(vertex.pos + bias, coeffs) >= float24::FromFloat32(0);
     }
 
-    bool IsOutSide(const Vertex& vertex) const {
+    bool IsOutSide(const OutputVertex& vertex) const {
         return !IsInside(vertex);
     }
 
+    const Common::Vec4<float24>& GetCoeffs() const {
+        return coeffs;
+    }
+
+    const Common::Vec4<float24>& GetBias() const {
+        return bias;
+    }
+
     Vertex GetIntersection(const Vertex& v0, const Vertex& v1) const {
         float24 dp = Common::Dot(v0.pos + bias, coeffs);
         float24 dp_prev = Common::Dot(v1.pos + bias, coeffs);
@@ -84,37 +100,17 @@ static void InitScreenCoordinates(Vertex& vtx) {
     vtx.screenpos[2] = vtx.pos.z * inv_w;
 }
 
-void ProcessTriangle(const OutputVertex& v0, const OutputVertex& v1, const OutputVertex& v2) {
-    using boost::container::static_vector;
-
-    // Clipping a planar n-gon against a plane will remove at least 1 vertex and introduces 2 at
-    // the new edge (or less in degenerate cases). As such, we can say that each clipping plane
-    // introduces at most 1 new vertex to the polygon. Since we start with a triangle and have a
-    // fixed 6 clipping planes, the maximum number of vertices of the clipped polygon is 3 + 6 = 9.
-    static const std::size_t MAX_VERTICES = 9;
-    static_vector<Vertex, MAX_VERTICES> buffer_a = {v0, v1, v2};
-    static_vector<Vertex, MAX_VERTICES> buffer_b;
-
-    auto FlipQuaternionIfOpposite = [](auto& a, const auto& b) {
-        if (Common::Dot(a, b) < float24::Zero())
-            a = a * float24::FromFloat32(-1.0f);
-    };
-
-    // Flip the quaternions if they are opposite to prevent interpolating them over the wrong
-    // direction.
-    FlipQuaternionIfOpposite(buffer_a[1].quat, buffer_a[0].quat);
-    FlipQuaternionIfOpposite(buffer_a[2].quat, buffer_a[0].quat);
-
-    auto* output_list = &buffer_a;
-    auto* input_list = &buffer_b;
+/// Clipping planes of a batch, the outcode of a vertex has the bit of each plane it is outside of
+using ClippingEdges = boost::container::static_vector<ClippingEdge, 8>;
 
+static ClippingEdges GetClippingEdges() {
     // NOTE: We clip against a w=epsilon plane to guarantee that the output has a positive w value.
     // TODO: Not sure if this is a valid approach. Also should probably instead use the smallest
     //       epsilon possible within float24 accuracy.
     static const float24 EPSILON = float24::FromFloat32(0.00001f);
     static const float24 f0 = float24::FromFloat32(0.0);
     static const float24 f1 = float24::FromFloat32(1.0);
-    static const std::array<ClippingEdge, 7> clipping_edges = {{
+    ClippingEdges edges = {
         {Common::MakeVec(-f1, f0, f0, f1)}, // x = +w
         {Common::MakeVec(f1, f0, f0, f1)},  // x = -w
         {Common::MakeVec(f0, -f1, f0, f1)}, // y = +w
@@ -123,54 +119,150 @@ void ProcessTriangle(const OutputVertex& v0, const OutputVertex& v1, const Outpu
         {Common::MakeVec(f0, f0, f1, f1)},  // z = -w
         {Common::MakeVec(f0, f0, f0, f1),
          Common::Vec4<float24>(f0, f0, f0, EPSILON)}, // w = EPSILON
-    }};
+    };
+
+    if (g_state.regs.rasterizer.clip_enable) {
+        edges.emplace_back(g_state.regs.rasterizer.GetClipCoef());
+    }
+    return edges;
+}
+
+#ifdef ARCHITECTURE_x86_64
+/// Multiplies like float24::operator*, which turns the NaN of 0 * inf into 0
+static __m128 MultiplyFloat24(__m128 a, __m128 b) {
+    const __m128 result = _mm_mul_ps(a, b);
+    const __m128 nan_result = _mm_cmpunord_ps(result, result);
+    const __m128 nan_input = _mm_cmpunord_ps(a, b);
+    return _mm_andnot_ps(_mm_andnot_ps(nan_input, nan_result), result);
+}
+
+/**
+ * Computes the outcodes of four vertices at once. The plane distances are computed with the same
+ * operations in the same order as ClippingEdge::IsInside, so the results are identical.
+ */
+static void ComputeOutcodes4(const OutputVertex* vertices, const ClippingEdges& edges,
+                             u8* outcodes) {
+    static_assert(sizeof(Common::Vec4<float24>) == 4 * sizeof(float));
+    __m128 x = _mm_loadu_ps(reinterpret_cast<const float*>(&vertices[0].pos));
+    __m128 y = _mm_loadu_ps(reinterpret_cast<const float*>(&vertices[1].pos));
+    __m128 z = _mm_loadu_ps(reinterpret_cast<const float*>(&vertices[2].pos));
+    __m128 w = _mm_loadu_ps(reinterpret_cast<const float*>(&vertices[3].pos));
+    _MM_TRANSPOSE4_PS(x, y, z, w);
+
+    std::fill_n(outcodes, 4, 0);
+    for (std::size_t i = 0; i < edges.size(); ++i) {
+        const auto& coeffs = edges[i].GetCoeffs();
+        const auto& bias = edges[i].GetBias();
+        const auto Term = [](__m128 value, float24 bias, float24 coeff) {
+            return MultiplyFloat24(_mm_add_ps(value, _mm_set1_ps(bias.ToFloat32())),
+                                   _mm_set1_ps(coeff.ToFloat32()));
+        };
+        __m128 distance = Term(x, bias.x, coeffs.x);
+        distance = _mm_add_ps(distance, Term(y, bias.y, coeffs.y));
+        distance = _mm_add_ps(distance, Term(z, bias.z, coeffs.z));
+        distance = _mm_add_ps(distance, Term(w, bias.w, coeffs.w));
+
+        // Also true for NaN distances, which IsInside treats as outside as well
+        const int outside = _mm_movemask_ps(_mm_cmpnge_ps(distance, _mm_setzero_ps()));
+        for (std::size_t vertex = 0; vertex < 4; ++vertex) {
+            outcodes[vertex] |= ((outside >> vertex) & 1) << i;
+        }
+    }
+}
+#endif // ARCHITECTURE_x86_64
+
+static void ComputeOutcodes(const OutputVertex* vertices, std::size_t count,
+                            const ClippingEdges& edges, u8* outcodes) {
+    std::size_t vertex = 0;
+#ifdef ARCHITECTURE_x86_64
+    for (; vertex + 4 <= count; vertex += 4) {
+        ComputeOutcodes4(vertices + vertex, edges, outcodes + vertex);
+    }
+#endif // ARCHITECTURE_x86_64
+
+    for (; vertex < count; ++vertex) {
+        outcodes[vertex] = 0;
+        for (std::size_t i = 0; i < edges.size(); ++i) {
+            outcodes[vertex] |= (edges[i].IsOutSide(vertices[vertex]) ? 1 : 0) << i;
+        }
+    }
+}
+
+static void ClipTriangle(const OutputVertex& v0, const OutputVertex& v1, const OutputVertex& v2,
+                         const ClippingEdges& edges, u8 crossed_edges) {
+    using boost::container::static_vector;
+
+    // Clipping a planar n-gon against a plane will remove at least 1 vertex and introduces 2 at
+    // the new edge (or less in degenerate cases). As such, we can say that each clipping plane
+    // introduces at most 1 new vertex to the polygon. Since we start with a triangle and have at
+    // most 8 clipping planes, the maximum number of vertices of the clipped polygon is 3 + 8 = 11.
+    static const std::size_t MAX_VERTICES = 11;
+    // The polygons refer to their vertices by index, so that clipping only moves indices around.
+    // Each plane adds at most 2 intersections to the vertices.
+    static_vector<Vertex, 3 + 2 * 8> vertices = {v0, v1, v2};
+    static_vector<u8, MAX_VERTICES> buffer_a = {0, 1, 2};
+    static_vector<u8, MAX_VERTICES> buffer_b;
+
+    auto FlipQuaternionIfOpposite = [](auto& a, const auto& b) {
+        if (Common::Dot(a, b) < float24::Zero())
+            a = a * float24::FromFloat32(-1.0f);
+    };
+
+    // Flip the quaternions if they are opposite to prevent interpolating them over the wrong
+    // direction.
+    FlipQuaternionIfOpposite(vertices[1].quat, vertices[0].quat);
+    FlipQuaternionIfOpposite(vertices[2].quat, vertices[0].quat);
+
+    auto* output_list = &buffer_a;
+    auto* input_list = &buffer_b;
 
     // Simple implementation of the Sutherland-Hodgman clipping algorithm.
-    // TODO: Make this less inefficient (currently lots of useless buffering overhead happens here)
     auto Clip = [&](const ClippingEdge& edge) {
         std::swap(input_list, output_list);
         output_list->clear();
 
-        const Vertex* reference_vertex = &input_list->back();
+        u8 reference_index = input_list->back();
+        bool reference_inside = edge.IsInside(vertices[reference_index]);
 
-        for (const auto& vertex : *input_list) {
+        for (u8 index : *input_list) {
             // NOTE: This algorithm changes vertex order in some cases!
-            if (edge.IsInside(vertex)) {
-                if (edge.IsOutSide(*reference_vertex)) {
-                    output_list->push_back(edge.GetIntersection(vertex, *reference_vertex));
-                }
-
-                output_list->push_back(vertex);
-            } else if (edge.IsInside(*reference_vertex)) {
-                output_list->push_back(edge.GetIntersection(vertex, *reference_vertex));
+            const bool inside = edge.IsInside(vertices[index]);
+            if (inside != reference_inside) {
+                output_list->push_back(static_cast<u8>(vertices.size()));
+                vertices.push_back(
+                    edge.GetIntersection(vertices[index], vertices[reference_index]));
+            }
+            if (inside) {
+                output_list->push_back(index);
             }
-            reference_vertex = &vertex;
+            reference_index = index;
+            reference_inside = inside;
         }
     };
 
-    for (auto edge : clipping_edges) {
-        Clip(edge);
-
-        // Need to have at least a full triangle to continue...
-        if (output_list->size() < 3)
-            return;
-    }
+    // Planes that the triangle doesn't cross leave it unchanged and can be skipped. The vertices
+    // introduced by clipping can be rounded to just outside of such a plane though, so once there
+    // are any, all remaining planes are clipped against to get the same result as clipping
+    // against every plane.
+    for (std::size_t i = 0; i < edges.size(); ++i) {
+        if ((crossed_edges & (1 << i)) == 0 && vertices.size() == 3) {
+            continue;
+        }
 
-    if (g_state.regs.rasterizer.clip_enable) {
-        ClippingEdge custom_edge{g_state.regs.rasterizer.GetClipCoef()};
-        Clip(custom_edge);
+        Clip(edges[i]);
 
+        // Need to have at least a full triangle to continue...
         if (output_list->size() < 3)
             return;
     }
 
-    InitScreenCoordinates((*output_list)[0]);
-    InitScreenCoordinates((*output_list)[1]);
+    InitScreenCoordinates(vertices[(*output_list)[0]]);
+    InitScreenCoordinates(vertices[(*output_list)[1]]);
 
     for (std::size_t i = 0; i < output_list->size() - 2; i++) {
-        Vertex& vtx0 = (*output_list)[0];
-        Vertex& vtx1 = (*output_list)[i + 1];
-        Vertex& vtx2 = (*output_list)[i + 2];
+        Vertex& vtx0 = vertices[(*output_list)[0]];
+        Vertex& vtx1 = vertices[(*output_list)[i + 1]];
+        Vertex& vtx2 = vertices[(*output_list)[i + 2]];
 
         InitScreenCoordinates(vtx2);
 
@@ -193,4 +285,27 @@ void ProcessTriangle(const OutputVertex& v0, const OutputVertex& v1, const Outpu
     }
 }
 
+void ProcessTriangles(const OutputVertex* vertices, std::size_t count) {
+    MICROPROFILE_SCOPE(GPU_Clipping);
+
+    const ClippingEdges edges = GetClippingEdges();
+
+    // The outcodes of the whole batch are computed up front, which vectorizes the plane tests
+    std::vector<u8> outcodes(count * 3);
+    ComputeOutcodes(vertices, count * 3, edges, outcodes.data());
+
+    for (std::size_t triangle = 0; triangle < count; ++triangle) {
+        const OutputVertex* triangle_vertices = vertices + triangle * 3;
+        const u8* triangle_outcodes = outcodes.data() + triangle * 3;
+
+        // All vertices are outside of the same plane, so the triangle is not visible
+        if ((triangle_outcodes[0] & triangle_outcodes[1] & triangle_outcodes[2]) != 0) {
+            continue;
+        }
+
+        ClipTriangle(triangle_vertices[0], triangle_vertices[1], triangle_vertices[2], edges,
+                     triangle_outcodes[0] | triangle_outcodes[1] | triangle_outcodes[2]);
+    }
+}
+
 } // namespace Pica::Clipper
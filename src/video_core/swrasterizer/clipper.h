@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include <cstddef>
+
 namespace Pica {
 namespace Shader {
 struct OutputVertex;
@@ -13,7 +15,13 @@ namespace Clipper {
 
 using Shader::OutputVertex;
 
-void ProcessTriangle(const OutputVertex& v0, const OutputVertex& v1, const OutputVertex& v2);
+/**
+ * Clips and rasterizes a batch of triangles. Triangles outside of the view volume are rejected
+ * early, the others are only clipped against the planes they cross.
+ * @param vertices Vertices of the triangles, three consecutive vertices per triangle
+ * @param count Number of triangles
+ */
+void ProcessTriangles(const OutputVertex* vertices, std::size_t count);
 
 } // namespace Clipper
 } // namespace Pica
@@ -3,32 +3,52 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <cstring>
+#include "common/logging/log.h"
 #include "video_core/swrasterizer/lighting.h"
 
 namespace Pica {
 
-static float LookupLightingLut(const Pica::State::Lighting& lighting, std::size_t lut_index,
-                               u8 index, float delta) {
-    ASSERT_MSG(lut_index < lighting.luts.size(), "Out of range lut");
-    ASSERT_MSG(index < lighting.luts[lut_index].size(), "Out of range index");
+using BumpMode = LightingRegs::LightingBumpMode;
 
-    const auto& lut = lighting.luts[lut_index][index];
+static float LookupLightingLut(const LightingSetup::Lut& lut, u8 index, float delta) {
+    const auto& entry = lut[index];
+    return entry.value + entry.difference * delta;
+}
+
+static float SampleLut(const LightingSetup::LutSampler& sampler, float input,
+                       bool two_sided_diffuse) {
+    u8 index;
+    float delta;
 
-    float lut_value = lut.ToFloat();
-    float lut_diff = lut.DiffToFloat();
+    if (sampler.abs) {
+        if (two_sided_diffuse)
+            input = std::abs(input);
+        else
+            input = std::max(input, 0.0f);
 
-    return lut_value + lut_diff * delta;
+        float flr = std::floor(input * 256.0f);
+        index = static_cast<u8>(std::clamp(flr, 0.0f, 255.0f));
+        delta = input * 256 - index;
+    } else {
+        float flr = std::floor(input * 128.0f);
+        s8 signed_index = static_cast<s8>(std::clamp(flr, -128.0f, 127.0f));
+        delta = input * 128.0f - signed_index;
+        index = static_cast<u8>(signed_index);
+    }
+
+    return sampler.scale * LookupLightingLut(*sampler.lut, index, delta);
 }
 
-std::tuple<Common::Vec4<u8>, Common::Vec4<u8>> ComputeFragmentsColors(
-    const Pica::LightingRegs& lighting, const Pica::State::Lighting& lighting_state,
-    const Common::Quaternion<float>& normquat, const Common::Vec3<float>& view,
-    const Common::Vec4<u8> (&texture_color)[4]) {
+template <BumpMode bump_mode, bool enable_shadow>
+static std::tuple<Common::Vec4<u8>, Common::Vec4<u8>> ComputeFragmentsColorsImpl(
+    const LightingSetup& setup, const Common::Quaternion<float>& normquat,
+    const Common::Vec3<float>& view, const Common::Vec4<u8> (&texture_color)[4]) {
 
     Common::Vec4<float> shadow;
-    if (lighting.config0.enable_shadow) {
-        shadow = texture_color[lighting.config0.shadow_selector].Cast<float>() / 255.0f;
-        if (lighting.config0.shadow_invert) {
+    if constexpr (enable_shadow) {
+        shadow = texture_color[setup.shadow_selector].Cast<float>() / 255.0f;
+        if (setup.shadow_invert) {
             shadow = Common::MakeVec(1.0f, 1.0f, 1.0f, 1.0f) - shadow;
         }
     } else {
@@ -38,23 +58,20 @@ std::tuple<Common::Vec4<u8>, Common::Vec4<u8>> ComputeFragmentsColors(
     Common::Vec3<float> surface_normal;
     Common::Vec3<float> surface_tangent;
 
-    if (lighting.config0.bump_mode != LightingRegs::LightingBumpMode::None) {
+    if constexpr (bump_mode != BumpMode::None) {
         Common::Vec3<float> perturbation =
-            texture_color[lighting.config0.bump_selector].xyz().Cast<float>() / 127.5f -
+            texture_color[setup.bump_selector].xyz().Cast<float>() / 127.5f -
             Common::MakeVec(1.0f, 1.0f, 1.0f);
-        if (lighting.config0.bump_mode == LightingRegs::LightingBumpMode::NormalMap) {
-            if (!lighting.config0.disable_bump_renorm) {
+        if constexpr (bump_mode == BumpMode::NormalMap) {
+            if (!setup.disable_bump_renorm) {
                 const float z_square = 1 - perturbation.xy().Length2();
                 perturbation.z = std::sqrt(std::max(z_square, 0.0f));
             }
             surface_normal = perturbation;
             surface_tangent = Common::MakeVec(1.0f, 0.0f, 0.0f);
-        } else if (lighting.config0.bump_mode == LightingRegs::LightingBumpMode::TangentMap) {
+        } else {
             surface_normal = Common::MakeVec(0.0f, 0.0f, 1.0f);
             surface_tangent = perturbation;
-        } else {
-            LOG_ERROR(HW_GPU, "Unknown bump mode {}",
-                      static_cast<u32>(lighting.config0.bump_mode.Value()));
         }
     } else {
         surface_normal = Common::MakeVec(0.0f, 0.0f, 1.0f);
@@ -65,57 +82,49 @@ std::tuple<Common::Vec4<u8>, Common::Vec4<u8>> ComputeFragmentsColors(
     auto normal = Common::QuaternionRotate(normquat, surface_normal);
     auto tangent = Common::QuaternionRotate(normquat, surface_tangent);
 
+    const Common::Vec3<float> norm_view = view.Normalized();
+
     Common::Vec4<float> diffuse_sum = {0.0f, 0.0f, 0.0f, 1.0f};
     Common::Vec4<float> specular_sum = {0.0f, 0.0f, 0.0f, 1.0f};
 
-    for (unsigned light_index = 0; light_index <= lighting.max_light_index; ++light_index) {
-        unsigned num = lighting.light_enable.GetNum(light_index);
-        const auto& light_config = lighting.light[num];
+    for (unsigned light_index = 0; light_index < setup.num_lights; ++light_index) {
+        const auto& light = setup.lights[light_index];
 
         Common::Vec3<float> refl_value = {};
-        Common::Vec3<float> position = {float16::FromRaw(light_config.x).ToFloat32(),
-                                        float16::FromRaw(light_config.y).ToFloat32(),
-                                        float16::FromRaw(light_config.z).ToFloat32()};
         Common::Vec3<float> light_vector;
 
-        if (light_config.config.directional)
-            light_vector = position;
+        if (light.directional)
+            light_vector = light.position;
         else
-            light_vector = position + view;
+            light_vector = light.position + view;
 
         light_vector.Normalize();
 
-        Common::Vec3<float> norm_view = view.Normalized();
         Common::Vec3<float> half_vector = norm_view + light_vector;
+        const Common::Vec3<float> norm_half_vector = half_vector.Normalized();
 
         float dist_atten = 1.0f;
-        if (!lighting.IsDistAttenDisabled(num)) {
-            auto distance = (-view - position).Length();
-            float scale = Pica::float20::FromRaw(light_config.dist_atten_scale).ToFloat32();
-            float bias = Pica::float20::FromRaw(light_config.dist_atten_bias).ToFloat32();
-            std::size_t lut =
-                static_cast<std::size_t>(LightingRegs::LightingSampler::DistanceAttenuation) + num;
-
-            float sample_loc = std::clamp(scale * distance + bias, 0.0f, 1.0f);
+        if (light.dist_atten_lut != nullptr) {
+            auto distance = (-view - light.position).Length();
+            float sample_loc =
+                std::clamp(light.dist_atten_scale * distance + light.dist_atten_bias, 0.0f, 1.0f);
 
             u8 lutindex =
                 static_cast<u8>(std::clamp(std::floor(sample_loc * 256.0f), 0.0f, 255.0f));
             float delta = sample_loc * 256 - lutindex;
-            dist_atten = LookupLightingLut(lighting_state, lut, lutindex, delta);
+            dist_atten = LookupLightingLut(*light.dist_atten_lut, lutindex, delta);
         }
 
-        auto GetLutValue = [&](LightingRegs::LightingLutInput input, bool abs,
-                               LightingRegs::LightingScale scale_enum,
-                               LightingRegs::LightingSampler sampler) {
+        auto GetLutValue = [&](const LightingSetup::LutSampler& sampler) {
             float result = 0.0f;
 
-            switch (input) {
+            switch (sampler.input) {
             case LightingRegs::LightingLutInput::NH:
-                result = Common::Dot(normal, half_vector.Normalized());
+                result = Common::Dot(normal, norm_half_vector);
                 break;
 
             case LightingRegs::LightingLutInput::VH:
-                result = Common::Dot(norm_view, half_vector.Normalized());
+                result = Common::Dot(norm_view, norm_half_vector);
                 break;
 
             case LightingRegs::LightingLutInput::NV:
@@ -126,15 +135,12 @@ std::tuple<Common::Vec4<u8>, Common::Vec4<u8>> ComputeFragmentsColors(
                 result = Common::Dot(light_vector, normal);
                 break;
 
-            case LightingRegs::LightingLutInput::SP: {
-                Common::Vec3<s32> spot_dir{light_config.spot_x.Value(), light_config.spot_y.Value(),
-                                           light_config.spot_z.Value()};
-                result = Common::Dot(light_vector, spot_dir.Cast<float>() / 2047.0f);
+            case LightingRegs::LightingLutInput::SP:
+                result = Common::Dot(light_vector, light.spot_direction);
                 break;
-            }
+
             case LightingRegs::LightingLutInput::CP:
-                if (lighting.config0.config == LightingRegs::LightingConfig::Config7) {
-                    const Common::Vec3<float> norm_half_vector = half_vector.Normalized();
+                if (setup.config7) {
                     const Common::Vec3<float> half_vector_proj =
                         norm_half_vector - normal * Common::Dot(normal, norm_half_vector);
                     result = Common::Dot(half_vector_proj, tangent);
@@ -142,157 +148,104 @@ std::tuple<Common::Vec4<u8>, Common::Vec4<u8>> ComputeFragmentsColors(
                     result = 0.0f;
                 }
                 break;
+
             default:
-                LOG_CRITICAL(HW_GPU, "Unknown lighting LUT input {}", static_cast<u32>(input));
-                UNIMPLEMENTED();
+                // Reported by SetupLighting
                 result = 0.0f;
             }
 
-            u8 index;
-            float delta;
-
-            if (abs) {
-                if (light_config.config.two_sided_diffuse)
-                    result = std::abs(result);
-                else
-                    result = std::max(result, 0.0f);
-
-                float flr = std::floor(result * 256.0f);
-                index = static_cast<u8>(std::clamp(flr, 0.0f, 255.0f));
-                delta = result * 256 - index;
-            } else {
-                float flr = std::floor(result * 128.0f);
-                s8 signed_index = static_cast<s8>(std::clamp(flr, -128.0f, 127.0f));
-                delta = result * 128.0f - signed_index;
-                index = static_cast<u8>(signed_index);
-            }
-
-            float scale = lighting.lut_scale.GetScale(scale_enum);
-            return scale * LookupLightingLut(lighting_state, static_cast<std::size_t>(sampler),
-                                             index, delta);
+            return SampleLut(sampler, result, light.two_sided_diffuse);
         };
 
         // If enabled, compute spot light attenuation value
         float spot_atten = 1.0f;
-        if (!lighting.IsSpotAttenDisabled(num) &&
-            LightingRegs::IsLightingSamplerSupported(
-                lighting.config0.config, LightingRegs::LightingSampler::SpotlightAttenuation)) {
-            auto lut = LightingRegs::SpotlightAttenuationSampler(num);
-            spot_atten = GetLutValue(lighting.lut_input.sp, lighting.abs_lut_input.disable_sp == 0,
-                                     lighting.lut_scale.sp, lut);
+        if (light.spot.lut != nullptr) {
+            spot_atten = GetLutValue(light.spot);
         }
 
         // Specular 0 component
         float d0_lut_value = 1.0f;
-        if (lighting.config1.disable_lut_d0 == 0 &&
-            LightingRegs::IsLightingSamplerSupported(
-                lighting.config0.config, LightingRegs::LightingSampler::Distribution0)) {
-            d0_lut_value =
-                GetLutValue(lighting.lut_input.d0, lighting.abs_lut_input.disable_d0 == 0,
-                            lighting.lut_scale.d0, LightingRegs::LightingSampler::Distribution0);
+        if (setup.d0.lut != nullptr) {
+            d0_lut_value = GetLutValue(setup.d0);
         }
 
-        Common::Vec3<float> specular_0 = d0_lut_value * light_config.specular_0.ToVec3f();
+        Common::Vec3<float> specular_0 = d0_lut_value * light.specular_0;
 
         // If enabled, lookup ReflectRed value, otherwise, 1.0 is used
-        if (lighting.config1.disable_lut_rr == 0 &&
-            LightingRegs::IsLightingSamplerSupported(lighting.config0.config,
-                                                     LightingRegs::LightingSampler::ReflectRed)) {
-            refl_value.x =
-                GetLutValue(lighting.lut_input.rr, lighting.abs_lut_input.disable_rr == 0,
-                            lighting.lut_scale.rr, LightingRegs::LightingSampler::ReflectRed);
+        if (setup.rr.lut != nullptr) {
+            refl_value.x = GetLutValue(setup.rr);
         } else {
             refl_value.x = 1.0f;
         }
 
         // If enabled, lookup ReflectGreen value, otherwise, ReflectRed value is used
-        if (lighting.config1.disable_lut_rg == 0 &&
-            LightingRegs::IsLightingSamplerSupported(lighting.config0.config,
-                                                     LightingRegs::LightingSampler::ReflectGreen)) {
-            refl_value.y =
-                GetLutValue(lighting.lut_input.rg, lighting.abs_lut_input.disable_rg == 0,
-                            lighting.lut_scale.rg, LightingRegs::LightingSampler::ReflectGreen);
+        if (setup.rg.lut != nullptr) {
+            refl_value.y = GetLutValue(setup.rg);
         } else {
             refl_value.y = refl_value.x;
         }
 
         // If enabled, lookup ReflectBlue value, otherwise, ReflectRed value is used
-        if (lighting.config1.disable_lut_rb == 0 &&
-            LightingRegs::IsLightingSamplerSupported(lighting.config0.config,
-                                                     LightingRegs::LightingSampler::ReflectBlue)) {
-            refl_value.z =
-                GetLutValue(lighting.lut_input.rb, lighting.abs_lut_input.disable_rb == 0,
-                            lighting.lut_scale.rb, LightingRegs::LightingSampler::ReflectBlue);
+        if (setup.rb.lut != nullptr) {
+            refl_value.z = GetLutValue(setup.rb);
         } else {
             refl_value.z = refl_value.x;
         }
 
         // Specular 1 component
         float d1_lut_value = 1.0f;
-        if (lighting.config1.disable_lut_d1 == 0 &&
-            LightingRegs::IsLightingSamplerSupported(
-                lighting.config0.config, LightingRegs::LightingSampler::Distribution1)) {
-            d1_lut_value =
-                GetLutValue(lighting.lut_input.d1, lighting.abs_lut_input.disable_d1 == 0,
-                            lighting.lut_scale.d1, LightingRegs::LightingSampler::Distribution1);
+        if (setup.d1.lut != nullptr) {
+            d1_lut_value = GetLutValue(setup.d1);
         }
 
-        Common::Vec3<float> specular_1 =
-            d1_lut_value * refl_value * light_config.specular_1.ToVec3f();
+        Common::Vec3<float> specular_1 = d1_lut_value * refl_value * light.specular_1;
 
         // Fresnel
         // Note: only the last entry in the light slots applies the Fresnel factor
-        if (light_index == lighting.max_light_index && lighting.config1.disable_lut_fr == 0 &&
-            LightingRegs::IsLightingSamplerSupported(lighting.config0.config,
-                                                     LightingRegs::LightingSampler::Fresnel)) {
-
-            float lut_value =
-                GetLutValue(lighting.lut_input.fr, lighting.abs_lut_input.disable_fr == 0,
-                            lighting.lut_scale.fr, LightingRegs::LightingSampler::Fresnel);
+        if (light_index == setup.num_lights - 1 && setup.fr.lut != nullptr) {
+            float lut_value = GetLutValue(setup.fr);
 
             // Enabled for diffuse lighting alpha component
-            if (lighting.config0.enable_primary_alpha) {
+            if (setup.enable_primary_alpha) {
                 diffuse_sum.a() = lut_value;
             }
 
             // Enabled for the specular lighting alpha component
-            if (lighting.config0.enable_secondary_alpha) {
+            if (setup.enable_secondary_alpha) {
                 specular_sum.a() = lut_value;
             }
         }
 
         auto dot_product = Common::Dot(light_vector, normal);
-        if (light_config.config.two_sided_diffuse)
+        if (light.two_sided_diffuse)
             dot_product = std::abs(dot_product);
         else
             dot_product = std::max(dot_product, 0.0f);
 
         float clamp_highlights = 1.0f;
-        if (lighting.config0.clamp_highlights) {
+        if (setup.clamp_highlights) {
             clamp_highlights = dot_product == 0.0f ? 0.0f : 1.0f;
         }
 
-        if (light_config.config.geometric_factor_0 || light_config.config.geometric_factor_1) {
+        if (light.geometric_factor_0 || light.geometric_factor_1) {
             float geo_factor = half_vector.Length2();
             geo_factor = geo_factor == 0.0f ? 0.0f : std::min(dot_product / geo_factor, 1.0f);
-            if (light_config.config.geometric_factor_0) {
+            if (light.geometric_factor_0) {
                 specular_0 *= geo_factor;
             }
-            if (light_config.config.geometric_factor_1) {
+            if (light.geometric_factor_1) {
                 specular_1 *= geo_factor;
             }
         }
 
-        auto diffuse =
-            (light_config.diffuse.ToVec3f() * dot_product + light_config.ambient.ToVec3f()) *
-            dist_atten * spot_atten;
+        auto diffuse = (light.diffuse * dot_product + light.ambient) * dist_atten * spot_atten;
         auto specular = (specular_0 + specular_1) * clamp_highlights * dist_atten * spot_atten;
 
-        if (!lighting.IsShadowDisabled(num)) {
-            if (lighting.config0.shadow_primary) {
+        if constexpr (enable_shadow) {
+            if (light.shadow_primary) {
                 diffuse = diffuse * shadow.xyz();
             }
-            if (lighting.config0.shadow_secondary) {
+            if (light.shadow_secondary) {
                 specular = specular * shadow.xyz();
             }
         }
@@ -301,20 +254,20 @@ std::tuple<Common::Vec4<u8>, Common::Vec4<u8>> ComputeFragmentsColors(
         specular_sum += Common::MakeVec(specular, 0.0f);
     }
 
-    if (lighting.config0.shadow_alpha) {
+    if (setup.shadow_alpha) {
         // Alpha shadow also uses the Fresnel selecotr to determine which alpha to apply
         // Enabled for diffuse lighting alpha component
-        if (lighting.config0.enable_primary_alpha) {
+        if (setup.enable_primary_alpha) {
             diffuse_sum.a() *= shadow.w;
         }
 
         // Enabled for the specular lighting alpha component
-        if (lighting.config0.enable_secondary_alpha) {
+        if (setup.enable_secondary_alpha) {
             specular_sum.a() *= shadow.w;
         }
     }
 
-    diffuse_sum += Common::MakeVec(lighting.global_ambient.ToVec3f(), 0.0f);
+    diffuse_sum += Common::MakeVec(setup.global_ambient, 0.0f);
 
     auto diffuse = Common::MakeVec<float>(std::clamp(diffuse_sum.x, 0.0f, 1.0f) * 255,
                                           std::clamp(diffuse_sum.y, 0.0f, 1.0f) * 255,
@@ -329,4 +282,159 @@ std::tuple<Common::Vec4<u8>, Common::Vec4<u8>> ComputeFragmentsColors(
     return std::make_tuple(diffuse, specular);
 }
 
+/// Converts a lookup table to float, unless it hasn't changed since it was last converted
+static const LightingSetup::Lut& GetLut(LightingSetup& setup,
+                                        const Pica::State::Lighting& lighting_state,
+                                        LightingRegs::LightingSampler sampler) {
+    const std::size_t lut_index = static_cast<std::size_t>(sampler);
+    ASSERT_MSG(lut_index < lighting_state.luts.size(), "Out of range lut");
+
+    const auto& source = lighting_state.luts[lut_index];
+    auto& raw = setup.raw_luts[lut_index];
+    auto& lut = setup.luts[lut_index];
+    static_assert(sizeof(source) == sizeof(raw));
+    if (std::memcmp(source.data(), raw.data(), sizeof(raw)) != 0) {
+        for (std::size_t i = 0; i < lut.size(); ++i) {
+            raw[i] = source[i].raw;
+            lut[i] = {source[i].ToFloat(), source[i].DiffToFloat()};
+        }
+    }
+    return lut;
+}
+
+static bool IsKnownLutInput(LightingRegs::LightingLutInput input) {
+    switch (input) {
+    case LightingRegs::LightingLutInput::NH:
+    case LightingRegs::LightingLutInput::VH:
+    case LightingRegs::LightingLutInput::NV:
+    case LightingRegs::LightingLutInput::LN:
+    case LightingRegs::LightingLutInput::SP:
+    case LightingRegs::LightingLutInput::CP:
+        return true;
+    default:
+        return false;
+    }
+}
+
+void SetupLighting(LightingSetup& setup, const Pica::LightingRegs& lighting,
+                   const Pica::State::Lighting& lighting_state) {
+    using Sampler = LightingRegs::LightingSampler;
+    const auto config = lighting.config0.config.Value();
+
+    auto SetupSampler = [&](LightingSetup::LutSampler& sampler, bool enabled,
+                            LightingRegs::LightingSampler lut,
+                            LightingRegs::LightingLutInput input, bool abs,
+                            LightingRegs::LightingScale scale) {
+        // The spotlight tables of all lights are supported like the first one
+        const auto kind =
+            static_cast<u32>(lut) >= static_cast<u32>(Sampler::SpotlightAttenuation)
+                ? Sampler::SpotlightAttenuation
+                : lut;
+        sampler.lut = nullptr;
+        if (!enabled || !LightingRegs::IsLightingSamplerSupported(config, kind)) {
+            return;
+        }
+        if (!IsKnownLutInput(input)) {
+            LOG_CRITICAL(HW_GPU, "Unknown lighting LUT input {}", static_cast<u32>(input));
+            UNIMPLEMENTED();
+        }
+        sampler.lut = &GetLut(setup, lighting_state, lut);
+        sampler.input = input;
+        sampler.abs = abs;
+        sampler.scale = lighting.lut_scale.GetScale(scale);
+    };
+
+    SetupSampler(setup.d0, lighting.config1.disable_lut_d0 == 0, Sampler::Distribution0,
+                 lighting.lut_input.d0, lighting.abs_lut_input.disable_d0 == 0,
+                 lighting.lut_scale.d0);
+    SetupSampler(setup.d1, lighting.config1.disable_lut_d1 == 0, Sampler::Distribution1,
+                 lighting.lut_input.d1, lighting.abs_lut_input.disable_d1 == 0,
+                 lighting.lut_scale.d1);
+    SetupSampler(setup.rr, lighting.config1.disable_lut_rr == 0, Sampler::ReflectRed,
+                 lighting.lut_input.rr, lighting.abs_lut_input.disable_rr == 0,
+                 lighting.lut_scale.rr);
+    SetupSampler(setup.rg, lighting.config1.disable_lut_rg == 0, Sampler::ReflectGreen,
+                 lighting.lut_input.rg, lighting.abs_lut_input.disable_rg == 0,
+                 lighting.lut_scale.rg);
+    SetupSampler(setup.rb, lighting.config1.disable_lut_rb == 0, Sampler::ReflectBlue,
+                 lighting.lut_input.rb, lighting.abs_lut_input.disable_rb == 0,
+                 lighting.lut_scale.rb);
+    SetupSampler(setup.fr, lighting.config1.disable_lut_fr == 0, Sampler::Fresnel,
+                 lighting.lut_input.fr, lighting.abs_lut_input.disable_fr == 0,
+                 lighting.lut_scale.fr);
+
+    const bool enable_shadow = lighting.config0.enable_shadow != 0;
+
+    setup.num_lights = lighting.max_light_index + 1;
+    for (unsigned light_index = 0; light_index < setup.num_lights; ++light_index) {
+        const unsigned num = lighting.light_enable.GetNum(light_index);
+        const auto& light_config = lighting.light[num];
+        auto& light = setup.lights[light_index];
+
+        light.position = {float16::FromRaw(light_config.x).ToFloat32(),
+                          float16::FromRaw(light_config.y).ToFloat32(),
+                          float16::FromRaw(light_config.z).ToFloat32()};
+        Common::Vec3<s32> spot_dir{light_config.spot_x.Value(), light_config.spot_y.Value(),
+                                   light_config.spot_z.Value()};
+        light.spot_direction = spot_dir.Cast<float>() / 2047.0f;
+        light.specular_0 = light_config.specular_0.ToVec3f();
+        light.specular_1 = light_config.specular_1.ToVec3f();
+        light.diffuse = light_config.diffuse.ToVec3f();
+        light.ambient = light_config.ambient.ToVec3f();
+        light.directional = light_config.config.directional != 0;
+        light.two_sided_diffuse = light_config.config.two_sided_diffuse != 0;
+        light.geometric_factor_0 = light_config.config.geometric_factor_0 != 0;
+        light.geometric_factor_1 = light_config.config.geometric_factor_1 != 0;
+
+        const bool shadow = enable_shadow && !lighting.IsShadowDisabled(num);
+        light.shadow_primary = shadow && lighting.config0.shadow_primary;
+        light.shadow_secondary = shadow && lighting.config0.shadow_secondary;
+
+        light.dist_atten_lut = nullptr;
+        if (!lighting.IsDistAttenDisabled(num)) {
+            light.dist_atten_lut =
+                &GetLut(setup, lighting_state, LightingRegs::DistanceAttenuationSampler(num));
+            light.dist_atten_scale =
+                Pica::float20::FromRaw(light_config.dist_atten_scale).ToFloat32();
+            light.dist_atten_bias =
+                Pica::float20::FromRaw(light_config.dist_atten_bias).ToFloat32();
+        }
+
+        SetupSampler(light.spot, !lighting.IsSpotAttenDisabled(num),
+                     LightingRegs::SpotlightAttenuationSampler(num), lighting.lut_input.sp,
+                     lighting.abs_lut_input.disable_sp == 0, lighting.lut_scale.sp);
+    }
+
+    setup.global_ambient = lighting.global_ambient.ToVec3f();
+    setup.shadow_selector = lighting.config0.shadow_selector;
+    setup.bump_selector = lighting.config0.bump_selector;
+    setup.shadow_invert = lighting.config0.shadow_invert != 0;
+    // Without shadows, the alpha is multiplied by 1
+    setup.shadow_alpha = enable_shadow && lighting.config0.shadow_alpha;
+    setup.disable_bump_renorm = lighting.config0.disable_bump_renorm != 0;
+    setup.clamp_highlights = lighting.config0.clamp_highlights != 0;
+    setup.enable_primary_alpha = lighting.config0.enable_primary_alpha != 0;
+    setup.enable_secondary_alpha = lighting.config0.enable_secondary_alpha != 0;
+    setup.config7 = config == LightingRegs::LightingConfig::Config7;
+
+    switch (lighting.config0.bump_mode) {
+    case BumpMode::NormalMap:
+        setup.compute = enable_shadow ? ComputeFragmentsColorsImpl<BumpMode::NormalMap, true>
+                                      : ComputeFragmentsColorsImpl<BumpMode::NormalMap, false>;
+        break;
+    case BumpMode::TangentMap:
+        setup.compute = enable_shadow ? ComputeFragmentsColorsImpl<BumpMode::TangentMap, true>
+                                      : ComputeFragmentsColorsImpl<BumpMode::TangentMap, false>;
+        break;
+    default:
+        LOG_ERROR(HW_GPU, "Unknown bump mode {}",
+                  static_cast<u32>(lighting.config0.bump_mode.Value()));
+        [[fallthrough]];
+    case BumpMode::None:
+        setup.compute = enable_shadow ? ComputeFragmentsColorsImpl<BumpMode::None, true>
+                                      : ComputeFragmentsColorsImpl<BumpMode::None, false>;
+        break;
+    }
+}
+
 } // namespace Pica
@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <array>
 #include <tuple>
 #include "common/quaternion.h"
 #include "common/vector_math.h"
@@ -11,9 +12,89 @@
 
 namespace Pica {
 
-std::tuple<Common::Vec4<u8>, Common::Vec4<u8>> ComputeFragmentsColors(
-    const Pica::LightingRegs& lighting, const Pica::State::Lighting& lighting_state,
-    const Common::Quaternion<float>& normquat, const Common::Vec3<float>& view,
-    const Common::Vec4<u8> (&texture_color)[4]);
+/**
+ * Lighting state of a draw, decoded from the registers once so that the fragments only do the
+ * math. The lights are flattened into a list of the enabled lights, and the lookup tables they use
+ * are converted to float.
+ */
+struct LightingSetup {
+    struct LutEntry {
+        float value;
+        float difference;
+    };
+    using Lut = std::array<LutEntry, 256>;
+
+    struct LutSampler {
+        /// Table to sample, null if the sampler is disabled or unsupported by the configuration
+        const Lut* lut = nullptr;
+        LightingRegs::LightingLutInput input;
+        bool abs;
+        float scale;
+    };
+
+    struct Light {
+        Common::Vec3<float> position;
+        Common::Vec3<float> spot_direction;
+        Common::Vec3<float> specular_0;
+        Common::Vec3<float> specular_1;
+        Common::Vec3<float> diffuse;
+        Common::Vec3<float> ambient;
+        bool directional;
+        bool two_sided_diffuse;
+        bool geometric_factor_0;
+        bool geometric_factor_1;
+        bool shadow_primary;
+        bool shadow_secondary;
+        /// Distance attenuation table, null if it is disabled
+        const Lut* dist_atten_lut;
+        float dist_atten_scale;
+        float dist_atten_bias;
+        LutSampler spot;
+    };
+
+    using ComputeFunction = std::tuple<Common::Vec4<u8>, Common::Vec4<u8>> (*)(
+        const LightingSetup& setup, const Common::Quaternion<float>& normquat,
+        const Common::Vec3<float>& view, const Common::Vec4<u8> (&texture_color)[4]);
+
+    /// Implementation specialized for the bump mapping and shadow configuration
+    ComputeFunction compute;
+
+    std::array<Light, 8> lights;
+    unsigned num_lights;
+
+    LutSampler d0;
+    LutSampler d1;
+    LutSampler rr;
+    LutSampler rg;
+    LutSampler rb;
+    /// Fresnel, which is only applied by the last light
+    LutSampler fr;
+
+    Common::Vec3<float> global_ambient;
+    unsigned shadow_selector;
+    unsigned bump_selector;
+    bool shadow_invert;
+    bool shadow_alpha;
+    bool disable_bump_renorm;
+    bool clamp_highlights;
+    bool enable_primary_alpha;
+    bool enable_secondary_alpha;
+    bool config7;
+
+    /// Tables converted to float, kept across draws together with the raw values they were
+    /// converted from, so that only the tables that changed are converted again
+    std::array<Lut, LightingRegs::NumLightingSampler> luts{};
+    std::array<std::array<u32, 256>, LightingRegs::NumLightingSampler> raw_luts{};
+};
+
+/// Updates the lighting setup for the current draw from the registers and lookup tables
+void SetupLighting(LightingSetup& setup, const Pica::LightingRegs& lighting,
+                   const Pica::State::Lighting& lighting_state);
+
+inline std::tuple<Common::Vec4<u8>, Common::Vec4<u8>> ComputeFragmentsColors(
+    const LightingSetup& setup, const Common::Quaternion<float>& normquat,
+    const Common::Vec3<float>& view, const Common::Vec4<u8> (&texture_color)[4]) {
+    return setup.compute(setup, normquat, view, texture_color);
+}
 
 } // namespace Pica
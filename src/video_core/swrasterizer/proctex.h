@@ -2,13 +2,58 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#pragma once
+
+#include <array>
 #include "common/common_types.h"
 #include "common/vector_math.h"
 #include "video_core/pica_state.h"
 
 namespace Pica::Rasterizer {
 
+/**
+ * Procedural texture state decoded from the registers, with the lookup tables converted to float.
+ * It only has to be set up again when the procedural texture registers or tables change.
+ */
+struct ProcTexSetup {
+    struct LutEntry {
+        float value;
+        float difference;
+    };
+    using Lut = std::array<LutEntry, 128>;
+
+    TexturingRegs::ProcTexShift u_shift;
+    TexturingRegs::ProcTexShift v_shift;
+    TexturingRegs::ProcTexClamp u_clamp;
+    TexturingRegs::ProcTexClamp v_clamp;
+    TexturingRegs::ProcTexCombiner color_combiner;
+    TexturingRegs::ProcTexCombiner alpha_combiner;
+    TexturingRegs::ProcTexFilter filter;
+    bool separate_alpha;
+
+    bool noise_enable;
+    float noise_freq_u;
+    float noise_freq_v;
+    float noise_phase_u;
+    float noise_phase_v;
+    float noise_amplitude_u;
+    float noise_amplitude_v;
+
+    u32 lut_offset;
+    u32 lut_width;
+
+    Lut noise_table;
+    Lut color_map_table;
+    Lut alpha_map_table;
+    std::array<Common::Vec4<u8>, 256> color_table;
+    std::array<Common::Vec4<float>, 256> color_float_table;
+    std::array<Common::Vec4<float>, 256> color_diff_table;
+};
+
+/// Decodes the procedural texture registers and tables into the setup
+void SetupProcTex(ProcTexSetup& setup, const TexturingRegs& regs, const State::ProcTex& state);
+
 /// Generates procedural texture color for the given coordinates
-Common::Vec4<u8> ProcTex(float u, float v, TexturingRegs regs, State::ProcTex state);
+Common::Vec4<u8> ProcTex(float u, float v, const ProcTexSetup& setup);
 
 } // namespace Pica::Rasterizer
@@ -119,6 +119,12 @@ static std::tuple<float24, float24, float24, PAddr> ConvertCubeCoord(float24 u,
 
 MICROPROFILE_DEFINE(GPU_Rasterization, "GPU", "Rasterization", MP_RGB(50, 50, 240));
 
+/// Lighting state of the current draw, set up by BeginDraw
+static LightingSetup lighting_setup;
+/// Procedural texture state, set up by BeginDraw after it was invalidated
+static ProcTexSetup proctex_setup;
+static bool proctex_dirty = true;
+
 /**
  * Helper function for ProcessTriangle with the "reversed" flag to allow for implementing
  * culling via recursion.
@@ -433,8 +439,8 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
             // sample procedural texture
             if (regs.texturing.main_config.texture3_enable) {
                 const auto& proctex_uv = uv[regs.texturing.main_config.texture3_coordinates];
-                texture_color[3] = ProcTex(proctex_uv.u().ToFloat32(), proctex_uv.v().ToFloat32(),
-                                           g_state.regs.texturing, g_state.proctex);
+                texture_color[3] =
+                    ProcTex(proctex_uv.u().ToFloat32(), proctex_uv.v().ToFloat32(), proctex_setup);
             }
 
             // Texture environment - consists of 6 stages of color and alpha combining.
@@ -471,8 +477,8 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
                     GetInterpolatedAttribute(v0.view.y, v1.view.y, v2.view.y).ToFloat32(),
                     GetInterpolatedAttribute(v0.view.z, v1.view.z, v2.view.z).ToFloat32(),
                 };
-                std::tie(primary_fragment_color, secondary_fragment_color) = ComputeFragmentsColors(
-                    g_state.regs.lighting, g_state.lighting, normquat, view, texture_color);
+                std::tie(primary_fragment_color, secondary_fragment_color) =
+                    ComputeFragmentsColors(lighting_setup, normquat, view, texture_color);
             }
 
             for (unsigned tev_stage_index = 0; tev_stage_index < tev_stages.size();
@@ -891,6 +897,20 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
     }
 }
 
+void BeginDraw() {
+    if (!g_state.regs.lighting.disable) {
+        SetupLighting(lighting_setup, g_state.regs.lighting, g_state.lighting);
+    }
+    if (proctex_dirty && g_state.regs.texturing.main_config.texture3_enable) {
+        SetupProcTex(proctex_setup, g_state.regs.texturing, g_state.proctex);
+        proctex_dirty = false;
+    }
+}
+
+void InvalidateProcTex() {
+    proctex_dirty = true;
+}
+
 void ProcessTriangle(const Vertex& v0, const Vertex& v1, const Vertex& v2) {
     ProcessTriangleInternal(v0, v1, v2);
 }
@@ -39,6 +39,12 @@ struct Vertex : Shader::OutputVertex {
     }
 };
 
+/// Prepares the state that is the same for all triangles of a draw, from the current registers
+void BeginDraw();
+
+/// Marks the procedural texture registers or tables as changed, so that BeginDraw decodes them
+void InvalidateProcTex();
+
 void ProcessTriangle(const Vertex& v0, const Vertex& v1, const Vertex& v2);
 
 } // namespace Pica::Rasterizer
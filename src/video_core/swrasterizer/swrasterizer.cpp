@@ -2,15 +2,57 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include "video_core/regs.h"
+#include "video_core/shader/shader.h"
 #include "video_core/swrasterizer/clipper.h"
+#include "video_core/swrasterizer/rasterizer.h"
 #include "video_core/swrasterizer/swrasterizer.h"
 
 namespace VideoCore {
 
+SWRasterizer::SWRasterizer() {
+    // The procedural texture tables may have been reset since the last rasterizer was used
+    Pica::Rasterizer::InvalidateProcTex();
+}
+
+SWRasterizer::~SWRasterizer() = default;
+
 void SWRasterizer::AddTriangle(const Pica::Shader::OutputVertex& v0,
                                const Pica::Shader::OutputVertex& v1,
                                const Pica::Shader::OutputVertex& v2) {
-    Pica::Clipper::ProcessTriangle(v0, v1, v2);
+    triangle_vertices.push_back(v0);
+    triangle_vertices.push_back(v1);
+    triangle_vertices.push_back(v2);
+}
+
+void SWRasterizer::DrawTriangles() {
+    if (triangle_vertices.empty()) {
+        return;
+    }
+    Pica::Rasterizer::BeginDraw();
+    Pica::Clipper::ProcessTriangles(triangle_vertices.data(), triangle_vertices.size() / 3);
+    triangle_vertices.clear();
+}
+
+void SWRasterizer::NotifyPicaRegisterChanged(u32 id) {
+    switch (id) {
+    case PICA_REG_INDEX(texturing.proctex):
+    case PICA_REG_INDEX(texturing.proctex_noise_u):
+    case PICA_REG_INDEX(texturing.proctex_noise_v):
+    case PICA_REG_INDEX(texturing.proctex_noise_frequency):
+    case PICA_REG_INDEX(texturing.proctex_lut):
+    case PICA_REG_INDEX(texturing.proctex_lut_offset):
+    case PICA_REG_INDEX(texturing.proctex_lut_data[0]):
+    case PICA_REG_INDEX(texturing.proctex_lut_data[1]):
+    case PICA_REG_INDEX(texturing.proctex_lut_data[2]):
+    case PICA_REG_INDEX(texturing.proctex_lut_data[3]):
+    case PICA_REG_INDEX(texturing.proctex_lut_data[4]):
+    case PICA_REG_INDEX(texturing.proctex_lut_data[5]):
+    case PICA_REG_INDEX(texturing.proctex_lut_data[6]):
+    case PICA_REG_INDEX(texturing.proctex_lut_data[7]):
+        Pica::Rasterizer::InvalidateProcTex();
+        break;
+    }
 }
 
 } // namespace VideoCore
@@ -1,9 +1,13 @@
+#include <array>
+#include <cstring>
 #include <memory>
+#include <unordered_map>
 #include <boost/range/algorithm/fill.hpp>
 #include "common/alignment.h"
 #include "common/assert.h"
 #include "common/bit_field.h"
 #include "common/common_types.h"
+#include "common/hash.h"
 #include "common/logging/log.h"
 #include "common/vector_math.h"
 #include "core/memory.h"
@@ -15,8 +19,20 @@
 #include "video_core/vertex_loader.h"
 #include "video_core/video_core.h"
 
+#ifdef ARCHITECTURE_x86_64
+#include "video_core/vertex_loader_jit_x64.h"
+#endif // ARCHITECTURE_x86_64
+
 namespace Pica {
 
+VertexLoader::VertexLoader() = default;
+
+VertexLoader::VertexLoader(const PipelineRegs& regs) {
+    Setup(regs);
+}
+
+VertexLoader::~VertexLoader() = default;
+
 void VertexLoader::Setup(const PipelineRegs& regs) {
     ASSERT_MSG(!is_setup, "VertexLoader is not intended to be setup more than once.");
 
@@ -49,6 +65,8 @@ void VertexLoader::Setup(const PipelineRegs& regs) {
                 offset = Common::AlignUp(offset,
                                          attribute_config.GetElementSizeInBytes(attribute_index));
                 vertex_attribute_sources[attribute_index] = loader_config.data_offset + offset;
+                vertex_attribute_loaders[attribute_index] = loader;
+                vertex_attribute_offsets[attribute_index] = offset;
                 vertex_attribute_strides[attribute_index] =
                     static_cast<u32>(loader_config.byte_count);
                 vertex_attribute_formats[attribute_index] =
@@ -69,13 +87,52 @@ void VertexLoader::Setup(const PipelineRegs& regs) {
     }
 
     is_setup = true;
+
+#ifdef ARCHITECTURE_x86_64
+    if (VideoCore::g_shader_jit_enabled && VertexLoaderJit::IsSupported()) {
+        jit = std::make_unique<VertexLoaderJit>(*this);
+    }
+#endif // ARCHITECTURE_x86_64
+}
+
+VertexLoader::AttributeArrays VertexLoader::GetAttributeArrays(u32 base_address) const {
+    AttributeArrays arrays;
+    arrays.valid = true;
+    for (int i = 0; i < num_total_attributes; ++i) {
+        if (vertex_attribute_elements[i] == 0) {
+            continue;
+        }
+        arrays.pointers[i] =
+            VideoCore::g_memory->GetPhysicalPointer(base_address + vertex_attribute_sources[i]);
+        if (arrays.pointers[i] == nullptr) {
+            LOG_ERROR(HW_GPU, "Vertex array of attribute {} at 0x{:08x} is not mapped", i,
+                      base_address + vertex_attribute_sources[i]);
+            arrays.valid = false;
+        }
+    }
+    return arrays;
 }
 
-void VertexLoader::LoadVertex(u32 base_address, int index, int vertex,
-                              Shader::AttributeBuffer& input,
-                              DebugUtils::MemoryAccessTracker& memory_accesses) {
+void VertexLoader::LoadVertex(u32 base_address, const AttributeArrays& arrays, int index,
+                              int vertex, Shader::AttributeBuffer& input,
+                              DebugUtils::MemoryAccessTracker& memory_accesses) const {
     ASSERT_MSG(is_setup, "A VertexLoader needs to be setup before loading vertices.");
 
+#ifdef ARCHITECTURE_x86_64
+    // The compiled loader doesn't report its memory accesses to the debugger
+    if (jit && arrays.valid && VideoCore::g_shader_jit_enabled &&
+        !(g_debug_context && g_debug_context->recorder)) {
+        jit->LoadVertex(arrays.pointers.data(), static_cast<u32>(vertex), input);
+        return;
+    }
+#endif // ARCHITECTURE_x86_64
+
+    LoadVertexInterpreted(base_address, index, vertex, input, memory_accesses);
+}
+
+void VertexLoader::LoadVertexInterpreted(u32 base_address, int index, int vertex,
+                                         Shader::AttributeBuffer& input,
+                                         DebugUtils::MemoryAccessTracker& memory_accesses) const {
     for (int i = 0; i < num_total_attributes; ++i) {
         if (vertex_attribute_elements[i] != 0) {
             // Load per-vertex data from the loader arrays
@@ -160,4 +217,43 @@ void VertexLoader::LoadVertex(u32 base_address, int index, int vertex,
     }
 }
 
+namespace {
+
+/// The attribute config except for the base address, which is only needed when loading vertices
+struct VertexLoaderKey {
+    std::array<u8, sizeof(PipelineRegs::vertex_attributes) - sizeof(u32)> config;
+
+    bool operator==(const VertexLoaderKey& other) const {
+        return config == other.config;
+    }
+};
+
+struct VertexLoaderKeyHash {
+    std::size_t operator()(const VertexLoaderKey& key) const {
+        return static_cast<std::size_t>(
+            Common::ComputeHash64(key.config.data(), key.config.size()));
+    }
+};
+
+} // anonymous namespace
+
+static std::unordered_map<VertexLoaderKey, std::unique_ptr<VertexLoader>, VertexLoaderKeyHash>
+    loader_cache;
+
+const VertexLoader& GetVertexLoader(const PipelineRegs& regs) {
+    VertexLoaderKey key;
+    const u8* config_bytes = reinterpret_cast<const u8*>(&regs.vertex_attributes) + sizeof(u32);
+    std::memcpy(key.config.data(), config_bytes, key.config.size());
+
+    auto& loader = loader_cache[key];
+    if (!loader) {
+        loader = std::make_unique<VertexLoader>(regs);
+    }
+    return *loader;
+}
+
+void ClearVertexLoaderCache() {
+    loader_cache.clear();
+}
+
 } // namespace Pica
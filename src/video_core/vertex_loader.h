@@ -1,6 +1,8 @@
 #pragma once
 
 #include <array>
+#include <cstddef>
+#include <memory>
 #include "common/common_types.h"
 #include "video_core/regs_pipeline.h"
 
@@ -14,29 +16,87 @@ namespace Shader {
 struct AttributeBuffer;
 }
 
+class VertexLoaderJit;
+
 class VertexLoader {
 public:
-    VertexLoader() = default;
-    explicit VertexLoader(const PipelineRegs& regs) {
-        Setup(regs);
-    }
+    /// Host pointers to the vertex arrays of all attributes, resolved once per draw
+    struct AttributeArrays {
+        std::array<const u8*, 16> pointers{};
+        /// False if an array is not in mapped memory, vertices are then loaded access by access
+        bool valid = false;
+    };
+
+    VertexLoader();
+    explicit VertexLoader(const PipelineRegs& regs);
+    ~VertexLoader();
 
     void Setup(const PipelineRegs& regs);
-    void LoadVertex(u32 base_address, int index, int vertex, Shader::AttributeBuffer& input,
-                    DebugUtils::MemoryAccessTracker& memory_accesses);
+
+    /// Resolves the vertex arrays of the loaded attributes for a draw at the given base address
+    AttributeArrays GetAttributeArrays(u32 base_address) const;
+
+    void LoadVertex(u32 base_address, const AttributeArrays& arrays, int index, int vertex,
+                    Shader::AttributeBuffer& input,
+                    DebugUtils::MemoryAccessTracker& memory_accesses) const;
 
     int GetNumTotalAttributes() const {
         return num_total_attributes;
     }
 
+    /// Returns the number of elements loaded from the vertex arrays, 0 if there is no array
+    u32 GetAttributeElements(std::size_t attribute) const {
+        return vertex_attribute_elements[attribute];
+    }
+
+    PipelineRegs::VertexAttributeFormat GetAttributeFormat(std::size_t attribute) const {
+        return vertex_attribute_formats[attribute];
+    }
+
+    u32 GetAttributeStride(std::size_t attribute) const {
+        return vertex_attribute_strides[attribute];
+    }
+
+    /// Returns the attribute loader whose vertex array contains the attribute
+    u32 GetAttributeLoader(std::size_t attribute) const {
+        return vertex_attribute_loaders[attribute];
+    }
+
+    /// Returns the offset of the attribute within a vertex of its loader
+    u32 GetAttributeOffset(std::size_t attribute) const {
+        return vertex_attribute_offsets[attribute];
+    }
+
+    bool IsDefaultAttribute(std::size_t attribute) const {
+        return vertex_attribute_is_default[attribute];
+    }
+
 private:
+    void LoadVertexInterpreted(u32 base_address, int index, int vertex,
+                               Shader::AttributeBuffer& input,
+                               DebugUtils::MemoryAccessTracker& memory_accesses) const;
+
     std::array<u32, 16> vertex_attribute_sources;
     std::array<u32, 16> vertex_attribute_strides{};
     std::array<PipelineRegs::VertexAttributeFormat, 16> vertex_attribute_formats;
     std::array<u32, 16> vertex_attribute_elements{};
     std::array<bool, 16> vertex_attribute_is_default;
+    std::array<u32, 16> vertex_attribute_loaders{};
+    std::array<u32, 16> vertex_attribute_offsets{};
     int num_total_attributes = 0;
     bool is_setup = false;
+
+    /// Compiled version of LoadVertex, null if the JIT is disabled or unsupported
+    std::unique_ptr<VertexLoaderJit> jit;
 };
 
+/**
+ * Returns the vertex loader for the attribute configuration in the given registers. Loaders are
+ * cached by their configuration, so each one is only set up and compiled once.
+ */
+const VertexLoader& GetVertexLoader(const PipelineRegs& regs);
+
+/// Frees all cached vertex loaders
+void ClearVertexLoaderCache();
+
 } // namespace Pica
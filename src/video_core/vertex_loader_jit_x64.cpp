@@ -0,0 +1,176 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <cstddef>
+#include "common/assert.h"
+#include "common/logging/log.h"
+#include "common/vector_math.h"
+#include "common/x64/cpu_detect.h"
+#include "common/x64/xbyak_abi.h"
+#include "video_core/pica_state.h"
+#include "video_core/pica_types.h"
+#include "video_core/regs_pipeline.h"
+#include "video_core/shader/shader.h"
+#include "video_core/vertex_loader.h"
+#include "video_core/vertex_loader_jit_x64.h"
+
+using namespace Common::X64;
+using namespace Xbyak::util;
+using Xbyak::Reg32;
+using Xbyak::Reg64;
+using Xbyak::Xmm;
+
+namespace Pica {
+
+/// Memory allocated for each compiled loader, enough for 16 attributes
+constexpr std::size_t MAX_LOADER_SIZE = 4096;
+
+/// Pointer to the array of vertex array pointers
+static const Reg64 ARRAYS = r9;
+/// Index of the vertex to load
+static const Reg32 VERTEX = r10d;
+/// Pointer to the attribute buffer that is loaded
+static const Reg64 OUTPUT = r11;
+/// Address of the current attribute in its vertex array
+static const Reg64 ADDRESS = rax;
+/// Holds the components of the current attribute before they are merged with the defaults
+static const Xmm SRC = xmm1;
+/// The values of components that are not in the vertex array, (0, 0, 0, 1)
+static const Xmm DEFAULTS = xmm2;
+
+alignas(16) static constexpr std::array<float, 4> default_components{{0.0f, 0.0f, 0.0f, 1.0f}};
+
+VertexLoaderJit::VertexLoaderJit(const VertexLoader& loader)
+    : Xbyak::CodeGenerator(MAX_LOADER_SIZE) {
+    Compile(loader);
+}
+
+bool VertexLoaderJit::IsSupported() {
+    return Common::GetCPUCaps().sse4_1;
+}
+
+void VertexLoaderJit::Compile(const VertexLoader& loader) {
+    program = (CompiledLoader*)getCurr();
+
+    // Only caller saved registers are used, so nothing needs to be preserved
+    mov(ARRAYS, ABI_PARAM1);
+    mov(VERTEX, ABI_PARAM2.cvt32());
+    mov(OUTPUT, ABI_PARAM3);
+    mov(ADDRESS, reinterpret_cast<std::size_t>(default_components.data()));
+    movaps(DEFAULTS, xword[ADDRESS]);
+
+    for (int i = 0; i < loader.GetNumTotalAttributes(); ++i) {
+        const auto output = xword[OUTPUT + i * sizeof(Common::Vec4<float24>)];
+        const u32 elements = loader.GetAttributeElements(i);
+        if (elements != 0) {
+            Compile_LoadArray(loader, i);
+            if (elements < 4) {
+                // Components missing from the array are (0, 0, 0, 1), not the default attribute
+                movaps(xmm0, DEFAULTS);
+                blendps(xmm0, SRC, (1 << elements) - 1);
+                movups(output, xmm0);
+            } else {
+                movups(output, SRC);
+            }
+        } else if (loader.IsDefaultAttribute(i)) {
+            // Read when the vertex is loaded, as default attributes can change between draws
+            mov(ADDRESS, reinterpret_cast<std::size_t>(&g_state.input_default_attributes.attr[i]));
+            movups(xmm0, xword[ADDRESS]);
+            movups(output, xmm0);
+        }
+        // Otherwise the attribute keeps whatever value it had, as in VertexLoader::LoadVertex
+    }
+    ret();
+
+    ready();
+
+    ASSERT_MSG(getSize() <= MAX_LOADER_SIZE, "Compiled a vertex loader that exceeds its buffer!");
+    LOG_DEBUG(HW_GPU, "Compiled vertex loader size={}", getSize());
+}
+
+void VertexLoaderJit::Compile_LoadArray(const VertexLoader& loader, int attribute) {
+    mov(ADDRESS, qword[ARRAYS + attribute * sizeof(const u8*)]);
+    const u32 stride = loader.GetAttributeStride(attribute);
+    if (stride != 0) {
+        imul(ecx, VERTEX, stride);
+        add(ADDRESS, rcx);
+    }
+
+    // Loads exactly the bytes of the attribute, so that the end of memory is never read past
+    const u32 elements = loader.GetAttributeElements(attribute);
+    switch (loader.GetAttributeFormat(attribute)) {
+    case PipelineRegs::VertexAttributeFormat::FLOAT:
+        switch (elements) {
+        case 1:
+            movss(SRC, dword[ADDRESS]);
+            break;
+        case 2:
+            movq(SRC, qword[ADDRESS]);
+            break;
+        case 3:
+            movq(SRC, qword[ADDRESS]);
+            insertps(SRC, dword[ADDRESS + 8], 0x20);
+            break;
+        default:
+            movups(SRC, xword[ADDRESS]);
+            break;
+        }
+        // Already the float values of the attribute
+        return;
+
+    case PipelineRegs::VertexAttributeFormat::SHORT:
+        switch (elements) {
+        case 1:
+            movzx(ecx, word[ADDRESS]);
+            movd(SRC, ecx);
+            break;
+        case 2:
+            movd(SRC, dword[ADDRESS]);
+            break;
+        case 3:
+            movd(SRC, dword[ADDRESS]);
+            pinsrw(SRC, word[ADDRESS + 4], 2);
+            break;
+        default:
+            movq(SRC, qword[ADDRESS]);
+            break;
+        }
+        pmovsxwd(SRC, SRC);
+        break;
+
+    case PipelineRegs::VertexAttributeFormat::BYTE:
+    case PipelineRegs::VertexAttributeFormat::UBYTE:
+        switch (elements) {
+        case 1:
+            movzx(ecx, byte[ADDRESS]);
+            movd(SRC, ecx);
+            break;
+        case 2:
+            movzx(ecx, word[ADDRESS]);
+            movd(SRC, ecx);
+            break;
+        case 3:
+            movzx(ecx, word[ADDRESS]);
+            movzx(edx, byte[ADDRESS + 2]);
+            shl(edx, 16);
+            or_(ecx, edx);
+            movd(SRC, ecx);
+            break;
+        default:
+            movd(SRC, dword[ADDRESS]);
+            break;
+        }
+        if (loader.GetAttributeFormat(attribute) == PipelineRegs::VertexAttributeFormat::BYTE) {
+            pmovsxbd(SRC, SRC);
+        } else {
+            pmovzxbd(SRC, SRC);
+        }
+        break;
+    }
+
+    cvtdq2ps(SRC, SRC);
+}
+
+} // namespace Pica
@@ -0,0 +1,47 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <xbyak.h>
+#include "common/common_types.h"
+
+namespace Pica {
+
+namespace Shader {
+struct AttributeBuffer;
+}
+
+class VertexLoader;
+
+/**
+ * Compiles the attribute configuration of a VertexLoader into x86_64 code that loads a whole
+ * vertex without branching, converting each attribute to float with a few SSE4.1 instructions.
+ */
+class VertexLoaderJit : public Xbyak::CodeGenerator {
+public:
+    explicit VertexLoaderJit(const VertexLoader& loader);
+
+    /**
+     * Loads a vertex into the attribute buffer.
+     * @param arrays Host pointers to the vertex arrays of the attributes, see
+     *               VertexLoader::GetAttributeArrays
+     */
+    void LoadVertex(const u8* const* arrays, u32 vertex, Shader::AttributeBuffer& input) const {
+        program(arrays, vertex, &input);
+    }
+
+    /// Returns whether the host supports the instructions used by the compiled loaders
+    static bool IsSupported();
+
+private:
+    void Compile(const VertexLoader& loader);
+    void Compile_LoadArray(const VertexLoader& loader, int attribute);
+
+    using CompiledLoader = void(const u8* const* arrays, u32 vertex,
+                                Shader::AttributeBuffer* input);
+    CompiledLoader* program = nullptr;
+};
+
+} // namespace Pica
@@ -5,8 +5,10 @@
 #include <memory>
 #include "common/logging/log.h"
 #include "core/settings.h"
+#include "video_core/gpu_thread.h"
 #include "video_core/pica.h"
 #include "video_core/renderer_base.h"
+#include "video_core/renderer_null/renderer_null.h"
 #include "video_core/renderer_opengl/gl_vars.h"
 #include "video_core/renderer_opengl/renderer_opengl.h"
 #include "video_core/video_core.h"
@@ -38,14 +40,20 @@ Core::System::ResultStatus Init(Frontend::EmuWindow& emu_window, Memory::MemoryS
     g_memory = &memory;
     Pica::Init();
 
-    OpenGL::GLES = Settings::values.use_gles;
-
-    g_renderer = std::make_unique<OpenGL::RendererOpenGL>(emu_window);
+    if (Settings::values.use_null_renderer) {
+        g_renderer = std::make_unique<RendererNull>(emu_window);
+    } else {
+        OpenGL::GLES = Settings::values.use_gles;
+        g_renderer = std::make_unique<OpenGL::RendererOpenGL>(emu_window);
+    }
     Core::System::ResultStatus result = g_renderer->Init();
 
     if (result != Core::System::ResultStatus::Success) {
         LOG_ERROR(Render, "initialization failed !");
     } else {
+        if (Settings::values.use_async_gpu) {
+            g_gpu_thread = std::make_unique<GPUThread>();
+        }
         LOG_DEBUG(Render, "initialized OK");
     }
 
@@ -54,6 +62,9 @@ Core::System::ResultStatus Init(Frontend::EmuWindow& emu_window, Memory::MemoryS
 
 /// Shutdown the video core
 void Shutdown() {
+    // Finishes the queued work, which may still use the PICA state and the renderer
+    g_gpu_thread.reset();
+
     Pica::Shutdown();
 
     g_renderer.reset();